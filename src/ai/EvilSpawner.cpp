@@ -0,0 +1,420 @@
+#include "EvilSpawner.h"
+#include "../core/BitUtils.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace {
+
+constexpr int INF = 1 << 30;
+// 玩家无路可走时的估值；越早走死越低，生成方会优先选最快的死路
+constexpr int LOSS = 1 << 20;
+constexpr int EMPTY_WEIGHT = 2;
+constexpr int PAIR_WEIGHT = 1;
+constexpr int MAX_SPAWNS = EvilSpawner::PACKED_SIZE * EvilSpawner::PACKED_SIZE * 2;
+constexpr int MAX_ORDER = 10;  // 最多4个邻居可合并，乘2再加是否为2
+
+// 每搜这么多个节点看一次时钟
+constexpr uint64_t CLOCK_CHECK_MASK = 63;
+
+constexpr uint64_t LOW7 = 0x7F7F7F7F7F7F7F7FULL;
+constexpr uint64_t HIGH_BITS = 0x8080808080808080ULL;
+
+// 值为0的字节最高位置1，其余位全为0（不会像常见写法那样在0字节之后误报）
+inline uint64_t zeroBytes(uint64_t v) {
+    return ~(((v & LOW7) + LOW7) | v | LOW7);
+}
+
+const int CLASSIC_AXES[4][2] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}};
+const int DIAGONAL_AXES[4][2] = {{1, 1}, {-1, -1}, {1, -1}, {-1, 1}};
+
+const int (*mergeAxes(GameVersion version))[2] {
+    return version == GameVersion::ORIGINAL ? CLASSIC_AXES : DIAGONAL_AXES;
+}
+
+} // namespace
+
+struct EvilSpawner::SearchContext {
+    uint64_t nodes = 0;
+    uint64_t nodeLimit = 0;
+    std::chrono::steady_clock::time_point deadline;
+    bool aborted = false;
+    bool timedOut = false;
+    // 每层最近一次导致剪枝的生成（下标 * 2 + 是否为4），同层的兄弟节点先试它
+    int killers[MAX_DEPTH + 1];
+};
+
+EvilSpawner::EvilSpawner() : n(0), preparedVersion(GameVersion::ORIGINAL), rowMask(0), neighbours{} {
+}
+
+void EvilSpawner::prepare(int gridSize, GameVersion version) {
+    if (gridSize == n && version == preparedVersion) return;
+    n = gridSize;
+    preparedVersion = version;
+    rowMask = n >= PACKED_SIZE ? HIGH_BITS : HIGH_BITS & ((1ULL << (8 * n)) - 1);
+
+    // 与 Board::move 相同的线：从紧贴边界的格子出发，步长指向远离边界的方向
+    for (int d = 0; d < 4; ++d) {
+        const Direction dir = directionFromIndex(version, d);
+        const int dx = directionDx(dir);
+        const int dy = directionDy(dir);
+        const bool farFirst = (dx != 0 && dy > 0);
+        const int stride = -(dy * PACKED_SIZE + dx);
+        std::vector<Line>& list = lines[d];
+        list.clear();
+        lineOfCell[d].fill(0xFF);
+        auto addLine = [&](int x, int y) {
+            const int lengthX = dx > 0 ? x + 1 : (dx < 0 ? n - x : n);
+            const int lengthY = dy > 0 ? y + 1 : (dy < 0 ? n - y : n);
+            const int length = std::min(lengthX, lengthY);
+            if (length > 1) {
+                const int start = y * PACKED_SIZE + x;
+                for (int i = 0; i < length; ++i) {
+                    lineOfCell[d][start + i * stride] = static_cast<uint8_t>(list.size());
+                }
+                list.push_back({static_cast<uint8_t>(start), static_cast<int8_t>(stride),
+                                static_cast<uint8_t>(length), farFirst});
+            }
+        };
+        for (int y = 0; y < n; ++y) {
+            if (y + dy < 0 || y + dy >= n) {
+                for (int x = 0; x < n; ++x) {
+                    addLine(x, y);
+                }
+            } else if (dx != 0) {
+                addLine(dx < 0 ? 0 : n - 1, y);
+            }
+        }
+    }
+
+    const int (*axes)[2] = mergeAxes(version);
+    for (int y = 0; y < n; ++y) {
+        for (int x = 0; x < n; ++x) {
+            std::array<uint8_t, 4>& list = neighbours[y * PACKED_SIZE + x];
+            list.fill(0xFF);
+            int count = 0;
+            for (int a = 0; a < 4; ++a) {
+                const int nx = x + axes[a][0];
+                const int ny = y + axes[a][1];
+                if (nx >= 0 && nx < n && ny >= 0 && ny < n) {
+                    list[count++] = static_cast<uint8_t>(ny * PACKED_SIZE + nx);
+                }
+            }
+        }
+    }
+}
+
+bool EvilSpawner::slide(uint8_t* cells, const Line& line) {
+    // 与 Board.cpp 里的 slideLine 同一套规则，合并标记放在一个字节里
+    const int start = line.start;
+    const int stride = line.stride;
+    const int length = line.length;
+    bool moved = false;
+    unsigned merged = 0;
+    int filled = 0;
+    for (int step = 0; step < length; ++step) {
+        const int i = line.farFirst ? length - 1 - step : step;
+        const int from = start + i * stride;
+        const uint8_t exp = cells[from];
+        if (exp == 0) continue;
+
+        int pos = filled;
+        if (line.farFirst) {
+            pos = i;
+            while (pos > 0 && cells[start + (pos - 1) * stride] == 0) {
+                --pos;
+            }
+        }
+
+        if (pos > 0 && cells[start + (pos - 1) * stride] == exp && !((merged >> (pos - 1)) & 1)) {
+            merged |= 1u << (pos - 1);
+            cells[start + (pos - 1) * stride] = static_cast<uint8_t>(exp + 1);
+            cells[from] = 0;
+            moved = true;
+        } else {
+            if (pos != i) {
+                cells[start + pos * stride] = exp;
+                cells[from] = 0;
+                moved = true;
+            }
+            filled = pos + 1;
+        }
+    }
+    return moved;
+}
+
+void EvilSpawner::expand(const Grid& grid, Moves& moves) const {
+    for (int d = 0; d < 4; ++d) {
+        Grid& after = moves.after[d];
+        after = grid;
+        uint32_t moved = 0;
+        const std::vector<Line>& list = lines[d];
+        for (size_t i = 0; i < list.size(); ++i) {
+            moved |= static_cast<uint32_t>(slide(after.cells, list[i])) << i;
+        }
+        moves.movedLines[d] = moved;
+    }
+}
+
+void EvilSpawner::expandSpawn(const Moves& base, const Grid& grid, int cell, uint8_t exp, Moves& moves) const {
+    // 新方块只影响经过它的那条线，其余的线直接沿用父局面走完的结果
+    for (int d = 0; d < 4; ++d) {
+        Grid& after = moves.after[d];
+        after = base.after[d];
+        const uint8_t index = lineOfCell[d][cell];
+        if (index == 0xFF) {
+            // 这个方向上单独成线（对角线的角），不会移动也不会被合并
+            after.cells[cell] = exp;
+            moves.movedLines[d] = base.movedLines[d];
+            continue;
+        }
+        const Line& line = lines[d][index];
+        for (int i = 0; i < line.length; ++i) {
+            const int at = line.start + i * line.stride;
+            after.cells[at] = grid.cells[at];
+        }
+        after.cells[cell] = exp;
+        const uint32_t bit = 1u << index;
+        moves.movedLines[d] = (base.movedLines[d] & ~bit) | (slide(after.cells, line) ? bit : 0);
+    }
+}
+
+int EvilSpawner::evaluate(const Grid& grid) const {
+    uint64_t rows[PACKED_SIZE];
+    std::memcpy(rows, grid.cells, sizeof(rows));
+
+    // 玩家的余地：空格越多、沿可移动方向相邻且相同的方块越多越好
+    int empties = 0;
+    int pairs = 0;
+    const bool classic = preparedVersion == GameVersion::ORIGINAL;
+    for (int y = 0; y < n; ++y) {
+        const uint64_t row = rows[y];
+        const uint64_t filled = ~zeroBytes(row);
+        empties += popcount64(zeroBytes(row) & rowMask);
+        if (classic) {
+            pairs += popcount64(zeroBytes(row ^ (row >> 8)) & filled & (rowMask >> 8));
+        }
+        if (y + 1 == n) continue;
+        const uint64_t next = rows[y + 1];
+        if (classic) {
+            pairs += popcount64(zeroBytes(row ^ next) & filled & rowMask);
+        } else {
+            pairs += popcount64(zeroBytes(row ^ (next >> 8)) & filled & (rowMask >> 8));
+            pairs += popcount64(zeroBytes(row ^ (next << 8)) & filled & rowMask & ~0xFFULL);
+        }
+    }
+    return EMPTY_WEIGHT * empties + PAIR_WEIGHT * pairs;
+}
+
+int EvilSpawner::listSpawns(const Grid& grid, Spawn* spawns) const {
+    // 能和邻居合并的生成对玩家友好，放到后面；同样友好时先试4。
+    // 排序键只有 MAX_ORDER 种，按键分桶后依次拼起来，同一桶内保持格子顺序
+    Spawn buckets[MAX_ORDER][MAX_SPAWNS / 2];
+    int bucketSize[MAX_ORDER] = {};
+    for (int y = 0; y < n; ++y) {
+        for (int x = 0; x < n; ++x) {
+            const int cell = y * PACKED_SIZE + x;
+            if (grid.cells[cell] != 0) continue;
+            for (uint8_t exp = 1; exp <= 2; ++exp) {
+                int friendly = 0;
+                for (uint8_t other : neighbours[cell]) {
+                    if (other == 0xFF) break;
+                    friendly += grid.cells[other] == exp;
+                }
+                const int order = friendly * 2 + (exp == 1);
+                buckets[order][bucketSize[order]++] = {static_cast<uint8_t>(cell), exp};
+            }
+        }
+    }
+    int count = 0;
+    for (int order = 0; order < MAX_ORDER; ++order) {
+        std::copy(buckets[order], buckets[order] + bucketSize[order], spawns + count);
+        count += bucketSize[order];
+    }
+    return count;
+}
+
+bool EvilSpawner::interrupted(SearchContext& context) const {
+    if (context.aborted) return true;
+    if (context.nodes >= context.nodeLimit) {
+        context.aborted = true;
+    } else if ((context.nodes & CLOCK_CHECK_MASK) == 0 && std::chrono::steady_clock::now() >= context.deadline) {
+        context.aborted = true;
+        context.timedOut = true;
+    }
+    return context.aborted;
+}
+
+int EvilSpawner::spawnerNode(const Grid& grid, int depth, int ply, int alpha, int beta, SearchContext& context) {
+    ++context.nodes;
+    if (interrupted(context)) return 0;
+
+    Spawn spawns[MAX_SPAWNS];
+    const int count = listSpawns(grid, spawns);
+    if (count == 0) return evaluate(grid);
+
+    // 杀手生成提到最前面
+    const int killer = context.killers[ply];
+    for (int i = 1; i < count; ++i) {
+        if (spawns[i].cell * 2 + spawns[i].exponent - 1 == killer) {
+            std::rotate(spawns, spawns + i, spawns + i + 1);
+            break;
+        }
+    }
+
+    Moves base;
+    expand(grid, base);
+    int best = INF;
+    for (int i = 0; i < count; ++i) {
+        Moves child;
+        expandSpawn(base, grid, spawns[i].cell, spawns[i].exponent, child);
+        const int value = playerNode(child, depth - 1, ply, alpha, beta, context);
+        if (context.aborted) return 0;
+        if (value < best) {
+            best = value;
+            beta = std::min(beta, value);
+        }
+        if (best <= alpha) {
+            context.killers[ply] = spawns[i].cell * 2 + spawns[i].exponent - 1;
+            break;
+        }
+    }
+    return best;
+}
+
+int EvilSpawner::playerNode(const Moves& moves, int depth, int ply, int alpha, int beta, SearchContext& context) {
+    ++context.nodes;
+    if (interrupted(context)) return 0;
+
+    int values[4];
+    int order[4];
+    int count = 0;
+    for (int d = 0; d < 4; ++d) {
+        if (moves.movedLines[d] == 0) continue;
+        values[d] = evaluate(moves.after[d]);
+        // 按估值从高到低插入
+        int pos = count++;
+        while (pos > 0 && values[order[pos - 1]] < values[d]) {
+            order[pos] = order[pos - 1];
+            --pos;
+        }
+        order[pos] = d;
+    }
+    if (count == 0) return -LOSS + ply;
+    if (depth == 0) return values[order[0]];
+
+    int best = -INF;
+    for (int i = 0; i < count; ++i) {
+        const int value = spawnerNode(moves.after[order[i]], depth, ply + 1, alpha, beta, context);
+        if (context.aborted) return 0;
+        if (value > best) {
+            best = value;
+            alpha = std::max(alpha, value);
+        }
+        if (best >= beta) break;
+    }
+    return best;
+}
+
+SpawnChoice EvilSpawner::choose(const Board& board, GameVersion version, uint64_t nodeLimit) {
+    if (board.size() > PACKED_SIZE) {
+        return chooseStatic(board, version);
+    }
+    prepare(board.size(), version);
+
+    Grid root;
+    std::memset(root.cells, 0, sizeof(root.cells));
+    for (int y = 0; y < n; ++y) {
+        for (int x = 0; x < n; ++x) {
+            root.cells[y * PACKED_SIZE + x] = board.exponent(y * n + x);
+        }
+    }
+
+    Spawn spawns[MAX_SPAWNS];
+    const int count = listSpawns(root, spawns);
+    SpawnChoice choice;
+    if (count == 0) return choice;
+
+    SearchContext context;
+    context.nodeLimit = nodeLimit != 0 ? nodeLimit : DEFAULT_CELL_NODE_LIMIT / (n * n);
+    context.deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(TIME_BACKSTOP_MS);
+    std::fill(std::begin(context.killers), std::end(context.killers), -1);
+
+    // 静态排序的第一个作为还没搜完一层时的结果
+    int order[MAX_SPAWNS];
+    int values[MAX_SPAWNS];
+    for (int i = 0; i < count; ++i) {
+        order[i] = i;
+        values[i] = INF;
+    }
+    int chosen = 0;
+    int stableDepths = 0;   // 连续几层选中同一个生成
+    Moves base;
+    expand(root, base);
+
+    for (int depth = 1; depth <= MAX_DEPTH; ++depth) {
+        int best = INF;
+        int bestIndex = -1;
+        for (int k = 0; k < count; ++k) {
+            const int i = order[k];
+            Moves child;
+            expandSpawn(base, root, spawns[i].cell, spawns[i].exponent, child);
+            // 窗口上界是目前最好的值：更差的生成只需证明"不比它好"
+            const int value = playerNode(child, depth - 1, 0, -INF, best, context);
+            if (context.aborted) break;
+            values[i] = value;
+            if (value < best) {
+                best = value;
+                bestIndex = i;
+            }
+        }
+        // 上一层的最佳排在最前，只要它搜完了，这一层里比它更好的结果就是可信的。
+        // 中断点只取决于节点数（时间兜底触发时除外），所以用到半层的结果也是可复现的
+        if (bestIndex >= 0) {
+            stableDepths = bestIndex == chosen ? stableDepths + 1 : 1;
+            chosen = bestIndex;
+        }
+        if (context.aborted) break;
+        choice.depth = depth;
+        if (best <= -LOSS + MAX_DEPTH || stableDepths >= CONVERGED_DEPTHS) break;
+        std::stable_sort(order, order + count, [&](int a, int b) { return values[a] < values[b]; });
+    }
+
+    choice.cell = (spawns[chosen].cell / PACKED_SIZE) * n + spawns[chosen].cell % PACKED_SIZE;
+    choice.exponent = spawns[chosen].exponent;
+    choice.nodes = context.nodes;
+    choice.timedOut = context.timedOut;
+    return choice;
+}
+
+SpawnChoice EvilSpawner::chooseStatic(const Board& board, GameVersion version) const {
+    // 超大棋盘搜不动：挑一个不能与邻居合并、周围空格最少的位置
+    const int size = board.size();
+    const int (*axes)[2] = mergeAxes(version);
+    SpawnChoice choice;
+    int bestScore = INF;
+    for (int y = 0; y < size; ++y) {
+        for (int x = 0; x < size; ++x) {
+            if (board.exponent(y * size + x) != 0) continue;
+            for (uint8_t exp = 1; exp <= 2; ++exp) {
+                int friendly = 0;
+                int open = 0;
+                for (int a = 0; a < 4; ++a) {
+                    const int nx = x + axes[a][0];
+                    const int ny = y + axes[a][1];
+                    if (nx < 0 || nx >= size || ny < 0 || ny >= size) continue;
+                    const uint8_t other = board.exponent(ny * size + nx);
+                    friendly += other == exp;
+                    open += other == 0;
+                }
+                const int score = friendly * 8 + open * 2 + (exp == 1);
+                if (score < bestScore) {
+                    bestScore = score;
+                    choice.cell = y * size + x;
+                    choice.exponent = exp;
+                }
+            }
+        }
+    }
+    return choice;
+}
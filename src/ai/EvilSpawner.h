@@ -0,0 +1,86 @@
+#ifndef EVIL_SPAWNER_H
+#define EVIL_SPAWNER_H
+
+#include <array>
+#include <cstdint>
+#include <vector>
+#include "../core/Board.h"
+
+struct SpawnChoice {
+    int cell = -1;          // 棋盘下标（行优先），没有空格时为-1
+    uint8_t exponent = 1;
+    int depth = 0;          // 完整搜完的层数（一层 = 生成一个方块 + 玩家走一步），0 表示按静态规则挑选
+    uint64_t nodes = 0;
+    bool timedOut = false;  // 被时间兜底打断：这一步的选择与机器快慢有关
+};
+
+// 恶意生成：在所有（空格 x {2,4}）里挑让玩家最难受的一个。
+// 不超过 PACKED_SIZE 的棋盘压成每行一个64位字、每格一个字节，空格数和可合并的相邻对用按字节并行的位运算统计；
+// 移动按预先算好的线（起点、步长、长度）处理，规则与 Board::move 完全一致；
+// 新方块只改变经过它的线，所以每个生成节点先把父局面往四个方向走一遍，每个子节点只重算一条线。
+// 搜索是生成方取最小、玩家取最大的 alpha-beta，逐层加深：根节点按上一层的结果排序，
+// 内部节点先试不与任何邻居相同的生成、玩家先试估值高的方向。
+// 预算按节点数计：同一局面、同一预算总是选出同一个生成，与机器快慢和负载无关。
+// 每个节点的开销与格子数成正比，默认预算按格子数折算，各种尺寸每步的最坏耗时都在 5 毫秒以内。
+// 另有墙上时钟兜底（TIME_BACKSTOP_MS），只在机器很慢或负载很重、节点预算也用不完时才会触发。
+// 连续几层选中同一个生成就认为已经收敛，提前结束，多数局面用不完预算。
+// 更大的棋盘只按邻居做静态挑选。
+class EvilSpawner {
+public:
+    static constexpr int PACKED_SIZE = 8;
+    static constexpr int MAX_DEPTH = 8;
+    static constexpr uint64_t DEFAULT_CELL_NODE_LIMIT = 24000;   // 节点数上限 x 格子数，4x4 为1500个节点
+    static constexpr int TIME_BACKSTOP_MS = 4;
+    static constexpr int CONVERGED_DEPTHS = 3;
+
+    EvilSpawner();
+
+    // nodeLimit 为0时按棋盘尺寸取默认预算
+    SpawnChoice choose(const Board& board, GameVersion version, uint64_t nodeLimit = 0);
+
+private:
+    struct Grid {
+        alignas(8) uint8_t cells[PACKED_SIZE * PACKED_SIZE];    // 第 y 行第 x 格在 y * PACKED_SIZE + x
+    };
+    struct Line {
+        uint8_t start;
+        int8_t stride;
+        uint8_t length;
+        bool farFirst;
+    };
+    struct Spawn {
+        uint8_t cell;       // 压缩棋盘里的下标
+        uint8_t exponent;
+    };
+    // 一个局面往四个方向各走一步的结果；movedLines 的第 i 位表示该方向第 i 条线有变化，全为0即不能走
+    struct Moves {
+        Grid after[4];
+        uint32_t movedLines[4];
+    };
+    struct SearchContext;
+
+    // 棋盘尺寸或版本变化时重建线表和邻居表
+    void prepare(int gridSize, GameVersion version);
+    static bool slide(uint8_t* cells, const Line& line);
+    void expand(const Grid& grid, Moves& moves) const;
+    // grid 是父局面，在 cell 放上 exp 之后往四个方向走；只重算经过 cell 的线
+    void expandSpawn(const Moves& base, const Grid& grid, int cell, uint8_t exp, Moves& moves) const;
+    int evaluate(const Grid& grid) const;
+    // 按"对玩家多不友好"排好序的全部生成，返回个数
+    int listSpawns(const Grid& grid, Spawn* spawns) const;
+
+    int spawnerNode(const Grid& grid, int depth, int ply, int alpha, int beta, SearchContext& context);
+    int playerNode(const Moves& moves, int depth, int ply, int alpha, int beta, SearchContext& context);
+    bool interrupted(SearchContext& context) const;
+
+    SpawnChoice chooseStatic(const Board& board, GameVersion version) const;
+
+    int n;
+    GameVersion preparedVersion;
+    uint64_t rowMask;       // 每行有效字节的最高位
+    std::array<std::vector<Line>, 4> lines;    // 按方向下标
+    std::array<std::array<uint8_t, PACKED_SIZE * PACKED_SIZE>, 4> lineOfCell;  // 格子所在的线，不在任何线上为 0xFF
+    std::array<std::array<uint8_t, 4>, PACKED_SIZE * PACKED_SIZE> neighbours;   // 沿可合并方向的邻居，不足的填 0xFF
+};
+
+#endif // EVIL_SPAWNER_H
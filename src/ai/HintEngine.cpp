@@ -0,0 +1,442 @@
+#include "HintEngine.h"
+#include "NTupleNetwork.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+// 累计概率低于这个值的分支不再展开，直接估值（空格多时每层的分支数很大，靠它控制搜索量）
+constexpr float PROBABILITY_THRESHOLD = 0.0001f;
+constexpr float SPAWN_TWO_PROBABILITY = 0.8f;
+constexpr float SPAWN_FOUR_PROBABILITY = 0.2f;
+// 每展开这么多局面检查一次局面是否已经变了
+constexpr uint64_t INTERRUPT_CHECK_INTERVAL = 1024;
+
+constexpr int MAX_EXPONENT = 32;
+
+// 启发式估值的权重：每行每列分别统计，空格和可合并的相邻对加分，不单调和数字总和减分
+constexpr float LINE_BASE_SCORE = 200000.0f;
+constexpr float EMPTY_WEIGHT = 270.0f;
+constexpr float MERGES_WEIGHT = 700.0f;
+constexpr float MONOTONICITY_POWER = 4.0f;
+constexpr float MONOTONICITY_WEIGHT = 47.0f;
+constexpr float SUM_POWER = 3.5f;
+constexpr float SUM_WEIGHT = 11.0f;
+
+struct HeuristicTables {
+    float monotonicity[MAX_EXPONENT];
+    float sum[MAX_EXPONENT];
+
+    HeuristicTables() {
+        for (int e = 0; e < MAX_EXPONENT; ++e) {
+            monotonicity[e] = std::pow(static_cast<float>(e), MONOTONICITY_POWER);
+            sum[e] = std::pow(static_cast<float>(e), SUM_POWER);
+        }
+    }
+};
+
+const HeuristicTables& heuristicTables() {
+    static const HeuristicTables tables;
+    return tables;
+}
+
+// 每格每种指数一个随机键，另外区分棋盘尺寸和版本，不同规则的结果可以放在同一张表里
+struct ZobristKeys {
+    uint64_t cells[HintEngine::MAX_GRID_SIZE * HintEngine::MAX_GRID_SIZE][MAX_EXPONENT];
+    uint64_t sizes[HintEngine::MAX_GRID_SIZE + 1];
+    uint64_t versions[2];
+
+    ZobristKeys() {
+        Rng rng(0x2048);
+        auto next64 = [&rng]() { return (static_cast<uint64_t>(rng.next()) << 32) | rng.next(); };
+        for (auto& cell : cells) {
+            for (uint64_t& key : cell) {
+                key = next64();
+            }
+        }
+        for (uint64_t& key : sizes) {
+            key = next64();
+        }
+        for (uint64_t& key : versions) {
+            key = next64();
+        }
+    }
+};
+
+const ZobristKeys& zobristKeys() {
+    static const ZobristKeys keys;
+    return keys;
+}
+
+float heuristicLine(const uint8_t* line, int length) {
+    const HeuristicTables& tables = heuristicTables();
+    float sum = 0.0f;
+    int empty = 0;
+    int merges = 0;
+    int previous = 0;
+    int run = 0;
+    for (int i = 0; i < length; ++i) {
+        const int exponent = line[i];
+        sum += tables.sum[exponent];
+        if (exponent == 0) {
+            ++empty;
+            continue;
+        }
+        if (exponent == previous) {
+            ++run;
+        } else if (run > 0) {
+            merges += 1 + run;
+            run = 0;
+        }
+        previous = exponent;
+    }
+    if (run > 0) {
+        merges += 1 + run;
+    }
+
+    float towardStart = 0.0f;
+    float towardEnd = 0.0f;
+    for (int i = 1; i < length; ++i) {
+        if (line[i - 1] > line[i]) {
+            towardStart += tables.monotonicity[line[i - 1]] - tables.monotonicity[line[i]];
+        } else {
+            towardEnd += tables.monotonicity[line[i]] - tables.monotonicity[line[i - 1]];
+        }
+    }
+
+    return LINE_BASE_SCORE + EMPTY_WEIGHT * empty + MERGES_WEIGHT * merges -
+           MONOTONICITY_WEIGHT * std::min(towardStart, towardEnd) - SUM_WEIGHT * sum;
+}
+
+// 概率 p 对应的等级：p 在 (2^-(k+1), 2^-k] 时为 k
+int probabilityLevel(float probability) {
+    int exponent = 0;
+    std::frexp(probability, &exponent);
+    return std::min(std::max(1 - exponent, 0), 255);
+}
+
+// 不超过 LINE_TABLE_MAX_LENGTH 格、指数都小于16的一行，按每格4位编号后直接查预先算好的表
+// （4格 64K 项，5格 1M 项，第一次用到时生成）；更长的行或者更大的数字现算
+constexpr int LINE_TABLE_MAX_LENGTH = 5;
+
+const std::vector<float>& lineTable(int length) {
+    static std::vector<float> tables[LINE_TABLE_MAX_LENGTH + 1];
+    static std::once_flag built[LINE_TABLE_MAX_LENGTH + 1];
+    std::call_once(built[length], [length]() {
+        std::vector<float>& table = tables[length];
+        table.resize(size_t(1) << (4 * length));
+        uint8_t line[LINE_TABLE_MAX_LENGTH];
+        for (size_t index = 0; index < table.size(); ++index) {
+            for (int i = 0; i < length; ++i) {
+                line[i] = static_cast<uint8_t>((index >> (4 * i)) & 0xF);
+            }
+            table[index] = heuristicLine(line, length);
+        }
+    });
+    return tables[length];
+}
+
+float heuristicBoard(const Board& board) {
+    const int n = board.size();
+    const bool useTable = n <= LINE_TABLE_MAX_LENGTH && board.maxExponent() < 16;
+    const float* table = useTable ? lineTable(n).data() : nullptr;
+    uint8_t row[HintEngine::MAX_GRID_SIZE];
+    uint8_t column[HintEngine::MAX_GRID_SIZE];
+    float value = 0.0f;
+    for (int i = 0; i < n; ++i) {
+        if (table) {
+            uint32_t rowIndex = 0;
+            uint32_t columnIndex = 0;
+            for (int j = 0; j < n; ++j) {
+                rowIndex |= static_cast<uint32_t>(board.exponent(i * n + j)) << (4 * j);
+                columnIndex |= static_cast<uint32_t>(board.exponent(j * n + i)) << (4 * j);
+            }
+            value += table[rowIndex] + table[columnIndex];
+            continue;
+        }
+        for (int j = 0; j < n; ++j) {
+            row[j] = static_cast<uint8_t>(std::min<int>(board.exponent(i * n + j), MAX_EXPONENT - 1));
+            column[j] = static_cast<uint8_t>(std::min<int>(board.exponent(j * n + i), MAX_EXPONENT - 1));
+        }
+        value += heuristicLine(row, n) + heuristicLine(column, n);
+    }
+    return value;
+}
+
+} // namespace
+
+HintTable::HintTable(int bits) : tableBits(bits), slots(new Slot[size_t(1) << bits]) {
+    for (size_t i = 0; i < (size_t(1) << bits); ++i) {
+        slots[i].check.store(0, std::memory_order_relaxed);
+        slots[i].data.store(0, std::memory_order_relaxed);
+    }
+}
+
+// 低32位是估值，之后每8位依次是深度、方向下标+1、代数、概率等级
+uint64_t HintTable::pack(const Entry& entry, uint8_t generation) {
+    uint32_t valueBits;
+    std::memcpy(&valueBits, &entry.value, sizeof(valueBits));
+    return static_cast<uint64_t>(valueBits) | (static_cast<uint64_t>(entry.depth & 0xFF) << 32) |
+           (static_cast<uint64_t>((entry.move + 1) & 0xFF) << 40) | (static_cast<uint64_t>(generation) << 48) |
+           (static_cast<uint64_t>(entry.probabilityLevel & 0xFF) << 56);
+}
+
+HintTable::Entry HintTable::unpack(uint64_t data) {
+    Entry entry;
+    const uint32_t valueBits = static_cast<uint32_t>(data);
+    std::memcpy(&entry.value, &valueBits, sizeof(valueBits));
+    entry.depth = static_cast<int>((data >> 32) & 0xFF);
+    entry.move = static_cast<int>((data >> 40) & 0xFF) - 1;
+    entry.probabilityLevel = static_cast<int>(data >> 56);
+    return entry;
+}
+
+bool HintTable::probe(uint64_t key, Entry& entry) const {
+    const Slot& slot = slots[key >> (64 - tableBits)];
+    const uint64_t data = slot.data.load(std::memory_order_relaxed);
+    const uint64_t check = slot.check.load(std::memory_order_relaxed);
+    // 空位的两个字都是0，depth 为0的结果不会写入，所以不会误判
+    if ((check ^ data) != key || data == 0) return false;
+    entry = unpack(data);
+    return true;
+}
+
+void HintTable::store(uint64_t key, const Entry& entry, uint8_t generation) {
+    Slot& slot = slots[key >> (64 - tableBits)];
+    const uint64_t oldData = slot.data.load(std::memory_order_relaxed);
+    const uint64_t oldCheck = slot.check.load(std::memory_order_relaxed);
+    if (oldData != 0) {
+        const Entry old = unpack(oldData);
+        const bool sameKey = (oldCheck ^ oldData) == key;
+        const bool current = static_cast<uint8_t>(oldData >> 48) == generation;
+        const bool better = old.depth > entry.depth && old.probabilityLevel <= entry.probabilityLevel;
+        if (better && (sameKey || current)) return;
+    }
+    const uint64_t data = pack(entry, generation);
+    slot.data.store(data, std::memory_order_relaxed);
+    slot.check.store(key ^ data, std::memory_order_relaxed);
+}
+
+HintEngine::HintEngine()
+    : table(TABLE_BITS), pendingVersion(GameVersion::ORIGINAL), pendingWeights(nullptr), finishedGeneration(0),
+      quit(false), generation(0), totalNodes(0) {
+}
+
+HintEngine::~HintEngine() {
+    stop();
+}
+
+void HintEngine::start() {
+    if (worker.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        quit = false;
+    }
+    worker = std::thread(&HintEngine::run, this);
+}
+
+void HintEngine::stop() {
+    if (!worker.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        quit = true;
+    }
+    generation.fetch_add(1, std::memory_order_relaxed);
+    wake.notify_one();
+    worker.join();
+}
+
+void HintEngine::setPosition(const Board& board, GameVersion version, const float* weights) {
+    if (!supports(board.size())) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (board == pendingBoard && version == pendingVersion && weights == pendingWeights) return;
+        pendingBoard = board;
+        pendingVersion = version;
+        pendingWeights = weights;
+        generation.fetch_add(1, std::memory_order_relaxed);
+    }
+    wake.notify_one();
+}
+
+bool HintEngine::lookup(const Board& board, GameVersion version, HintResult& result) const {
+    result = HintResult();
+    if (!supports(board.size())) return false;
+    HintTable::Entry entry;
+    if (!table.probe(hashBoard(board, version), entry)) return false;
+    result.depth = entry.depth;
+    result.hasMove = entry.move >= 0;
+    if (result.hasMove) {
+        result.move = directionFromIndex(version, entry.move);
+    }
+    return true;
+}
+
+uint64_t HintEngine::hashBoard(const Board& board, GameVersion version) {
+    const ZobristKeys& keys = zobristKeys();
+    uint64_t hash = keys.sizes[board.size()] ^ keys.versions[static_cast<int>(version)];
+    for (int cell = 0; cell < board.cellCount(); ++cell) {
+        const int exponent = board.exponent(cell);
+        if (exponent != 0) {
+            hash ^= keys.cells[cell][std::min(exponent, MAX_EXPONENT - 1)];
+        }
+    }
+    return hash;
+}
+
+void HintEngine::run() {
+    while (true) {
+        SearchContext context;
+        Board board;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [this]() {
+                return quit || generation.load(std::memory_order_relaxed) != finishedGeneration;
+            });
+            if (quit) return;
+            board = pendingBoard;
+            context.version = pendingVersion;
+            context.weights = board.size() == NTupleNetwork::GRID_SIZE ? pendingWeights : nullptr;
+            context.generation = generation.load(std::memory_order_relaxed);
+        }
+
+        int order[4];
+        int count = 0;
+        for (int depth = 1; depth <= MAX_DEPTH; ++depth) {
+            bool depthLimited = false;
+            count = searchRoot(board, depth, context, order, depthLimited);
+            if (context.aborted || !depthLimited) break;
+        }
+
+        // 投机：按根局面的估值从好到坏，把每个方向之后所有可能出现的新方块局面都当作根局面搜一遍
+        for (int k = 0; k < count && !context.aborted; ++k) {
+            Board after = board;
+            MoveResult result;
+            after.move(directionFromIndex(context.version, order[k]), result);
+            for (int exponent = 1; exponent <= 2 && !context.aborted; ++exponent) {
+                for (int cell = 0; cell < after.cellCount() && !context.aborted; ++cell) {
+                    if (after.exponent(cell) != 0) continue;
+                    Board child = after;
+                    child.setExponent(cell, static_cast<uint8_t>(exponent));
+                    deepen(child, context);
+                }
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!context.aborted) {
+            finishedGeneration = context.generation;
+        }
+    }
+}
+
+void HintEngine::deepen(const Board& board, SearchContext& context) {
+    for (int depth = 1; depth <= MAX_DEPTH && !context.aborted; ++depth) {
+        bool depthLimited = false;
+        maxNode(board, hashBoard(board, context.version), depth, 1.0f, context, depthLimited);
+        if (!depthLimited) break;
+    }
+}
+
+bool HintEngine::interrupted(SearchContext& context) {
+    if (++context.nodes % INTERRUPT_CHECK_INTERVAL == 0) {
+        totalNodes.fetch_add(INTERRUPT_CHECK_INTERVAL, std::memory_order_relaxed);
+        if (generation.load(std::memory_order_relaxed) != context.generation) {
+            context.aborted = true;
+        }
+    }
+    return context.aborted;
+}
+
+int HintEngine::searchRoot(const Board& board, int depth, SearchContext& context, int* order, bool& depthLimited) {
+    float values[4];
+    int count = 0;
+    for (int i = 0; i < 4; ++i) {
+        Board after = board;
+        MoveResult result;
+        if (!after.move(directionFromIndex(context.version, i), result)) continue;
+        const float reward = context.weights ? static_cast<float>(result.scoreGained) : 0.0f;
+        values[i] = reward + chanceNode(after, depth - 1, 1.0f, context, depthLimited);
+        if (context.aborted) return 0;
+        order[count++] = i;
+    }
+    std::sort(order, order + count, [&values](int a, int b) { return values[a] > values[b]; });
+
+    HintTable::Entry entry;
+    entry.depth = depthLimited ? depth : MAX_DEPTH;
+    entry.move = count > 0 ? order[0] : -1;
+    entry.value = count > 0 ? values[order[0]] : 0.0f;
+    table.store(hashBoard(board, context.version), entry, static_cast<uint8_t>(context.generation));
+    return count;
+}
+
+float HintEngine::maxNode(const Board& board, uint64_t key, int depth, float probability, SearchContext& context,
+                          bool& depthLimited) {
+    const int level = probabilityLevel(probability);
+    HintTable::Entry entry;
+    // 表里的结果要搜得至少一样深，而且当时的累计概率不比现在小（否则它的子树剪得更多）
+    if (table.probe(key, entry) && entry.depth >= depth && entry.probabilityLevel <= level) {
+        if (entry.depth < MAX_DEPTH) depthLimited = true;
+        return entry.value;
+    }
+    if (interrupted(context)) return 0.0f;
+
+    bool limited = false;
+    entry = HintTable::Entry();
+    for (int i = 0; i < 4; ++i) {
+        Board after = board;
+        MoveResult result;
+        if (!after.move(directionFromIndex(context.version, i), result)) continue;
+        const float reward = context.weights ? static_cast<float>(result.scoreGained) : 0.0f;
+        const float value = reward + chanceNode(after, depth - 1, probability, context, limited);
+        if (context.aborted) return 0.0f;
+        if (entry.move < 0 || value > entry.value) {
+            entry.value = value;
+            entry.move = i;
+        }
+    }
+    // 无路可走的局面估值为0；没有受深度限制的结果对任何深度都成立
+    entry.depth = limited ? depth : MAX_DEPTH;
+    entry.probabilityLevel = level;
+    table.store(key, entry, static_cast<uint8_t>(context.generation));
+    depthLimited = depthLimited || limited;
+    return entry.value;
+}
+
+float HintEngine::chanceNode(const Board& after, int depth, float probability, SearchContext& context,
+                             bool& depthLimited) {
+    if (probability < PROBABILITY_THRESHOLD) {
+        return evaluate(after, context);
+    }
+    if (depth == 0) {
+        depthLimited = true;
+        return evaluate(after, context);
+    }
+    const int empty = after.emptyCount();
+    // 新方块只改一格，子局面的键在移动后局面的键上异或一项即可
+    const uint64_t afterKey = hashBoard(after, context.version);
+    const ZobristKeys& keys = zobristKeys();
+    float sum = 0.0f;
+    for (int cell = 0; cell < after.cellCount(); ++cell) {
+        if (after.exponent(cell) != 0) continue;
+        for (int exponent = 1; exponent <= 2; ++exponent) {
+            const float weight = (exponent == 1 ? SPAWN_TWO_PROBABILITY : SPAWN_FOUR_PROBABILITY) / empty;
+            Board child = after;
+            child.setExponent(cell, static_cast<uint8_t>(exponent));
+            sum += weight * maxNode(child, afterKey ^ keys.cells[cell][exponent], depth, probability * weight, context,
+                                    depthLimited);
+            if (context.aborted) return 0.0f;
+        }
+    }
+    return sum;
+}
+
+float HintEngine::evaluate(const Board& after, const SearchContext& context) const {
+    if (context.weights) {
+        return NTupleNetwork::evaluate(context.weights, packBoard(after), context.version);
+    }
+    return heuristicBoard(after);
+}
@@ -0,0 +1,118 @@
+#ifndef HINT_ENGINE_H
+#define HINT_ENGINE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include "../core/Board.h"
+
+// 提示搜索用的置换表：后台线程写、界面线程读，都不加锁。
+// 每项存两个64位字：键^数据 和 数据，两半是分别写入的，读到的组合对不上（正好有人在写）时当作没有。
+class HintTable {
+public:
+    struct Entry {
+        float value = 0.0f;
+        int depth = 0;
+        int move = -1;          // 方向下标 0-3，-1 表示无路可走
+        int probabilityLevel = 0;   // 搜索时到达这个局面的累计概率约为 2^-probabilityLevel
+    };
+
+    explicit HintTable(int bits);
+
+    bool probe(uint64_t key, Entry& entry) const;
+    // 同一局面只用搜得更充分的结果覆盖；别的局面占着位置时，旧一代的或者更浅的让位
+    void store(uint64_t key, const Entry& entry, uint8_t generation);
+
+private:
+    struct Slot {
+        std::atomic<uint64_t> check;
+        std::atomic<uint64_t> data;
+    };
+
+    static uint64_t pack(const Entry& entry, uint8_t generation);
+    static Entry unpack(uint64_t data);
+
+    int tableBits;
+    std::unique_ptr<Slot[]> slots;
+};
+
+struct HintResult {
+    bool hasMove = false;
+    Direction move = Direction::UP;
+    int depth = 0;
+};
+
+// 后台期望最大化搜索：界面每次局面变化时把新局面交给后台线程，后台线程逐层加深搜索根局面，
+// 之后趁玩家思考，按最可能的方向优先，把每个（方向, 新方块）之后的局面都当作根局面搜一遍。
+// 玩家走完一步、新方块出现后，真正的新局面在置换表里已经有结果（至少有根搜索时顺带算出的），
+// 界面线程直接查表，按键之后的下一帧就能显示提示，不需要等搜索。
+// 累计概率很小的分支不展开，所以深度到一定程度以后不再受深度限制，这样的结果直接记为 MAX_DEPTH。
+// 4x4 棋盘有 n元组网络权重时用网络估值（加上移动得分），否则用按行列统计的启发式估值。
+class HintEngine {
+public:
+    static constexpr int MAX_GRID_SIZE = 6;
+    static constexpr int MAX_DEPTH = 10;
+    static constexpr int TABLE_BITS = 20;
+
+    HintEngine();
+    ~HintEngine();
+
+    HintEngine(const HintEngine&) = delete;
+    HintEngine& operator=(const HintEngine&) = delete;
+
+    static bool supports(int gridSize) { return gridSize >= 2 && gridSize <= MAX_GRID_SIZE; }
+
+    void start();
+    void stop();
+    bool running() const { return worker.joinable(); }
+
+    // 局面变化时调用，立即返回；weights 只在 4x4 棋盘上使用，可以为空
+    void setPosition(const Board& board, GameVersion version, const float* weights);
+    // 在置换表里查局面的最佳方向
+    bool lookup(const Board& board, GameVersion version, HintResult& result) const;
+
+    uint64_t nodesSearched() const { return totalNodes.load(std::memory_order_relaxed); }
+
+private:
+    struct SearchContext {
+        uint64_t generation = 0;
+        GameVersion version = GameVersion::ORIGINAL;
+        const float* weights = nullptr;
+        uint64_t nodes = 0;
+        bool aborted = false;
+    };
+
+    void run();
+    // 搜索根局面，按估值从高到低把方向下标写入 order，返回合法方向数
+    int searchRoot(const Board& board, int depth, SearchContext& context, int* order, bool& depthLimited);
+    // 逐层加深搜索一个局面，直到结果不再受深度限制
+    void deepen(const Board& board, SearchContext& context);
+    // depthLimited：子树里是否有分支因为深度用完而停下（而不是因为概率太小）
+    float maxNode(const Board& board, uint64_t key, int depth, float probability, SearchContext& context,
+                  bool& depthLimited);
+    float chanceNode(const Board& after, int depth, float probability, SearchContext& context, bool& depthLimited);
+    float evaluate(const Board& after, const SearchContext& context) const;
+    bool interrupted(SearchContext& context);
+
+    static uint64_t hashBoard(const Board& board, GameVersion version);
+
+    HintTable table;
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable wake;
+    // 以下由 mutex 保护
+    Board pendingBoard;
+    GameVersion pendingVersion;
+    const float* pendingWeights;
+    uint64_t finishedGeneration;
+    bool quit;
+
+    std::atomic<uint64_t> generation;   // 每次 setPosition 加一，搜索中发现变了就放弃当前局面
+    std::atomic<uint64_t> totalNodes;
+};
+
+#endif // HINT_ENGINE_H
@@ -0,0 +1,499 @@
+#include "MonteCarloAdvisor.h"
+#include "../core/BoardEngine.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace {
+
+// 一段模拟不超过这么多局时不再拆分
+constexpr uint32_t GRAIN = 4;
+// 后台分析时 run 用这个代替代数，表示不会被打断
+constexpr uint64_t NEVER_ABORT = ~0ULL;
+
+// 一段模拟（方向下标, 从第 first 局开始的 count 局）压在一个64位整数里，双端队列里存的就是它
+uint64_t encodeTask(int move, uint64_t first, uint32_t count) {
+    return static_cast<uint64_t>(move) | (static_cast<uint64_t>(count) << 2) | (first << 24);
+}
+
+int taskMove(uint64_t task) { return static_cast<int>(task & 3); }
+uint32_t taskCount(uint64_t task) { return static_cast<uint32_t>((task >> 2) & ((1u << 22) - 1)); }
+uint64_t taskFirst(uint64_t task) { return task >> 24; }
+
+constexpr uint32_t MAX_TASK_COUNT = (1u << 22) - 1;
+
+uint64_t mixSeed(uint64_t seed, int move, uint64_t index) {
+    // splitmix64 的终结步骤
+    uint64_t z = seed ^ (static_cast<uint64_t>(move) << 56) ^ (index * 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+// 四个方向的全部排列，随机选一个排列后第一个能走的方向在合法方向里是均匀分布的
+const uint8_t PERMUTATIONS[24][4] = {
+    {0, 1, 2, 3}, {0, 1, 3, 2}, {0, 2, 1, 3}, {0, 2, 3, 1}, {0, 3, 1, 2}, {0, 3, 2, 1},
+    {1, 0, 2, 3}, {1, 0, 3, 2}, {1, 2, 0, 3}, {1, 2, 3, 0}, {1, 3, 0, 2}, {1, 3, 2, 0},
+    {2, 0, 1, 3}, {2, 0, 3, 1}, {2, 1, 0, 3}, {2, 1, 3, 0}, {2, 3, 0, 1}, {2, 3, 1, 0},
+    {3, 0, 1, 2}, {3, 0, 2, 1}, {3, 1, 0, 2}, {3, 1, 2, 0}, {3, 2, 0, 1}, {3, 2, 1, 0},
+};
+
+// 从 board（已经生成过新方块）开始模拟到结束或步数用完，返回模拟中得到的分数
+double playout(Board& board, Board* scratch, const BoardRules& rules, const Direction* directions,
+               PlayoutPolicy policy, int maxMoves, Rng& rng) {
+    double total = 0.0;
+    for (int step = 0; step < maxMoves; ++step) {
+        if (policy == PlayoutPolicy::RANDOM) {
+            // 走不动的方向不会改动棋盘，直接在原棋盘上按随机顺序试
+            const uint8_t* order = PERMUTATIONS[rng.bounded(24)];
+            bool moved = false;
+            for (int k = 0; k < 4 && !moved; ++k) {
+                MoveResult result;
+                moved = rules.move(board, directions[order[k]], result, nullptr);
+                total += result.scoreGained;
+            }
+            if (!moved) break;
+        } else {
+            int best = -1;
+            int bestGain = -1;
+            uint32_t ties = 0;
+            for (int k = 0; k < 4; ++k) {
+                scratch[k] = board;
+                MoveResult result;
+                if (!rules.move(scratch[k], directions[k], result, nullptr)) continue;
+                if (result.scoreGained > bestGain) {
+                    best = k;
+                    bestGain = result.scoreGained;
+                    ties = 1;
+                } else if (result.scoreGained == bestGain && rng.bounded(++ties) == 0) {
+                    best = k;
+                }
+            }
+            if (best < 0) break;
+            std::swap(board, scratch[best]);
+            total += bestGain;
+        }
+        board.spawnRandom(rng);
+    }
+    return total;
+}
+
+// Chase-Lev 工作窃取双端队列（固定容量）：所有者在底端压入和弹出，其他线程从顶端偷
+class TaskDeque {
+public:
+    static constexpr int64_t CAPACITY = 256;
+
+    TaskDeque() : top(0), bottom(0) {
+    }
+
+    // 只能由所有者调用，队列满时返回 false（调用方自己把这段做完）
+    bool push(uint64_t task) {
+        const int64_t b = bottom.load(std::memory_order_relaxed);
+        const int64_t t = top.load(std::memory_order_acquire);
+        if (b - t >= CAPACITY) return false;
+        slots[b & (CAPACITY - 1)].store(task, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom.store(b + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // 只能由所有者调用
+    bool pop(uint64_t& task) {
+        const int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+        bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = top.load(std::memory_order_relaxed);
+        if (t > b) {
+            bottom.store(b + 1, std::memory_order_relaxed);
+            return false;
+        }
+        task = slots[b & (CAPACITY - 1)].load(std::memory_order_relaxed);
+        if (t == b) {
+            // 最后一个元素，和小偷抢
+            const bool won = top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                                         std::memory_order_relaxed);
+            bottom.store(b + 1, std::memory_order_relaxed);
+            return won;
+        }
+        return true;
+    }
+
+    bool steal(uint64_t& task) {
+        int64_t t = top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const int64_t b = bottom.load(std::memory_order_acquire);
+        if (t >= b) return false;
+        task = slots[t & (CAPACITY - 1)].load(std::memory_order_relaxed);
+        return top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+    }
+
+private:
+    alignas(64) std::atomic<int64_t> top;
+    alignas(64) std::atomic<int64_t> bottom;
+    std::atomic<uint64_t> slots[CAPACITY];
+};
+
+} // namespace
+
+// 每个线程独占的队列、统计和模拟用的棋盘，按缓存行对齐，线程之间不共享写入的数据
+struct alignas(64) MonteCarloAdvisor::Worker {
+    TaskDeque deque;
+    alignas(64) double sum[4] = {};
+    double sumSquares[4] = {};
+    uint64_t count[4] = {};
+    Board board;
+    Board scratch[4];
+    Rng stealRng;
+
+    explicit Worker(unsigned index) : stealRng(index + 1) {
+    }
+
+    void resetStats() {
+        std::fill(sum, sum + 4, 0.0);
+        std::fill(sumSquares, sumSquares + 4, 0.0);
+        std::fill(count, count + 4, 0);
+    }
+};
+
+// 一轮模拟要用的只读数据
+struct MonteCarloAdvisor::Round {
+    Board after[4];         // 每个方向走完、还没生成新方块的局面
+    double rootScore[4] = {};
+    Direction directions[4];
+    const BoardRules* rules = nullptr;  // 按尺寸和版本特化的移动，每次分析选一次
+    PlayoutPolicy policy = PlayoutPolicy::RANDOM;
+    int maxPlayoutMoves = 0;
+    uint64_t seed = 0;
+    uint64_t generation = NEVER_ABORT;
+    uint64_t first[4] = {};     // 本轮每个方向从第几局开始
+    uint32_t playouts[4] = {};  // 本轮每个方向模拟几局，0 表示不模拟
+};
+
+MonteCarloAdvisor::MonteCarloAdvisor(unsigned threadCount)
+    : round(nullptr),
+      remaining(0),
+      roundNumber(0),
+      poolQuit(false),
+      pendingVersion(GameVersion::ORIGINAL),
+      finishedGeneration(0),
+      quit(false),
+      generation(0),
+      publishedVersion(GameVersion::ORIGINAL),
+      hasPublished(false) {
+    if (threadCount == 0) {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (unsigned i = 0; i < threadCount; ++i) {
+        workers.emplace_back(new Worker(i));
+    }
+    // 0号线程是调用 analyze 的线程（后台分析时是协调线程）
+    for (unsigned i = 1; i < threadCount; ++i) {
+        threads.emplace_back(&MonteCarloAdvisor::workerLoop, this, i);
+    }
+}
+
+MonteCarloAdvisor::~MonteCarloAdvisor() {
+    stop();
+    {
+        std::lock_guard<std::mutex> lock(poolMutex);
+        poolQuit = true;
+    }
+    poolWake.notify_all();
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+}
+
+MonteCarloResult MonteCarloAdvisor::analyze(const Board& board, GameVersion version,
+                                            const MonteCarloOptions& options) {
+    return run(board, version, options, NEVER_ABORT);
+}
+
+bool MonteCarloAdvisor::aborted(uint64_t generationAtStart) const {
+    return generationAtStart != NEVER_ABORT && generation.load(std::memory_order_relaxed) != generationAtStart;
+}
+
+MonteCarloResult MonteCarloAdvisor::run(const Board& board, GameVersion version, const MonteCarloOptions& options,
+                                        uint64_t generationAtStart) {
+    const auto started = std::chrono::steady_clock::now();
+    MonteCarloResult result;
+    Round current;
+    current.rules = &boardRules(board.size(), version);
+    current.policy = options.policy;
+    current.maxPlayoutMoves = std::max(1, options.maxPlayoutMoves);
+    current.seed = options.seed;
+    current.generation = generationAtStart;
+
+    int legalCount = 0;
+    int onlyMove = -1;
+    for (int i = 0; i < 4; ++i) {
+        current.directions[i] = directionFromIndex(version, i);
+        current.after[i] = board;
+        MoveResult moveResult;
+        result.moves[i].legal = current.after[i].move(current.directions[i], moveResult);
+        current.rootScore[i] = moveResult.scoreGained;
+        if (result.moves[i].legal) {
+            ++legalCount;
+            onlyMove = i;
+        }
+    }
+    // 无路可走或者只有一个方向时不需要模拟
+    if (legalCount <= 1) {
+        result.hasMove = legalCount == 1;
+        if (result.hasMove) result.move = current.directions[onlyMove];
+        result.decided = result.hasMove;
+        result.finished = true;
+        return result;
+    }
+
+    for (const std::unique_ptr<Worker>& worker : workers) {
+        worker->resetStats();
+    }
+    const uint32_t minPlayouts = std::max<uint32_t>(2, std::min(options.minPlayouts, MAX_TASK_COUNT));
+    const uint32_t maxPlayouts = std::max(minPlayouts, std::min(options.maxPlayouts, MAX_TASK_COUNT));
+    // 第一轮每个方向模拟 minPlayouts 局，之后每轮的量让每个线程都能分到几段
+    const uint32_t roundPlayouts = std::max(minPlayouts, threadCount() * GRAIN * 4);
+
+    while (true) {
+        bool any = false;
+        for (int i = 0; i < 4; ++i) {
+            const MoveEstimate& estimate = result.moves[i];
+            const uint32_t target = estimate.playouts == 0 ? minPlayouts : roundPlayouts;
+            const uint64_t left = maxPlayouts - std::min<uint64_t>(maxPlayouts, estimate.playouts);
+            current.first[i] = estimate.playouts;
+            current.playouts[i] = (estimate.legal && !estimate.pruned)
+                                      ? static_cast<uint32_t>(std::min<uint64_t>(target, left)) : 0;
+            any = any || current.playouts[i] > 0;
+        }
+        if (!any) {
+            result.finished = true;
+            break;
+        }
+
+        runRound(current);
+        if (aborted(generationAtStart)) return result;
+
+        // 汇总各线程的统计，计算每个方向的均值和置信区间
+        int leader = -1;
+        for (int i = 0; i < 4; ++i) {
+            MoveEstimate& estimate = result.moves[i];
+            if (!estimate.legal) continue;
+            double sum = 0.0;
+            double sumSquares = 0.0;
+            uint64_t count = 0;
+            for (const std::unique_ptr<Worker>& worker : workers) {
+                sum += worker->sum[i];
+                sumSquares += worker->sumSquares[i];
+                count += worker->count[i];
+            }
+            estimate.playouts = count;
+            if (count == 0) continue;
+            estimate.mean = sum / count;
+            const double variance = count > 1 ? std::max(0.0, (sumSquares - sum * estimate.mean) / (count - 1)) : 0.0;
+            estimate.halfWidth = options.z * std::sqrt(variance / count);
+            if (leader < 0 || estimate.mean > result.moves[leader].mean) leader = i;
+        }
+
+        // 上界低于领先方向下界的方向淘汰，只剩领先方向时提前结束
+        const MoveEstimate& best = result.moves[leader];
+        bool decided = true;
+        for (int i = 0; i < 4; ++i) {
+            MoveEstimate& estimate = result.moves[i];
+            if (i == leader || !estimate.legal) continue;
+            if (!estimate.pruned && estimate.mean + estimate.halfWidth < best.mean - best.halfWidth) {
+                estimate.pruned = true;
+            }
+            decided = decided && estimate.pruned;
+        }
+        result.hasMove = true;
+        result.move = current.directions[leader];
+        result.decided = decided;
+        result.playouts = 0;
+        for (const MoveEstimate& estimate : result.moves) {
+            result.playouts += estimate.playouts;
+        }
+        result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+
+        if (decided || (options.timeLimit > 0.0 && result.seconds >= options.timeLimit)) {
+            result.finished = true;
+            break;
+        }
+        if (generationAtStart != NEVER_ABORT) {
+            // 后台分析：每轮的中间结果都给界面看
+            std::lock_guard<std::mutex> lock(mutex);
+            if (generation.load(std::memory_order_relaxed) != generationAtStart) return result;
+            publishedBoard = board;
+            publishedVersion = version;
+            published = result;
+            hasPublished = true;
+        }
+    }
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    return result;
+}
+
+void MonteCarloAdvisor::runRound(Round& current) {
+    round = &current;
+    // 每个方向一段放进0号线程的队列，执行时逐次对半拆开，其他线程从队列顶端偷走大的那些
+    TaskDeque& own = workers[0]->deque;
+    int64_t total = 0;
+    uint64_t held[4];
+    int heldCount = 0;
+    for (int i = 0; i < 4; ++i) {
+        if (current.playouts[i] == 0) continue;
+        const uint64_t task = encodeTask(i, current.first[i], current.playouts[i]);
+        if (!own.push(task)) held[heldCount++] = task;
+        total += current.playouts[i];
+    }
+    remaining.store(total, std::memory_order_release);
+    if (threads.empty()) {
+        for (int i = 0; i < heldCount; ++i) execute(0, held[i]);
+        work(0);
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(poolMutex);
+        ++roundNumber;
+    }
+    poolWake.notify_all();
+    for (int i = 0; i < heldCount; ++i) execute(0, held[i]);
+    work(0);
+}
+
+void MonteCarloAdvisor::workerLoop(unsigned index) {
+    uint64_t seen = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(poolMutex);
+            poolWake.wait(lock, [&]() { return poolQuit || roundNumber != seen; });
+            if (poolQuit) return;
+            seen = roundNumber;
+        }
+        work(index);
+    }
+}
+
+void MonteCarloAdvisor::work(unsigned index) {
+    TaskDeque& own = workers[index]->deque;
+    while (remaining.load(std::memory_order_acquire) > 0) {
+        uint64_t task;
+        if (own.pop(task) || steal(index, task)) {
+            execute(index, task);
+        } else {
+            std::this_thread::yield();
+        }
+    }
+}
+
+bool MonteCarloAdvisor::steal(unsigned thief, uint64_t& task) {
+    const unsigned count = threadCount();
+    if (count < 2) return false;
+    // 从随机的一个线程开始依次试，避免所有小偷同时挤在同一个队列上
+    const unsigned start = workers[thief]->stealRng.bounded(count);
+    for (unsigned k = 0; k < count; ++k) {
+        const unsigned victim = (start + k) % count;
+        if (victim != thief && workers[victim]->deque.steal(task)) return true;
+    }
+    return false;
+}
+
+void MonteCarloAdvisor::execute(unsigned index, uint64_t task) {
+    Worker& worker = *workers[index];
+    const Round& current = *round;
+    const int move = taskMove(task);
+    const uint64_t first = taskFirst(task);
+    uint32_t count = taskCount(task);
+
+    // 后一半放回自己的队列，别的线程可以偷走；自己接着拆前一半
+    while (count > GRAIN) {
+        const uint32_t half = count / 2;
+        if (!worker.deque.push(encodeTask(move, first + count - half, half))) break;
+        count -= half;
+    }
+
+    for (uint32_t i = 0; i < count; ++i) {
+        if (aborted(current.generation)) break;
+        Rng rng(mixSeed(current.seed, move, first + i));
+        worker.board = current.after[move];
+        worker.board.spawnRandom(rng);
+        const double outcome = current.rootScore[move] +
+                               playout(worker.board, worker.scratch, *current.rules, current.directions,
+                                       current.policy, current.maxPlayoutMoves, rng);
+        worker.sum[move] += outcome;
+        worker.sumSquares[move] += outcome * outcome;
+        ++worker.count[move];
+    }
+    // 拆出去的部分由执行它们的线程各自扣除
+    remaining.fetch_sub(count, std::memory_order_acq_rel);
+}
+
+void MonteCarloAdvisor::start() {
+    if (coordinator.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        quit = false;
+    }
+    coordinator = std::thread(&MonteCarloAdvisor::coordinatorLoop, this);
+}
+
+void MonteCarloAdvisor::stop() {
+    if (!coordinator.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        quit = true;
+        hasPublished = false;
+    }
+    generation.fetch_add(1, std::memory_order_relaxed);
+    wake.notify_one();
+    coordinator.join();
+}
+
+void MonteCarloAdvisor::setPosition(const Board& board, GameVersion version, const MonteCarloOptions& options) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (board == pendingBoard && version == pendingVersion) return;
+        pendingBoard = board;
+        pendingVersion = version;
+        pendingOptions = options;
+        generation.fetch_add(1, std::memory_order_relaxed);
+    }
+    wake.notify_one();
+}
+
+bool MonteCarloAdvisor::latest(const Board& board, GameVersion version, MonteCarloResult& result) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!hasPublished || publishedBoard != board || publishedVersion != version) return false;
+    result = published;
+    return true;
+}
+
+void MonteCarloAdvisor::coordinatorLoop() {
+    while (true) {
+        Board board;
+        GameVersion version;
+        MonteCarloOptions options;
+        uint64_t generationAtStart;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [this]() {
+                return quit || generation.load(std::memory_order_relaxed) != finishedGeneration;
+            });
+            if (quit) return;
+            board = pendingBoard;
+            version = pendingVersion;
+            options = pendingOptions;
+            generationAtStart = generation.load(std::memory_order_relaxed);
+        }
+
+        const MonteCarloResult result = run(board, version, options, generationAtStart);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        finishedGeneration = generationAtStart;
+        if (generation.load(std::memory_order_relaxed) == generationAtStart) {
+            publishedBoard = board;
+            publishedVersion = version;
+            published = result;
+            hasPublished = true;
+        }
+    }
+}
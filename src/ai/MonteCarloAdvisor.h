@@ -0,0 +1,117 @@
+#ifndef MONTE_CARLO_ADVISOR_H
+#define MONTE_CARLO_ADVISOR_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "../core/Board.h"
+
+// 模拟时每一步怎么走
+enum class PlayoutPolicy {
+    RANDOM,     // 在合法方向里均匀随机
+    GREEDY      // 选本步得分最高的方向，一样高时随机（多数步骤得分都是0，所以仍然很随机）
+};
+
+struct MonteCarloOptions {
+    PlayoutPolicy policy = PlayoutPolicy::RANDOM;
+    int maxPlayoutMoves = 1000;     // 每局模拟最多走的步数（大棋盘随机走到结束要很久）
+    uint32_t minPlayouts = 64;      // 每个方向至少模拟这么多局才开始比较
+    uint32_t maxPlayouts = 4096;    // 每个方向最多模拟这么多局
+    double z = 2.58;                // 置信区间半宽 = z * 标准误，2.58 约为99%
+    double timeLimit = 0.0;         // 秒，0 表示不限
+    uint64_t seed = 1;
+};
+
+struct MoveEstimate {
+    bool legal = false;
+    bool pruned = false;        // 上界已经低于领先方向的下界，不再模拟
+    uint64_t playouts = 0;
+    double mean = 0.0;          // 这一步的得分加上之后模拟得到的分数
+    double halfWidth = 0.0;     // 置信区间的半宽
+};
+
+struct MonteCarloResult {
+    bool hasMove = false;
+    Direction move = Direction::UP;
+    bool decided = false;       // 其他方向都已被领先方向在统计上甩开
+    bool finished = false;      // 这个局面已经分析完（胜负已分、模拟数用完或时间到）
+    MoveEstimate moves[4];      // 按方向下标
+    uint64_t playouts = 0;
+    double seconds = 0.0;
+};
+
+// 蒙特卡洛走法建议：每个合法方向走一步之后随机模拟很多局，选平均得分最高的方向。
+// 模拟分轮进行，每轮结束时计算每个方向的置信区间：上界低于领先方向下界的方向不再模拟，
+// 只剩领先方向时提前结束。第 i 局模拟的随机数只由种子、方向和 i 决定，结果与线程数和调度无关。
+//
+// 模拟在工作窃取线程池上执行：每个线程有自己的双端队列（Chase-Lev，无锁），
+// 拿到一段模拟时先把后一半拆出去放回自己的队列，空闲的线程从别人队列的另一端偷；
+// 每个线程把结果累加在自己独占缓存行的统计里，轮末才汇总，模拟过程中没有共享的计数器。
+class MonteCarloAdvisor {
+public:
+    // threads 为0时使用全部CPU核心
+    explicit MonteCarloAdvisor(unsigned threads = 0);
+    ~MonteCarloAdvisor();
+
+    MonteCarloAdvisor(const MonteCarloAdvisor&) = delete;
+    MonteCarloAdvisor& operator=(const MonteCarloAdvisor&) = delete;
+
+    unsigned threadCount() const { return static_cast<unsigned>(workers.size()); }
+
+    // 同步分析，调用线程作为0号线程参与模拟。不能和后台分析同时使用
+    MonteCarloResult analyze(const Board& board, GameVersion version, const MonteCarloOptions& options);
+
+    // 后台分析（界面用）：局面变化时调用 setPosition，立即返回；每轮结束时更新结果
+    void start();
+    void stop();
+    bool running() const { return coordinator.joinable(); }
+    void setPosition(const Board& board, GameVersion version, const MonteCarloOptions& options);
+    // 取这个局面最近一轮的结果，还没有时返回 false
+    bool latest(const Board& board, GameVersion version, MonteCarloResult& result) const;
+
+private:
+    struct Worker;
+    struct Round;
+
+    MonteCarloResult run(const Board& board, GameVersion version, const MonteCarloOptions& options,
+                         uint64_t generationAtStart);
+    void runRound(Round& round);
+    void workerLoop(unsigned index);
+    void work(unsigned index);
+    bool steal(unsigned thief, uint64_t& task);
+    void execute(unsigned index, uint64_t task);
+    void coordinatorLoop();
+    bool aborted(uint64_t generationAtStart) const;
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::thread> threads;
+
+    // 当前一轮（由协调线程写好后再唤醒工作线程）
+    Round* round;
+    std::atomic<int64_t> remaining;     // 本轮还没模拟完的局数，每段模拟完成时减一次
+    std::mutex poolMutex;
+    std::condition_variable poolWake;
+    uint64_t roundNumber;
+    bool poolQuit;
+
+    // 后台分析
+    std::thread coordinator;
+    mutable std::mutex mutex;
+    std::condition_variable wake;
+    Board pendingBoard;
+    GameVersion pendingVersion;
+    MonteCarloOptions pendingOptions;
+    uint64_t finishedGeneration;
+    bool quit;
+    std::atomic<uint64_t> generation;
+    Board publishedBoard;
+    GameVersion publishedVersion;
+    MonteCarloResult published;
+    bool hasPublished;
+};
+
+#endif // MONTE_CARLO_ADVISOR_H
@@ -0,0 +1,256 @@
+#include "NTupleNetwork.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+const uint8_t WEIGHTS_MAGIC[4] = {'M', 'A', 'O', 'N'};
+constexpr uint8_t WEIGHTS_FORMAT_VERSION = 2;
+constexpr size_t TUPLE_CELLS_OFFSET = 24;
+
+// 8种对称下每个元组实际对应的格子，第一次使用时生成
+struct SymmetricTuples {
+    int cells[NTupleNetwork::TUPLE_COUNT][NTupleNetwork::SYMMETRY_COUNT][NTupleNetwork::TUPLE_LENGTH];
+
+    SymmetricTuples() {
+        const int n = NTupleNetwork::GRID_SIZE;
+        for (int t = 0; t < NTupleNetwork::TUPLE_COUNT; ++t) {
+            for (int s = 0; s < NTupleNetwork::SYMMETRY_COUNT; ++s) {
+                for (int k = 0; k < NTupleNetwork::TUPLE_LENGTH; ++k) {
+                    int x = NTupleNetwork::TUPLES[t][k] % n;
+                    int y = NTupleNetwork::TUPLES[t][k] / n;
+                    // 前4种是旋转0/90/180/270度，后4种先左右翻转再旋转
+                    if (s >= 4) x = n - 1 - x;
+                    for (int r = 0; r < s % 4; ++r) {
+                        const int rotatedX = n - 1 - y;
+                        y = x;
+                        x = rotatedX;
+                    }
+                    cells[t][s][k] = y * n + x;
+                }
+            }
+        }
+    }
+};
+
+const SymmetricTuples& symmetricTuples() {
+    static const SymmetricTuples tuples;
+    return tuples;
+}
+
+bool hostIsLittleEndian() {
+    const uint16_t probe = 1;
+    uint8_t firstByte = 0;
+    std::memcpy(&firstByte, &probe, 1);
+    return firstByte == 1;
+}
+
+bool checkHeader(const uint8_t* header, GameVersion& version, uint64_t& gamesTrained) {
+    if (std::memcmp(header, WEIGHTS_MAGIC, 4) != 0 || header[4] < 1 || header[4] > WEIGHTS_FORMAT_VERSION ||
+        header[5] != NTupleNetwork::GRID_SIZE || header[6] > static_cast<uint8_t>(GameVersion::MODIFIED) ||
+        header[7] != NTupleNetwork::TUPLE_COUNT || header[8] != NTupleNetwork::TUPLE_LENGTH) {
+        return false;
+    }
+    // 版本1的对角线权重把不等价的旋转也合在一起训练了，需要重新训练
+    if (header[4] == 1 && header[6] != static_cast<uint8_t>(GameVersion::ORIGINAL)) {
+        return false;
+    }
+    // 元组形状不同的文件，下标含义也不同
+    for (int t = 0; t < NTupleNetwork::TUPLE_COUNT; ++t) {
+        for (int k = 0; k < NTupleNetwork::TUPLE_LENGTH; ++k) {
+            if (header[TUPLE_CELLS_OFFSET + t * NTupleNetwork::TUPLE_LENGTH + k] != NTupleNetwork::TUPLES[t][k]) {
+                return false;
+            }
+        }
+    }
+    version = static_cast<GameVersion>(header[6]);
+    gamesTrained = 0;
+    for (int i = 0; i < 8; ++i) gamesTrained |= static_cast<uint64_t>(header[16 + i]) << (8 * i);
+    return true;
+}
+
+} // namespace
+
+PackedBoard packBoard(const Board& board) {
+    PackedBoard packed = 0;
+    for (int cell = 0; cell < NTupleNetwork::GRID_SIZE * NTupleNetwork::GRID_SIZE; ++cell) {
+        const uint64_t exponent = std::min<uint8_t>(board.exponent(cell), 15);
+        packed |= exponent << (4 * cell);
+    }
+    return packed;
+}
+
+// 边上一行、往里一行，角上、边上和中间的田字格；其余位置由对称变换得到
+const int NTupleNetwork::TUPLES[TUPLE_COUNT][TUPLE_LENGTH] = {
+    {0, 1, 2, 3},
+    {4, 5, 6, 7},
+    {0, 1, 4, 5},
+    {1, 2, 5, 6},
+    {5, 6, 9, 10}
+};
+
+int NTupleNetwork::features(PackedBoard board, GameVersion version, uint32_t* indices) {
+    // 经典版本用全部8种对称；对角线版本只用第0种（原样）和第4种（只左右翻转）
+    static const int CLASSIC_SYMMETRIES[SYMMETRY_COUNT] = {0, 1, 2, 3, 4, 5, 6, 7};
+    static const int DIAGONAL_SYMMETRIES[2] = {0, 4};
+    const int* symmetries = version == GameVersion::ORIGINAL ? CLASSIC_SYMMETRIES : DIAGONAL_SYMMETRIES;
+    const int count = symmetryCount(version);
+
+    const SymmetricTuples& tuples = symmetricTuples();
+    for (int t = 0; t < TUPLE_COUNT; ++t) {
+        for (int i = 0; i < count; ++i) {
+            const int s = symmetries[i];
+            uint32_t index = 0;
+            for (int k = 0; k < TUPLE_LENGTH; ++k) {
+                index |= static_cast<uint32_t>(packedExponent(board, tuples.cells[t][s][k])) << (4 * k);
+            }
+            indices[t * count + i] = t * TABLE_SIZE + index;
+        }
+    }
+    return TUPLE_COUNT * count;
+}
+
+bool chooseNTupleMove(const float* weights, const Board& board, GameVersion version, Direction& best) {
+    bool found = false;
+    float bestValue = 0.0f;
+    for (int i = 0; i < 4; ++i) {
+        const Direction dir = directionFromIndex(version, i);
+        Board after = board;
+        MoveResult result;
+        if (!after.move(dir, result)) continue;
+        const float value = result.scoreGained + NTupleNetwork::evaluate(weights, packBoard(after), version);
+        if (!found || value > bestValue) {
+            found = true;
+            bestValue = value;
+            best = dir;
+        }
+    }
+    return found;
+}
+
+NTupleWeights::NTupleWeights()
+    : mapping(nullptr), mappingSize(0), weights(nullptr), gameVersion(GameVersion::ORIGINAL), trainedGames(0) {
+}
+
+NTupleWeights::~NTupleWeights() {
+    close();
+}
+
+bool NTupleWeights::load(const std::string& filename) {
+    close();
+    // 权重按本机字节序直接使用，文件是小端的
+    if (!hostIsLittleEndian()) {
+        std::cerr << "N-tuple weights require a little-endian host: " << filename << std::endl;
+        return false;
+    }
+
+#ifdef _WIN32
+    FILE* file = fopen(filename.c_str(), "rb");
+    if (!file) return false;
+    uint8_t header[HEADER_SIZE];
+    bool ok = fread(header, 1, HEADER_SIZE, file) == HEADER_SIZE && checkHeader(header, gameVersion, trainedGames);
+    if (ok) {
+        fallback.resize(NTupleNetwork::WEIGHT_COUNT);
+        ok = fread(fallback.data(), sizeof(float), fallback.size(), file) == fallback.size();
+    }
+    fclose(file);
+    if (!ok) {
+        std::cerr << "Invalid n-tuple weights file: " << filename << std::endl;
+        fallback.clear();
+        return false;
+    }
+    weights = fallback.data();
+#else
+    const size_t expectedSize = HEADER_SIZE + static_cast<size_t>(NTupleNetwork::WEIGHT_COUNT) * sizeof(float);
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat info;
+    if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) != expectedSize) {
+        std::cerr << "Invalid n-tuple weights file size: " << filename << std::endl;
+        ::close(fd);
+        return false;
+    }
+    void* mapped = mmap(nullptr, expectedSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        std::cerr << "Failed to map n-tuple weights file: " << filename << std::endl;
+        return false;
+    }
+    if (!checkHeader(static_cast<const uint8_t*>(mapped), gameVersion, trainedGames)) {
+        std::cerr << "Invalid n-tuple weights file: " << filename << std::endl;
+        munmap(mapped, expectedSize);
+        return false;
+    }
+    mapping = mapped;
+    mappingSize = expectedSize;
+    weights = reinterpret_cast<const float*>(static_cast<const uint8_t*>(mapped) + HEADER_SIZE);
+#endif
+    return true;
+}
+
+void NTupleWeights::close() {
+#ifndef _WIN32
+    if (mapping) {
+        munmap(mapping, mappingSize);
+    }
+#endif
+    mapping = nullptr;
+    mappingSize = 0;
+    fallback.clear();
+    fallback.shrink_to_fit();
+    weights = nullptr;
+    trainedGames = 0;
+}
+
+bool NTupleWeights::save(const std::string& filename, GameVersion version, uint64_t gamesTrained,
+                         const std::vector<float>& weights) {
+    if (weights.size() != NTupleNetwork::WEIGHT_COUNT || !hostIsLittleEndian()) {
+        std::cerr << "Cannot write n-tuple weights: " << filename << std::endl;
+        return false;
+    }
+
+    uint8_t header[HEADER_SIZE] = {};
+    std::memcpy(header, WEIGHTS_MAGIC, 4);
+    header[4] = WEIGHTS_FORMAT_VERSION;
+    header[5] = NTupleNetwork::GRID_SIZE;
+    header[6] = static_cast<uint8_t>(version);
+    header[7] = NTupleNetwork::TUPLE_COUNT;
+    header[8] = NTupleNetwork::TUPLE_LENGTH;
+    for (int i = 0; i < 8; ++i) header[16 + i] = static_cast<uint8_t>(gamesTrained >> (8 * i));
+    for (int t = 0; t < NTupleNetwork::TUPLE_COUNT; ++t) {
+        for (int k = 0; k < NTupleNetwork::TUPLE_LENGTH; ++k) {
+            header[TUPLE_CELLS_OFFSET + t * NTupleNetwork::TUPLE_LENGTH + k] =
+                static_cast<uint8_t>(NTupleNetwork::TUPLES[t][k]);
+        }
+    }
+
+    // 先写临时文件再改名，训练中途被打断也不会留下半个权重文件
+    std::string tempName = filename + ".tmp";
+    FILE* out = fopen(tempName.c_str(), "wb");
+    if (!out) {
+        std::cerr << "Failed to create n-tuple weights file: " << tempName << std::endl;
+        return false;
+    }
+    bool ok = fwrite(header, 1, HEADER_SIZE, out) == HEADER_SIZE &&
+              fwrite(weights.data(), sizeof(float), weights.size(), out) == weights.size();
+    ok = fclose(out) == 0 && ok;
+
+    if (!ok || std::rename(tempName.c_str(), filename.c_str()) != 0) {
+        std::cerr << "Failed to write n-tuple weights file: " << filename << std::endl;
+        return false;
+    }
+    return true;
+}
+
+std::string NTupleWeights::defaultPath(GameVersion version) {
+    return std::string("weights/4x4_") + (version == GameVersion::ORIGINAL ? "classic" : "diagonal") + ".ntw";
+}
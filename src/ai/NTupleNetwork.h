@@ -0,0 +1,96 @@
+#ifndef NTUPLE_NETWORK_H
+#define NTUPLE_NETWORK_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "../core/Board.h"
+
+// 4x4 棋盘压缩成一个64位整数，每格4位（行优先，第0格在最低位），指数超过15时按15计
+using PackedBoard = uint64_t;
+
+PackedBoard packBoard(const Board& board);
+inline int packedExponent(PackedBoard board, int cell) { return static_cast<int>((board >> (4 * cell)) & 0xF); }
+
+// n元组网络估值：2个4格直线元组和3个2x2方块元组，每个元组在规则的对称变换下共用一张权重表。
+// 经典版本在8种旋转/翻转下都等价，合起来覆盖所有行、列和田字格，估值是 5x8 个特征对应权重之和；
+// 对角线版本只在左右翻转下等价（见 WinSolver），每个元组只有原样和左右翻转两个特征，共 5x2 个。
+// 只用于 4x4 棋盘。
+// 每张表 16^4 项，整个网络只有约1.3MB，训练时常驻缓存，游戏里直接映射文件使用。
+// 权重按“移动后、生成新方块前”的局面训练，估计的是从这里开始还能得到的分数。
+class NTupleNetwork {
+public:
+    static constexpr int GRID_SIZE = 4;
+    static constexpr int TUPLE_COUNT = 5;
+    static constexpr int TUPLE_LENGTH = 4;
+    static constexpr int SYMMETRY_COUNT = 8;
+    // 特征数的上限（经典版本），调用方按它开数组
+    static constexpr int FEATURE_COUNT = TUPLE_COUNT * SYMMETRY_COUNT;
+    static constexpr uint32_t TABLE_SIZE = 1u << (4 * TUPLE_LENGTH);
+    static constexpr uint32_t WEIGHT_COUNT = TUPLE_COUNT * TABLE_SIZE;
+
+    // 每个元组在未变换的棋盘上的格子
+    static const int TUPLES[TUPLE_COUNT][TUPLE_LENGTH];
+
+    // 该版本规则下等价的对称变换数：经典8种，对角线只有原样和左右翻转2种
+    static int symmetryCount(GameVersion version) { return version == GameVersion::ORIGINAL ? SYMMETRY_COUNT : 2; }
+    static int featureCount(GameVersion version) { return TUPLE_COUNT * symmetryCount(version); }
+
+    // 局面的全部特征在权重数组中的下标，返回写入的个数 featureCount(version)
+    static int features(PackedBoard board, GameVersion version, uint32_t* indices);
+
+    static float evaluate(const float* weights, PackedBoard board, GameVersion version) {
+        uint32_t indices[FEATURE_COUNT];
+        const int count = features(board, version, indices);
+        float value = 0.0f;
+        for (int i = 0; i < count; ++i) {
+            value += weights[indices[i]];
+        }
+        return value;
+    }
+};
+
+// 按网络一步贪心选择方向：使 移动得分 + 移动后局面估值 最大
+// 没有合法移动时返回 false
+bool chooseNTupleMove(const float* weights, const Board& board, GameVersion version, Direction& best);
+
+// 权重文件（小端）：
+//   64字节头: "MAON" | 格式版本 | 棋盘尺寸 | GameVersion | 元组数 | 元组长度 | 保留(7) |
+//             已训练局数(8字节) | 各元组的格子(元组数 x 元组长度) | 补零到64字节
+//   之后是 WEIGHT_COUNT 个 float32，顺序与 NTupleNetwork::features 的下标一致。
+//   格式版本1的对角线权重是按8种对称训练的，与规则不符，不再接受；经典版本的版本1文件照常可用。
+// 游戏启动时整个文件只读映射进内存，权重直接在映射上读取，不复制也不解析。
+class NTupleWeights {
+public:
+    static constexpr size_t HEADER_SIZE = 64;
+
+    NTupleWeights();
+    ~NTupleWeights();
+
+    NTupleWeights(const NTupleWeights&) = delete;
+    NTupleWeights& operator=(const NTupleWeights&) = delete;
+
+    bool load(const std::string& filename);
+    void close();
+
+    bool isLoaded() const { return weights != nullptr; }
+    const float* data() const { return weights; }
+    GameVersion version() const { return gameVersion; }
+    uint64_t gamesTrained() const { return trainedGames; }
+
+    static bool save(const std::string& filename, GameVersion version, uint64_t gamesTrained,
+                     const std::vector<float>& weights);
+    // weights/4x4_<classic|diagonal>.ntw
+    static std::string defaultPath(GameVersion version);
+
+private:
+    void* mapping;
+    size_t mappingSize;
+    std::vector<float> fallback;    // 不支持 mmap 的平台上整体读入
+    const float* weights;
+    GameVersion gameVersion;
+    uint64_t trainedGames;
+};
+
+#endif // NTUPLE_NETWORK_H
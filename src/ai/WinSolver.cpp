@@ -0,0 +1,473 @@
+#include "WinSolver.h"
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
+namespace {
+
+// 新方块：80% 为2，20% 为4（与 Board::spawnRandom 一致）
+constexpr double SPAWN_TWO_PROBABILITY = 0.8;
+constexpr double SPAWN_FOUR_PROBABILITY = 0.2;
+constexpr double CERTAIN = 1.0 - 1e-12;
+constexpr int PROOF_SLACK = 4;
+// supports() 保证格子数乘以每格位数不超过64，每格至少2位
+constexpr int MAX_CELLS = 32;
+// 每展开这么多局面检查一次时限、其他线程和局面是否已经变了
+constexpr uint64_t INTERRUPT_CHECK_MASK = 255;
+
+uint64_t doubleBits(double value) {
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+double bitsDouble(uint64_t bits) {
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+int bitWidth(int value) {
+    int bits = 0;
+    while ((1 << bits) <= value) ++bits;
+    return bits;
+}
+
+} // namespace
+
+SolverTable::SolverTable(int bits)
+    : tableBits(bits), slots(new Slot[size_t(1) << bits]), halfSums(new std::atomic<uint16_t>[size_t(1) << bits]),
+      floorHalfSum(0), count(0) {
+    clear();
+}
+
+uint16_t SolverTable::halfSum(int tileSum) {
+    return static_cast<uint16_t>(std::min(tileSum / 2, 0xFFFF));
+}
+
+SolverTable::Slot* SolverTable::bucket(uint64_t key) const {
+    const size_t index = static_cast<size_t>((key * 0x9E3779B97F4A7C15ULL) >> (64 - tableBits));
+    return &slots[index & ~static_cast<size_t>(BUCKET_SLOTS - 1)];
+}
+
+bool SolverTable::find(uint64_t key, double& value) const {
+    const Slot* group = bucket(key);
+    for (int i = 0; i < BUCKET_SLOTS; ++i) {
+        const uint64_t data = group[i].data.load(std::memory_order_relaxed);
+        const uint64_t check = group[i].check.load(std::memory_order_relaxed);
+        if ((check ^ data) == key) {
+            value = bitsDouble(data);
+            return true;
+        }
+    }
+    return false;
+}
+
+void SolverTable::insert(uint64_t key, double value, int tileSum) {
+    // 键为0的只有空棋盘，不会出现；空槽的两个字都是0，查0时会误判
+    if (key == 0) return;
+    Slot* group = bucket(key);
+    const size_t first = static_cast<size_t>(group - slots.get());
+    const uint16_t floor = floorHalfSum.load(std::memory_order_relaxed);
+    int victim = 0;
+    int victimRank = -1;
+    for (int i = 0; i < BUCKET_SLOTS; ++i) {
+        const uint64_t data = group[i].data.load(std::memory_order_relaxed);
+        const uint64_t check = group[i].check.load(std::memory_order_relaxed);
+        // 同一局面的结果总是相同的，覆盖也无妨
+        if ((check ^ data) == key) {
+            victim = i;
+            break;
+        }
+        if (check == 0 && data == 0) {
+            victim = i;
+            count.fetch_add(1, std::memory_order_relaxed);
+            break;
+        }
+        const uint16_t sum = halfSums[first + i].load(std::memory_order_relaxed);
+        const int rank = sum < floor ? 0x10000 : sum;
+        if (rank > victimRank) {
+            victimRank = rank;
+            victim = i;
+        }
+    }
+    const uint64_t data = doubleBits(value);
+    group[victim].data.store(data, std::memory_order_relaxed);
+    group[victim].check.store(key ^ data, std::memory_order_relaxed);
+    halfSums[first + victim].store(halfSum(tileSum), std::memory_order_relaxed);
+}
+
+void SolverTable::setFloor(int tileSum) {
+    floorHalfSum.store(halfSum(tileSum), std::memory_order_relaxed);
+}
+
+void SolverTable::clear() {
+    const size_t capacity = size_t(1) << tableBits;
+    for (size_t i = 0; i < capacity; ++i) {
+        slots[i].check.store(0, std::memory_order_relaxed);
+        slots[i].data.store(0, std::memory_order_relaxed);
+        halfSums[i].store(0, std::memory_order_relaxed);
+    }
+    floorHalfSum.store(0, std::memory_order_relaxed);
+    count.store(0, std::memory_order_relaxed);
+}
+
+bool WinSolver::supports(int gridSize, int targetExponent) {
+    return gridSize >= 2 && targetExponent >= 3 && gridSize * gridSize * bitWidth(targetExponent - 1) <= 64;
+}
+
+WinSolver::WinSolver(int gridSize, GameVersion version, int targetExponent, int tableBits, unsigned threads)
+    : n(gridSize), gameVersion(version), target(targetExponent), bitsPerCell(bitWidth(targetExponent - 1)),
+      table(tableBits), threads(threads != 0 ? threads : std::max(1u, std::thread::hardware_concurrency())),
+      pendingTimeLimit(0), finishedGeneration(0), quit(false), generation(0),
+      publishedProgress(Progress::SOLVING), hasPublished(false) {
+    // 前4种是旋转0/90/180/270度，后4种先左右翻转再旋转；对角线版本只保留不变和左右翻转
+    const std::vector<int> used = version == GameVersion::ORIGINAL
+        ? std::vector<int>{0, 1, 2, 3, 4, 5, 6, 7} : std::vector<int>{0, 4};
+    symmetryCount = static_cast<int>(used.size());
+    symmetryShifts.resize(n * n * symmetryCount);
+    for (int k = 0; k < symmetryCount; ++k) {
+        const int s = used[k];
+        for (int cell = 0; cell < n * n; ++cell) {
+            int x = cell % n;
+            int y = cell / n;
+            if (s >= 4) x = n - 1 - x;
+            for (int r = 0; r < s % 4; ++r) {
+                const int rotatedX = n - 1 - y;
+                y = x;
+                x = rotatedX;
+            }
+            symmetryShifts[cell * symmetryCount + k] = static_cast<uint8_t>(bitsPerCell * (y * n + x));
+        }
+    }
+}
+
+WinSolver::~WinSolver() {
+    stop();
+}
+
+uint64_t WinSolver::canonicalKey(const Board& board) const {
+    // 一次遍历同时算出所有等价变换下的键，空格不用处理
+    uint64_t keys[8] = {};
+    const uint8_t* shifts = symmetryShifts.data();
+    for (int cell = 0; cell < n * n; ++cell, shifts += symmetryCount) {
+        const uint64_t exponent = board.exponent(cell);
+        if (exponent == 0) continue;
+        for (int k = 0; k < symmetryCount; ++k) {
+            keys[k] |= exponent << shifts[k];
+        }
+    }
+    return *std::min_element(keys, keys + symmetryCount);
+}
+
+bool WinSolver::reachedTarget(const Board& board) const {
+    return board.maxExponent() >= target;
+}
+
+int WinSolver::legalMoves(const Board& board, Board* afters, Direction* directions) const {
+    int count = 0;
+    for (int i = 0; i < 4; ++i) {
+        const Direction dir = directionFromIndex(gameVersion, i);
+        Board after = board;
+        MoveResult result;
+        if (after.move(dir, result)) {
+            afters[count] = after;
+            directions[count] = dir;
+            ++count;
+        }
+    }
+    // 先试合成出更大数字、空格更多的走法，更早找到必胜的走法就能跳过其余方向（最多4个，直接插入排序）
+    int keys[4];
+    for (int i = 0; i < count; ++i) {
+        keys[i] = afters[i].maxExponent() * 64 + afters[i].emptyCount();
+    }
+    for (int i = 1; i < count; ++i) {
+        for (int j = i; j > 0 && keys[j] > keys[j - 1]; --j) {
+            std::swap(keys[j], keys[j - 1]);
+            std::swap(afters[j], afters[j - 1]);
+            std::swap(directions[j], directions[j - 1]);
+        }
+    }
+    return count;
+}
+
+double WinSolver::expectAfterMove(const Board& after, SearchContext& context, double alpha, bool& pruned) {
+    pruned = false;
+    if (reachedTarget(after)) return 1.0;
+
+    // 从这个线程的起点开始轮流试各个空格，但最后按格子顺序求和，各线程和冷热表算出的结果完全相同
+    int empties[MAX_CELLS];
+    int empty = 0;
+    for (int cell = 0; cell < n * n; ++cell) {
+        if (after.exponent(cell) == 0) empties[empty++] = cell;
+    }
+    double values[2 * MAX_CELLS];
+    double sum = 0.0;
+    double remaining = 1.0;
+    for (int i = 0, k = context.spawnOffset % empty; i < empty; ++i, k = k + 1 == empty ? 0 : k + 1) {
+        for (int exponent = 1; exponent <= 2; ++exponent) {
+            const double weight = (exponent == 1 ? SPAWN_TWO_PROBABILITY : SPAWN_FOUR_PROBABILITY) / empty;
+            Board child = after;
+            child.setExponent(empties[k], static_cast<uint8_t>(exponent));
+            const double value = search(child, context, nullptr);
+            if (context.aborted) return 0.0;
+            values[2 * k + exponent - 1] = value;
+            sum += weight * value;
+            remaining -= weight;
+            // 剩下的分支全部必胜也追不上已有的走法
+            if (sum + remaining <= alpha) {
+                pruned = true;
+                return sum;
+            }
+        }
+    }
+    if (context.spawnOffset % empty == 0) return sum;
+    sum = 0.0;
+    for (int k = 0; k < empty; ++k) {
+        sum += SPAWN_TWO_PROBABILITY / empty * values[2 * k];
+        sum += SPAWN_FOUR_PROBABILITY / empty * values[2 * k + 1];
+    }
+    return sum;
+}
+
+int WinSolver::tileSum(const Board& board) const {
+    int sum = 0;
+    for (int cell = 0; cell < n * n; ++cell) {
+        const int exponent = board.exponent(cell);
+        if (exponent != 0) sum += 1 << exponent;
+    }
+    return sum;
+}
+
+bool WinSolver::proveWithin(const Board& board, int moves, SearchContext& context) {
+    // 新方块可以一直是2：剩下的步数里数字总和都凑不够目标，就不可能保证赢
+    const int sum = tileSum(board);
+    if (sum + 2 * (moves - 1) < (1 << target)) return false;
+
+    const uint64_t key = canonicalKey(board);
+    double cached = 0.0;
+    if (table.find(key, cached)) {
+        if (cached >= CERTAIN) return true;
+        // 负数 -k 表示 k 步之内不能保证赢；非负的精确概率小于1表示永远不能保证
+        if (cached >= 0.0 || -cached >= moves) return false;
+    }
+
+    if (interrupted(context)) return false;
+
+    Board afters[4];
+    Direction directions[4];
+    const int count = legalMoves(board, afters, directions);
+    for (int i = 0; i < count; ++i) {
+        if (reachedTarget(afters[i])) {
+            table.insert(key, 1.0, sum);
+            return true;
+        }
+        if (moves == 1) continue;
+        // 每个空格出现2或4之后都必须还能保证赢，有一个不行就换下一个方向。
+        // 同一层上次的反例往往还是反例，先试它；其余的从这个线程的起点开始轮流试
+        int& killer = context.killers[std::min(moves, SearchContext::KILLER_DEPTHS - 1)];
+        const int spawns = 2 * n * n;
+        bool certain = true;
+        for (int k = -1; k < spawns && certain; ++k) {
+            const int spawn = k < 0 ? killer : (k + 2 * context.spawnOffset) % spawns;
+            if (spawn < 0 || (k >= 0 && spawn == killer)) continue;
+            const int cell = spawn >> 1;
+            if (afters[i].exponent(cell) != 0) continue;
+            Board child = afters[i];
+            child.setExponent(cell, static_cast<uint8_t>((spawn & 1) + 1));
+            certain = proveWithin(child, moves - 1, context);
+            if (context.aborted) return false;
+            if (!certain) killer = spawn;
+        }
+        if (certain) {
+            table.insert(key, 1.0, sum);
+            return true;
+        }
+    }
+    table.insert(key, -static_cast<double>(moves), sum);
+    return false;
+}
+
+bool WinSolver::proveCertain(const Board& board, SearchContext& context) {
+    // 逐步加深：先找步数少的必胜走法，走错方向时很快就能在浅层被否定，不会一路搜到底。
+    // 反驳“k 步内能保证赢”的代价随 k 成倍增长，所以只比最少步数多看 PROOF_SLACK 步，
+    // 证明不了就交给 search 求精确期望（返回 false 只表示没证明出来）
+    const int minMoves = std::max(1, ((1 << target) - tileSum(board) + 1) / 2 + 1);
+    for (int moves = minMoves; moves <= minMoves + PROOF_SLACK; ++moves) {
+        if (proveWithin(board, moves, context)) return true;
+        if (context.aborted) return false;
+    }
+    return false;
+}
+
+double WinSolver::search(const Board& board, SearchContext& context, WinChance* root) {
+    const uint64_t key = canonicalKey(board);
+    double cached = 0.0;
+    const bool known = table.find(key, cached);
+    if (!root && known && cached >= 0.0) return cached;
+
+    // 空旷的局面绝大多数是必胜的，先只判断能不能保证赢，比算出精确概率省得多；
+    // 只有证明不了的局面（通常已经很拥挤、分支很少）才展开求期望
+    if (!root) {
+        if (proveCertain(board, context)) return 1.0;
+        if (context.aborted) return 0.0;
+    }
+
+    if (interrupted(context)) return 0.0;
+
+    Board afters[4];
+    Direction directions[4];
+    const int count = legalMoves(board, afters, directions);
+    double best = 0.0;
+    for (int i = 0; i < count; ++i) {
+        bool pruned = false;
+        const double value = expectAfterMove(afters[i], context, best, pruned);
+        if (context.aborted) return 0.0;
+        if (!pruned && (value > best || (root && !root->hasMove))) {
+            best = value;
+            if (root) {
+                root->hasMove = true;
+                root->bestMove = directions[i];
+            }
+        }
+        if (best >= CERTAIN) {
+            // 各分支的1加权求和可能差一点点才到1，统一记成1，冷热表算出的结果才完全相同
+            best = 1.0;
+            break;
+        }
+    }
+
+    table.insert(key, best, tileSum(board));
+    if (root) root->probability = best;
+    return best;
+}
+
+bool WinSolver::interrupted(SearchContext& context) {
+    if (context.aborted) return true;
+    if ((++context.nodes & INTERRUPT_CHECK_MASK) != 0) return false;
+    if (context.halt->load(std::memory_order_relaxed) ||
+        (context.background && generation.load(std::memory_order_relaxed) != context.generation)) {
+        context.aborted = true;
+    } else if (context.timed && std::chrono::steady_clock::now() >= context.deadline) {
+        context.aborted = true;
+        context.halt->store(true, std::memory_order_relaxed);
+    }
+    return context.aborted;
+}
+
+bool WinSolver::solve(const Board& board, WinChance& result, std::chrono::milliseconds timeLimit) {
+    return solveFrom(board, result, timeLimit, false, 0);
+}
+
+bool WinSolver::solveFrom(const Board& board, WinChance& result, std::chrono::milliseconds timeLimit,
+                          bool background, uint64_t generationAtStart) {
+    result = WinChance();
+    if (reachedTarget(board)) {
+        result.probability = 1.0;
+        return true;
+    }
+    // 数字总和只增不减，比根局面小的局面以后再也查不到了，表满时先让出来
+    table.setFloor(tileSum(board));
+
+    std::atomic<bool> halt(false);
+    std::atomic<int> finisher(-1);
+    std::vector<WinChance> results(threads);
+    const auto deadline = std::chrono::steady_clock::now() + timeLimit;
+    auto work = [&](unsigned index) {
+        SearchContext context;
+        context.spawnOffset = static_cast<int>(index * static_cast<unsigned>(n * n) / threads);
+        context.halt = &halt;
+        context.timed = timeLimit.count() > 0;
+        context.deadline = deadline;
+        context.background = background;
+        context.generation = generationAtStart;
+        search(board, context, &results[index]);
+        if (!context.aborted) {
+            int none = -1;
+            finisher.compare_exchange_strong(none, static_cast<int>(index));
+            halt.store(true, std::memory_order_relaxed);
+        }
+    };
+    std::vector<std::thread> pool;
+    for (unsigned t = 1; t < threads; ++t) {
+        pool.emplace_back(work, t);
+    }
+    work(0);
+    for (std::thread& thread : pool) {
+        thread.join();
+    }
+
+    const int index = finisher.load();
+    if (index < 0) return false;
+    result = results[index];
+    return true;
+}
+
+void WinSolver::start() {
+    if (worker.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        quit = false;
+    }
+    worker = std::thread(&WinSolver::run, this);
+}
+
+void WinSolver::stop() {
+    if (!worker.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        quit = true;
+    }
+    generation.fetch_add(1, std::memory_order_relaxed);
+    wake.notify_one();
+    worker.join();
+}
+
+void WinSolver::setPosition(const Board& board, std::chrono::milliseconds timeLimit) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (board == pendingBoard && timeLimit == pendingTimeLimit) return;
+        pendingBoard = board;
+        pendingTimeLimit = timeLimit;
+        generation.fetch_add(1, std::memory_order_relaxed);
+    }
+    wake.notify_one();
+}
+
+WinSolver::Progress WinSolver::latest(const Board& board, WinChance& result) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!hasPublished || publishedBoard != board) return Progress::SOLVING;
+    result = published;
+    return publishedProgress;
+}
+
+void WinSolver::run() {
+    while (true) {
+        Board board;
+        std::chrono::milliseconds timeLimit;
+        uint64_t generationAtStart;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [this]() {
+                return quit || generation.load(std::memory_order_relaxed) != finishedGeneration;
+            });
+            if (quit) return;
+            board = pendingBoard;
+            timeLimit = pendingTimeLimit;
+            generationAtStart = generation.load(std::memory_order_relaxed);
+        }
+
+        WinChance chance;
+        const bool solved = solveFrom(board, chance, timeLimit, true, generationAtStart);
+
+        // 局面中途变了的结果不发布，下一轮接着算新局面
+        std::lock_guard<std::mutex> lock(mutex);
+        finishedGeneration = generationAtStart;
+        if (generation.load(std::memory_order_relaxed) == generationAtStart) {
+            publishedBoard = board;
+            published = chance;
+            publishedProgress = solved ? Progress::SOLVED : Progress::TIMED_OUT;
+            hasPublished = true;
+        }
+    }
+}
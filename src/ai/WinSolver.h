@@ -0,0 +1,159 @@
+#ifndef WIN_SOLVER_H
+#define WIN_SOLVER_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "../core/Board.h"
+
+// 多线程共用的定长哈希表（不加锁）：每 BUCKET_SLOTS 个槽一组，正好一条缓存行。
+// 每个槽存两个64位字：键^值 和 值，两半是分别写入的，读到对不上的组合（正好有人在写）时当作没有。
+// 组满时挤掉一个：数字总和比 floor 小的局面（从当前根局面再也走不到）最先让位，其次是总和最大、重算最快的。
+// 所以表不会被占满而停住，只是被挤掉的结果要重算，只影响速度不影响正确性。
+class SolverTable {
+public:
+    explicit SolverTable(int bits);
+
+    bool find(uint64_t key, double& value) const;
+    // tileSum 是局面的数字总和，只用来挑被挤掉的局面
+    void insert(uint64_t key, double value, int tileSum);
+    // 之后只会查数字总和不小于 tileSum 的局面
+    void setFloor(int tileSum);
+    // 调用时不能有其他线程在使用
+    void clear();
+    size_t size() const { return count.load(std::memory_order_relaxed); }
+
+private:
+    struct Slot {
+        std::atomic<uint64_t> check;    // 键 ^ data；两个字都为0是空槽
+        std::atomic<uint64_t> data;
+    };
+    static constexpr int BUCKET_SLOTS = 4;
+
+    static uint16_t halfSum(int tileSum);
+    Slot* bucket(uint64_t key) const;
+
+    int tableBits;
+    std::unique_ptr<Slot[]> slots;
+    std::unique_ptr<std::atomic<uint16_t>[]> halfSums;     // 各槽局面数字总和的一半
+    std::atomic<uint16_t> floorHalfSum;
+    std::atomic<size_t> count;
+};
+
+struct WinChance {
+    double probability = 0.0;   // 最优走法下最终合成出目标数值的概率
+    bool hasMove = false;
+    Direction bestMove = Direction::UP;
+};
+
+// 精确求解“最优走法下合成出 2^targetExponent 的概率”。
+// 目标出现之前每格的指数都小于目标，按固定位数压缩成一个64位键；
+// 等价局面（经典版本8种旋转/翻转，对角线版本因为向下移动从远端处理，只有左右翻转）合并成一个键。
+// 每步移动后数字总和增加2或4，而不出现目标时总和有上限，所以搜索一定会结束。
+// 求解在多个线程上进行：所有线程都从根局面出发，在每个新方块节点上从不同的空格开始试，
+// 分头展开不同的子树，算完的子局面通过共用的表互相复用；第一个算完的线程给出结果，其余的随即停下。
+// 新方块节点总是按格子顺序求和，结果与线程数和调度无关。
+class WinSolver {
+public:
+    enum class Progress {
+        SOLVING,
+        SOLVED,
+        TIMED_OUT       // 时限内没算完（对角线版本开局附近的空旷局面往往如此）
+    };
+
+    // 指数的位数乘以格子数不能超过64
+    static bool supports(int gridSize, int targetExponent);
+
+    // threads 为0时使用全部CPU核心
+    WinSolver(int gridSize, GameVersion version, int targetExponent, int tableBits = 22, unsigned threads = 0);
+    ~WinSolver();
+
+    WinSolver(const WinSolver&) = delete;
+    WinSolver& operator=(const WinSolver&) = delete;
+
+    int gridSize() const { return n; }
+    GameVersion version() const { return gameVersion; }
+    int targetExponent() const { return target; }
+    unsigned threadCount() const { return threads; }
+
+    // 同步求解，调用线程作为0号线程参与。timeLimit 不为0时最多算这么久，超出时返回 false；
+    // 已经算完的局面留在表里，从同一局面重新开始或者走到它的后续局面时会快得多。不能和后台求解同时使用
+    bool solve(const Board& board, WinChance& result, std::chrono::milliseconds timeLimit = std::chrono::milliseconds(0));
+
+    // 后台求解（界面用）：局面变化时调用 setPosition，立即返回；表在整局里保留
+    void start();
+    void stop();
+    bool running() const { return worker.joinable(); }
+    void setPosition(const Board& board, std::chrono::milliseconds timeLimit);
+    // 这个局面的求解进度，SOLVED 时 result 为结果
+    Progress latest(const Board& board, WinChance& result) const;
+
+    void clear() { table.clear(); }
+    size_t tableSize() const { return table.size(); }
+
+private:
+    struct SearchContext {
+        uint64_t nodes = 0;
+        bool aborted = false;
+        int spawnOffset = 0;        // 新方块节点从第几个空格开始试，各线程不同
+        std::atomic<bool>* halt = nullptr;      // 别的线程已经算完或者超时
+        bool timed = false;
+        std::chrono::steady_clock::time_point deadline;
+        bool background = false;
+        uint64_t generation = 0;    // 后台求解开始时的局面代数，变了就放弃
+        // 每个剩余步数上一次驳倒某个方向的新方块（格子 * 2 + 是否为4）
+        static constexpr int KILLER_DEPTHS = 64;
+        int killers[KILLER_DEPTHS];
+        SearchContext() { std::fill(killers, killers + KILLER_DEPTHS, -1); }
+    };
+
+    bool solveFrom(const Board& board, WinChance& result, std::chrono::milliseconds timeLimit, bool background,
+                   uint64_t generationAtStart);
+    void run();
+    bool interrupted(SearchContext& context);
+
+    uint64_t canonicalKey(const Board& board) const;
+    // 返回局面（轮到玩家移动）的获胜概率；中途被打断时返回值无意义
+    double search(const Board& board, SearchContext& context, WinChance* root);
+    // 只判断能否保证赢（概率为1）：与或树搜索，找到一个反例就换方向，比求期望剪掉的分支多得多。
+    // 结果也记在表里：1 表示能保证赢，-k 表示 k 步之内不能
+    bool proveCertain(const Board& board, SearchContext& context);
+    bool proveWithin(const Board& board, int moves, SearchContext& context);
+    int tileSum(const Board& board) const;
+    // 移动后局面的期望：按生成规则对每个空格的2和4加权；alpha 为剪枝下界，结果不超过它时提前返回
+    double expectAfterMove(const Board& after, SearchContext& context, double alpha, bool& pruned);
+    bool reachedTarget(const Board& board) const;
+    int legalMoves(const Board& board, Board* afters, Direction* directions) const;
+
+    int n;
+    GameVersion gameVersion;
+    int target;
+    int bitsPerCell;
+    int symmetryCount;
+    std::vector<uint8_t> symmetryShifts;    // [格子 * symmetryCount + 变换]：该格在这种变换下的键中的位移
+    SolverTable table;
+    unsigned threads;
+
+    // 后台求解
+    std::thread worker;
+    mutable std::mutex mutex;
+    std::condition_variable wake;
+    Board pendingBoard;
+    std::chrono::milliseconds pendingTimeLimit;
+    uint64_t finishedGeneration;
+    bool quit;
+    std::atomic<uint64_t> generation;   // 每次 setPosition 加一
+    Board publishedBoard;
+    WinChance published;
+    Progress publishedProgress;
+    bool hasPublished;
+};
+
+#endif // WIN_SOLVER_H
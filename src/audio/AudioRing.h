@@ -0,0 +1,79 @@
+#ifndef AUDIO_RING_H
+#define AUDIO_RING_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// 单生产者单消费者的无锁环形缓冲区（交错的16位采样）：解码线程写、音频线程读。
+// 读写各自只推进自己的下标，两边都不加锁、不分配内存，音频线程永远不会被解码线程挡住。
+// 下标一直递增，用容量（2的幂）取模定位，写满时 write 只写进能放下的部分。
+class AudioRing {
+public:
+    explicit AudioRing(size_t minCapacity) : capacity(1), head(0), tail(0) {
+        while (capacity < minCapacity) capacity <<= 1;
+        buffer.reset(new int16_t[capacity]);
+    }
+
+    AudioRing(const AudioRing&) = delete;
+    AudioRing& operator=(const AudioRing&) = delete;
+
+    size_t size() const { return capacity; }
+    // 可读的采样数（读端调用）
+    size_t available() const {
+        return head.load(std::memory_order_acquire) - tail.load(std::memory_order_relaxed);
+    }
+    // 可写的采样数（写端调用）
+    size_t space() const {
+        return capacity - (head.load(std::memory_order_relaxed) - tail.load(std::memory_order_acquire));
+    }
+
+    // 清空：只能在读写双方都已停止时调用
+    void reset() {
+        head.store(0, std::memory_order_relaxed);
+        tail.store(0, std::memory_order_relaxed);
+    }
+
+    // 只能由写端调用，返回实际写入的采样数
+    size_t write(const int16_t* samples, size_t count) {
+        const size_t writePos = head.load(std::memory_order_relaxed);
+        count = std::min(count, capacity - (writePos - tail.load(std::memory_order_acquire)));
+        copyIn(writePos, samples, count);
+        head.store(writePos + count, std::memory_order_release);
+        return count;
+    }
+
+    // 只能由读端调用，返回实际读出的采样数
+    size_t read(int16_t* samples, size_t count) {
+        const size_t readPos = tail.load(std::memory_order_relaxed);
+        count = std::min(count, head.load(std::memory_order_acquire) - readPos);
+        copyOut(readPos, samples, count);
+        tail.store(readPos + count, std::memory_order_release);
+        return count;
+    }
+
+private:
+    void copyIn(size_t pos, const int16_t* samples, size_t count) {
+        const size_t offset = pos & (capacity - 1);
+        const size_t first = std::min(count, capacity - offset);
+        std::copy(samples, samples + first, buffer.get() + offset);
+        std::copy(samples + first, samples + count, buffer.get());
+    }
+
+    void copyOut(size_t pos, int16_t* samples, size_t count) const {
+        const size_t offset = pos & (capacity - 1);
+        const size_t first = std::min(count, capacity - offset);
+        std::copy(buffer.get() + offset, buffer.get() + offset + first, samples);
+        std::copy(buffer.get(), buffer.get() + (count - first), samples + first);
+    }
+
+    size_t capacity;
+    std::unique_ptr<int16_t[]> buffer;
+    // 读写下标分放在不同的缓存行，避免两个线程互相使对方的缓存失效
+    alignas(64) std::atomic<size_t> head;
+    alignas(64) std::atomic<size_t> tail;
+};
+
+#endif // AUDIO_RING_H
@@ -0,0 +1,131 @@
+#include "Mp3Decoder.h"
+#include <cstring>
+#include <iostream>
+
+#ifdef MAO_HAVE_MINIMP3
+#define MINIMP3_IMPLEMENTATION
+#include "minimp3.h"
+#endif
+
+struct Mp3Decoder::State {
+#ifdef MAO_HAVE_MINIMP3
+    mp3dec_t decoder;
+#endif
+};
+
+namespace {
+
+// ID3v2 标签（常带封面图片，可能有几百KB）直接跳过，不必让解码器逐块扫描
+long id3v2Size(FILE* file) {
+    uint8_t header[10];
+    if (std::fread(header, 1, sizeof(header), file) != sizeof(header) || std::memcmp(header, "ID3", 3) != 0) {
+        return 0;
+    }
+    long size = (static_cast<long>(header[6] & 0x7F) << 21) | (static_cast<long>(header[7] & 0x7F) << 14) |
+                (static_cast<long>(header[8] & 0x7F) << 7) | static_cast<long>(header[9] & 0x7F);
+    size += 10;
+    if (header[5] & 0x10) size += 10;   // 有页脚
+    return size;
+}
+
+} // namespace
+
+Mp3Decoder::Mp3Decoder() : state(new State()), file(nullptr), inputBegin(0), inputEnd(0), endOfFile(false) {
+}
+
+Mp3Decoder::~Mp3Decoder() {
+    close();
+}
+
+bool Mp3Decoder::available() {
+#ifdef MAO_HAVE_MINIMP3
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool Mp3Decoder::open(const std::string& filename) {
+    close();
+#ifdef MAO_HAVE_MINIMP3
+    file = std::fopen(filename.c_str(), "rb");
+    if (!file) {
+        std::cerr << "Failed to open " << filename << std::endl;
+        return false;
+    }
+    const long skip = id3v2Size(file);
+    std::fseek(file, skip, SEEK_SET);
+
+    input.resize(INPUT_CHUNK);
+    inputBegin = 0;
+    inputEnd = 0;
+    endOfFile = false;
+    mp3dec_init(&state->decoder);
+    refill();
+    return true;
+#else
+    std::cerr << "MP3 support was not compiled in, cannot play " << filename << std::endl;
+    return false;
+#endif
+}
+
+void Mp3Decoder::close() {
+    if (file) {
+        std::fclose(file);
+        file = nullptr;
+    }
+    inputBegin = 0;
+    inputEnd = 0;
+}
+
+void Mp3Decoder::refill() {
+    if (inputBegin > 0) {
+        std::memmove(input.data(), input.data() + inputBegin, inputEnd - inputBegin);
+        inputEnd -= inputBegin;
+        inputBegin = 0;
+    }
+    if (!endOfFile && inputEnd < input.size()) {
+        const size_t got = std::fread(input.data() + inputEnd, 1, input.size() - inputEnd, file);
+        inputEnd += got;
+        if (got == 0) endOfFile = true;
+    }
+}
+
+int Mp3Decoder::decodeFrame(int16_t* pcm, int& channels, int& sampleRate) {
+#ifdef MAO_HAVE_MINIMP3
+    if (!file) return 0;
+    while (true) {
+        // minimp3 需要看到几帧的数据才能可靠地同步，剩下不到半块时就补充
+        if (!endOfFile && inputEnd - inputBegin < INPUT_CHUNK / 2) {
+            refill();
+        }
+        if (inputBegin == inputEnd) return 0;
+
+        mp3dec_frame_info_t info;
+        const int samples = mp3dec_decode_frame(&state->decoder, input.data() + inputBegin,
+                                                static_cast<int>(inputEnd - inputBegin), pcm, &info);
+        if (info.frame_bytes == 0) {
+            // 整块里找不到帧：文件已读完就结束，否则丢掉这块继续找
+            if (endOfFile) return 0;
+            inputBegin = inputEnd;
+            continue;
+        }
+        inputBegin += static_cast<size_t>(info.frame_bytes);
+        if (samples > 0) {
+            channels = info.channels;
+            sampleRate = info.hz;
+            return samples;
+        }
+        // 解码器跳过的非音频数据（标签、损坏的帧），继续下一帧
+    }
+#else
+    (void)pcm;
+    (void)channels;
+    (void)sampleRate;
+    return 0;
+#endif
+}
+
+size_t Mp3Decoder::memoryBytes() {
+    return INPUT_CHUNK + sizeof(State);
+}
@@ -0,0 +1,51 @@
+#ifndef MP3_DECODER_H
+#define MP3_DECODER_H
+
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+// 流式MP3解码：文件按 INPUT_CHUNK 字节分块读入，每次只解出一帧（最多1152个采样/声道）。
+// 整首歌从不完整地放进内存，一个解码器只占一块输入缓冲加上解码器自身的状态。
+// 解码本身由 minimp3 完成（构建时找到 minimp3.h 才启用，见 CMakeLists.txt），否则 open 总是失败。
+class Mp3Decoder {
+public:
+    static constexpr size_t INPUT_CHUNK = 16 * 1024;
+    static constexpr int MAX_FRAME_SAMPLES = 1152 * 2;
+
+    Mp3Decoder();
+    ~Mp3Decoder();
+
+    Mp3Decoder(const Mp3Decoder&) = delete;
+    Mp3Decoder& operator=(const Mp3Decoder&) = delete;
+
+    // 构建时是否带了MP3解码支持
+    static bool available();
+
+    bool open(const std::string& filename);
+    void close();
+    bool isOpen() const { return file != nullptr; }
+
+    // 解出下一帧，交错的采样写入 pcm（至少 MAX_FRAME_SAMPLES 个），返回每个声道的采样数；
+    // 文件结束或出错时返回0
+    int decodeFrame(int16_t* pcm, int& channels, int& sampleRate);
+
+    // 每个解码器的输入缓冲和解码状态占用的内存（字节）
+    static size_t memoryBytes();
+
+private:
+    // 补充输入：把未用完的数据移到开头，再从文件读满
+    void refill();
+
+    struct State;
+    std::unique_ptr<State> state;
+    FILE* file;
+    std::vector<uint8_t> input;
+    size_t inputBegin;
+    size_t inputEnd;
+    bool endOfFile;
+};
+
+#endif // MP3_DECODER_H
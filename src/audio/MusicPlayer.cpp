@@ -0,0 +1,323 @@
+#include "MusicPlayer.h"
+#include <SFML/Audio.hpp>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+namespace {
+
+constexpr uint32_t PHASE_ONE = 1u << 16;    // 重采样相位的定点小数位
+// 环形缓冲满时解码线程的等待时间，远小于缓冲区能播放的时长
+constexpr auto PUSH_RETRY_INTERVAL = std::chrono::milliseconds(10);
+
+} // namespace
+
+// 一首歌的解码状态：每次从解码器取一帧，按需线性插值成 SAMPLE_RATE 的立体声
+struct MusicPlayer::Track {
+    Mp3Decoder decoder;
+    int16_t frame[Mp3Decoder::MAX_FRAME_SAMPLES];
+    int frameFrames = 0;
+    int framePos = 0;
+    int channels = 2;
+    uint32_t step = PHASE_ONE;      // 源采样率 / 输出采样率
+    uint32_t phase = 0;
+    int16_t previous[2] = {};
+    int16_t following[2] = {};
+    bool started = false;
+    bool finished = false;
+    uint64_t produced = 0;
+    int index = -1;
+
+    bool open(const std::string& filename, int trackIndex) {
+        frameFrames = 0;
+        framePos = 0;
+        phase = 0;
+        started = false;
+        finished = false;
+        produced = 0;
+        index = trackIndex;
+        return decoder.open(filename);
+    }
+
+    bool nextSource(int16_t* out) {
+        if (framePos == frameFrames) {
+            int sampleRate = SAMPLE_RATE;
+            frameFrames = finished ? 0 : decoder.decodeFrame(frame, channels, sampleRate);
+            framePos = 0;
+            if (frameFrames == 0) {
+                finished = true;
+                return false;
+            }
+            step = static_cast<uint32_t>((static_cast<uint64_t>(sampleRate) << 16) / SAMPLE_RATE);
+        }
+        const int16_t* source = frame + framePos * channels;
+        out[0] = source[0];
+        out[1] = channels > 1 ? source[1] : source[0];
+        ++framePos;
+        return true;
+    }
+
+    // 返回实际输出的帧数，少于 frames 说明这首歌结束了
+    size_t read(int16_t* out, size_t frames) {
+        if (!started) {
+            started = true;
+            if (!nextSource(previous) || !nextSource(following)) return 0;
+        }
+        size_t count = 0;
+        for (; count < frames; ++count) {
+            while (phase >= PHASE_ONE) {
+                previous[0] = following[0];
+                previous[1] = following[1];
+                if (!nextSource(following)) {
+                    produced += count;
+                    return count;
+                }
+                phase -= PHASE_ONE;
+            }
+            for (int c = 0; c < 2; ++c) {
+                const int delta = following[c] - previous[c];
+                out[count * 2 + c] = static_cast<int16_t>(previous[c] + ((delta * static_cast<int>(phase)) >> 16));
+            }
+            phase += step;
+        }
+        produced += count;
+        return count;
+    }
+};
+
+// 声卡输出：SFML 的音频线程定期回调 onGetData，每次交出 CHUNK_FRAMES 帧
+class MusicPlayer::Stream : public sf::SoundStream {
+public:
+    explicit Stream(MusicPlayer& player) : owner(player), chunk(CHUNK_FRAMES * CHANNELS) {
+        initialize(CHANNELS, SAMPLE_RATE);
+    }
+
+    ~Stream() override {
+        stop();
+    }
+
+protected:
+    bool onGetData(Chunk& data) override {
+        owner.pullFrames(chunk.data(), CHUNK_FRAMES);
+        data.samples = chunk.data();
+        data.sampleCount = chunk.size();
+        return true;
+    }
+
+    void onSeek(sf::Time) override {
+    }
+
+private:
+    MusicPlayer& owner;
+    std::vector<int16_t> chunk;
+};
+
+MusicPlayer::MusicPlayer()
+    : ring(RING_FRAMES * CHANNELS),
+      tailCapacity(static_cast<size_t>(CROSSFADE_SECONDS * SAMPLE_RATE)),
+      tailStart(0),
+      tailCount(0),
+      nextIndex(0),
+      quit(false),
+      skipRequested(false),
+      primed(false),
+      gain(1.0f),
+      currentTrack(-1),
+      framesPlayed(0),
+      underruns(0) {
+}
+
+MusicPlayer::~MusicPlayer() {
+    stop();
+}
+
+bool MusicPlayer::start(const std::vector<std::string>& tracks, Sink sink) {
+    stop();
+    if (!Mp3Decoder::available()) {
+        std::cerr << "Music disabled: built without MP3 support" << std::endl;
+        return false;
+    }
+    if (tracks.empty()) return false;
+
+    playlist = tracks;
+    nextIndex = 0;
+    current.reset(new Track());
+    next.reset(new Track());
+    if (!openNext(*current)) return false;
+    currentTrack = current->index;
+
+    ring.reset();
+    tail.assign(tailCapacity * CHANNELS, 0);
+    tailStart = 0;
+    tailCount = 0;
+    scratch.assign(DECODE_BLOCK_FRAMES * CHANNELS, 0);
+    quit = false;
+    skipRequested = false;
+    primed = false;
+    framesPlayed = 0;
+    underruns = 0;
+
+    decoder = std::thread(&MusicPlayer::decodeLoop, this);
+    if (sink == Sink::DEVICE) {
+        stream.reset(new Stream(*this));
+        stream->play();
+    } else {
+        nullSink = std::thread(&MusicPlayer::nullSinkLoop, this);
+    }
+    return true;
+}
+
+void MusicPlayer::stop() {
+    quit = true;
+    if (stream) {
+        stream->stop();
+        stream.reset();
+    }
+    if (nullSink.joinable()) nullSink.join();
+    if (decoder.joinable()) decoder.join();
+    current.reset();
+    next.reset();
+    currentTrack = -1;
+}
+
+void MusicPlayer::nextTrack() {
+    skipRequested = true;
+}
+
+void MusicPlayer::setVolume(float volume) {
+    gain.store(std::min(1.0f, std::max(0.0f, volume)), std::memory_order_relaxed);
+}
+
+MusicPlayer::Stats MusicPlayer::stats() const {
+    Stats result;
+    result.framesPlayed = framesPlayed.load(std::memory_order_relaxed);
+    result.underruns = underruns.load(std::memory_order_relaxed);
+    result.bufferedFrames = ring.available() / CHANNELS;
+    result.track = currentTrack.load(std::memory_order_relaxed);
+    result.memoryBytes = ring.size() * sizeof(int16_t) + tail.capacity() * sizeof(int16_t) +
+                         scratch.capacity() * sizeof(int16_t) + 2 * (sizeof(Track) + Mp3Decoder::memoryBytes());
+    return result;
+}
+
+void MusicPlayer::pullFrames(int16_t* out, size_t frames) {
+    const size_t wanted = frames * CHANNELS;
+    const size_t got = ring.read(out, wanted);
+    if (got < wanted) {
+        std::fill(out + got, out + wanted, 0);
+        if (primed.load(std::memory_order_acquire) && !quit.load(std::memory_order_relaxed)) {
+            underruns.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    const float volume = gain.load(std::memory_order_relaxed);
+    if (volume < 1.0f) {
+        for (size_t i = 0; i < got; ++i) {
+            out[i] = static_cast<int16_t>(out[i] * volume);
+        }
+    }
+    framesPlayed.fetch_add(frames, std::memory_order_relaxed);
+}
+
+void MusicPlayer::nullSinkLoop() {
+    std::vector<int16_t> buffer(CHUNK_FRAMES * CHANNELS);
+    const auto period = std::chrono::microseconds(CHUNK_FRAMES * 1000000 / SAMPLE_RATE);
+    auto deadline = std::chrono::steady_clock::now();
+    while (!quit.load(std::memory_order_relaxed)) {
+        pullFrames(buffer.data(), CHUNK_FRAMES);
+        deadline += period;
+        std::this_thread::sleep_until(deadline);
+    }
+}
+
+bool MusicPlayer::openNext(Track& track) {
+    for (size_t attempt = 0; attempt < playlist.size(); ++attempt) {
+        const size_t index = nextIndex;
+        nextIndex = (nextIndex + 1) % playlist.size();
+        if (track.open(playlist[index], static_cast<int>(index))) return true;
+    }
+    std::cerr << "No playable music track" << std::endl;
+    return false;
+}
+
+bool MusicPlayer::push(const int16_t* samples, size_t frames) {
+    size_t remaining = frames * CHANNELS;
+    while (remaining > 0) {
+        const size_t written = ring.write(samples, remaining);
+        samples += written;
+        remaining -= written;
+        if (written > 0) primed.store(true, std::memory_order_release);
+        if (remaining == 0) break;
+        if (quit.load(std::memory_order_relaxed)) return false;
+        std::this_thread::sleep_for(PUSH_RETRY_INTERVAL);
+    }
+    return true;
+}
+
+bool MusicPlayer::emitThroughTail(const int16_t* samples, size_t frames) {
+    // frames 不超过淡出缓冲的容量，所以需要先送走的帧全在淡出缓冲里
+    size_t overflow = tailCount + frames > tailCapacity ? tailCount + frames - tailCapacity : 0;
+    while (overflow > 0) {
+        const size_t run = std::min(overflow, tailCapacity - tailStart);
+        if (!push(tail.data() + tailStart * CHANNELS, run)) return false;
+        tailStart = (tailStart + run) % tailCapacity;
+        tailCount -= run;
+        overflow -= run;
+    }
+    for (size_t i = 0; i < frames; ++i) {
+        const size_t at = (tailStart + tailCount + i) % tailCapacity;
+        tail[at * CHANNELS] = samples[i * CHANNELS];
+        tail[at * CHANNELS + 1] = samples[i * CHANNELS + 1];
+    }
+    tailCount += frames;
+    return true;
+}
+
+bool MusicPlayer::crossfadeToNext() {
+    if (!openNext(*next)) return false;
+
+    const size_t fadeFrames = tailCount;
+    size_t done = 0;
+    while (done < fadeFrames) {
+        const size_t count = std::min(DECODE_BLOCK_FRAMES, fadeFrames - done);
+        const size_t got = next->read(scratch.data(), count);
+        std::fill(scratch.begin() + got * CHANNELS, scratch.begin() + count * CHANNELS, 0);
+        for (size_t i = 0; i < count; ++i) {
+            const float fadeIn = (static_cast<float>(done + i) + 0.5f) / static_cast<float>(fadeFrames);
+            const size_t at = (tailStart + i) % tailCapacity;
+            for (size_t c = 0; c < CHANNELS; ++c) {
+                const float mixed = tail[at * CHANNELS + c] * (1.0f - fadeIn) + scratch[i * CHANNELS + c] * fadeIn;
+                scratch[i * CHANNELS + c] = static_cast<int16_t>(mixed);
+            }
+        }
+        if (!push(scratch.data(), count)) return false;
+        tailStart = (tailStart + count) % tailCapacity;
+        tailCount -= count;
+        done += count;
+    }
+
+    std::swap(current, next);
+    next->decoder.close();
+    currentTrack = current->index;
+    return true;
+}
+
+void MusicPlayer::decodeLoop() {
+    // 连续几首都解不出声音（文件损坏）时停止，免得空转
+    size_t silentTracks = 0;
+    while (!quit.load(std::memory_order_relaxed)) {
+        if (skipRequested.exchange(false)) {
+            if (!crossfadeToNext()) break;
+            continue;
+        }
+
+        const size_t got = current->read(scratch.data(), DECODE_BLOCK_FRAMES);
+        if (got > 0 && !emitThroughTail(scratch.data(), got)) break;
+        if (got == DECODE_BLOCK_FRAMES) continue;
+
+        silentTracks = current->produced == 0 ? silentTracks + 1 : 0;
+        if (silentTracks >= playlist.size()) {
+            std::cerr << "Music stopped: no track could be decoded" << std::endl;
+            break;
+        }
+        if (!crossfadeToNext()) break;
+    }
+}
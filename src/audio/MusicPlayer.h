@@ -0,0 +1,100 @@
+#ifndef MUSIC_PLAYER_H
+#define MUSIC_PLAYER_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "AudioRing.h"
+#include "Mp3Decoder.h"
+
+// 背景音乐：解码线程逐帧解码MP3、统一重采样成 44.1kHz 立体声，写进无锁环形缓冲区；
+// 音频线程（sf::SoundStream 的回调，或者测试用的空输出线程）每次取 CHUNK_FRAMES 帧，
+// 不加锁、不分配内存、不等待，缓冲区空了就补静音并记一次欠载。
+// 解码线程把每首歌最后 CROSSFADE_SECONDS 秒留在淡出缓冲里，歌曲结束（或切歌）时与下一首的开头交叉淡化。
+// 常驻内存只有环形缓冲、淡出缓冲和两个解码器的输入块，与歌曲长度无关。
+class MusicPlayer {
+public:
+    enum class Sink {
+        DEVICE,     // 通过 SFML 输出到声卡
+        NONE        // 不打开声卡，由一个线程按实时速度取走数据（无声卡的机器和测试用）
+    };
+
+    static constexpr unsigned SAMPLE_RATE = 44100;
+    static constexpr unsigned CHANNELS = 2;
+    static constexpr size_t CHUNK_FRAMES = 1024;    // 音频线程每次取的帧数（约23毫秒）
+    static constexpr size_t RING_FRAMES = 8192;     // 环形缓冲约0.19秒
+    static constexpr size_t DECODE_BLOCK_FRAMES = 1024;
+    static constexpr float CROSSFADE_SECONDS = 1.0f;
+
+    struct Stats {
+        uint64_t framesPlayed = 0;
+        uint64_t underruns = 0;     // 音频线程取数据时缓冲区不够的次数（开始播放前的不算）
+        size_t bufferedFrames = 0;
+        size_t memoryBytes = 0;     // 环形缓冲、淡出缓冲和解码器的内存
+        int track = -1;
+    };
+
+    MusicPlayer();
+    ~MusicPlayer();
+
+    MusicPlayer(const MusicPlayer&) = delete;
+    MusicPlayer& operator=(const MusicPlayer&) = delete;
+
+    // 按顺序循环播放 tracks
+    bool start(const std::vector<std::string>& tracks, Sink sink);
+    void stop();
+    bool running() const { return decoder.joinable(); }
+
+    // 立即与下一首交叉淡化
+    void nextTrack();
+    // 音量 0-1，在音频线程里生效，不经过缓冲区的延迟
+    void setVolume(float volume);
+    float volume() const { return gain.load(std::memory_order_relaxed); }
+
+    Stats stats() const;
+
+    // 音频线程调用：取 frames 帧交错采样，不足的部分补静音
+    void pullFrames(int16_t* out, size_t frames);
+
+private:
+    class Stream;
+    struct Track;
+
+    void decodeLoop();
+    void nullSinkLoop();
+    // 阻塞写入环形缓冲（只在解码线程里调用），停止时返回 false
+    bool push(const int16_t* samples, size_t frames);
+    // 淡出缓冲满了以后最早的帧写入环形缓冲，再追加新帧
+    bool emitThroughTail(const int16_t* samples, size_t frames);
+    // 淡出缓冲里剩下的帧与下一首的开头交叉淡化，之后 current 就是下一首
+    bool crossfadeToNext();
+    bool openNext(Track& track);
+
+    std::vector<std::string> playlist;
+    AudioRing ring;
+    std::unique_ptr<Track> current;
+    std::unique_ptr<Track> next;
+    // 淡出缓冲：当前歌曲最近解出、还没写进环形缓冲的 tailCapacity 帧
+    std::vector<int16_t> tail;
+    size_t tailCapacity;
+    size_t tailStart;
+    size_t tailCount;
+    size_t nextIndex;
+    std::vector<int16_t> scratch;
+
+    std::unique_ptr<Stream> stream;
+    std::thread decoder;
+    std::thread nullSink;
+    std::atomic<bool> quit;
+    std::atomic<bool> skipRequested;
+    std::atomic<bool> primed;       // 解码线程已经写入过数据
+    std::atomic<float> gain;
+    std::atomic<int> currentTrack;
+    std::atomic<uint64_t> framesPlayed;
+    std::atomic<uint64_t> underruns;
+};
+
+#endif // MUSIC_PLAYER_H
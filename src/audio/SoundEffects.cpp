@@ -0,0 +1,163 @@
+#include "SoundEffects.h"
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <iostream>
+
+namespace {
+
+constexpr float PI = 3.14159265f;
+
+const char* const EFFECT_NAMES[] = {"spawn", "merge", "dialog"};
+
+// 合成一段衰减的正弦音：每个音符 {起始秒, 频率, 时长}，叠加一个八度泛音
+struct Note {
+    float start;
+    float frequency;
+    float duration;
+};
+
+std::vector<sf::Int16> synthesize(const std::vector<Note>& notes, float decay, float amplitude) {
+    float length = 0.0f;
+    for (const Note& note : notes) {
+        length = std::max(length, note.start + note.duration);
+    }
+    std::vector<float> mix(static_cast<size_t>(length * SoundEffects::SAMPLE_RATE) + 1, 0.0f);
+    for (const Note& note : notes) {
+        const size_t begin = static_cast<size_t>(note.start * SoundEffects::SAMPLE_RATE);
+        const size_t count = static_cast<size_t>(note.duration * SoundEffects::SAMPLE_RATE);
+        const size_t attack = SoundEffects::SAMPLE_RATE / 500;   // 2毫秒起音，避免开头的爆音
+        for (size_t i = 0; i < count && begin + i < mix.size(); ++i) {
+            const float t = static_cast<float>(i) / SoundEffects::SAMPLE_RATE;
+            float envelope = std::exp(-t * decay);
+            if (i < attack) envelope *= static_cast<float>(i) / attack;
+            if (i + attack > count) envelope *= static_cast<float>(count - i) / attack;
+            const float phase = 2.0f * PI * note.frequency * t;
+            mix[begin + i] += envelope * (std::sin(phase) + 0.3f * std::sin(2.0f * phase));
+        }
+    }
+    std::vector<sf::Int16> samples(mix.size());
+    for (size_t i = 0; i < mix.size(); ++i) {
+        const float value = std::max(-1.0f, std::min(1.0f, mix[i] * amplitude));
+        samples[i] = static_cast<sf::Int16>(value * 32767.0f);
+    }
+    return samples;
+}
+
+std::vector<sf::Int16> defaultSamples(SoundEffect effect) {
+    switch (effect) {
+        case SoundEffect::SPAWN:
+            return synthesize({{0.0f, 880.0f, 0.06f}}, 45.0f, 0.25f);
+        case SoundEffect::MERGE:
+            return synthesize({{0.0f, 440.0f, 0.14f}}, 22.0f, 0.45f);
+        case SoundEffect::DIALOG:
+            return synthesize({{0.0f, 523.25f, 0.18f}, {0.12f, 783.99f, 0.3f}}, 9.0f, 0.35f);
+        default:
+            return {};
+    }
+}
+
+} // namespace
+
+SoundEffects::SoundEffects()
+    : firstVoice{},
+      isLoaded(false),
+      muted(false),
+      latencyTotalMicros(0) {
+}
+
+void SoundEffects::load(bool withDevice) {
+    for (size_t i = 0; i < buffers.size(); ++i) {
+        const SoundEffect effect = static_cast<SoundEffect>(i);
+        const std::string custom = std::string("assets/sfx/") + EFFECT_NAMES[i] + ".wav";
+        std::error_code ec;
+        if (std::filesystem::exists(custom, ec) && buffers[i].loadFromFile(custom)) {
+            continue;
+        }
+        const std::vector<sf::Int16> samples = defaultSamples(effect);
+        if (!buffers[i].loadFromSamples(samples.data(), samples.size(), 1, SAMPLE_RATE)) {
+            std::cerr << "Failed to create sound effect " << EFFECT_NAMES[i] << std::endl;
+            return;
+        }
+    }
+
+    voices.clear();
+    if (withDevice) {
+        voices.resize(VOICES);
+        size_t voice = 0;
+        for (size_t i = 0; i < buffers.size(); ++i) {
+            firstVoice[i] = voice;
+            for (size_t k = 0; k < VOICES_PER_EFFECT[i]; ++k, ++voice) {
+                voices[voice].sound.setBuffer(buffers[i]);
+            }
+        }
+    }
+    isLoaded = true;
+}
+
+void SoundEffects::trigger(SoundEffect effect, int level, Clock::time_point inputTime) {
+    ++counters.triggered;
+    Pending& slot = pending[static_cast<size_t>(effect)];
+    if (inputTime != Clock::time_point() && (slot.inputTime == Clock::time_point() || inputTime < slot.inputTime)) {
+        slot.inputTime = inputTime;
+    }
+    slot.level = std::max(slot.level, level);
+    ++slot.count;
+}
+
+void SoundEffects::flush() {
+    const Clock::time_point now = Clock::now();
+    for (size_t i = 0; i < pending.size(); ++i) {
+        Pending& slot = pending[i];
+        if (slot.count == 0) continue;
+        const SoundEffect effect = static_cast<SoundEffect>(i);
+
+        if (isLoaded && !muted) {
+            ++counters.played;
+            if (!voices.empty()) {
+                bool stolen = false;
+                Voice& voice = pickVoice(effect, stolen);
+                if (stolen) {
+                    ++counters.stolen;
+                    voice.sound.stop();
+                }
+                // 合并：每高一级升一个半音，同一帧里合并越多越响
+                const float pitch = effect == SoundEffect::MERGE
+                    ? std::pow(2.0f, static_cast<float>(std::min(std::max(slot.level, 1), 17) - 1) / 12.0f)
+                    : 1.0f;
+                const float volume = std::min(100.0f, 70.0f + 8.0f * static_cast<float>(slot.count - 1));
+                voice.sound.setPitch(pitch);
+                voice.sound.setVolume(volume);
+                voice.sound.play();
+                voice.startedAt = now;
+            }
+            if (slot.inputTime != Clock::time_point()) {
+                recordLatency(slot.inputTime, now);
+            }
+        }
+        slot = Pending();
+    }
+}
+
+SoundEffects::Voice& SoundEffects::pickVoice(SoundEffect effect, bool& stolen) {
+    const size_t begin = firstVoice[static_cast<size_t>(effect)];
+    const size_t end = begin + VOICES_PER_EFFECT[static_cast<size_t>(effect)];
+    size_t oldest = begin;
+    for (size_t v = begin; v < end; ++v) {
+        if (voices[v].sound.getStatus() != sf::SoundSource::Playing) {
+            stolen = false;
+            return voices[v];
+        }
+        if (voices[v].startedAt < voices[oldest].startedAt) oldest = v;
+    }
+    stolen = true;
+    return voices[oldest];
+}
+
+void SoundEffects::recordLatency(Clock::time_point inputTime, Clock::time_point now) {
+    const int64_t micros = std::chrono::duration_cast<std::chrono::microseconds>(now - inputTime).count();
+    ++counters.latencySamples;
+    latencyTotalMicros += micros;
+    counters.latencyMeanMicros = static_cast<double>(latencyTotalMicros) / counters.latencySamples;
+    counters.latencyMaxMicros = std::max(counters.latencyMaxMicros, micros);
+}
@@ -0,0 +1,87 @@
+#ifndef SOUND_EFFECTS_H
+#define SOUND_EFFECTS_H
+
+#include <SFML/Audio.hpp>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+enum class SoundEffect : uint8_t {
+    SPAWN,      // 新方块出现
+    MERGE,      // 方块合并，音高随合并出的数值升高
+    DIALOG,     // 对话框弹出
+    COUNT
+};
+
+// 音效混音：每种音效的PCM在启动时生成（或从 assets/sfx/<名字>.wav 读入）一次，之后只复用。
+// 播放用固定数量的 sf::Sound 声部，每个声部在启动时就绑定到一种音效的缓冲区
+// （sf::Sound::setBuffer 会往缓冲区的声部集合里插入节点，不能放在每步都走的路径上），
+// 同一种音效的声部都在播放时抢占最早开始的那个。
+// 一帧里触发的同种音效先攒起来，帧末 flush 合并成一次播放：6x6 棋盘一步合并十对也只占一个声部，
+// 音高取最大的数值、音量随合并数增加。trigger 和 flush 都不分配内存。
+// 每次触发可以带上引起它的输入的时间，flush 时统计从输入到声部开始播放的延迟。
+class SoundEffects {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr unsigned SAMPLE_RATE = 44100;
+    static constexpr size_t VOICES = 8;
+    // 每种音效分到的声部数，合计 VOICES
+    static constexpr std::array<size_t, static_cast<size_t>(SoundEffect::COUNT)> VOICES_PER_EFFECT = {2, 4, 2};
+
+    struct Stats {
+        uint64_t triggered = 0;     // trigger 调用次数
+        uint64_t played = 0;        // 实际开始播放的次数（合并之后）
+        uint64_t stolen = 0;        // 打断正在播放的声部的次数
+        uint64_t latencySamples = 0;
+        double latencyMeanMicros = 0.0;
+        int64_t latencyMaxMicros = 0;
+    };
+
+    SoundEffects();
+
+    SoundEffects(const SoundEffects&) = delete;
+    SoundEffects& operator=(const SoundEffects&) = delete;
+
+    // 准备所有音效的缓冲区。withDevice 为假时不创建声部（不打开声卡），只做合并和延迟统计
+    void load(bool withDevice);
+    bool loaded() const { return isLoaded; }
+
+    // level 对合并来说是合并出的指数；inputTime 为默认值时不计入延迟统计（例如回放自动播放的步）
+    void trigger(SoundEffect effect, int level = 0, Clock::time_point inputTime = Clock::time_point());
+    // 每帧调用一次：把这一帧攒下的音效各播放一次
+    void flush();
+
+    void setMuted(bool value) { muted = value; }
+    bool isMuted() const { return muted; }
+
+    const Stats& stats() const { return counters; }
+
+private:
+    struct Pending {
+        int count = 0;
+        int level = 0;
+        Clock::time_point inputTime;    // 这一帧里最早的输入
+    };
+    struct Voice {
+        sf::Sound sound;
+        Clock::time_point startedAt;
+    };
+
+    // 选一个空闲声部，都在播放时返回最早开始的那个
+    Voice& pickVoice(SoundEffect effect, bool& stolen);
+    void recordLatency(Clock::time_point inputTime, Clock::time_point now);
+
+    std::array<sf::SoundBuffer, static_cast<size_t>(SoundEffect::COUNT)> buffers;
+    std::array<Pending, static_cast<size_t>(SoundEffect::COUNT)> pending;
+    std::array<size_t, static_cast<size_t>(SoundEffect::COUNT)> firstVoice;
+    std::vector<Voice> voices;  // load 时一次建好，之后大小不变
+    bool isLoaded;
+    bool muted;
+    Stats counters;
+    int64_t latencyTotalMicros;
+};
+
+#endif // SOUND_EFFECTS_H
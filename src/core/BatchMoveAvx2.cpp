@@ -0,0 +1,66 @@
+// 用 -mavx2（MSVC 为 /arch:AVX2）单独编译，只在运行时检测到 AVX2 后才调用
+#define BATCH_MOVE_KERNEL_IMPL
+#include "BatchMoveKernel.h"
+
+#ifdef MAO_BATCH_SIMD
+#include <immintrin.h>
+
+namespace {
+
+struct Avx2Ops {
+    using V = __m256i;
+    static constexpr int LANES = 32;
+
+    static V load(const uint8_t* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+    static void store(uint8_t* p, V v) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v); }
+    static V zero() { return _mm256_setzero_si256(); }
+    static V set1(uint8_t value) { return _mm256_set1_epi8(static_cast<char>(value)); }
+    static V eq(V a, V b) { return _mm256_cmpeq_epi8(a, b); }
+    static V andv(V a, V b) { return _mm256_and_si256(a, b); }
+    static V orv(V a, V b) { return _mm256_or_si256(a, b); }
+    static V andnot(V a, V b) { return _mm256_andnot_si256(a, b); }   // ~a & b
+    static V notv(V a) { return _mm256_xor_si256(a, _mm256_set1_epi8(-1)); }
+    static V blend(V a, V b, V mask) { return _mm256_blendv_epi8(a, b, mask); }
+    static V add(V a, V b) { return _mm256_add_epi8(a, b); }
+    static V sub(V a, V b) { return _mm256_sub_epi8(a, b); }
+
+    // 每个棋盘一个32位得分，按8个一组放在4个寄存器里
+    struct Scores {
+        __m256i parts[4];
+
+        Scores() {
+            for (__m256i& part : parts) part = _mm256_setzero_si256();
+        }
+
+        // exps 为0的棋盘不计分，否则加上 2^exps
+        void add(V exps) {
+            if (_mm256_testz_si256(exps, exps)) return;
+            const __m128i low = _mm256_castsi256_si128(exps);
+            const __m128i high = _mm256_extracti128_si256(exps, 1);
+            addPart(0, low);
+            addPart(1, _mm_srli_si128(low, 8));
+            addPart(2, high);
+            addPart(3, _mm_srli_si128(high, 8));
+        }
+
+        void addPart(int k, __m128i bytes) {
+            const __m256i e = _mm256_cvtepu8_epi32(bytes);
+            const __m256i value = _mm256_sllv_epi32(_mm256_set1_epi32(1), e);
+            const __m256i none = _mm256_cmpeq_epi32(e, _mm256_setzero_si256());
+            parts[k] = _mm256_add_epi32(parts[k], _mm256_andnot_si256(none, value));
+        }
+
+        void store(uint32_t* out) const {
+            for (int k = 0; k < 4; ++k) {
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + k * 8), parts[k]);
+            }
+        }
+    };
+};
+
+} // namespace
+
+void batchMoveAvx2(const BatchLines& lines, uint8_t* cells, size_t stride, uint32_t* scores, uint8_t* changed) {
+    BatchMover<Avx2Ops>::run(lines, cells, stride, scores, changed);
+}
+#endif // MAO_BATCH_SIMD
@@ -0,0 +1,139 @@
+#ifndef BATCH_MOVE_KERNEL_H
+#define BATCH_MOVE_KERNEL_H
+
+// BoardBatch 的向量实现，只由 BatchMoveSse41.cpp / BatchMoveAvx2.cpp 包含。
+// 这两个文件用各自的指令集选项编译，所以这里不能包含任何带内联函数的标准库头文件，
+// 自己的函数也都放在匿名命名空间里：否则链接器可能在别的文件里选用 AVX2 版本的同名内联函数，
+// 在不支持的CPU上崩溃。
+
+#include <cstddef>
+#include <cstdint>
+
+// 一条线：第 i 格是 start + i * step，第0格紧贴移动方向的边界
+struct BatchLine {
+    int start;
+    int step;
+    int length;
+};
+
+// 一次移动要处理的所有线（与 Board::move 的枚举顺序相同）
+struct BatchLines {
+    static constexpr int MAX_LENGTH = 8;
+    static constexpr int MAX_LINES = 2 * MAX_LENGTH - 1;
+    BatchLine lines[MAX_LINES];
+    int count;
+    bool farFirst;  // 对角线向下移动时从离边界最远的方块开始处理
+};
+
+void batchMoveSse41(const BatchLines& lines, uint8_t* cells, size_t stride, uint32_t* scores, uint8_t* changed);
+void batchMoveAvx2(const BatchLines& lines, uint8_t* cells, size_t stride, uint32_t* scores, uint8_t* changed);
+
+#ifdef BATCH_MOVE_KERNEL_IMPL
+namespace {
+
+// Ops 提供按字节的向量运算（比较结果为全0或全1的掩码），V 的每个字节是一个棋盘。
+// 每个棋盘在同一条线上按 slideLine 的步骤执行，分支换成按掩码选择：
+// 方块要写到的位置因棋盘而异，所以对每个可能的位置都做一次带掩码的选择，一条线的代价是长度的平方级，
+// 对不超过8格的线仍远少于逐个棋盘执行时的分支和访存。
+template <class Ops>
+struct BatchMover {
+    using V = typename Ops::V;
+    static constexpr int MAX_LENGTH = BatchLines::MAX_LENGTH;
+
+    // 从近端处理：[0, filled) 总是压紧的，只需记住最后一个方块和它是否已合并过
+    static void slideNearFirst(V* c, int length, typename Ops::Scores& scores) {
+        const V zero = Ops::zero();
+        V merged[MAX_LENGTH];
+        V filled = zero;
+        V top = zero;
+        V topMerged = zero;
+        for (int i = 0; i < length; ++i) {
+            const V e = c[i];
+            const V e1 = Ops::add(e, Ops::set1(1));
+            const V nz = Ops::notv(Ops::eq(e, zero));
+            // 没有方块时 top 为0，而 e 不为0，不会误判
+            const V m = Ops::andnot(topMerged, Ops::andv(nz, Ops::eq(top, e)));
+            const V place = Ops::andnot(m, nz);
+            merged[i] = zero;
+            c[i] = Ops::blend(c[i], zero, nz);
+            for (int j = 0; j <= i; ++j) {
+                const V mergeHere = Ops::andv(m, Ops::eq(filled, Ops::set1(static_cast<uint8_t>(j + 1))));
+                const V placeHere = Ops::andv(place, Ops::eq(filled, Ops::set1(static_cast<uint8_t>(j))));
+                c[j] = Ops::blend(c[j], e1, mergeHere);
+                c[j] = Ops::blend(c[j], e, placeHere);
+                merged[j] = Ops::orv(merged[j], mergeHere);
+            }
+            top = Ops::blend(Ops::blend(top, e1, m), e, place);
+            topMerged = Ops::andnot(place, Ops::orv(topMerged, m));
+            filled = Ops::sub(filled, place);
+        }
+        // 合并出的方块之后不会再动，最后按位置统一计分
+        for (int j = 0; j < length; ++j) {
+            scores.add(Ops::andv(merged[j], c[j]));
+        }
+    }
+
+    // 从远端处理：前面还有未处理的方块，每步都要找出前方最后一个方块
+    static void slideFarFirst(V* c, int length, typename Ops::Scores& scores) {
+        const V zero = Ops::zero();
+        V merged[MAX_LENGTH];
+        for (int j = 0; j < length; ++j) merged[j] = zero;
+        for (int i = length - 1; i >= 0; --i) {
+            const V e = c[i];
+            const V e1 = Ops::add(e, Ops::set1(1));
+            const V nz = Ops::notv(Ops::eq(e, zero));
+            V pos = zero;
+            V lastValue = zero;
+            V lastMerged = zero;
+            for (int j = 0; j < i; ++j) {
+                const V occupied = Ops::notv(Ops::eq(c[j], zero));
+                pos = Ops::blend(pos, Ops::set1(static_cast<uint8_t>(j + 1)), occupied);
+                lastValue = Ops::blend(lastValue, c[j], occupied);
+                lastMerged = Ops::blend(lastMerged, merged[j], occupied);
+            }
+            const V m = Ops::andnot(lastMerged, Ops::andv(nz, Ops::eq(lastValue, e)));
+            const V place = Ops::andnot(m, nz);
+            c[i] = Ops::blend(c[i], zero, nz);
+            for (int j = 0; j <= i; ++j) {
+                const V mergeHere = Ops::andv(m, Ops::eq(pos, Ops::set1(static_cast<uint8_t>(j + 1))));
+                const V placeHere = Ops::andv(place, Ops::eq(pos, Ops::set1(static_cast<uint8_t>(j))));
+                c[j] = Ops::blend(c[j], e1, mergeHere);
+                c[j] = Ops::blend(c[j], e, placeHere);
+                merged[j] = Ops::orv(merged[j], mergeHere);
+            }
+            // 合并出的方块之后还可能继续滑动，在合并时计分
+            scores.add(Ops::andv(m, e1));
+        }
+    }
+
+    static void run(const BatchLines& lines, uint8_t* cells, size_t stride, uint32_t* scores, uint8_t* changed) {
+        for (size_t base = 0; base < stride; base += Ops::LANES) {
+            typename Ops::Scores blockScores;
+            V changedMask = Ops::zero();
+            for (int l = 0; l < lines.count; ++l) {
+                const BatchLine& line = lines.lines[l];
+                V c[MAX_LENGTH];
+                for (int i = 0; i < line.length; ++i) {
+                    c[i] = Ops::load(cells + static_cast<size_t>(line.start + i * line.step) * stride + base);
+                }
+                if (lines.farFirst) {
+                    slideFarFirst(c, line.length, blockScores);
+                } else {
+                    slideNearFirst(c, line.length, blockScores);
+                }
+                for (int i = 0; i < line.length; ++i) {
+                    uint8_t* p = cells + static_cast<size_t>(line.start + i * line.step) * stride + base;
+                    changedMask = Ops::orv(changedMask, Ops::notv(Ops::eq(Ops::load(p), c[i])));
+                    Ops::store(p, c[i]);
+                }
+            }
+            blockScores.store(scores + base);
+            Ops::store(changed + base, Ops::andv(changedMask, Ops::set1(1)));
+        }
+    }
+};
+
+} // namespace
+#endif // BATCH_MOVE_KERNEL_IMPL
+
+#endif // BATCH_MOVE_KERNEL_H
@@ -0,0 +1,66 @@
+// 用 -msse4.1 单独编译，只在运行时检测到 SSE4.1 后才调用
+#define BATCH_MOVE_KERNEL_IMPL
+#include "BatchMoveKernel.h"
+
+#ifdef MAO_BATCH_SIMD
+#include <smmintrin.h>
+
+namespace {
+
+struct Sse41Ops {
+    using V = __m128i;
+    static constexpr int LANES = 16;
+
+    static V load(const uint8_t* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+    static void store(uint8_t* p, V v) { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v); }
+    static V zero() { return _mm_setzero_si128(); }
+    static V set1(uint8_t value) { return _mm_set1_epi8(static_cast<char>(value)); }
+    static V eq(V a, V b) { return _mm_cmpeq_epi8(a, b); }
+    static V andv(V a, V b) { return _mm_and_si128(a, b); }
+    static V orv(V a, V b) { return _mm_or_si128(a, b); }
+    static V andnot(V a, V b) { return _mm_andnot_si128(a, b); }   // ~a & b
+    static V notv(V a) { return _mm_xor_si128(a, _mm_set1_epi8(-1)); }
+    static V blend(V a, V b, V mask) { return _mm_blendv_epi8(a, b, mask); }
+    static V add(V a, V b) { return _mm_add_epi8(a, b); }
+    static V sub(V a, V b) { return _mm_sub_epi8(a, b); }
+
+    // 每个棋盘一个32位得分，按4个一组放在4个寄存器里
+    struct Scores {
+        __m128i parts[4];
+
+        Scores() {
+            for (__m128i& part : parts) part = _mm_setzero_si128();
+        }
+
+        // exps 为0的棋盘不计分，否则加上 2^exps。
+        // SSE 没有按元素的移位，2^e 由浮点数的指数位拼出来再转成整数（e 不超过31时是精确的）
+        void add(V exps) {
+            if (_mm_testz_si128(exps, exps)) return;
+            addPart(0, exps);
+            addPart(1, _mm_srli_si128(exps, 4));
+            addPart(2, _mm_srli_si128(exps, 8));
+            addPart(3, _mm_srli_si128(exps, 12));
+        }
+
+        void addPart(int k, __m128i bytes) {
+            const __m128i e = _mm_cvtepu8_epi32(bytes);
+            const __m128i bits = _mm_slli_epi32(_mm_add_epi32(e, _mm_set1_epi32(127)), 23);
+            const __m128i value = _mm_cvttps_epi32(_mm_castsi128_ps(bits));
+            const __m128i none = _mm_cmpeq_epi32(e, _mm_setzero_si128());
+            parts[k] = _mm_add_epi32(parts[k], _mm_andnot_si128(none, value));
+        }
+
+        void store(uint32_t* out) const {
+            for (int k = 0; k < 4; ++k) {
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + k * 4), parts[k]);
+            }
+        }
+    };
+};
+
+} // namespace
+
+void batchMoveSse41(const BatchLines& lines, uint8_t* cells, size_t stride, uint32_t* scores, uint8_t* changed) {
+    BatchMover<Sse41Ops>::run(lines, cells, stride, scores, changed);
+}
+#endif // MAO_BATCH_SIMD
@@ -0,0 +1,50 @@
+#ifndef BIT_UTILS_H
+#define BIT_UTILS_H
+
+#include <cstdint>
+
+// 统计64位掩码中置位的个数
+inline int popcount64(uint64_t mask) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_popcountll(mask);
+#else
+    int count = 0;
+    while (mask) {
+        mask &= mask - 1;
+        ++count;
+    }
+    return count;
+#endif
+}
+
+// 最低置位的下标（mask 不能为0）
+inline int lowestBitIndex(uint64_t mask) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(mask);
+#else
+    int index = 0;
+    while ((mask & 1) == 0) {
+        mask >>= 1;
+        ++index;
+    }
+    return index;
+#endif
+}
+
+// 返回掩码中第 k 个（从0开始）置位的下标，要求 k < popcount64(mask)
+inline int selectBit(uint64_t mask, int k) {
+    // 先按32位折半跳过，再逐个清除最低位
+    int base = 0;
+    int lowCount = popcount64(mask & 0xFFFFFFFFULL);
+    if (k >= lowCount) {
+        k -= lowCount;
+        mask >>= 32;
+        base = 32;
+    }
+    for (; k > 0; --k) {
+        mask &= mask - 1;
+    }
+    return base + lowestBitIndex(mask);
+}
+
+#endif // BIT_UTILS_H
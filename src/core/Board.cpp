@@ -0,0 +1,269 @@
+#include "Board.h"
+#include "BitUtils.h"
+#include <algorithm>
+
+namespace {
+
+// 按原规则处理一条线：方块一直滑到被挡住，遇到相同且本次未合并过的格子就合并
+// 线上第 i 格是 cells[start + i * stride]，第0格紧贴移动方向的边界
+bool slideLine(uint8_t* cells, int start, int stride, int length, bool farFirst, MoveResult& result,
+               MovePlan* plan) {
+    bool moved = false;
+    bool merged[Board::MAX_SIZE] = {};
+    // 从近端开始处理时，已处理部分总是压紧在前面：[0, filled) 有方块，之后到 i 都是空格
+    int filled = 0;
+
+    for (int step = 0; step < length; ++step) {
+        const int i = farFirst ? length - 1 - step : step;
+        const int from = start + i * stride;
+        const uint8_t exp = cells[from];
+        if (exp == 0) continue;
+
+        int pos = filled;
+        if (farFirst) {
+            // 从远端开始时前面还有未处理的方块，只能逐格往前找
+            pos = i;
+            while (pos > 0 && cells[start + (pos - 1) * stride] == 0) {
+                --pos;
+            }
+        }
+
+        const int before = start + (pos - 1) * stride;
+        if (pos > 0 && cells[before] == exp && !merged[pos - 1]) {
+            merged[pos - 1] = true;
+            cells[before] = static_cast<uint8_t>(exp + 1);
+            cells[from] = 0;
+            result.scoreGained += 1 << (exp + 1);
+            result.mergedExponents |= 1u << (exp + 1);
+            moved = true;
+            if (plan) {
+                plan->moves[plan->count++] = {static_cast<uint16_t>(from), static_cast<uint16_t>(before),
+                                              static_cast<uint8_t>(exp + 1), true};
+            }
+        } else {
+            if (pos != i) {
+                const int to = start + pos * stride;
+                cells[to] = exp;
+                cells[from] = 0;
+                moved = true;
+                if (plan) {
+                    plan->moves[plan->count++] = {static_cast<uint16_t>(from), static_cast<uint16_t>(to), exp, false};
+                }
+            }
+            filled = pos + 1;
+        }
+    }
+    return moved;
+}
+
+} // namespace
+
+int directionDx(Direction dir) {
+    switch (dir) {
+        case Direction::LEFT:
+        case Direction::UP_LEFT:
+        case Direction::DOWN_LEFT:
+            return -1;
+        case Direction::RIGHT:
+        case Direction::UP_RIGHT:
+        case Direction::DOWN_RIGHT:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+int directionDy(Direction dir) {
+    switch (dir) {
+        case Direction::UP:
+        case Direction::UP_LEFT:
+        case Direction::UP_RIGHT:
+            return -1;
+        case Direction::DOWN:
+        case Direction::DOWN_LEFT:
+        case Direction::DOWN_RIGHT:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+Direction directionFromDelta(int dx, int dy) {
+    if (dx == 0) return dy < 0 ? Direction::UP : Direction::DOWN;
+    if (dy == 0) return dx < 0 ? Direction::LEFT : Direction::RIGHT;
+    if (dy < 0) return dx < 0 ? Direction::UP_LEFT : Direction::UP_RIGHT;
+    return dx < 0 ? Direction::DOWN_LEFT : Direction::DOWN_RIGHT;
+}
+
+int directionIndex(Direction dir) {
+    return static_cast<int>(dir) & 3;
+}
+
+Direction directionFromIndex(GameVersion version, int index) {
+    int base = (version == GameVersion::ORIGINAL) ? 0 : 4;
+    return static_cast<Direction>(base + (index & 3));
+}
+
+Board::Board() : n(0), inlineCells{} {
+}
+
+Board::Board(int size) : n(size), inlineCells{} {
+    if (n > INLINE_SIZE) {
+        heapCells.assign(static_cast<size_t>(n) * n, 0);
+    }
+}
+
+void Board::clear() {
+    std::fill(data(), data() + cellCount(), 0);
+}
+
+int Board::value(int x, int y) const {
+    uint8_t exp = data()[y * n + x];
+    return exp ? (1 << exp) : 0;
+}
+
+void Board::setValue(int x, int y, int value) {
+    uint8_t exp = 0;
+    while (value > 1) {
+        value >>= 1;
+        ++exp;
+    }
+    data()[y * n + x] = exp;
+}
+
+CellMask Board::emptyMask() const {
+    const int count = cellCount();
+    CellMask mask(count);
+    const uint8_t* cells = data();
+    for (int w = 0; w < mask.wordCount(); ++w) {
+        const int begin = w * 64;
+        const int end = std::min(begin + 64, count);
+        uint64_t bits = 0;
+        for (int i = begin; i < end; ++i) {
+            bits |= static_cast<uint64_t>(cells[i] == 0) << (i - begin);
+        }
+        mask.setWord(w, bits);
+    }
+    return mask;
+}
+
+int Board::emptyCount() const {
+    return emptyMask().count();
+}
+
+uint8_t Board::maxExponent() const {
+    const uint8_t* cells = data();
+    return cellCount() > 0 ? *std::max_element(cells, cells + cellCount()) : 0;
+}
+
+bool Board::move(Direction dir, MoveResult& result, MovePlan* plan) {
+    const int dx = directionDx(dir);
+    const int dy = directionDy(dir);
+    // 原 moveTiles 中对角线移动总是逐行从上往下遍历，
+    // 向下的对角线移动因此会先处理离边界最远的方块
+    const bool farFirst = (dx != 0 && dy > 0);
+    // 沿线远离边界的一步
+    const int stride = -(dy * n + dx);
+
+    if (plan) {
+        plan->count = 0;
+    }
+    uint8_t* cells = data();
+    bool moved = false;
+
+    // 每条线从紧贴边界的格子出发，按行优先的顺序枚举这些起点（与原来建表的顺序一致）
+    auto slideFrom = [&](int x, int y) {
+        const int lengthX = dx > 0 ? x + 1 : (dx < 0 ? n - x : n);
+        const int lengthY = dy > 0 ? y + 1 : (dy < 0 ? n - y : n);
+        moved |= slideLine(cells, y * n + x, stride, std::min(lengthX, lengthY), farFirst, result, plan);
+    };
+    for (int y = 0; y < n; ++y) {
+        if (y + dy < 0 || y + dy >= n) {
+            for (int x = 0; x < n; ++x) {
+                slideFrom(x, y);
+            }
+        } else if (dx != 0) {
+            slideFrom(dx < 0 ? 0 : n - 1, y);
+        }
+    }
+    return moved;
+}
+
+bool Board::isGameOver(GameVersion version) const {
+    const uint8_t* cells = data();
+    const int count = cellCount();
+    for (int i = 0; i < count; ++i) {
+        if (cells[i] == 0) return false;
+    }
+
+    for (int y = 0; y < n; ++y) {
+        for (int x = 0; x < n; ++x) {
+            uint8_t exp = cells[y * n + x];
+            if (version == GameVersion::ORIGINAL) {
+                if (x < n - 1 && cells[y * n + x + 1] == exp) return false;
+                if (y < n - 1 && cells[(y + 1) * n + x] == exp) return false;
+            } else {
+                // 只需检查右上和右下，左侧的两条对角线会在相邻格子处被检查到
+                if (x < n - 1 && y > 0 && cells[(y - 1) * n + x + 1] == exp) return false;
+                if (x < n - 1 && y < n - 1 && cells[(y + 1) * n + x + 1] == exp) return false;
+            }
+        }
+    }
+    return true;
+}
+
+int Board::spawnRandom(Rng& rng) {
+    const CellMask mask = emptyMask();
+    int count = mask.count();
+    if (count == 0) return -1;
+
+    int cell = mask.select(static_cast<int>(rng.bounded(count)));
+    data()[cell] = (rng.bounded(10) < 8) ? 1 : 2;
+    return cell;
+}
+
+bool Board::operator==(const Board& other) const {
+    if (n != other.n) return false;
+    return std::equal(data(), data() + cellCount(), other.data());
+}
+
+CellMask::CellMask(int cellCount) : usedWords((cellCount + 63) / 64) {
+    clear();
+}
+
+void CellMask::clear() {
+    std::fill(words.begin(), words.begin() + usedWords, 0);
+}
+
+int CellMask::count() const {
+    int total = 0;
+    for (int w = 0; w < usedWords; ++w) {
+        total += popcount64(words[w]);
+    }
+    return total;
+}
+
+int CellMask::select(int k) const {
+    // 先按字跳过，再在字内选取
+    for (int w = 0; w < usedWords; ++w) {
+        const int inWord = popcount64(words[w]);
+        if (k < inWord) {
+            return w * 64 + selectBit(words[w], k);
+        }
+        k -= inWord;
+    }
+    return -1;
+}
+
+int CellMask::rank(int cell) const {
+    const int word = cell >> 6;
+    int total = 0;
+    for (int w = 0; w < word; ++w) {
+        total += popcount64(words[w]);
+    }
+    const int bit = cell & 63;
+    if (bit > 0) {
+        total += popcount64(words[word] & (~0ULL >> (64 - bit)));
+    }
+    return total;
+}
@@ -0,0 +1,133 @@
+#ifndef BOARD_H
+#define BOARD_H
+
+#include <array>
+#include <cstdint>
+#include <vector>
+#include "Rng.h"
+
+enum class GameVersion {
+    ORIGINAL,
+    MODIFIED
+};
+
+// 八个移动方向：经典版本只用前四个，对角线版本只用后四个
+enum class Direction : uint8_t {
+    UP,
+    DOWN,
+    LEFT,
+    RIGHT,
+    UP_LEFT,
+    UP_RIGHT,
+    DOWN_LEFT,
+    DOWN_RIGHT
+};
+
+int directionDx(Direction dir);
+int directionDy(Direction dir);
+Direction directionFromDelta(int dx, int dy);
+
+// 每个版本只有四个合法方向，回放文件里用 0-3 的下标表示
+int directionIndex(Direction dir);
+Direction directionFromIndex(GameVersion version, int index);
+
+struct MoveResult {
+    int scoreGained = 0;
+    uint32_t mergedExponents = 0; // 本次移动合成出的所有数值（第e位表示合成出了2^e）
+};
+
+struct MovePlan;
+class CellMask;
+
+// 与界面无关的棋盘核心：每格存指数（0为空，1为2，2为4……）
+// 移动规则与原 Game::moveTiles 完全一致，包括对角线向下移动时从上往下处理的顺序
+// 不超过 INLINE_SIZE 的棋盘直接存在对象内部，复制时不分配内存（撤销、回放、搜索里大量复制的都是小棋盘）；
+// 更大的棋盘（活动展示用的超大棋盘，最大 64x64）才放到堆上
+class Board {
+public:
+    static constexpr int MAX_SIZE = 64;
+    static constexpr int MAX_CELLS = MAX_SIZE * MAX_SIZE;
+    static constexpr int INLINE_SIZE = 8;
+
+    Board();
+    explicit Board(int size);
+
+    int size() const { return n; }
+    int cellCount() const { return n * n; }
+
+    uint8_t exponent(int cell) const { return data()[cell]; }
+    void setExponent(int cell, uint8_t exp) { data()[cell] = exp; }
+    // 行优先的全部指数，批量导出局面时整块复制
+    const uint8_t* cells() const { return data(); }
+    uint8_t* cells() { return data(); }
+    void clear();
+    int value(int x, int y) const;
+    void setValue(int x, int y, int value);
+
+    CellMask emptyMask() const;
+    int emptyCount() const;
+    uint8_t maxExponent() const;
+
+    // 执行一次移动，返回是否有方块移动或合并
+    // plan 不为空时顺便记下每个方块的去向，供界面播放滑动动画，不需要事后比对棋盘
+    bool move(Direction dir, MoveResult& result, MovePlan* plan = nullptr);
+    bool isGameOver(GameVersion version) const;
+
+    // 与 Game::addRandomTile 相同的抽取顺序：先抽第k个空格，再抽2或4
+    // 返回生成位置，没有空格时返回-1
+    int spawnRandom(Rng& rng);
+
+    bool operator==(const Board& other) const;
+    bool operator!=(const Board& other) const { return !(*this == other); }
+
+private:
+    uint8_t* data() { return n <= INLINE_SIZE ? inlineCells.data() : heapCells.data(); }
+    const uint8_t* data() const { return n <= INLINE_SIZE ? inlineCells.data() : heapCells.data(); }
+
+    int n;
+    std::array<uint8_t, INLINE_SIZE * INLINE_SIZE> inlineCells;
+    std::vector<uint8_t> heapCells;
+};
+
+// 每格一位的位图（行优先），按64位分字存放，只使用棋盘实际需要的字数
+class CellMask {
+public:
+    static constexpr int MAX_WORDS = Board::MAX_CELLS / 64;
+
+    explicit CellMask(int cellCount = Board::MAX_CELLS);
+
+    bool test(int cell) const { return (words[cell >> 6] >> (cell & 63)) & 1; }
+    void set(int cell) { words[cell >> 6] |= 1ULL << (cell & 63); }
+    void reset(int cell) { words[cell >> 6] &= ~(1ULL << (cell & 63)); }
+    void clear();
+
+    int count() const;
+    // 第 k 个（从0开始）置位的下标，要求 k < count()
+    int select(int k) const;
+    // cell 之前（不含）置位的个数
+    int rank(int cell) const;
+
+    int wordCount() const { return usedWords; }
+    uint64_t word(int index) const { return words[index]; }
+    void setWord(int index, uint64_t value) { words[index] = value; }
+
+private:
+    int usedWords;
+    std::array<uint64_t, MAX_WORDS> words;
+};
+
+// 一个方块在一次移动中的去向，按执行顺序排列
+// 同一个方块可能先被合并、再继续滑动（对角线向下移动时），依次对应多条记录
+struct TileMove {
+    uint16_t from;
+    uint16_t to;
+    uint8_t exponent;   // 到达后终点格的指数
+    bool merged;
+};
+
+struct MovePlan {
+    std::array<TileMove, Board::MAX_CELLS> moves;
+    int count = 0;
+};
+
+#endif // BOARD_H
@@ -0,0 +1,153 @@
+#include "BoardBatch.h"
+#include "BatchMoveKernel.h"
+#include <algorithm>
+
+#if defined(MAO_BATCH_SIMD) && defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+namespace {
+
+bool cpuSupports(BatchKernel kernel) {
+#if !defined(MAO_BATCH_SIMD)
+    (void)kernel;
+    return false;
+#elif defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 0);
+    const int maxLeaf = info[0];
+    __cpuid(info, 1);
+    if (kernel == BatchKernel::SSE41) return (info[2] & (1 << 19)) != 0;
+    // AVX2 还要求操作系统保存 YMM 寄存器（OSXSAVE 且 XCR0 的第1、2位）
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx || maxLeaf < 7 || (_xgetbv(0) & 6) != 6) return false;
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    if (kernel == BatchKernel::SSE41) return __builtin_cpu_supports("sse4.1");
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+// 按 Board::move 的方式枚举一次移动的所有线
+void buildLines(int n, Direction dir, BatchLines& lines) {
+    const int dx = directionDx(dir);
+    const int dy = directionDy(dir);
+    const int step = -(dy * n + dx);
+    lines.count = 0;
+    lines.farFirst = (dx != 0 && dy > 0);
+
+    auto addLine = [&](int x, int y) {
+        const int lengthX = dx > 0 ? x + 1 : (dx < 0 ? n - x : n);
+        const int lengthY = dy > 0 ? y + 1 : (dy < 0 ? n - y : n);
+        lines.lines[lines.count++] = {y * n + x, step, std::min(lengthX, lengthY)};
+    };
+    for (int y = 0; y < n; ++y) {
+        if (y + dy < 0 || y + dy >= n) {
+            for (int x = 0; x < n; ++x) {
+                addLine(x, y);
+            }
+        } else if (dx != 0) {
+            addLine(dx < 0 ? 0 : n - 1, y);
+        }
+    }
+}
+
+} // namespace
+
+bool batchKernelAvailable(BatchKernel kernel) {
+    switch (kernel) {
+        case BatchKernel::AUTO:
+        case BatchKernel::SCALAR:
+            return true;
+        case BatchKernel::SSE41:
+        case BatchKernel::AVX2: {
+            // 只检测一次
+            static const bool sse41 = cpuSupports(BatchKernel::SSE41);
+            static const bool avx2 = cpuSupports(BatchKernel::AVX2);
+            return kernel == BatchKernel::SSE41 ? sse41 : avx2;
+        }
+    }
+    return false;
+}
+
+BatchKernel bestBatchKernel() {
+    if (batchKernelAvailable(BatchKernel::AVX2)) return BatchKernel::AVX2;
+    if (batchKernelAvailable(BatchKernel::SSE41)) return BatchKernel::SSE41;
+    return BatchKernel::SCALAR;
+}
+
+const char* batchKernelName(BatchKernel kernel) {
+    switch (kernel) {
+        case BatchKernel::AUTO: return "auto";
+        case BatchKernel::SCALAR: return "scalar";
+        case BatchKernel::SSE41: return "sse4.1";
+        case BatchKernel::AVX2: return "avx2";
+    }
+    return "?";
+}
+
+BoardBatch::BoardBatch(int size, int count)
+    : n(size),
+      boardCount(count),
+      laneStride((count + LANES - 1) / LANES * LANES),
+      cells(static_cast<size_t>(size) * size * laneStride, 0),
+      scores(laneStride, 0),
+      changedFlags(laneStride, 0) {
+}
+
+void BoardBatch::setBoard(int index, const Board& board) {
+    for (int cell = 0; cell < n * n; ++cell) {
+        lanes(cell)[index] = board.exponent(cell);
+    }
+}
+
+void BoardBatch::getBoard(int index, Board& board) const {
+    if (board.size() != n) board = Board(n);
+    for (int cell = 0; cell < n * n; ++cell) {
+        board.setExponent(cell, lanes(cell)[index]);
+    }
+}
+
+Board BoardBatch::board(int index) const {
+    Board result(n);
+    getBoard(index, result);
+    return result;
+}
+
+int BoardBatch::move(Direction dir, BatchKernel kernel) {
+    if (kernel == BatchKernel::AUTO || !batchKernelAvailable(kernel)) {
+        kernel = bestBatchKernel();
+    }
+    // 向量实现的一条线最多 BatchLines::MAX_LENGTH 格
+    if (n > BatchLines::MAX_LENGTH) kernel = BatchKernel::SCALAR;
+
+    if (kernel == BatchKernel::SCALAR) {
+        Board board(n);
+        for (int i = 0; i < boardCount; ++i) {
+            getBoard(i, board);
+            MoveResult result;
+            changedFlags[i] = board.move(dir, result) ? 1 : 0;
+            scores[i] = static_cast<uint32_t>(result.scoreGained);
+            if (changedFlags[i]) setBoard(i, board);
+        }
+    } else {
+        BatchLines lines;
+        buildLines(n, dir, lines);
+#ifdef MAO_BATCH_SIMD
+        if (kernel == BatchKernel::AVX2) {
+            batchMoveAvx2(lines, cells.data(), laneStride, scores.data(), changedFlags.data());
+        } else {
+            batchMoveSse41(lines, cells.data(), laneStride, scores.data(), changedFlags.data());
+        }
+#endif
+    }
+
+    int changedCount = 0;
+    for (int i = 0; i < boardCount; ++i) {
+        changedCount += changedFlags[i];
+    }
+    return changedCount;
+}
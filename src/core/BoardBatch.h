@@ -0,0 +1,62 @@
+#ifndef BOARD_BATCH_H
+#define BOARD_BATCH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Board.h"
+
+// 批量移动用的实现：
+//   SCALAR 逐个棋盘取出来调用 Board::move，任何平台都能用；
+//   SSE41 / AVX2 一条指令流同时处理16 / 32个棋盘（只支持不超过 Board::INLINE_SIZE 的棋盘）。
+// AUTO 在运行时按CPU支持的指令集选最快的一种
+enum class BatchKernel {
+    AUTO,
+    SCALAR,
+    SSE41,
+    AVX2
+};
+
+bool batchKernelAvailable(BatchKernel kernel);
+BatchKernel bestBatchKernel();
+const char* batchKernelName(BatchKernel kernel);
+
+// 按“结构体数组”转置存放的一批同尺寸棋盘：同一格的所有棋盘连续存放，
+// 第 index 个棋盘的第 cell 格在 lanes(cell)[index]。每格的棋盘数补齐到 LANES 的倍数，
+// 多出来的棋盘始终为空，移动时原地不动。
+// 移动规则与 Board::move 完全一致（包括对角线向下移动从远端处理的顺序），
+// 移动后每个棋盘的得分和是否变化可以逐个查询。
+class BoardBatch {
+public:
+    static constexpr int LANES = 32;
+
+    BoardBatch(int size, int count);
+
+    int size() const { return n; }
+    int count() const { return boardCount; }
+    int stride() const { return laneStride; }
+
+    uint8_t* lanes(int cell) { return &cells[static_cast<size_t>(cell) * laneStride]; }
+    const uint8_t* lanes(int cell) const { return &cells[static_cast<size_t>(cell) * laneStride]; }
+    uint8_t exponent(int index, int cell) const { return lanes(cell)[index]; }
+    void setExponent(int index, int cell, uint8_t exp) { lanes(cell)[index] = exp; }
+
+    void setBoard(int index, const Board& board);
+    void getBoard(int index, Board& board) const;
+    Board board(int index) const;
+
+    // 所有棋盘朝同一方向移动一次，返回发生变化的棋盘数
+    int move(Direction dir, BatchKernel kernel = BatchKernel::AUTO);
+    uint32_t scoreGained(int index) const { return scores[index]; }
+    bool changed(int index) const { return changedFlags[index] != 0; }
+
+private:
+    int n;
+    int boardCount;
+    int laneStride;
+    std::vector<uint8_t> cells;
+    std::vector<uint32_t> scores;
+    std::vector<uint8_t> changedFlags;
+};
+
+#endif // BOARD_BATCH_H
@@ -0,0 +1,262 @@
+#include "BoardEngine.h"
+#include <cstddef>
+#include <utility>
+
+namespace {
+
+constexpr int deltaX(int dir) {
+    switch (static_cast<Direction>(dir)) {
+        case Direction::LEFT:
+        case Direction::UP_LEFT:
+        case Direction::DOWN_LEFT:
+            return -1;
+        case Direction::RIGHT:
+        case Direction::UP_RIGHT:
+        case Direction::DOWN_RIGHT:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+constexpr int deltaY(int dir) {
+    switch (static_cast<Direction>(dir)) {
+        case Direction::UP:
+        case Direction::UP_LEFT:
+        case Direction::UP_RIGHT:
+            return -1;
+        case Direction::DOWN:
+        case Direction::DOWN_LEFT:
+        case Direction::DOWN_RIGHT:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+// 一个方向的所有线，枚举顺序与 Board::move 相同（决定 MovePlan 里的记录顺序）
+template <int N>
+struct LineTable {
+    int count = 0;
+    bool farFirst = false;
+    int length[2 * N - 1] = {};
+    int cells[2 * N - 1][N] = {};   // 第 i 格紧贴边界的是 cells[line][0]
+};
+
+template <int N>
+constexpr void addLine(LineTable<N>& table, int x, int y, int dx, int dy) {
+    const int lengthX = dx > 0 ? x + 1 : (dx < 0 ? N - x : N);
+    const int lengthY = dy > 0 ? y + 1 : (dy < 0 ? N - y : N);
+    const int length = lengthX < lengthY ? lengthX : lengthY;
+    const int stride = -(dy * N + dx);
+    table.length[table.count] = length;
+    for (int i = 0; i < length; ++i) {
+        table.cells[table.count][i] = y * N + x + i * stride;
+    }
+    ++table.count;
+}
+
+template <int N>
+constexpr LineTable<N> makeLines(int dir) {
+    LineTable<N> table;
+    const int dx = deltaX(dir);
+    const int dy = deltaY(dir);
+    table.farFirst = dx != 0 && dy > 0;
+    for (int y = 0; y < N; ++y) {
+        if (y + dy < 0 || y + dy >= N) {
+            for (int x = 0; x < N; ++x) {
+                addLine(table, x, y, dx, dy);
+            }
+        } else if (dx != 0) {
+            addLine(table, dx < 0 ? 0 : N - 1, y, dx, dy);
+        }
+    }
+    return table;
+}
+
+// 判断结束时要比较的相邻格子：经典版本比较右边和下边，对角线版本比较右上和右下
+template <int N>
+struct NeighborTable {
+    int count = 0;
+    int first[2 * N * (N - 1)] = {};
+    int second[2 * N * (N - 1)] = {};
+};
+
+template <int N>
+constexpr void addNeighbor(NeighborTable<N>& table, int first, int second) {
+    table.first[table.count] = first;
+    table.second[table.count] = second;
+    ++table.count;
+}
+
+template <int N>
+constexpr NeighborTable<N> makeNeighbors(GameVersion version) {
+    NeighborTable<N> table;
+    for (int y = 0; y < N; ++y) {
+        for (int x = 0; x < N; ++x) {
+            const int cell = y * N + x;
+            if (version == GameVersion::ORIGINAL) {
+                if (x + 1 < N) addNeighbor(table, cell, cell + 1);
+                if (y + 1 < N) addNeighbor(table, cell, cell + N);
+            } else {
+                if (x + 1 < N && y > 0) addNeighbor(table, cell, cell - N + 1);
+                if (x + 1 < N && y + 1 < N) addNeighbor(table, cell, cell + N + 1);
+            }
+        }
+    }
+    return table;
+}
+
+template <int N>
+struct Tables {
+    static constexpr LineTable<N> lines[8] = {
+        makeLines<N>(0), makeLines<N>(1), makeLines<N>(2), makeLines<N>(3),
+        makeLines<N>(4), makeLines<N>(5), makeLines<N>(6), makeLines<N>(7)
+    };
+    static constexpr NeighborTable<N> neighbors[2] = {
+        makeNeighbors<N>(GameVersion::ORIGINAL), makeNeighbors<N>(GameVersion::MODIFIED)
+    };
+};
+
+// 与 Board.cpp 里的 slideLine 逐步相同，只是线长和处理顺序是编译期常量，格子下标来自常量表
+template <int L, bool FAR_FIRST>
+inline bool slideLine(uint8_t* cells, const int* line, MoveResult& result, MovePlan* plan) {
+    bool moved = false;
+    bool merged[L] = {};
+    int filled = 0;
+
+    for (int step = 0; step < L; ++step) {
+        const int i = FAR_FIRST ? L - 1 - step : step;
+        const int from = line[i];
+        const uint8_t exp = cells[from];
+        if (exp == 0) continue;
+
+        int pos = filled;
+        if (FAR_FIRST) {
+            pos = i;
+            while (pos > 0 && cells[line[pos - 1]] == 0) {
+                --pos;
+            }
+        }
+
+        if (pos > 0 && cells[line[pos - 1]] == exp && !merged[pos - 1]) {
+            const int before = line[pos - 1];
+            merged[pos - 1] = true;
+            cells[before] = static_cast<uint8_t>(exp + 1);
+            cells[from] = 0;
+            result.scoreGained += 1 << (exp + 1);
+            result.mergedExponents |= 1u << (exp + 1);
+            moved = true;
+            if (plan) {
+                plan->moves[plan->count++] = {static_cast<uint16_t>(from), static_cast<uint16_t>(before),
+                                              static_cast<uint8_t>(exp + 1), true};
+            }
+        } else {
+            if (pos != i) {
+                const int to = line[pos];
+                cells[to] = exp;
+                cells[from] = 0;
+                moved = true;
+                if (plan) {
+                    plan->moves[plan->count++] = {static_cast<uint16_t>(from), static_cast<uint16_t>(to), exp, false};
+                }
+            }
+            filled = pos + 1;
+        }
+    }
+    return moved;
+}
+
+// 逐条线展开：线的下标是编译期常量，所以每条线的长度也是
+template <int N, int D, size_t... LINE>
+inline bool moveLines(uint8_t* cells, MoveResult& result, MovePlan* plan, std::index_sequence<LINE...>) {
+    constexpr const LineTable<N>& table = Tables<N>::lines[D];
+    bool moved = false;
+    ((moved |= slideLine<table.length[LINE], table.farFirst>(cells, table.cells[LINE], result, plan)), ...);
+    return moved;
+}
+
+template <int N, int D>
+bool moveDirection(Board& board, MoveResult& result, MovePlan* plan) {
+    if (plan) {
+        plan->count = 0;
+    }
+    return moveLines<N, D>(board.cells(), result, plan, std::make_index_sequence<Tables<N>::lines[D].count>());
+}
+
+template <int N, GameVersion V>
+struct BoardEngine {
+    static constexpr int BASE = V == GameVersion::ORIGINAL ? 0 : 4;
+
+    static bool move(Board& board, Direction dir, MoveResult& result, MovePlan* plan) {
+        if (board.size() != N) return board.move(dir, result, plan);
+        switch (static_cast<int>(dir) - BASE) {
+            case 0: return moveDirection<N, BASE + 0>(board, result, plan);
+            case 1: return moveDirection<N, BASE + 1>(board, result, plan);
+            case 2: return moveDirection<N, BASE + 2>(board, result, plan);
+            case 3: return moveDirection<N, BASE + 3>(board, result, plan);
+            default: return board.move(dir, result, plan);
+        }
+    }
+
+    static bool isGameOver(const Board& board) {
+        if (board.size() != N) return board.isGameOver(V);
+        const uint8_t* cells = board.cells();
+        for (int i = 0; i < N * N; ++i) {
+            if (cells[i] == 0) return false;
+        }
+        constexpr const NeighborTable<N>& neighbors = Tables<N>::neighbors[static_cast<int>(V)];
+        for (int k = 0; k < neighbors.count; ++k) {
+            if (cells[neighbors.first[k]] == cells[neighbors.second[k]]) return false;
+        }
+        return true;
+    }
+};
+
+bool genericMove(Board& board, Direction dir, MoveResult& result, MovePlan* plan) {
+    return board.move(dir, result, plan);
+}
+
+template <GameVersion V>
+bool genericIsGameOver(const Board& board) {
+    return board.isGameOver(V);
+}
+
+template <int N, GameVersion V>
+constexpr BoardRules specialized() {
+    return {N, V, &BoardEngine<N, V>::move, &BoardEngine<N, V>::isGameOver};
+}
+
+template <int N>
+constexpr BoardRules specialized(GameVersion version) {
+    return version == GameVersion::ORIGINAL ? specialized<N, GameVersion::ORIGINAL>()
+                                            : specialized<N, GameVersion::MODIFIED>();
+}
+
+// 下标为 尺寸 - 2
+const BoardRules SPECIALIZED_RULES[][2] = {
+    {specialized<2>(GameVersion::ORIGINAL), specialized<2>(GameVersion::MODIFIED)},
+    {specialized<3>(GameVersion::ORIGINAL), specialized<3>(GameVersion::MODIFIED)},
+    {specialized<4>(GameVersion::ORIGINAL), specialized<4>(GameVersion::MODIFIED)},
+    {specialized<5>(GameVersion::ORIGINAL), specialized<5>(GameVersion::MODIFIED)},
+    {specialized<6>(GameVersion::ORIGINAL), specialized<6>(GameVersion::MODIFIED)},
+    {specialized<7>(GameVersion::ORIGINAL), specialized<7>(GameVersion::MODIFIED)},
+    {specialized<8>(GameVersion::ORIGINAL), specialized<8>(GameVersion::MODIFIED)},
+};
+static_assert(sizeof(SPECIALIZED_RULES) / sizeof(SPECIALIZED_RULES[0]) == BoardRules::MAX_SPECIALIZED_SIZE - 1,
+              "one row per specialized size");
+
+const BoardRules GENERIC_RULES[2] = {
+    {0, GameVersion::ORIGINAL, &genericMove, &genericIsGameOver<GameVersion::ORIGINAL>},
+    {0, GameVersion::MODIFIED, &genericMove, &genericIsGameOver<GameVersion::MODIFIED>},
+};
+
+} // namespace
+
+const BoardRules& boardRules(int size, GameVersion version) {
+    const int v = static_cast<int>(version);
+    if (size >= 2 && size <= BoardRules::MAX_SPECIALIZED_SIZE) {
+        return SPECIALIZED_RULES[size - 2][v];
+    }
+    return GENERIC_RULES[v];
+}
@@ -0,0 +1,23 @@
+#ifndef BOARD_ENGINE_H
+#define BOARD_ENGINE_H
+
+#include "Board.h"
+
+// 按棋盘尺寸和版本特化的规则（BoardEngine<N, V>，实现在 BoardEngine.cpp）：
+// 每个方向的每条线经过哪些格子、判断结束时要比较的相邻格子，都在编译期生成成常量表，
+// 每条线的长度是编译期常量，滑动和合并的循环全部展开，运行时不再计算坐标、判断尺寸和版本。
+// 开局时用 boardRules 按尺寸和版本选一次，之后直接调用函数指针；
+// 超过 MAX_SPECIALIZED_SIZE 的棋盘退回 Board::move / Board::isGameOver。结果与通用实现完全一致。
+struct BoardRules {
+    static constexpr int MAX_SPECIALIZED_SIZE = Board::INLINE_SIZE;
+
+    int size;               // 特化的尺寸，0 表示通用实现
+    GameVersion version;
+    // 尺寸和选规则时不一样的棋盘、不属于这个版本的方向都交给 Board 的通用实现
+    bool (*move)(Board& board, Direction dir, MoveResult& result, MovePlan* plan);
+    bool (*isGameOver)(const Board& board);
+};
+
+const BoardRules& boardRules(int size, GameVersion version);
+
+#endif // BOARD_ENGINE_H
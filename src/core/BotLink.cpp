@@ -0,0 +1,145 @@
+#include "BotLink.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr uint32_t BOT_MAGIC = 0x544F424D;  // "MBOT"
+
+// 状态里棋盘之前的部分（命令编号、分数等）
+constexpr size_t STATE_HEADER_SIZE = offsetof(BotState, cells);
+
+} // namespace
+
+BotLink::BotLink() : segment(nullptr), owner(false) {
+}
+
+BotLink::~BotLink() {
+    close();
+}
+
+bool BotLink::create(const std::string& name) {
+    close();
+    shm_unlink(name.c_str());
+    const int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0) {
+        std::cerr << "Failed to create shared memory " << name << std::endl;
+        return false;
+    }
+    if (ftruncate(fd, sizeof(BotSegment)) != 0) {
+        std::cerr << "Failed to size shared memory " << name << std::endl;
+        ::close(fd);
+        shm_unlink(name.c_str());
+        return false;
+    }
+    void* mapped = mmap(nullptr, sizeof(BotSegment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        std::cerr << "Failed to map shared memory " << name << std::endl;
+        shm_unlink(name.c_str());
+        return false;
+    }
+
+    // 新建的段全是0；原子变量在这里原地构造，magic 最后写，代理看到 magic 才认为段已就绪
+    segment = static_cast<BotSegment*>(mapped);
+    new (&segment->stateSequence) std::atomic<uint64_t>(0);
+    new (&segment->commandHead) std::atomic<uint64_t>(0);
+    new (&segment->commandTail) std::atomic<uint64_t>(0);
+    new (&segment->renderEvery) std::atomic<uint32_t>(0);
+    segment->protocol = BOT_PROTOCOL_VERSION;
+    segment->segmentSize = sizeof(BotSegment);
+    segment->gameProcess = static_cast<uint32_t>(getpid());
+    std::atomic_thread_fence(std::memory_order_release);
+    segment->magic = BOT_MAGIC;
+    segmentName = name;
+    owner = true;
+    return true;
+}
+
+bool BotLink::attach(const std::string& name) {
+    close();
+    const int fd = shm_open(name.c_str(), O_RDWR, 0600);
+    if (fd < 0) {
+        std::cerr << "Shared memory " << name << " not found (is the game running with --bot?)" << std::endl;
+        return false;
+    }
+    void* mapped = mmap(nullptr, sizeof(BotSegment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        std::cerr << "Failed to map shared memory " << name << std::endl;
+        return false;
+    }
+    BotSegment* candidate = static_cast<BotSegment*>(mapped);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (candidate->magic != BOT_MAGIC || candidate->protocol != BOT_PROTOCOL_VERSION ||
+        candidate->segmentSize != sizeof(BotSegment)) {
+        std::cerr << "Shared memory " << name << " has an incompatible layout" << std::endl;
+        munmap(mapped, sizeof(BotSegment));
+        return false;
+    }
+    segment = candidate;
+    segmentName = name;
+    owner = false;
+    return true;
+}
+
+void BotLink::close() {
+    if (!segment) return;
+    munmap(segment, sizeof(BotSegment));
+    if (owner) shm_unlink(segmentName.c_str());
+    segment = nullptr;
+    owner = false;
+}
+
+bool BotLink::popCommand(BotCommand& command) {
+    const uint64_t tail = segment->commandTail.load(std::memory_order_relaxed);
+    if (tail == segment->commandHead.load(std::memory_order_acquire)) return false;
+    command = segment->commands[tail & (BOT_COMMAND_CAPACITY - 1)];
+    segment->commandTail.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+void BotLink::publish(const BotState& state) {
+    // 序号锁的写端：先把序号改成奇数，写完再改成下一个偶数
+    const uint64_t sequence = segment->stateSequence.load(std::memory_order_relaxed);
+    segment->stateSequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(static_cast<void*>(&segment->state), &state, STATE_HEADER_SIZE);
+    segment->state.published = sequence / 2 + 1;
+    std::memcpy(segment->state.cells, state.cells, static_cast<size_t>(state.gridSize) * state.gridSize);
+    segment->stateSequence.store(sequence + 2, std::memory_order_release);
+}
+
+uint32_t BotLink::renderEvery() const {
+    return segment->renderEvery.load(std::memory_order_relaxed);
+}
+
+bool BotLink::pushCommand(const BotCommand& command) {
+    const uint64_t head = segment->commandHead.load(std::memory_order_relaxed);
+    if (head - segment->commandTail.load(std::memory_order_acquire) >= BOT_COMMAND_CAPACITY) return false;
+    segment->commands[head & (BOT_COMMAND_CAPACITY - 1)] = command;
+    segment->commandHead.store(head + 1, std::memory_order_release);
+    return true;
+}
+
+bool BotLink::readState(BotState& state) const {
+    if (!segment) return false;
+    while (true) {
+        const uint64_t before = segment->stateSequence.load(std::memory_order_acquire);
+        if (before & 1) continue;
+        std::memcpy(static_cast<void*>(&state), &segment->state, STATE_HEADER_SIZE);
+        const size_t cells = std::min<size_t>(static_cast<size_t>(state.gridSize) * state.gridSize, Board::MAX_CELLS);
+        std::memcpy(state.cells, segment->state.cells, cells);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (segment->stateSequence.load(std::memory_order_relaxed) == before) return true;
+    }
+}
+
+void BotLink::setRenderEvery(uint32_t every) {
+    segment->renderEvery.store(every, std::memory_order_relaxed);
+}
@@ -0,0 +1,100 @@
+#ifndef BOT_LINK_H
+#define BOT_LINK_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "Board.h"
+
+// 外部程序（机器人、强化学习代理）驱动游戏用的共享内存接口（POSIX shm_open + mmap）。
+// 游戏创建共享内存段，代理连接同一个名字：
+//   - 代理往命令环里写命令（单生产者单消费者，下标一直递增），游戏每帧取走执行；
+//   - 游戏每执行一条命令就发布一次局面（棋盘指数、分数、合法方向、最后执行的命令编号），
+//     用序号锁（seqlock）保护：写时序号为奇数，读者看到前后序号相同且为偶数才算读到完整的局面。
+// 游戏这一侧取命令、发布局面都不加锁、不等待，代理再慢也挡不住游戏的主循环；
+// 局面直接写在共享内存里，代理直接读，没有序列化和系统调用。
+constexpr uint32_t BOT_PROTOCOL_VERSION = 1;
+constexpr size_t BOT_COMMAND_CAPACITY = 1024;   // 2的幂
+
+enum class BotOp : uint32_t {
+    NONE,
+    MOVE,       // arg 为方向下标 0-3（与回放文件相同，见 directionFromIndex）
+    RESET,      // arg 为 棋盘尺寸 | (GameVersion << 8)，尺寸为0时按当前的尺寸和版本重开
+    UNDO
+};
+
+struct BotCommand {
+    BotOp op = BotOp::NONE;
+    uint32_t arg = 0;
+    uint64_t id = 0;    // 由代理编号，执行后出现在 BotState::lastCommand 里
+};
+
+// 游戏发布的局面
+struct BotState {
+    uint64_t lastCommand = 0;   // 最后执行的命令编号
+    uint64_t published = 0;     // 发布次数（由 BotLink::publish 填写）
+    uint32_t score = 0;
+    uint32_t moveCount = 0;
+    uint8_t gridSize = 0;
+    uint8_t version = 0;        // GameVersion
+    uint8_t legalMoves = 0;     // 第i位表示方向下标i可以移动
+    uint8_t gameOver = 0;
+    uint8_t lastMoveChanged = 0;    // 最后一条命令是否改变了棋盘
+    uint8_t reserved[7] = {};
+    uint8_t cells[Board::MAX_CELLS] = {};   // 行优先的指数，只有前 gridSize*gridSize 个有效
+};
+
+// 共享内存段的布局。两边都按这个结构直接访问，原子变量必须是无锁的才能跨进程使用
+struct BotSegment {
+    uint32_t magic;
+    uint32_t protocol;
+    uint32_t segmentSize;
+    uint32_t gameProcess;
+
+    alignas(64) std::atomic<uint64_t> stateSequence;
+    BotState state;
+
+    alignas(64) std::atomic<uint64_t> commandHead;  // 代理写
+    alignas(64) std::atomic<uint64_t> commandTail;  // 游戏写
+    // 代理写：0 表示每帧照常绘制；N > 0 表示不再每帧绘制，只在执行了 N 条命令后画一次当前局面
+    alignas(64) std::atomic<uint32_t> renderEvery;
+    BotCommand commands[BOT_COMMAND_CAPACITY];
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "shared memory atomics must be lock-free");
+
+class BotLink {
+public:
+    BotLink();
+    ~BotLink();
+
+    BotLink(const BotLink&) = delete;
+    BotLink& operator=(const BotLink&) = delete;
+
+    // 游戏端：创建共享内存段（同名的旧段会被替换），name 形如 "/mao_bot"
+    bool create(const std::string& name);
+    // 代理端：连接游戏创建的段
+    bool attach(const std::string& name);
+    void close();
+    bool isOpen() const { return segment != nullptr; }
+
+    // 游戏端：取一条命令，没有命令时返回 false
+    bool popCommand(BotCommand& command);
+    // 游戏端：发布局面，只复制棋盘实际用到的格子
+    void publish(const BotState& state);
+    uint32_t renderEvery() const;
+
+    // 代理端：写入一条命令，命令环满时返回 false
+    bool pushCommand(const BotCommand& command);
+    // 代理端：读到一份完整的局面（游戏正在写时重试）
+    bool readState(BotState& state) const;
+    void setRenderEvery(uint32_t every);
+
+private:
+    BotSegment* segment;
+    std::string segmentName;
+    bool owner;
+};
+
+#endif // BOT_LINK_H
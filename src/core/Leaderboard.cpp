@@ -0,0 +1,619 @@
+#include "Leaderboard.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+
+const uint8_t LEADERBOARD_MAGIC[4] = {'M', 'A', 'O', 'L'};
+constexpr uint8_t LEADERBOARD_FORMAT_VERSION = 2;   // 版本1没有段表，只能读取或整体转换
+constexpr long LEADERBOARD_HEADER_SIZE = 16;
+constexpr size_t STREAM_CHUNK = 256;   // 归并时每段一次读入的条数
+
+// 每层同时最多有两段在归并、一段在等待，64层也用不满
+constexpr size_t MAX_RUNS = 128;
+// 段表槽位: 序号(8) | 记录总数(8) | 段数(4) | MAX_RUNS 个 (起始下标(8), 条数(8)) | 校验和(4)
+constexpr long RUN_TABLE_SIZE = 8 + 8 + 4 + MAX_RUNS * 16 + 4;
+constexpr long DATA_START = LEADERBOARD_HEADER_SIZE + 2 * RUN_TABLE_SIZE;
+// 每次插入给每个归并推进的输出条数；长度 2^k 的两段要 2^(k+1)/4 次插入做完，
+// 而下一对同样长度的段至少要 2^(k+1) 次插入才会凑齐，所以归并不会积压
+constexpr uint64_t MERGE_STEP = 4;
+
+// 记录布局: 分数(4) | 步数(4) | 最大指数 | 保留(3) | 时间(8) | 机器编号(4)
+void encodeEntry(const LeaderboardEntry& entry, uint8_t* out) {
+    std::memset(out, 0, Leaderboard::RECORD_SIZE);
+    for (int i = 0; i < 4; ++i) out[i] = static_cast<uint8_t>(entry.score >> (8 * i));
+    for (int i = 0; i < 4; ++i) out[4 + i] = static_cast<uint8_t>(entry.moves >> (8 * i));
+    out[8] = entry.maxExponent;
+    uint64_t time = static_cast<uint64_t>(entry.timestamp);
+    for (int i = 0; i < 8; ++i) out[12 + i] = static_cast<uint8_t>(time >> (8 * i));
+    for (int i = 0; i < 4; ++i) out[20 + i] = static_cast<uint8_t>(entry.kioskId >> (8 * i));
+}
+
+LeaderboardEntry decodeEntry(const uint8_t* in) {
+    LeaderboardEntry entry;
+    for (int i = 0; i < 4; ++i) entry.score |= static_cast<uint32_t>(in[i]) << (8 * i);
+    for (int i = 0; i < 4; ++i) entry.moves |= static_cast<uint32_t>(in[4 + i]) << (8 * i);
+    entry.maxExponent = in[8];
+    uint64_t time = 0;
+    for (int i = 0; i < 8; ++i) time |= static_cast<uint64_t>(in[12 + i]) << (8 * i);
+    entry.timestamp = static_cast<int64_t>(time);
+    for (int i = 0; i < 4; ++i) entry.kioskId |= static_cast<uint32_t>(in[20 + i]) << (8 * i);
+    return entry;
+}
+
+bool readEntries(FILE* file, long offset, size_t count, std::vector<LeaderboardEntry>& out) {
+    std::vector<uint8_t> bytes(count * Leaderboard::RECORD_SIZE);
+    if (fseek(file, offset, SEEK_SET) != 0 || fread(bytes.data(), 1, bytes.size(), file) != bytes.size()) {
+        return false;
+    }
+    out.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        out[i] = decodeEntry(&bytes[i * Leaderboard::RECORD_SIZE]);
+    }
+    return true;
+}
+
+bool writeEntries(FILE* file, long offset, const std::vector<LeaderboardEntry>& entries) {
+    std::vector<uint8_t> bytes(entries.size() * Leaderboard::RECORD_SIZE);
+    for (size_t i = 0; i < entries.size(); ++i) {
+        encodeEntry(entries[i], &bytes[i * Leaderboard::RECORD_SIZE]);
+    }
+    return fseek(file, offset, SEEK_SET) == 0 && fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size();
+}
+
+void encodeHeader(uint8_t* out, int gridSize, GameVersion version) {
+    std::memset(out, 0, LEADERBOARD_HEADER_SIZE);
+    std::memcpy(out, LEADERBOARD_MAGIC, 4);
+    out[4] = LEADERBOARD_FORMAT_VERSION;
+    out[5] = static_cast<uint8_t>(gridSize);
+    out[6] = static_cast<uint8_t>(version);
+}
+
+void putU64(uint8_t* out, uint64_t value) {
+    for (int i = 0; i < 8; ++i) out[i] = static_cast<uint8_t>(value >> (8 * i));
+}
+
+uint64_t getU64(const uint8_t* in) {
+    uint64_t value = 0;
+    for (int i = 0; i < 8; ++i) value |= static_cast<uint64_t>(in[i]) << (8 * i);
+    return value;
+}
+
+uint32_t fnv1a(const uint8_t* data, size_t length) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; ++i) {
+        hash ^= data[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+void encodeRunTable(uint8_t* out, uint64_t sequence, uint64_t count, const uint64_t* runs, size_t runCount) {
+    std::memset(out, 0, RUN_TABLE_SIZE);
+    putU64(out, sequence);
+    putU64(out + 8, count);
+    for (int i = 0; i < 4; ++i) out[16 + i] = static_cast<uint8_t>(runCount >> (8 * i));
+    for (size_t i = 0; i < runCount * 2; ++i) {
+        putU64(out + 20 + i * 8, runs[i]);
+    }
+    const uint32_t checksum = fnv1a(out, RUN_TABLE_SIZE - 4);
+    for (int i = 0; i < 4; ++i) out[RUN_TABLE_SIZE - 4 + i] = static_cast<uint8_t>(checksum >> (8 * i));
+}
+
+void syncDescriptor(int fd) {
+#if defined(_WIN32)
+    _commit(fd);
+#elif defined(__APPLE__)
+    fsync(fd);
+#else
+    fdatasync(fd);
+#endif
+}
+
+bool flushAndSync(FILE* file) {
+    if (fflush(file) != 0) return false;
+    syncDescriptor(fileno(file));
+    return true;
+}
+
+bool isPowerOfTwo(uint64_t value) {
+    return value != 0 && (value & (value - 1)) == 0;
+}
+
+} // namespace
+
+bool leaderboardBetter(const LeaderboardEntry& a, const LeaderboardEntry& b) {
+    if (a.score != b.score) return a.score > b.score;
+    if (a.moves != b.moves) return a.moves < b.moves;
+    if (a.timestamp != b.timestamp) return a.timestamp < b.timestamp;
+    return a.kioskId < b.kioskId;
+}
+
+bool operator==(const LeaderboardEntry& a, const LeaderboardEntry& b) {
+    return a.score == b.score && a.moves == b.moves && a.maxExponent == b.maxExponent &&
+           a.timestamp == b.timestamp && a.kioskId == b.kioskId;
+}
+
+void LeaderboardStream::addRun(const LeaderboardRun& run) {
+    if (run.count == 0) return;
+    Cursor cursor;
+    cursor.run = run;
+    cursors.push_back(cursor);
+}
+
+bool LeaderboardStream::refill(Cursor& cursor) {
+    if (cursor.position >= cursor.run.count) return false;
+
+    size_t count = static_cast<size_t>(std::min<uint64_t>(STREAM_CHUNK, cursor.run.count - cursor.position));
+    long offset = cursor.run.offset + static_cast<long>(cursor.position * Leaderboard::RECORD_SIZE);
+    if (!readEntries(cursor.run.file, offset, count, cursor.buffer)) {
+        std::cerr << "Failed to read leaderboard records" << std::endl;
+        cursor.position = cursor.run.count;
+        return false;
+    }
+    cursor.position += count;
+    cursor.bufferPos = 0;
+    return true;
+}
+
+bool LeaderboardStream::next(LeaderboardEntry& entry) {
+    // 堆顶是当前最好的一段；比较函数返回 a 比 b 差，std 堆就成了“最好者在顶”
+    auto worse = [this](size_t a, size_t b) {
+        const Cursor& ca = cursors[a];
+        const Cursor& cb = cursors[b];
+        return leaderboardBetter(cb.buffer[cb.bufferPos], ca.buffer[ca.bufferPos]);
+    };
+
+    if (!started) {
+        started = true;
+        for (size_t i = 0; i < cursors.size(); ++i) {
+            if (refill(cursors[i])) {
+                heap.push_back(i);
+            }
+        }
+        std::make_heap(heap.begin(), heap.end(), worse);
+    }
+    if (heap.empty()) return false;
+
+    std::pop_heap(heap.begin(), heap.end(), worse);
+    Cursor& cursor = cursors[heap.back()];
+    entry = cursor.buffer[cursor.bufferPos++];
+    if (cursor.bufferPos < cursor.buffer.size() || refill(cursor)) {
+        std::push_heap(heap.begin(), heap.end(), worse);
+    } else {
+        heap.pop_back();
+    }
+    return true;
+}
+
+Leaderboard::Leaderboard()
+    : file(nullptr), boardSize(0), gameVersion(GameVersion::ORIGINAL), entryCount(0),
+      formatVersion(LEADERBOARD_FORMAT_VERSION), dataStart(DATA_START), sequence(0), merges(64) {
+}
+
+Leaderboard::~Leaderboard() {
+    close();
+}
+
+long Leaderboard::recordPosition(uint64_t index) const {
+    return dataStart + static_cast<long>(index * RECORD_SIZE);
+}
+
+bool Leaderboard::readHeader() {
+    uint8_t header[LEADERBOARD_HEADER_SIZE];
+    if (fseek(file, 0, SEEK_SET) != 0 || fread(header, 1, LEADERBOARD_HEADER_SIZE, file) != LEADERBOARD_HEADER_SIZE ||
+        std::memcmp(header, LEADERBOARD_MAGIC, 4) != 0 || header[4] < 1 || header[4] > LEADERBOARD_FORMAT_VERSION) {
+        return false;
+    }
+    formatVersion = header[4];
+    boardSize = header[5];
+    gameVersion = header[6] == 0 ? GameVersion::ORIGINAL : GameVersion::MODIFIED;
+    if (formatVersion >= 2) {
+        dataStart = DATA_START;
+        return readRunTable();
+    }
+
+    // 版本1: 头里是记录总数，段长就是它二进制中为1的各位，从大到小首尾相接
+    dataStart = LEADERBOARD_HEADER_SIZE;
+    entryCount = getU64(header + 8);
+    runList.clear();
+    uint64_t start = 0;
+    for (int bit = 63; bit >= 0; --bit) {
+        const uint64_t length = entryCount & (1ULL << bit);
+        if (!length) continue;
+        StoredRun run;
+        run.start = start;
+        run.count = length;
+        runList.push_back(run);
+        start += length;
+    }
+    // 记录总数决定了段的划分，文件比它短说明已经损坏
+    return fseek(file, 0, SEEK_END) == 0 && ftell(file) >= recordPosition(entryCount);
+}
+
+bool Leaderboard::readRunTable() {
+    if (fseek(file, 0, SEEK_END) != 0) return false;
+    const long fileSize = ftell(file);
+
+    bool found = false;
+    std::vector<uint8_t> table(RUN_TABLE_SIZE);
+    for (int slot = 0; slot < 2; ++slot) {
+        if (fseek(file, LEADERBOARD_HEADER_SIZE + slot * RUN_TABLE_SIZE, SEEK_SET) != 0 ||
+            fread(table.data(), 1, table.size(), file) != table.size()) {
+            continue;
+        }
+        uint32_t checksum = 0;
+        for (int i = 0; i < 4; ++i) checksum |= static_cast<uint32_t>(table[RUN_TABLE_SIZE - 4 + i]) << (8 * i);
+        if (checksum != fnv1a(table.data(), RUN_TABLE_SIZE - 4)) continue;  // 写到一半的槽位
+        const uint64_t slotSequence = getU64(&table[0]);
+        if (found && slotSequence <= sequence) continue;
+
+        uint32_t runCount = 0;
+        for (int i = 0; i < 4; ++i) runCount |= static_cast<uint32_t>(table[16 + i]) << (8 * i);
+        if (runCount > MAX_RUNS) continue;
+        std::vector<StoredRun> slotRuns(runCount);
+        uint64_t total = 0;
+        bool valid = true;
+        for (uint32_t i = 0; i < runCount && valid; ++i) {
+            slotRuns[i].start = getU64(&table[20 + i * 16]);
+            slotRuns[i].count = getU64(&table[28 + i * 16]);
+            total += slotRuns[i].count;
+            // 段长是2的幂且按长度对齐，数据必须都在文件里
+            valid = isPowerOfTwo(slotRuns[i].count) && slotRuns[i].start % slotRuns[i].count == 0 &&
+                    recordPosition(slotRuns[i].start + slotRuns[i].count) <= fileSize;
+        }
+        if (!valid || total != getU64(&table[8])) continue;
+
+        found = true;
+        sequence = slotSequence;
+        entryCount = total;
+        runList.swap(slotRuns);
+    }
+    for (Merge& merge : merges) {
+        merge.active = false;
+    }
+    pendingFree.clear();
+    return found;
+}
+
+bool Leaderboard::commitRunTable() {
+    std::vector<uint64_t> runs;
+    runs.reserve(runList.size() * 2);
+    for (const StoredRun& run : runList) {
+        runs.push_back(run.start);
+        runs.push_back(run.count);
+    }
+    // 写进较旧的槽位：写到一半断电时，另一个槽位仍是完整的上一次提交
+    const uint64_t next = sequence + 1;
+    uint8_t table[RUN_TABLE_SIZE];
+    encodeRunTable(table, next, entryCount, runs.data(), runList.size());
+    if (fseek(file, LEADERBOARD_HEADER_SIZE + static_cast<long>(next % 2) * RUN_TABLE_SIZE, SEEK_SET) != 0 ||
+        fwrite(table, 1, RUN_TABLE_SIZE, file) != static_cast<size_t>(RUN_TABLE_SIZE) || !flushAndSync(file)) {
+        return false;
+    }
+    sequence = next;
+    pendingFree.clear();
+    return true;
+}
+
+uint64_t Leaderboard::allocate(uint64_t count) const {
+    // 所有占用的块都是按自身长度对齐的2的幂，按起点排序后在空隙里找第一个对齐的位置即可
+    std::vector<StoredRun> used(runList.begin(), runList.end());
+    used.insert(used.end(), pendingFree.begin(), pendingFree.end());
+    for (size_t level = 0; level < merges.size(); ++level) {
+        if (!merges[level].active) continue;
+        StoredRun output;
+        output.start = merges[level].outputStart;
+        output.count = 2ULL << level;
+        used.push_back(output);
+    }
+    std::sort(used.begin(), used.end(), [](const StoredRun& a, const StoredRun& b) { return a.start < b.start; });
+
+    uint64_t candidate = 0;
+    for (const StoredRun& block : used) {
+        if (candidate + count <= block.start) break;
+        const uint64_t end = block.start + block.count;
+        candidate = std::max(candidate, (end + count - 1) / count * count);
+    }
+    return candidate;
+}
+
+bool Leaderboard::stepMerge(Merge& merge) {
+    std::vector<LeaderboardEntry> left;
+    std::vector<LeaderboardEntry> right;
+    const size_t takeLeft = static_cast<size_t>(std::min(MERGE_STEP, merge.left.count - merge.doneLeft));
+    const size_t takeRight = static_cast<size_t>(std::min(MERGE_STEP, merge.right.count - merge.doneRight));
+    if ((takeLeft > 0 && !readEntries(file, recordPosition(merge.left.start + merge.doneLeft), takeLeft, left)) ||
+        (takeRight > 0 && !readEntries(file, recordPosition(merge.right.start + merge.doneRight), takeRight, right))) {
+        return false;
+    }
+
+    // 每边读了 MERGE_STEP 条，输出满 MERGE_STEP 条之前不会有一边的缓冲先用完而那一段还没读完
+    std::vector<LeaderboardEntry> output;
+    size_t i = 0;
+    size_t j = 0;
+    while (output.size() < MERGE_STEP && (i < left.size() || j < right.size())) {
+        if (j == right.size() || (i < left.size() && !leaderboardBetter(right[j], left[i]))) {
+            output.push_back(left[i++]);
+        } else {
+            output.push_back(right[j++]);
+        }
+    }
+    if (!writeEntries(file, recordPosition(merge.outputStart + merge.doneLeft + merge.doneRight), output)) {
+        return false;
+    }
+    merge.doneLeft += i;
+    merge.doneRight += j;
+    return true;
+}
+
+bool Leaderboard::advanceMerges() {
+    // 从短到长逐层处理，低层做完的输出段当次就能参与上一层
+    for (size_t level = 0; level < merges.size(); ++level) {
+        Merge& merge = merges[level];
+        const uint64_t length = 1ULL << level;
+        if (!merge.active) {
+            int found = 0;
+            for (const StoredRun& run : runList) {
+                if (run.count != length) continue;
+                (found == 0 ? merge.left : merge.right) = run;
+                if (++found == 2) break;
+            }
+            if (found < 2) continue;
+            merge.outputStart = allocate(2 * length);
+            merge.doneLeft = 0;
+            merge.doneRight = 0;
+            merge.active = true;
+        }
+
+        if (!stepMerge(merge)) return false;
+        if (merge.doneLeft < length || merge.doneRight < length) continue;
+
+        // 输出段换下两个输入段；输入段在段表提交之前还不能被重新分配
+        merge.active = false;
+        for (size_t i = runList.size(); i-- > 0;) {
+            const StoredRun& run = runList[i];
+            if (run.start == merge.left.start || run.start == merge.right.start) {
+                pendingFree.push_back(run);
+                runList.erase(runList.begin() + static_cast<long>(i));
+            }
+        }
+        StoredRun output;
+        output.start = merge.outputStart;
+        output.count = 2 * length;
+        runList.push_back(output);
+    }
+    return true;
+}
+
+bool Leaderboard::open(const std::string& filename, int gridSize, GameVersion version) {
+    close();
+
+    file = fopen(filename.c_str(), "r+b");
+    if (!file) {
+        file = fopen(filename.c_str(), "w+b");
+        if (!file) {
+            std::cerr << "Failed to create leaderboard file: " << filename << std::endl;
+            return false;
+        }
+        uint8_t header[LEADERBOARD_HEADER_SIZE];
+        encodeHeader(header, gridSize, version);
+        boardSize = gridSize;
+        gameVersion = version;
+        entryCount = 0;
+        sequence = 0;
+        formatVersion = LEADERBOARD_FORMAT_VERSION;
+        dataStart = DATA_START;
+        runList.clear();
+        if (fwrite(header, 1, LEADERBOARD_HEADER_SIZE, file) != LEADERBOARD_HEADER_SIZE || !commitRunTable()) {
+            std::cerr << "Failed to write leaderboard file: " << filename << std::endl;
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    if (!readHeader() || boardSize != gridSize || gameVersion != version) {
+        std::cerr << "Leaderboard file is invalid or belongs to another mode: " << filename << std::endl;
+        close();
+        return false;
+    }
+    if (formatVersion < LEADERBOARD_FORMAT_VERSION) {
+        // 旧格式整体重写一次（临时文件 + 原子替换），之后按新格式打开
+        LeaderboardStream stream;
+        for (const LeaderboardRun& run : runs()) {
+            stream.addRun(run);
+        }
+        uint64_t written = 0;
+        const bool converted = writeSorted(filename, gridSize, version, stream, false, written);
+        close();
+        if (!converted) {
+            std::cerr << "Failed to convert leaderboard file: " << filename << std::endl;
+            return false;
+        }
+        return open(filename, gridSize, version);
+    }
+    return true;
+}
+
+bool Leaderboard::openExisting(const std::string& filename) {
+    close();
+
+    file = fopen(filename.c_str(), "rb");
+    if (!file) {
+        std::cerr << "Failed to open leaderboard file: " << filename << std::endl;
+        return false;
+    }
+    if (!readHeader()) {
+        std::cerr << "Not a valid leaderboard file: " << filename << std::endl;
+        close();
+        return false;
+    }
+    return true;
+}
+
+void Leaderboard::close() {
+    // 没做完的归并直接丢掉：输出写在段表没有引用的区域，下次打开会从头再做
+    if (file) {
+        fclose(file);
+        file = nullptr;
+    }
+    entryCount = 0;
+    sequence = 0;
+    runList.clear();
+    pendingFree.clear();
+    for (Merge& merge : merges) {
+        merge.active = false;
+    }
+}
+
+std::vector<LeaderboardRun> Leaderboard::runs() const {
+    std::vector<LeaderboardRun> result;
+    for (const StoredRun& stored : runList) {
+        LeaderboardRun run;
+        run.file = file;
+        run.offset = recordPosition(stored.start);
+        run.count = stored.count;
+        result.push_back(run);
+    }
+    return result;
+}
+
+bool Leaderboard::insert(const LeaderboardEntry& entry) {
+    if (!file || formatVersion < LEADERBOARD_FORMAT_VERSION) return false;
+
+    // 段表满了就先把进行中的归并做完（只在多次崩溃打断归并之后才可能发生）
+    bool ok = true;
+    while (ok && runList.size() >= MAX_RUNS) {
+        ok = advanceMerges();
+    }
+
+    StoredRun run;
+    run.start = allocate(1);
+    run.count = 1;
+    ok = ok && writeEntries(file, recordPosition(run.start), std::vector<LeaderboardEntry>(1, entry));
+    if (ok) {
+        runList.push_back(run);
+        ++entryCount;
+    }
+    ok = ok && advanceMerges();
+
+    // 新记录和归并输出先落盘，再提交段表
+    if (!ok || !flushAndSync(file) || !commitRunTable()) {
+        std::cerr << "Failed to write leaderboard records" << std::endl;
+        // 回到最后一次提交的段表
+        readRunTable();
+        return false;
+    }
+    return true;
+}
+
+std::vector<LeaderboardEntry> Leaderboard::top(size_t n) {
+    std::vector<LeaderboardEntry> result;
+    LeaderboardStream stream;
+    for (const LeaderboardRun& run : runs()) {
+        LeaderboardRun head = run;
+        head.count = std::min<uint64_t>(run.count, n);  // 每段最多只需要前 n 条
+        stream.addRun(head);
+    }
+
+    LeaderboardEntry entry;
+    while (result.size() < n && stream.next(entry)) {
+        result.push_back(entry);
+    }
+    return result;
+}
+
+uint64_t Leaderboard::rankOf(uint32_t score) {
+    uint64_t rank = 0;
+    std::vector<LeaderboardEntry> probe;
+    for (const LeaderboardRun& run : runs()) {
+        uint64_t lo = 0;
+        uint64_t hi = run.count;
+        while (lo < hi) {
+            uint64_t mid = lo + (hi - lo) / 2;
+            if (!readEntries(file, run.offset + static_cast<long>(mid * RECORD_SIZE), 1, probe)) {
+                return rank;
+            }
+            if (probe[0].score > score) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        rank += lo;
+    }
+    return rank;
+}
+
+bool Leaderboard::writeSorted(const std::string& filename, int gridSize, GameVersion version,
+                              LeaderboardStream& stream, bool dropDuplicates, uint64_t& written) {
+    std::string tempName = filename + ".tmp";
+    FILE* out = fopen(tempName.c_str(), "wb");
+    if (!out) {
+        std::cerr << "Failed to create leaderboard file: " << tempName << std::endl;
+        return false;
+    }
+
+    // 整体有序的序列按任意方式切分都是有序段：按记录总数的二进制位从长到短首尾相接切开，
+    // 每段的起点都是更长各段之和，自然按自身长度对齐。段表等写完记录、知道总数后再填
+    uint8_t header[LEADERBOARD_HEADER_SIZE];
+    encodeHeader(header, gridSize, version);
+    std::vector<uint8_t> emptyTables(2 * RUN_TABLE_SIZE, 0);
+    bool ok = fwrite(header, 1, LEADERBOARD_HEADER_SIZE, out) == LEADERBOARD_HEADER_SIZE &&
+              fwrite(emptyTables.data(), 1, emptyTables.size(), out) == emptyTables.size();
+
+    written = 0;
+    std::vector<uint8_t> buffer;
+    buffer.reserve(STREAM_CHUNK * RECORD_SIZE);
+    LeaderboardEntry entry;
+    LeaderboardEntry previous;
+    while (ok && stream.next(entry)) {
+        if (dropDuplicates && written > 0 && entry == previous) continue;
+        previous = entry;
+        ++written;
+
+        uint8_t bytes[RECORD_SIZE];
+        encodeEntry(entry, bytes);
+        buffer.insert(buffer.end(), bytes, bytes + RECORD_SIZE);
+        if (buffer.size() >= STREAM_CHUNK * RECORD_SIZE) {
+            ok = fwrite(buffer.data(), 1, buffer.size(), out) == buffer.size();
+            buffer.clear();
+        }
+    }
+    if (ok && !buffer.empty()) {
+        ok = fwrite(buffer.data(), 1, buffer.size(), out) == buffer.size();
+    }
+
+    std::vector<uint64_t> runs;
+    uint64_t start = 0;
+    for (int bit = 63; bit >= 0; --bit) {
+        const uint64_t length = written & (1ULL << bit);
+        if (!length) continue;
+        runs.push_back(start);
+        runs.push_back(length);
+        start += length;
+    }
+    uint8_t table[RUN_TABLE_SIZE];
+    encodeRunTable(table, 1, written, runs.data(), runs.size() / 2);
+    ok = ok && fseek(out, LEADERBOARD_HEADER_SIZE + RUN_TABLE_SIZE, SEEK_SET) == 0 &&
+         fwrite(table, 1, RUN_TABLE_SIZE, out) == static_cast<size_t>(RUN_TABLE_SIZE) && flushAndSync(out);
+    ok = fclose(out) == 0 && ok;
+
+    if (!ok || std::rename(tempName.c_str(), filename.c_str()) != 0) {
+        std::cerr << "Failed to write leaderboard file: " << filename << std::endl;
+        return false;
+    }
+    return true;
+}
+
+std::string Leaderboard::defaultPath(int gridSize, GameVersion version, bool evilSpawns) {
+    return "leaderboard/" + std::to_string(gridSize) + "x" + std::to_string(gridSize) +
+           (version == GameVersion::ORIGINAL ? "_classic" : "_diagonal") + (evilSpawns ? "_evil" : "") + ".lb";
+}
@@ -0,0 +1,132 @@
+#ifndef LEADERBOARD_H
+#define LEADERBOARD_H
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "Board.h"
+
+struct LeaderboardEntry {
+    uint32_t score = 0;
+    uint32_t moves = 0;
+    uint8_t maxExponent = 0;
+    int64_t timestamp = 0;   // Unix 时间（秒）
+    uint32_t kioskId = 0;    // 来源机器，合并多台机器的记录时区分
+};
+
+// 排序规则：分数高的在前，同分步数少的在前，再按时间先后
+bool leaderboardBetter(const LeaderboardEntry& a, const LeaderboardEntry& b);
+bool operator==(const LeaderboardEntry& a, const LeaderboardEntry& b);
+
+// 一段按从好到差排好序的连续记录
+struct LeaderboardRun {
+    FILE* file = nullptr;
+    long offset = 0;
+    uint64_t count = 0;
+};
+
+// 多个有序段的k路归并，按从好到差的顺序逐条读出；每段只缓存一小块，不会把整个文件读进内存
+class LeaderboardStream {
+public:
+    void addRun(const LeaderboardRun& run);
+    bool next(LeaderboardEntry& entry);
+
+private:
+    struct Cursor {
+        LeaderboardRun run;
+        uint64_t position = 0;              // 已经读进缓冲区的条数
+        std::vector<LeaderboardEntry> buffer;
+        size_t bufferPos = 0;
+    };
+    bool refill(Cursor& cursor);
+
+    std::vector<Cursor> cursors;
+    std::vector<size_t> heap;   // 以各段当前首条记录为键的最大堆
+    bool started = false;
+};
+
+// 按 (棋盘尺寸, 版本) 区分的本地排行榜文件
+//   16字节头: "MAOL" | 格式版本 | 棋盘尺寸 | GameVersion | 保留
+//   两个段表槽位，轮流写入: 序号 | 记录总数 | 段数 | 各段(起始下标, 条数) | 校验和；打开时取校验通过且序号大的一个
+//   之后是定长记录区。每个有序段的长度是2的幂，占一块按自身长度对齐的区域（伙伴分配）。
+// 插入一条记录就是写一个长度为1的新段。同样长度的两段逐步归并成长一倍的段：
+// 每次插入给每个进行中的归并推进固定几条记录，输出写在空闲区域，归并完才在段表里替换两个输入段。
+// 所以一次插入最多读写 O(log n) 条记录，没有整段重写的最坏情况；已提交的段不会被原地改写，
+// 记录先 fsync 再提交段表，崩溃后回到最后一次提交的状态（没做完的归并下次从头开始）。
+// 前N名只需从各段的开头各读N条做归并，名次查询则在每段里二分查找，都不需要整体读入。
+// 格式版本1（段首尾相接、插入时原地改写）的文件在 open 时整体转换一次。
+class Leaderboard {
+public:
+    static constexpr size_t RECORD_SIZE = 24;
+
+    Leaderboard();
+    ~Leaderboard();
+
+    Leaderboard(const Leaderboard&) = delete;
+    Leaderboard& operator=(const Leaderboard&) = delete;
+
+    // 打开排行榜文件，不存在时新建
+    bool open(const std::string& filename, int gridSize, GameVersion version);
+    // 只读打开，尺寸和版本以文件头为准（合并工具使用）
+    bool openExisting(const std::string& filename);
+    void close();
+    bool isOpen() const { return file != nullptr; }
+
+    bool insert(const LeaderboardEntry& entry);
+    std::vector<LeaderboardEntry> top(size_t n);
+    // 严格比 score 高的记录条数，即该分数的名次（从0开始）
+    uint64_t rankOf(uint32_t score);
+
+    uint64_t size() const { return entryCount; }
+    int gridSize() const { return boardSize; }
+    GameVersion version() const { return gameVersion; }
+    // 各有序段，供归并读取
+    std::vector<LeaderboardRun> runs() const;
+
+    // 把已经排好序的记录流整体写成新文件（先写临时文件再原子替换）
+    static bool writeSorted(const std::string& filename, int gridSize, GameVersion version,
+                            LeaderboardStream& stream, bool dropDuplicates, uint64_t& written);
+    // 默认文件名，例如 leaderboard/4x4_classic.lb；恶意生成的局单独成榜，例如 4x4_classic_evil.lb
+    static std::string defaultPath(int gridSize, GameVersion version, bool evilSpawns = false);
+
+private:
+    // 一段在记录区里的位置，单位是记录
+    struct StoredRun {
+        uint64_t start = 0;
+        uint64_t count = 0;
+    };
+    // 两个长度为 2^level 的段归并成一段，done 是两边已经输出的条数
+    struct Merge {
+        bool active = false;
+        StoredRun left;
+        StoredRun right;
+        uint64_t outputStart = 0;
+        uint64_t doneLeft = 0;
+        uint64_t doneRight = 0;
+    };
+
+    bool readHeader();
+    bool readRunTable();
+    // 把当前的段表写进较旧的槽位；调用前记录必须已经落盘
+    bool commitRunTable();
+    // 长度为 count（2的幂）的空闲对齐区域的起点
+    uint64_t allocate(uint64_t count) const;
+    // 给每一层的归并推进一步，做完的归并把输出段换进段表
+    bool advanceMerges();
+    bool stepMerge(Merge& merge);
+    long recordPosition(uint64_t index) const;
+
+    FILE* file;
+    int boardSize;
+    GameVersion gameVersion;
+    uint64_t entryCount;
+    int formatVersion;
+    long dataStart;        // 记录区在文件里的起点
+    uint64_t sequence;     // 最近一次提交的段表序号
+    std::vector<StoredRun> runList;
+    std::vector<Merge> merges;          // 按层，第 level 层归并长度为 2^level 的两段
+    std::vector<StoredRun> pendingFree; // 归并掉的输入段，提交段表之前仍被旧段表引用，不能分配
+};
+
+#endif // LEADERBOARD_H
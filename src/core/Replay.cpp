@@ -0,0 +1,306 @@
+#include "Replay.h"
+#include <cstring>
+#include <iostream>
+
+namespace {
+
+const uint8_t REPLAY_MAGIC[4] = {'M', 'A', 'O', 'R'};
+constexpr uint8_t REPLAY_FORMAT_VERSION = 1;
+constexpr int REPLAY_HEADER_SIZE = 16;
+
+constexpr uint8_t SLOT_FIELD_EXTENDED = 30;
+constexpr uint8_t SLOT_FIELD_CONTROL = 31;
+
+constexpr uint8_t CONTROL_UNDO = 0x01;
+
+} // namespace
+
+ReplayMove makeReplayMove(Direction dir, const Board& boardAfterSpawn, int spawnCell) {
+    // 新方块之前的空格在生成前后都是空的，它们的个数就是生成序号
+    ReplayMove move;
+    move.direction = dir;
+    move.spawnSlot = static_cast<uint16_t>(boardAfterSpawn.emptyMask().rank(spawnCell));
+    move.spawnExponent = boardAfterSpawn.exponent(spawnCell);
+    return move;
+}
+
+int replaySpawnCell(const ReplayMove& move, const CellMask& emptyMask) {
+    if (move.spawnSlot >= emptyMask.count()) return -1;
+    return emptyMask.select(move.spawnSlot);
+}
+
+int encodeReplayMove(const ReplayMove& move, uint8_t* out) {
+    if (move.op == ReplayOp::UNDO) {
+        out[0] = SLOT_FIELD_CONTROL;
+        out[1] = CONTROL_UNDO;
+        return 2;
+    }
+
+    uint8_t head = static_cast<uint8_t>(directionIndex(move.direction) << 6);
+    if (move.spawnExponent == 2) {
+        head |= 0x20;
+    }
+
+    if (move.spawnSlot < SLOT_FIELD_EXTENDED) {
+        out[0] = head | static_cast<uint8_t>(move.spawnSlot);
+        return 1;
+    }
+
+    // 只有空格超过30个（6x6开局附近）时才需要额外字节
+    out[0] = head | SLOT_FIELD_EXTENDED;
+    int written = 1;
+    uint32_t slot = move.spawnSlot;
+    do {
+        uint8_t byte = slot & 0x7F;
+        slot >>= 7;
+        if (slot) byte |= 0x80;
+        out[written++] = byte;
+    } while (slot);
+    return written;
+}
+
+bool decodeReplayMove(const std::vector<uint8_t>& data, size_t& pos, GameVersion version, ReplayMove& move) {
+    if (pos >= data.size()) return false;
+
+    size_t cursor = pos;
+    uint8_t head = data[cursor++];
+    uint8_t slotField = head & 0x1F;
+
+    if (slotField == SLOT_FIELD_CONTROL) {
+        if (cursor >= data.size()) return false;
+        if (data[cursor] != CONTROL_UNDO) {
+            std::cerr << "Unsupported replay control opcode at byte " << pos << std::endl;
+            return false;
+        }
+        move = ReplayMove();
+        move.op = ReplayOp::UNDO;
+        pos = cursor + 1;
+        return true;
+    }
+
+    uint32_t slot = slotField;
+    if (slotField == SLOT_FIELD_EXTENDED) {
+        slot = 0;
+        int shift = 0;
+        while (true) {
+            if (cursor >= data.size() || shift > 14) return false;
+            uint8_t byte = data[cursor++];
+            slot |= static_cast<uint32_t>(byte & 0x7F) << shift;
+            shift += 7;
+            if (!(byte & 0x80)) break;
+        }
+    }
+
+    move.op = ReplayOp::MOVE;
+    move.direction = directionFromIndex(version, head >> 6);
+    move.spawnExponent = (head & 0x20) ? 2 : 1;
+    move.spawnSlot = static_cast<uint16_t>(slot);
+    pos = cursor;
+    return true;
+}
+
+ReplayWriter::ReplayWriter() : file(nullptr) {
+}
+
+ReplayWriter::~ReplayWriter() {
+    close();
+}
+
+bool ReplayWriter::open(const std::string& filename, const ReplayHeader& header) {
+    close();
+
+    file = fopen(filename.c_str(), "wb");
+    if (!file) {
+        std::cerr << "Failed to create replay file: " << filename << std::endl;
+        return false;
+    }
+
+    uint8_t bytes[REPLAY_HEADER_SIZE];
+    std::memcpy(bytes, REPLAY_MAGIC, 4);
+    bytes[4] = REPLAY_FORMAT_VERSION;
+    bytes[5] = header.gridSize;
+    bytes[6] = static_cast<uint8_t>(header.version);
+    bytes[7] = header.flags;
+    for (int i = 0; i < 8; ++i) {
+        bytes[8 + i] = static_cast<uint8_t>(header.seed >> (8 * i));
+    }
+
+    if (fwrite(bytes, 1, REPLAY_HEADER_SIZE, file) != REPLAY_HEADER_SIZE) {
+        close();
+        return false;
+    }
+    fflush(file);
+    return true;
+}
+
+bool ReplayWriter::openForAppend(const std::string& filename) {
+    close();
+
+    file = fopen(filename.c_str(), "ab");
+    if (!file) {
+        std::cerr << "Failed to reopen replay file: " << filename << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool ReplayWriter::appendMove(const ReplayMove& move) {
+    if (!file) return false;
+
+    uint8_t bytes[4];
+    int length = encodeReplayMove(move, bytes);
+    if (fwrite(bytes, 1, length, file) != static_cast<size_t>(length)) {
+        std::cerr << "Failed to write replay move" << std::endl;
+        close();
+        return false;
+    }
+    fflush(file);
+    return true;
+}
+
+void ReplayWriter::close() {
+    if (file) {
+        fclose(file);
+        file = nullptr;
+    }
+}
+
+ReplayPlayer::ReplayPlayer()
+    : currentScore(0), allMergedExponents(0), cursor(0), lastSpawn(-1) {
+}
+
+bool ReplayPlayer::load(const std::string& filename) {
+    FILE* file = fopen(filename.c_str(), "rb");
+    if (!file) {
+        std::cerr << "Failed to open replay file: " << filename << std::endl;
+        return false;
+    }
+
+    std::vector<uint8_t> data;
+    uint8_t buffer[4096];
+    size_t readCount;
+    while ((readCount = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        data.insert(data.end(), buffer, buffer + readCount);
+    }
+    fclose(file);
+
+    if (data.size() < REPLAY_HEADER_SIZE || std::memcmp(data.data(), REPLAY_MAGIC, 4) != 0 ||
+        data[4] != REPLAY_FORMAT_VERSION) {
+        std::cerr << "Not a valid replay file: " << filename << std::endl;
+        return false;
+    }
+
+    ReplayHeader header;
+    header.gridSize = data[5];
+    header.version = data[6] == 0 ? GameVersion::ORIGINAL : GameVersion::MODIFIED;
+    header.flags = data[7];
+    header.seed = 0;
+    for (int i = 0; i < 8; ++i) {
+        header.seed |= static_cast<uint64_t>(data[8 + i]) << (8 * i);
+    }
+    if (header.gridSize < 2 || header.gridSize > Board::MAX_SIZE) {
+        std::cerr << "Unsupported replay grid size: " << static_cast<int>(header.gridSize) << std::endl;
+        return false;
+    }
+
+    // 文件末尾可能有崩溃时写了一半的字节，解码到第一个坏步为止
+    moves.clear();
+    size_t pos = REPLAY_HEADER_SIZE;
+    ReplayMove move;
+    const int cellCount = header.gridSize * header.gridSize;
+    while (decodeReplayMove(data, pos, header.version, move)) {
+        if (move.spawnSlot >= cellCount) break;
+        moves.push_back(move);
+    }
+
+    replayHeader = header;
+    restart();
+    return true;
+}
+
+void ReplayPlayer::restart() {
+    currentBoard = Board(replayHeader.gridSize);
+    currentRng.seed(replayHeader.seed);
+    currentScore = 0;
+    allMergedExponents = 0;
+    cursor = 0;
+    history.clear(replayHeader.gridSize);
+    currentBoard.spawnRandom(currentRng);
+    lastSpawn = currentBoard.spawnRandom(currentRng);
+}
+
+bool ReplayPlayer::step(MovePlan* plan) {
+    if (finished()) return false;
+
+    const ReplayMove& move = moves[cursor];
+    if (move.op == ReplayOp::UNDO) {
+        if (plan) plan->count = 0;
+        return undo();
+    }
+
+    UndoEntry before;
+    before.board = currentBoard;
+    before.rngState = currentRng.getState();
+    before.direction = move.direction;
+
+    MoveResult result;
+    if (!currentBoard.move(move.direction, result, plan)) {
+        std::cerr << "Replay move " << cursor << " does not change the board" << std::endl;
+        return false;
+    }
+
+    // 出错时退回这一步之前，播放器停在最后一个可信的局面
+    int spawnCell = replaySpawnCell(move, currentBoard.emptyMask());
+    if (spawnCell < 0) {
+        std::cerr << "Replay spawn out of range at move " << cursor << std::endl;
+        currentBoard = before.board;
+        return false;
+    }
+
+    // 随机生成的方块由种子决定，顺便校验文件内容是否与种子一致；
+    // 不一致之后随机数状态和文件对不上，后面的每一步都不可信
+    if (!(replayHeader.flags & REPLAY_FLAG_EVIL_SPAWNS)) {
+        Board expected = currentBoard;
+        int expectedCell = expected.spawnRandom(currentRng);
+        if (expectedCell != spawnCell || expected.exponent(expectedCell) != move.spawnExponent) {
+            std::cerr << "Replay spawn mismatch at move " << cursor << std::endl;
+            currentBoard = before.board;
+            currentRng.setState(before.rngState);
+            return false;
+        }
+    }
+
+    currentBoard.setExponent(spawnCell, move.spawnExponent);
+    currentScore += result.scoreGained;
+    allMergedExponents |= result.mergedExponents;
+    lastSpawn = spawnCell;
+    ++cursor;
+
+    before.scoreGained = result.scoreGained;
+    history.push(before);
+    return true;
+}
+
+bool ReplayPlayer::undo() {
+    UndoEntry entry;
+    if (!history.undo(entry)) {
+        std::cerr << "Replay undo without a previous move at " << cursor << std::endl;
+        return false;
+    }
+
+    currentBoard = entry.board;
+    currentRng.setState(entry.rngState);
+    currentScore -= entry.scoreGained;
+    lastSpawn = -1;
+    ++cursor;
+    return true;
+}
+
+size_t ReplayPlayer::seek(size_t moveIndex) {
+    if (moveIndex < cursor) {
+        restart();
+    }
+    while (cursor < moveIndex && step()) {
+    }
+    return cursor;
+}
@@ -0,0 +1,108 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "Board.h"
+#include "UndoHistory.h"
+
+// 回放文件格式（小端）：
+//   16字节头: "MAOR" | 格式版本(1) | 棋盘尺寸 | GameVersion | 标志位 | 随机种子(8字节)
+//   之后每步一个字节: [方向下标:2][是否为4:1][生成序号:5]
+//   生成序号是新方块在移动后所有空格中的排位（按行优先），通常远小于30；
+//   字段 30 表示序号 >= 30，后面跟一个变长整数(LEB128)写出完整序号（超大棋盘最多2字节）；
+//   字段 31 保留给控制指令，后面跟一个指令字节（目前只有撤销，见 ReplayOp）
+//   撤销会连同随机数状态一起回退，重做就是再走一次同一方向，按普通一步记录
+// 开局的两个方块完全由种子决定，不写入文件
+// 标志位 REPLAY_FLAG_EVIL_SPAWNS：之后的方块由恶意生成挑选，与种子无关，回放时不再校验
+constexpr uint8_t REPLAY_FLAG_EVIL_SPAWNS = 1 << 0;
+
+struct ReplayHeader {
+    uint8_t gridSize = 4;
+    GameVersion version = GameVersion::ORIGINAL;
+    uint8_t flags = 0;
+    uint64_t seed = 0;
+};
+
+enum class ReplayOp : uint8_t {
+    MOVE,
+    UNDO    // 撤销上一步，其余字段无意义
+};
+
+struct ReplayMove {
+    ReplayOp op = ReplayOp::MOVE;
+    Direction direction = Direction::UP;
+    uint16_t spawnSlot = 0;     // 在移动后的空格中排第几个
+    uint8_t spawnExponent = 1;
+};
+
+// boardAfterSpawn 是已经放好新方块的棋盘
+ReplayMove makeReplayMove(Direction dir, const Board& boardAfterSpawn, int spawnCell);
+// 根据移动后的空格掩码还原生成位置，序号越界时返回-1
+int replaySpawnCell(const ReplayMove& move, const CellMask& emptyMask);
+
+// 把一步编码到 out 中，返回写入的字节数（最多4字节）
+int encodeReplayMove(const ReplayMove& move, uint8_t* out);
+// 从 data[pos] 开始解码一步，成功时推进 pos
+bool decodeReplayMove(const std::vector<uint8_t>& data, size_t& pos, GameVersion version, ReplayMove& move);
+
+// 边玩边写：每步只追加几个字节并立即刷新，程序崩溃也不会丢掉已经走过的步数
+class ReplayWriter {
+public:
+    ReplayWriter();
+    ~ReplayWriter();
+
+    ReplayWriter(const ReplayWriter&) = delete;
+    ReplayWriter& operator=(const ReplayWriter&) = delete;
+
+    bool open(const std::string& filename, const ReplayHeader& header);
+    // 继续往已有的回放文件末尾追加（读档后接着录制）
+    bool openForAppend(const std::string& filename);
+    bool appendMove(const ReplayMove& move);
+    void close();
+    bool isOpen() const { return file != nullptr; }
+
+private:
+    FILE* file;
+};
+
+// 回放播放器：不依赖界面，直接在棋盘核心上重演，可快速跳转到任意一步
+class ReplayPlayer {
+public:
+    ReplayPlayer();
+
+    bool load(const std::string& filename);
+
+    void restart();
+    // plan 不为空时记下这一步的方块去向（撤销指令时为空计划）
+    bool step(MovePlan* plan = nullptr);
+    // 无界面快进（或回退）到第 moveIndex 步，返回实际到达的步数
+    size_t seek(size_t moveIndex);
+
+    const ReplayHeader& header() const { return replayHeader; }
+    const Board& board() const { return currentBoard; }
+    const Rng& rng() const { return currentRng; }
+    int score() const { return currentScore; }
+    uint32_t mergedExponents() const { return allMergedExponents; }
+    size_t position() const { return cursor; }
+    size_t moveCount() const { return moves.size(); }
+    bool finished() const { return cursor >= moves.size(); }
+    int lastSpawnCell() const { return lastSpawn; }
+
+private:
+    bool undo();
+
+    ReplayHeader replayHeader;
+    std::vector<ReplayMove> moves;
+    Board currentBoard;
+    Rng currentRng;
+    UndoHistory history;
+    int currentScore;
+    uint32_t allMergedExponents;
+    size_t cursor;
+    int lastSpawn;
+};
+
+#endif // REPLAY_H
@@ -0,0 +1,57 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include <cstdint>
+#include <random>
+
+// PCG32 (XSH-RR) 伪随机数生成器
+// 只有8字节状态，可以用种子复现整局游戏（回放、测试、模拟都依赖这一点）
+class Rng {
+public:
+    explicit Rng(uint64_t seedValue = 0) { seed(seedValue); }
+
+    void seed(uint64_t seedValue) {
+        state = 0;
+        next();
+        state += seedValue;
+        next();
+    }
+
+    uint32_t next() {
+        uint64_t old = state;
+        state = old * MULTIPLIER + INCREMENT;
+        uint32_t xorShifted = static_cast<uint32_t>(((old >> 18u) ^ old) >> 27u);
+        uint32_t rot = static_cast<uint32_t>(old >> 59u);
+        return (xorShifted >> rot) | (xorShifted << ((32u - rot) & 31u));
+    }
+
+    // 返回 [0, bound) 内的均匀随机数（Lemire 乘法取高位法，几乎不需要除法）
+    uint32_t bounded(uint32_t bound) {
+        uint64_t m = static_cast<uint64_t>(next()) * bound;
+        uint32_t low = static_cast<uint32_t>(m);
+        if (low < bound) {
+            uint32_t threshold = (0u - bound) % bound;
+            while (low < threshold) {
+                m = static_cast<uint64_t>(next()) * bound;
+                low = static_cast<uint32_t>(m);
+            }
+        }
+        return static_cast<uint32_t>(m >> 32);
+    }
+
+    uint64_t getState() const { return state; }
+    void setState(uint64_t newState) { state = newState; }
+
+    // 只在新开一局时调用一次，取代每次生成方块都构造 std::random_device
+    static uint64_t randomSeed() {
+        std::random_device rd;
+        return (static_cast<uint64_t>(rd()) << 32) ^ rd();
+    }
+
+private:
+    static constexpr uint64_t MULTIPLIER = 6364136223846793005ULL;
+    static constexpr uint64_t INCREMENT = 1442695040888963407ULL;
+    uint64_t state;
+};
+
+#endif // RNG_H
@@ -0,0 +1,463 @@
+#include "SaveJournal.h"
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <vector>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+const uint8_t JOURNAL_MAGIC[4] = {'M', 'A', 'O', 'J'};
+constexpr uint8_t JOURNAL_FORMAT_VERSION = 3;   // 版本1的记录长度只有1字节，版本2的快照没有回放路径，都仍可读取
+constexpr int JOURNAL_HEADER_SIZE = 8;
+
+constexpr uint8_t RECORD_SNAPSHOT = 'S';
+constexpr uint8_t RECORD_MOVE = 'M';
+constexpr uint8_t RECORD_FLAGS = 'F';
+
+constexpr int SYNC_BATCH = 32;                               // 积累这么多条记录就立刻 fsync
+constexpr auto SYNC_INTERVAL = std::chrono::milliseconds(1000); // 否则最多每秒一次
+constexpr long COMPACT_THRESHOLD = 64 * 1024;                // 日志超过64KB时由后台线程重写
+
+uint32_t fnv1a(const uint8_t* data, size_t length) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; ++i) {
+        hash ^= data[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+void put32(uint8_t* out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) out[i] = static_cast<uint8_t>(value >> (8 * i));
+}
+
+void put64(uint8_t* out, uint64_t value) {
+    for (int i = 0; i < 8; ++i) out[i] = static_cast<uint8_t>(value >> (8 * i));
+}
+
+uint32_t get32(const uint8_t* in) {
+    uint32_t value = 0;
+    for (int i = 0; i < 4; ++i) value |= static_cast<uint32_t>(in[i]) << (8 * i);
+    return value;
+}
+
+uint64_t get64(const uint8_t* in) {
+    uint64_t value = 0;
+    for (int i = 0; i < 8; ++i) value |= static_cast<uint64_t>(in[i]) << (8 * i);
+    return value;
+}
+
+// 快照内容: 尺寸 | 版本 | 标志 | 步数(4) | 分数(4) | 种子(8) | 随机数状态(8) | 每格指数 | 回放路径长度 | 回放路径
+constexpr int SNAPSHOT_FIXED_SIZE = 27;
+constexpr size_t MAX_REPLAY_PATH = 255;
+
+int encodeSnapshot(const SaveState& state, uint8_t* out) {
+    out[0] = static_cast<uint8_t>(state.board.size());
+    out[1] = static_cast<uint8_t>(state.version);
+    out[2] = state.flags;
+    put32(out + 3, state.moveCount);
+    put32(out + 7, static_cast<uint32_t>(state.score));
+    put64(out + 11, state.seed);
+    put64(out + 19, state.rngState);
+    const int cells = state.board.cellCount();
+    for (int i = 0; i < cells; ++i) {
+        out[SNAPSHOT_FIXED_SIZE + i] = state.board.exponent(i);
+    }
+    // 路径过长时不记，读档后当作没有回放
+    const size_t pathLength = state.replayPath.size() <= MAX_REPLAY_PATH ? state.replayPath.size() : 0;
+    out[SNAPSHOT_FIXED_SIZE + cells] = static_cast<uint8_t>(pathLength);
+    std::memcpy(out + SNAPSHOT_FIXED_SIZE + cells + 1, state.replayPath.data(), pathLength);
+    return SNAPSHOT_FIXED_SIZE + cells + 1 + static_cast<int>(pathLength);
+}
+
+// 记录: 类型 | 内容长度(2字节) | 内容 | 校验；最大的记录是 64x64 棋盘的快照
+constexpr int RECORD_OVERHEAD = 3 + 4;
+constexpr int MAX_PAYLOAD = SNAPSHOT_FIXED_SIZE + Board::MAX_CELLS + 1 + MAX_REPLAY_PATH;
+
+int buildRecord(uint8_t type, const uint8_t* payload, int length, uint8_t* record) {
+    record[0] = type;
+    record[1] = static_cast<uint8_t>(length);
+    record[2] = static_cast<uint8_t>(length >> 8);
+    std::memcpy(record + 3, payload, length);
+    put32(record + 3 + length, fnv1a(record, 3 + length));
+    return length + RECORD_OVERHEAD;
+}
+
+bool decodeSnapshot(const uint8_t* in, int length, SaveState& state) {
+    if (length < SNAPSHOT_FIXED_SIZE) return false;
+    int size = in[0];
+    if (size < 2 || size > Board::MAX_SIZE || length < SNAPSHOT_FIXED_SIZE + size * size) return false;
+    // 版本2的快照到每格指数为止；之后是回放路径
+    const int cellsEnd = SNAPSHOT_FIXED_SIZE + size * size;
+    state.replayPath.clear();
+    if (length > cellsEnd) {
+        const int pathLength = in[cellsEnd];
+        if (length != cellsEnd + 1 + pathLength) return false;
+        state.replayPath.assign(reinterpret_cast<const char*>(in + cellsEnd + 1), pathLength);
+    }
+
+    state.board = Board(size);
+    state.version = in[1] == 0 ? GameVersion::ORIGINAL : GameVersion::MODIFIED;
+    state.flags = in[2];
+    state.moveCount = get32(in + 3);
+    state.score = static_cast<int>(get32(in + 7));
+    state.seed = get64(in + 11);
+    state.rngState = get64(in + 19);
+    for (int i = 0; i < size * size; ++i) {
+        state.board.setExponent(i, in[SNAPSHOT_FIXED_SIZE + i]);
+    }
+    return true;
+}
+
+// 重演一条移动记录，规则与 ReplayPlayer 相同
+bool applyMoveRecord(const uint8_t* in, int length, SaveState& state) {
+    if (length < 2) return false;
+
+    std::vector<uint8_t> bytes(in + 1, in + length);
+    size_t pos = 0;
+    ReplayMove move;
+    if (!decodeReplayMove(bytes, pos, state.version, move)) return false;
+    // 撤销在存档里直接记成快照，移动记录中不会出现
+    if (move.op != ReplayOp::MOVE) return false;
+
+    MoveResult result;
+    if (!state.board.move(move.direction, result)) return false;
+
+    int cell = replaySpawnCell(move, state.board.emptyMask());
+    if (cell < 0) return false;
+
+    // 推进随机数状态，让恢复后的后续生成与不中断时完全相同（恶意生成不使用随机数）
+    if (!(in[0] & SAVE_FLAG_EVIL_SPAWNS)) {
+        Rng rng;
+        rng.setState(state.rngState);
+        Board scratch = state.board;
+        scratch.spawnRandom(rng);
+        state.rngState = rng.getState();
+    }
+
+    state.board.setExponent(cell, move.spawnExponent);
+    state.score += result.scoreGained;
+    state.flags = in[0];
+    ++state.moveCount;
+    return true;
+}
+
+void syncDescriptor(int fd) {
+#if defined(_WIN32)
+    _commit(fd);
+#elif defined(__APPLE__)
+    fsync(fd);
+#else
+    fdatasync(fd);
+#endif
+}
+
+// rename 之后目录项也要落盘，否则断电后可能还是旧文件（或者根本没有文件）
+void syncDirectoryOf(const std::string& filename) {
+#ifndef _WIN32
+    const size_t slash = filename.find_last_of('/');
+    const std::string directory = slash == std::string::npos ? "." : filename.substr(0, slash == 0 ? 1 : slash);
+    int fd = ::open(directory.c_str(), O_RDONLY);
+    if (fd >= 0) {
+        fsync(fd);
+        ::close(fd);
+    }
+#else
+    (void)filename;
+#endif
+}
+
+void encodeJournalHeader(uint8_t* header) {
+    std::memset(header, 0, JOURNAL_HEADER_SIZE);
+    std::memcpy(header, JOURNAL_MAGIC, 4);
+    header[4] = JOURNAL_FORMAT_VERSION;
+}
+
+} // namespace
+
+SaveJournal::SaveJournal()
+    : file(nullptr), fileSize(0), movesSinceLastSnapshot(0), opened(false), unsyncedRecords(0), stopSync(false),
+      compacting(false), generation(0) {
+}
+
+SaveJournal::~SaveJournal() {
+    close();
+}
+
+bool SaveJournal::begin(const std::string& filename, const SaveState& state) {
+    if (!writeFresh(filename, state)) {
+        return false;
+    }
+
+    if (!syncThread.joinable()) {
+        stopSync = false;
+        syncThread = std::thread(&SaveJournal::syncLoop, this);
+    }
+    return true;
+}
+
+bool SaveJournal::writeFresh(const std::string& filename, const SaveState& state) {
+    // 先写临时文件、落盘后再原子替换，重写过程中崩溃也总有一份完整的存档（只在开局和读档时发生）
+    std::string tempName = filename + ".tmp";
+    FILE* temp = fopen(tempName.c_str(), "wb");
+    if (!temp) {
+        std::cerr << "Failed to create save file: " << tempName << std::endl;
+        return false;
+    }
+
+    uint8_t header[JOURNAL_HEADER_SIZE];
+    encodeJournalHeader(header);
+
+    uint8_t payload[MAX_PAYLOAD];
+    uint8_t record[MAX_PAYLOAD + RECORD_OVERHEAD];
+    const int recordSize = buildRecord(RECORD_SNAPSHOT, payload, encodeSnapshot(state, payload), record);
+
+    bool ok = fwrite(header, 1, JOURNAL_HEADER_SIZE, temp) == JOURNAL_HEADER_SIZE &&
+              fwrite(record, 1, recordSize, temp) == static_cast<size_t>(recordSize) &&
+              fflush(temp) == 0;
+    if (ok) {
+        syncDescriptor(fileno(temp));
+    }
+    fclose(temp);
+    if (!ok || std::rename(tempName.c_str(), filename.c_str()) != 0) {
+        std::cerr << "Failed to write save file: " << filename << std::endl;
+        return false;
+    }
+    syncDirectoryOf(filename);
+
+    FILE* appended = fopen(filename.c_str(), "ab");
+    if (!appended) {
+        std::cerr << "Failed to reopen save file: " << filename << std::endl;
+        return false;
+    }
+
+    FILE* old = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(syncMutex);
+        old = file;
+        file = appended;
+        path = filename;
+        fileSize = JOURNAL_HEADER_SIZE + recordSize;
+        unsyncedRecords = 0;
+        // 旧日志上还没做完的压缩作废
+        compacting = false;
+        compactTail.clear();
+        ++generation;
+    }
+    if (old) fclose(old);
+
+    movesSinceLastSnapshot = 0;
+    opened = true;
+    return true;
+}
+
+void SaveJournal::appendRecord(uint8_t type, const uint8_t* payload, int length) {
+    uint8_t record[MAX_PAYLOAD + RECORD_OVERHEAD];
+    const int recordSize = buildRecord(type, payload, length, record);
+
+    // 只写到内核缓冲区，真正落盘交给后台线程。锁只在后台线程换文件时才会有争用
+    std::lock_guard<std::mutex> lock(syncMutex);
+    if (!file) return;
+    if (fwrite(record, 1, recordSize, file) != static_cast<size_t>(recordSize) || fflush(file) != 0) {
+        std::cerr << "Failed to append to save file" << std::endl;
+        return;
+    }
+    fileSize += recordSize;
+
+    bool wake = ++unsyncedRecords >= SYNC_BATCH;
+    if (compacting) {
+        compactTail.insert(compactTail.end(), record, record + recordSize);
+    } else if (type == RECORD_SNAPSHOT && fileSize > COMPACT_THRESHOLD) {
+        // 新文件从这个快照开始，之后追加的记录先另存一份
+        compacting = true;
+        compactSnapshot.assign(record, record + recordSize);
+        compactTail.clear();
+        wake = true;
+    }
+    if (wake) {
+        syncCondition.notify_one();
+    }
+}
+
+void SaveJournal::appendMove(const ReplayMove& move, uint8_t flagsAfterMove) {
+    uint8_t payload[5];
+    payload[0] = flagsAfterMove;
+    int length = 1 + encodeReplayMove(move, payload + 1);
+    appendRecord(RECORD_MOVE, payload, length);
+    ++movesSinceLastSnapshot;
+}
+
+void SaveJournal::appendFlags(uint8_t flags) {
+    appendRecord(RECORD_FLAGS, &flags, 1);
+}
+
+void SaveJournal::appendSnapshot(const SaveState& state) {
+    if (!opened) return;
+
+    uint8_t payload[MAX_PAYLOAD];
+    int length = encodeSnapshot(state, payload);
+    appendRecord(RECORD_SNAPSHOT, payload, length);
+    movesSinceLastSnapshot = 0;
+}
+
+void SaveJournal::close() {
+    if (syncThread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(syncMutex);
+            stopSync = true;
+        }
+        syncCondition.notify_one();
+        syncThread.join();
+    }
+    std::lock_guard<std::mutex> lock(syncMutex);
+    if (file) {
+        fclose(file);
+        file = nullptr;
+    }
+    compacting = false;
+    compactTail.clear();
+    ++generation;
+    opened = false;
+}
+
+void SaveJournal::compact(std::unique_lock<std::mutex>& lock) {
+    const uint64_t startedGeneration = generation;
+    const std::string target = path;
+    const std::vector<uint8_t> snapshot = compactSnapshot;
+    lock.unlock();
+
+    // 文件头和快照在锁外写完并落盘，这是压缩里唯一慢的部分
+    const std::string tempName = target + ".compact";
+    FILE* temp = fopen(tempName.c_str(), "wb");
+    uint8_t header[JOURNAL_HEADER_SIZE];
+    encodeJournalHeader(header);
+    bool ok = temp && fwrite(header, 1, JOURNAL_HEADER_SIZE, temp) == JOURNAL_HEADER_SIZE &&
+              fwrite(snapshot.data(), 1, snapshot.size(), temp) == snapshot.size() && fflush(temp) == 0;
+    if (ok) {
+        syncDescriptor(fileno(temp));
+    }
+
+    lock.lock();
+    // 期间开了新局或关闭了日志，这份快照已经过时
+    const bool current = generation == startedGeneration && file;
+    ok = ok && current;
+    // 补上期间追加的记录后替换；这几条和平时追加的记录一样，由随后的 fsync 落盘
+    ok = ok && (compactTail.empty() || fwrite(compactTail.data(), 1, compactTail.size(), temp) == compactTail.size());
+    ok = ok && fflush(temp) == 0 && std::rename(tempName.c_str(), target.c_str()) == 0;
+    if (ok) {
+        fclose(file);
+        file = temp;
+        fileSize = JOURNAL_HEADER_SIZE + static_cast<long>(snapshot.size() + compactTail.size());
+    } else {
+        if (temp) {
+            fclose(temp);
+            std::remove(tempName.c_str());
+        }
+        if (current) {
+            std::cerr << "Failed to compact save file: " << target << std::endl;
+        }
+    }
+    if (current) {
+        compacting = false;
+        compactTail.clear();
+    }
+
+    if (ok) {
+        lock.unlock();
+        syncDirectoryOf(target);
+        lock.lock();
+    }
+}
+
+void SaveJournal::syncLoop() {
+    std::unique_lock<std::mutex> lock(syncMutex);
+    while (true) {
+        syncCondition.wait_for(lock, SYNC_INTERVAL, [this] {
+            return stopSync || unsyncedRecords >= SYNC_BATCH || compacting;
+        });
+
+        bool stopping = stopSync;
+        if (compacting && !stopping) {
+            compact(lock);
+        }
+        if (unsyncedRecords > 0 && file) {
+            // 复制一份描述符后在锁外 fsync，主线程继续追加记录不会被磁盘阻塞
+            int fd = dup(fileno(file));
+            unsyncedRecords = 0;
+            lock.unlock();
+            if (fd >= 0) {
+                syncDescriptor(fd);
+                ::close(fd);
+            }
+            lock.lock();
+        }
+        if (stopping) break;
+    }
+}
+
+bool SaveJournal::load(const std::string& filename, SaveState& state) {
+    FILE* in = fopen(filename.c_str(), "rb");
+    if (!in) return false;
+
+    std::vector<uint8_t> data;
+    uint8_t buffer[4096];
+    size_t readCount;
+    while ((readCount = fread(buffer, 1, sizeof(buffer), in)) > 0) {
+        data.insert(data.end(), buffer, buffer + readCount);
+    }
+    fclose(in);
+
+    if (data.size() < JOURNAL_HEADER_SIZE || std::memcmp(data.data(), JOURNAL_MAGIC, 4) != 0 ||
+        data[4] < 1 || data[4] > JOURNAL_FORMAT_VERSION) {
+        std::cerr << "Not a valid save file: " << filename << std::endl;
+        return false;
+    }
+    const size_t lengthBytes = data[4] == 1 ? 1 : 2;
+    const size_t headerBytes = 1 + lengthBytes;
+    auto recordLength = [&](size_t pos) -> size_t {
+        size_t length = data[pos + 1];
+        if (lengthBytes == 2) length |= static_cast<size_t>(data[pos + 2]) << 8;
+        return length;
+    };
+
+    // 第一遍只校验记录边界，找到最后一个完整快照
+    std::vector<size_t> records;
+    size_t lastSnapshot = SIZE_MAX;
+    size_t pos = JOURNAL_HEADER_SIZE;
+    while (pos + headerBytes <= data.size()) {
+        size_t length = recordLength(pos);
+        size_t recordSize = headerBytes + length + 4;
+        if (pos + recordSize > data.size()) break;
+        if (fnv1a(&data[pos], headerBytes + length) != get32(&data[pos + headerBytes + length])) break;
+
+        if (data[pos] == RECORD_SNAPSHOT) lastSnapshot = records.size();
+        records.push_back(pos);
+        pos += recordSize;
+    }
+    if (lastSnapshot == SIZE_MAX) return false;
+
+    SaveState result;
+    size_t start = records[lastSnapshot];
+    if (!decodeSnapshot(&data[start + headerBytes], static_cast<int>(recordLength(start)), result)) return false;
+
+    // 第二遍只重演快照之后的尾部
+    for (size_t i = lastSnapshot + 1; i < records.size(); ++i) {
+        const uint8_t* record = &data[records[i]];
+        const int length = static_cast<int>(recordLength(records[i]));
+        if (record[0] == RECORD_MOVE) {
+            if (!applyMoveRecord(record + headerBytes, length, result)) break;
+        } else if (record[0] == RECORD_FLAGS && length == 1) {
+            result.flags = record[headerBytes];
+        }
+    }
+
+    state = result;
+    return true;
+}
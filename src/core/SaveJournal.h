@@ -0,0 +1,92 @@
+#ifndef SAVE_JOURNAL_H
+#define SAVE_JOURNAL_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Board.h"
+#include "Replay.h"
+
+// 存档需要恢复的全部状态
+struct SaveState {
+    Board board;
+    GameVersion version = GameVersion::ORIGINAL;
+    uint8_t flags = 0;        // SAVE_FLAG_* 组合
+    uint32_t moveCount = 0;
+    int score = 0;
+    uint64_t seed = 0;
+    uint64_t rngState = 0;
+    std::string replayPath;   // 本局正在录制的回放文件，没有录制时为空
+};
+
+// 对话框与胜负标志
+constexpr uint8_t SAVE_FLAG_GAME_OVER = 1 << 0;
+constexpr uint8_t SAVE_FLAG_GAME_WON = 1 << 1;
+constexpr uint8_t SAVE_FLAG_WIN_DIALOG = 1 << 2;
+constexpr uint8_t SAVE_FLAG_ACHIEVED_WIN = 1 << 3;
+constexpr uint8_t SAVE_FLAG_ACHIEVEMENT_DIALOG = 1 << 4;
+constexpr uint8_t SAVE_FLAG_PAUSED = 1 << 5;
+// 不是对话框状态：本局开启了恶意生成，读档后继续使用
+constexpr uint8_t SAVE_FLAG_EVIL_SPAWNS = 1 << 6;
+
+// 只追加的存档日志：
+//   文件头 "MAOJ" + 版本，之后是一条条记录 [类型][长度(2字节)][内容][FNV-1a校验]
+//   'S' 完整快照，'M' 一步移动（移动后的标志 + 回放格式的一步），'F' 对话框标志变化
+// 每步只写几个字节进内核缓冲区，fsync 由后台线程按批次执行，按键不会等待磁盘；
+// 每隔 SNAPSHOT_INTERVAL 步追加一次快照，恢复时只需重演最后一个快照之后的尾部。
+// 日志过长时快照照常追加，再由后台线程把"文件头 + 这个快照 + 之后追加的记录"写成新文件，
+// 落盘后原子替换并同步目录，最后在锁内换掉追加用的文件；按键线程从不等待重写。
+// 崩溃时最后一条可能只写了一半，校验失败的记录及其之后的内容都会被忽略。
+class SaveJournal {
+public:
+    static constexpr int SNAPSHOT_INTERVAL = 64;
+
+    SaveJournal();
+    ~SaveJournal();
+
+    SaveJournal(const SaveJournal&) = delete;
+    SaveJournal& operator=(const SaveJournal&) = delete;
+
+    // 新建（或覆盖）存档，并写入初始快照
+    bool begin(const std::string& filename, const SaveState& state);
+    void appendMove(const ReplayMove& move, uint8_t flagsAfterMove);
+    void appendFlags(uint8_t flags);
+    // 追加快照；日志过长时让后台线程把日志压缩成从这个快照开始的新文件
+    void appendSnapshot(const SaveState& state);
+    int movesSinceSnapshot() const { return movesSinceLastSnapshot; }
+    bool isOpen() const { return opened; }
+    void close();
+
+    static bool load(const std::string& filename, SaveState& state);
+
+private:
+    bool writeFresh(const std::string& filename, const SaveState& state);
+    void appendRecord(uint8_t type, const uint8_t* payload, int length);
+    void syncLoop();
+    // 在后台线程里执行，进入和返回时都持有 syncMutex
+    void compact(std::unique_lock<std::mutex>& lock);
+
+    // file 会被后台线程压缩时换掉，读写它都要持有 syncMutex
+    FILE* file;
+    std::string path;
+    long fileSize;
+    int movesSinceLastSnapshot;
+    bool opened;   // 只在主线程使用
+
+    // 后台 fsync 和压缩线程
+    std::thread syncThread;
+    std::mutex syncMutex;
+    std::condition_variable syncCondition;
+    int unsyncedRecords;
+    bool stopSync;
+    bool compacting;                    // 已请求压缩、还没换文件
+    std::vector<uint8_t> compactSnapshot;   // 压缩后新文件的第一条记录
+    std::vector<uint8_t> compactTail;       // 请求压缩之后追加的记录，换文件前补进新文件
+    uint64_t generation;                // 每次 begin/close 加一，作废进行中的压缩
+};
+
+#endif // SAVE_JOURNAL_H
@@ -0,0 +1,142 @@
+#include "UndoHistory.h"
+#include <cstring>
+
+namespace {
+
+constexpr size_t ENTRY_FIXED_SIZE = 8 + 4 + 1 + 1 + 2 + 1; // 随机数状态 | 分数增量 | 标志 | 方向 | 新方块位置 | 新方块指数
+constexpr uint16_t NO_SPAWN = 0xFFFF;
+constexpr size_t INITIAL_CAPACITY = 64;
+constexpr uint8_t NIBBLE_MAX = 15;
+
+} // namespace
+
+UndoHistory::UndoHistory(size_t maxEntries)
+    : maxEntries(maxEntries), boardSize(0), cellCount(0), wideCells(false), cellBytes(0), stride(ENTRY_FIXED_SIZE),
+      capacity(0), head(0), count(0) {
+}
+
+void UndoHistory::clear(int size) {
+    boardSize = size;
+    cellCount = size * size;
+    wideCells = false;
+    cellBytes = static_cast<size_t>(cellCount + 1) / 2;
+    stride = cellBytes + ENTRY_FIXED_SIZE;
+    capacity = INITIAL_CAPACITY;
+    if (maxEntries != 0 && capacity > maxEntries) {
+        capacity = maxEntries;
+    }
+    head = 0;
+    count = 0;
+    ring.assign(capacity * stride, 0);
+    redoStack.clear();
+}
+
+void UndoHistory::grow() {
+    // 翻倍并把环形内容展开成从0开始的顺序，之后的下标计算不受影响
+    std::vector<uint8_t> larger(capacity * 2 * stride);
+    for (size_t i = 0; i < count; ++i) {
+        std::memcpy(&larger[i * stride], slot(i), stride);
+    }
+    ring.swap(larger);
+    capacity *= 2;
+    head = 0;
+}
+
+void UndoHistory::widen() {
+    const size_t wideStride = cellCount + ENTRY_FIXED_SIZE;
+    std::vector<uint8_t> wider(capacity * wideStride);
+    for (size_t i = 0; i < count; ++i) {
+        const uint8_t* in = slot(i);
+        uint8_t* out = &wider[i * wideStride];
+        for (int cell = 0; cell < cellCount; ++cell) {
+            out[cell] = (in[cell >> 1] >> ((cell & 1) * 4)) & 0x0F;
+        }
+        std::memcpy(out + cellCount, in + cellBytes, ENTRY_FIXED_SIZE);
+    }
+    ring.swap(wider);
+    wideCells = true;
+    cellBytes = cellCount;
+    stride = wideStride;
+    head = 0;
+}
+
+void UndoHistory::push(const UndoEntry& entry) {
+    if (capacity == 0) {
+        clear(entry.board.size());
+    }
+
+    if (count == capacity) {
+        if (maxEntries != 0 && count >= maxEntries) {
+            head = (head + 1) % capacity; // 丢掉最旧的一步
+            --count;
+        } else {
+            grow();
+        }
+    }
+
+    const uint8_t* cells = entry.board.cells();
+    if (!wideCells && entry.board.maxExponent() > NIBBLE_MAX) {
+        widen();
+    }
+    uint8_t* out = slot(count);
+    if (wideCells) {
+        std::memcpy(out, cells, cellCount);
+    } else {
+        for (int i = 0; i + 1 < cellCount; i += 2) {
+            out[i >> 1] = static_cast<uint8_t>(cells[i] | (cells[i + 1] << 4));
+        }
+        if (cellCount & 1) {
+            out[cellCount >> 1] = cells[cellCount - 1];
+        }
+    }
+    out += cellBytes;
+    std::memcpy(out, &entry.rngState, 8);
+    std::memcpy(out + 8, &entry.scoreGained, 4);
+    out[12] = entry.flags;
+    out[13] = static_cast<uint8_t>(entry.direction);
+    const uint16_t spawnCell = entry.spawnCell < 0 ? NO_SPAWN : static_cast<uint16_t>(entry.spawnCell);
+    std::memcpy(out + 14, &spawnCell, 2);
+    out[16] = entry.spawnExponent;
+    ++count;
+
+    if (!redoStack.empty() && redoStack.back().direction == entry.direction &&
+        redoStack.back().spawnCell == entry.spawnCell && redoStack.back().spawnExponent == entry.spawnExponent) {
+        redoStack.pop_back();
+    } else {
+        redoStack.clear();
+    }
+}
+
+bool UndoHistory::undo(UndoEntry& entry) {
+    if (count == 0) return false;
+
+    --count;
+    const uint8_t* in = slot(count);
+    if (entry.board.size() != boardSize) {
+        entry.board = Board(boardSize);
+    }
+    uint8_t* cells = entry.board.cells();
+    if (wideCells) {
+        std::memcpy(cells, in, cellCount);
+    } else {
+        for (int i = 0; i < cellCount; ++i) {
+            cells[i] = (in[i >> 1] >> ((i & 1) * 4)) & 0x0F;
+        }
+    }
+    in += cellBytes;
+    std::memcpy(&entry.rngState, in, 8);
+    std::memcpy(&entry.scoreGained, in + 8, 4);
+    entry.flags = in[12];
+    entry.direction = static_cast<Direction>(in[13]);
+    uint16_t spawnCell;
+    std::memcpy(&spawnCell, in + 14, 2);
+    entry.spawnCell = spawnCell == NO_SPAWN ? -1 : spawnCell;
+    entry.spawnExponent = in[16];
+
+    RedoStep step;
+    step.direction = entry.direction;
+    step.spawnCell = entry.spawnCell;
+    step.spawnExponent = entry.spawnExponent;
+    redoStack.push_back(step);
+    return true;
+}
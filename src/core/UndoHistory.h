@@ -0,0 +1,69 @@
+#ifndef UNDO_HISTORY_H
+#define UNDO_HISTORY_H
+
+#include <cstdint>
+#include <vector>
+#include "Board.h"
+
+// 一步之前的完整状态
+struct UndoEntry {
+    Board board;
+    uint64_t rngState = 0;
+    uint8_t flags = 0;
+    int scoreGained = 0;  // 这一步得到的分数，撤销时减回去
+    Direction direction = Direction::UP;
+    int spawnCell = -1;   // 这一步之后生成的方块，没有生成时为-1
+    uint8_t spawnExponent = 0;
+};
+
+// 可以重做的一步：方向加上第一次走时生成的方块
+struct RedoStep {
+    Direction direction = Direction::UP;
+    int spawnCell = -1;
+    uint8_t spawnExponent = 0;
+};
+
+// 撤销/重做历史
+// 每步按固定步长紧凑地存进一块环形缓冲区（棋盘 + 随机数状态 + 分数增量 + 标志 + 方向 + 新方块），没有逐步的堆分配。
+// 指数都不超过15（方块不超过32768）时每格只占半个字节，4x4约25字节、64x64约2KB；
+// 第一次出现更大的方块时整个缓冲区一次性展开成每格1字节，之后直到 clear 都按1字节存。
+// 没有做相对上一步的差分：满了会覆盖最旧的一步，差分链需要定期插入完整的关键帧，
+// 而撤销又要能从任意一步开始还原，省下的空间换不回额外的复杂度。撤销会恢复随机数状态，随机生成时从恢复的状态重新执行同一方向
+// 必然得到相同的新方块；恶意生成不用随机数，重做栈里同时记下第一次生成的方块，重做时直接放回，不再搜索。
+class UndoHistory {
+public:
+    // maxEntries 为0表示不限步数（缓冲区按需翻倍），否则满了之后覆盖最旧的一步
+    explicit UndoHistory(size_t maxEntries = 0);
+
+    void clear(int size);
+    // 记录一步；如果方向和新方块都与重做栈顶相同则视为重做，否则清空重做栈
+    void push(const UndoEntry& entry);
+    // 弹出最近一步，它的方向和新方块进入重做栈
+    bool undo(UndoEntry& entry);
+
+    bool canUndo() const { return count > 0; }
+    bool canRedo() const { return !redoStack.empty(); }
+    const RedoStep& nextRedo() const { return redoStack.back(); }
+    size_t size() const { return count; }
+    size_t memoryBytes() const { return ring.size() + redoStack.size() * sizeof(RedoStep); }
+
+private:
+    void grow();
+    // 改成每格1字节，已有的各步逐个展开
+    void widen();
+    uint8_t* slot(size_t index) { return &ring[((head + index) % capacity) * stride]; }
+
+    size_t maxEntries;
+    int boardSize;
+    int cellCount;
+    bool wideCells;     // 每格1字节；否则每格半字节
+    size_t cellBytes;
+    size_t stride;
+    size_t capacity;
+    size_t head;   // 最旧一步所在的槽位
+    size_t count;
+    std::vector<uint8_t> ring;
+    std::vector<RedoStep> redoStack;
+};
+
+#endif // UNDO_HISTORY_H
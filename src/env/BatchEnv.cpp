@@ -0,0 +1,316 @@
+#include "mao_env.h"
+#include "../core/Board.h"
+#include "../core/BoardEngine.h"
+#include "../core/Rng.h"
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// 每个线程至少分到这么多棋盘才值得多开线程（4x4 棋盘一步不到100纳秒，唤醒一次线程要几微秒）
+constexpr int MIN_BOARDS_PER_THREAD = 256;
+
+enum class EnvJob {
+    STEP,
+    LEGAL
+};
+
+} // namespace
+
+struct MaoEnv {
+    int batch;
+    int gridSize;
+    GameVersion version;
+    const BoardRules& rules;        // 按尺寸和版本特化的移动和结束判断
+
+    std::vector<Board> boards;
+    std::vector<Rng> rngs;          // 生成方块用，每局用本局种子重新播种，与游戏一致
+    std::vector<Rng> seeders;       // 给每个棋盘的每一局抽种子
+    std::vector<uint64_t> episodeSeeds;
+    std::vector<uint32_t> scores;
+    std::vector<uint32_t> moveCounts;
+    std::vector<uint32_t> lastScores;
+    std::vector<uint32_t> lastMoves;
+    std::vector<uint64_t> lastSeeds;
+    std::vector<Board> scratch;     // 每个线程一个，判断合法方向时试走用
+
+    // 当前这批工作的参数，由调用线程写好后再唤醒工作线程
+    EnvJob job = EnvJob::STEP;
+    const int32_t* actions = nullptr;
+    uint8_t* obs = nullptr;
+    float* rewards = nullptr;
+    uint8_t* dones = nullptr;
+    uint8_t* masks = nullptr;
+
+    int threadCount = 0;
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable startCondition;
+    std::condition_variable doneCondition;
+    uint64_t generation = 0;
+    int pending = 0;
+    bool stopping = false;
+
+    MaoEnv(int batchSize, int size, GameVersion gameVersion, uint64_t seed);
+    ~MaoEnv();
+
+    void startBoard(int index);
+    void stepBoard(int index);
+    void writeObservation(int index, uint8_t* out) const;
+    uint8_t legalMoves(int index, Board& trial) const;
+
+    void setThreads(int threads);
+    void stopWorkers();
+    void workerLoop(int thread, uint64_t seen);
+    void runChunk(int thread);
+    void run(EnvJob nextJob);
+};
+
+MaoEnv::MaoEnv(int batchSize, int size, GameVersion gameVersion, uint64_t seed)
+    : batch(batchSize),
+      gridSize(size),
+      version(gameVersion),
+      rules(boardRules(size, gameVersion)),
+      boards(batchSize, Board(size)),
+      rngs(batchSize),
+      seeders(batchSize),
+      episodeSeeds(batchSize, 0),
+      scores(batchSize, 0),
+      moveCounts(batchSize, 0),
+      lastScores(batchSize, 0),
+      lastMoves(batchSize, 0),
+      lastSeeds(batchSize, 0) {
+    // 各棋盘的种子序列互不相同，又都由 seed 决定
+    for (int i = 0; i < batch; ++i) {
+        seeders[i].seed(seed ^ (0x9E3779B97F4A7C15ULL * static_cast<uint64_t>(i + 1)));
+        startBoard(i);
+    }
+    setThreads(0);
+}
+
+MaoEnv::~MaoEnv() {
+    stopWorkers();
+}
+
+void MaoEnv::startBoard(int index) {
+    // 与 Game::initializeGame 相同：每局播种一次，再生成两个方块
+    Rng& seeder = seeders[index];
+    const uint64_t seed = (static_cast<uint64_t>(seeder.next()) << 32) | seeder.next();
+    episodeSeeds[index] = seed;
+    rngs[index].seed(seed);
+    Board& board = boards[index];
+    board.clear();
+    board.spawnRandom(rngs[index]);
+    board.spawnRandom(rngs[index]);
+    scores[index] = 0;
+    moveCounts[index] = 0;
+}
+
+void MaoEnv::stepBoard(int index) {
+    float reward = 0.0f;
+    uint8_t done = 0;
+    const int32_t action = actions[index];
+    if (action >= 0 && action < 4) {
+        // 与 Game::playMove 相同：走不动时什么都不发生，走动后生成方块、计步、判断结束
+        Board& board = boards[index];
+        MoveResult result;
+        if (rules.move(board, directionFromIndex(version, action), result, nullptr)) {
+            board.spawnRandom(rngs[index]);
+            scores[index] += static_cast<uint32_t>(result.scoreGained);
+            ++moveCounts[index];
+            reward = static_cast<float>(result.scoreGained);
+            if (rules.isGameOver(board)) {
+                lastScores[index] = scores[index];
+                lastMoves[index] = moveCounts[index];
+                lastSeeds[index] = episodeSeeds[index];
+                startBoard(index);
+                done = 1;
+            }
+        }
+    }
+    if (obs) writeObservation(index, obs);
+    if (rewards) rewards[index] = reward;
+    if (dones) dones[index] = done;
+}
+
+void MaoEnv::writeObservation(int index, uint8_t* out) const {
+    const size_t cellCount = static_cast<size_t>(gridSize) * gridSize;
+    std::memcpy(out + index * cellCount, boards[index].cells(), cellCount);
+}
+
+uint8_t MaoEnv::legalMoves(int index, Board& trial) const {
+    uint8_t mask = 0;
+    for (int i = 0; i < 4; ++i) {
+        // 同尺寸的棋盘之间赋值不会重新分配内存
+        trial = boards[index];
+        MoveResult result;
+        if (rules.move(trial, directionFromIndex(version, i), result, nullptr)) {
+            mask |= static_cast<uint8_t>(1 << i);
+        }
+    }
+    return mask;
+}
+
+void MaoEnv::setThreads(int threads) {
+    if (threads <= 0) {
+        const int cores = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+        threads = std::min(cores, std::max(1, batch / MIN_BOARDS_PER_THREAD));
+    }
+    threads = std::min(threads, batch);
+    if (threads == threadCount) return;
+
+    stopWorkers();
+    threadCount = threads;
+    scratch.assign(threadCount, Board(gridSize));
+    stopping = false;
+    // 调用线程自己处理第0段，只为其余各段开线程
+    for (int t = 1; t < threadCount; ++t) {
+        workers.emplace_back(&MaoEnv::workerLoop, this, t, generation);
+    }
+}
+
+void MaoEnv::stopWorkers() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    startCondition.notify_all();
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    workers.clear();
+}
+
+void MaoEnv::workerLoop(int thread, uint64_t seen) {
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            startCondition.wait(lock, [&] { return stopping || generation != seen; });
+            if (stopping) return;
+            seen = generation;
+        }
+        runChunk(thread);
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--pending == 0) doneCondition.notify_one();
+    }
+}
+
+void MaoEnv::runChunk(int thread) {
+    // 第 thread 段为连续的 [begin, end)，相邻线程写的输出区间互不重叠
+    const int begin = static_cast<int>(static_cast<int64_t>(batch) * thread / threadCount);
+    const int end = static_cast<int>(static_cast<int64_t>(batch) * (thread + 1) / threadCount);
+    switch (job) {
+        case EnvJob::STEP:
+            for (int i = begin; i < end; ++i) stepBoard(i);
+            break;
+        case EnvJob::LEGAL:
+            for (int i = begin; i < end; ++i) masks[i] = legalMoves(i, scratch[thread]);
+            break;
+    }
+}
+
+void MaoEnv::run(EnvJob nextJob) {
+    job = nextJob;
+    if (threadCount == 1) {
+        runChunk(0);
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        ++generation;
+        pending = threadCount - 1;
+    }
+    startCondition.notify_all();
+    runChunk(0);
+    std::unique_lock<std::mutex> lock(mutex);
+    doneCondition.wait(lock, [&] { return pending == 0; });
+}
+
+extern "C" {
+
+int env_abi_version(void) {
+    return MAO_ENV_ABI_VERSION;
+}
+
+MaoEnv* env_create(int batch, int grid_size, int version, uint64_t seed) {
+    if (batch <= 0 || grid_size < 2 || grid_size > Board::MAX_SIZE || (version != 0 && version != 1)) {
+        std::cerr << "env_create: invalid arguments (batch " << batch << ", grid size " << grid_size
+                  << ", version " << version << ")" << std::endl;
+        return nullptr;
+    }
+    const GameVersion gameVersion = version == 0 ? GameVersion::ORIGINAL : GameVersion::MODIFIED;
+    return new MaoEnv(batch, grid_size, gameVersion, seed);
+}
+
+void env_destroy(MaoEnv* env) {
+    delete env;
+}
+
+int env_set_threads(MaoEnv* env, int threads) {
+    if (!env || threads < 0) return -1;
+    env->setThreads(threads);
+    return 0;
+}
+
+int env_batch(const MaoEnv* env) {
+    return env ? env->batch : -1;
+}
+
+int env_obs_size(const MaoEnv* env) {
+    return env ? env->gridSize * env->gridSize : -1;
+}
+
+int env_reset(MaoEnv* env, uint8_t* obs) {
+    if (!env) return -1;
+    for (int i = 0; i < env->batch; ++i) {
+        env->startBoard(i);
+    }
+    return env_observe(env, obs);
+}
+
+int env_step(MaoEnv* env, const int32_t* actions, uint8_t* obs, float* rewards, uint8_t* dones) {
+    if (!env || !actions) return -1;
+    env->actions = actions;
+    env->obs = obs;
+    env->rewards = rewards;
+    env->dones = dones;
+    env->run(EnvJob::STEP);
+    return 0;
+}
+
+int env_observe(const MaoEnv* env, uint8_t* obs) {
+    if (!env) return -1;
+    if (!obs) return 0;
+    for (int i = 0; i < env->batch; ++i) {
+        env->writeObservation(i, obs);
+    }
+    return 0;
+}
+
+int env_legal_moves(MaoEnv* env, uint8_t* masks) {
+    if (!env || !masks) return -1;
+    env->masks = masks;
+    env->run(EnvJob::LEGAL);
+    return 0;
+}
+
+int env_episode_seeds(const MaoEnv* env, uint64_t* seeds) {
+    if (!env || !seeds) return -1;
+    std::copy(env->episodeSeeds.begin(), env->episodeSeeds.end(), seeds);
+    return 0;
+}
+
+int env_last_episodes(const MaoEnv* env, uint32_t* scores, uint32_t* moves, uint64_t* seeds) {
+    if (!env) return -1;
+    if (scores) std::copy(env->lastScores.begin(), env->lastScores.end(), scores);
+    if (moves) std::copy(env->lastMoves.begin(), env->lastMoves.end(), moves);
+    if (seeds) std::copy(env->lastSeeds.begin(), env->lastSeeds.end(), seeds);
+    return 0;
+}
+
+} // extern "C"
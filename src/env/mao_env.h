@@ -0,0 +1,80 @@
+#ifndef MAO_ENV_H
+#define MAO_ENV_H
+
+/*
+ * 强化学习训练用的批量环境（共享库 libmao_env，纯C接口，可以直接用 ctypes/cffi 加载）。
+ * 一个环境同时推进 batch 个棋盘，每次 env_step 所有棋盘各走一步：
+ *   - 规则就是游戏本身的 Board::move / Board::spawnRandom：走不动的方向不生成新方块、不计步数，
+ *     走动之后在空格里生成2或4，然后判断是否结束；
+ *   - 局面、奖励和结束标志写进调用方提供的连续缓冲区，每步不分配内存；
+ *   - 结束的棋盘立即自动重开，写出的局面是新一局的开局，dones 对应位置为1；
+ *   - 棋盘按连续的区间分给常驻的工作线程。
+ * 每一局都有自己的64位种子（env_episode_seeds），游戏里设置 MAO_SEED=<种子> 再按同样的动作走，
+ * 得到的是完全相同的一局。
+ *
+ * 返回 int 的函数成功时返回0，参数错误时返回-1。同一个环境不能被多个线程同时调用。
+ */
+
+#include <stdint.h>
+
+#if defined(_WIN32)
+#  if defined(MAO_ENV_BUILD)
+#    define MAO_ENV_API __declspec(dllexport)
+#  else
+#    define MAO_ENV_API __declspec(dllimport)
+#  endif
+#else
+#  define MAO_ENV_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MAO_ENV_ABI_VERSION 1
+
+typedef struct MaoEnv MaoEnv;
+
+MAO_ENV_API int env_abi_version(void);
+
+/* grid_size 为 2-64；version 为 0（经典，动作0-3依次为上下左右）或 1（对角线，动作0-3依次为
+ * 左上、右上、左下、右下）。创建后所有棋盘已经开局，用 env_reset 或 env_observe 取得初始局面。
+ * 参数无效时返回 NULL。 */
+MAO_ENV_API MaoEnv* env_create(int batch, int grid_size, int version, uint64_t seed);
+MAO_ENV_API void env_destroy(MaoEnv* env);
+
+/* 工作线程数（包括调用线程），0 表示按CPU核数和批量大小自动选择 */
+MAO_ENV_API int env_set_threads(MaoEnv* env, int threads);
+
+MAO_ENV_API int env_batch(const MaoEnv* env);
+/* 每个棋盘的局面字节数，即 grid_size * grid_size */
+MAO_ENV_API int env_obs_size(const MaoEnv* env);
+
+/* 所有棋盘重新开局，obs 为 batch * env_obs_size 字节（可以为 NULL） */
+MAO_ENV_API int env_reset(MaoEnv* env, uint8_t* obs);
+
+/* 每个棋盘走一步。
+ * actions: batch 个动作下标 0-3，超出范围或走不动的方向视为原地不动（奖励为0）；
+ * obs:     batch * env_obs_size 字节，行优先的指数（0为空，1为2，2为4……）；
+ * rewards: batch 个，本步合并得到的分数；
+ * dones:   batch 个，本步结束（并已经重开）的棋盘为1。
+ * obs、rewards 和 dones 都可以为 NULL。 */
+MAO_ENV_API int env_step(MaoEnv* env, const int32_t* actions, uint8_t* obs, float* rewards, uint8_t* dones);
+
+/* 只导出当前局面，不走棋 */
+MAO_ENV_API int env_observe(const MaoEnv* env, uint8_t* obs);
+
+/* 每个棋盘当前可走的方向，第i位表示动作i能让棋盘变化 */
+MAO_ENV_API int env_legal_moves(MaoEnv* env, uint8_t* masks);
+
+/* 每个棋盘当前这一局的种子 */
+MAO_ENV_API int env_episode_seeds(const MaoEnv* env, uint64_t* seeds);
+
+/* 每个棋盘最近一局结束时的分数、步数和种子（还没有结束过的为0），任一指针可以为 NULL */
+MAO_ENV_API int env_last_episodes(const MaoEnv* env, uint32_t* scores, uint32_t* moves, uint64_t* seeds);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MAO_ENV_H */
@@ -1,23 +1,22 @@
 #include "Game2048.h"
 #include "../gif/gif_wrapper.h"
 #include <stdexcept>
-#include <random>
+#include <cstdlib>
+#include <filesystem>
 #include <sstream>
+#include <iomanip>
 #include <iostream>
 #include <locale>
 #include <codecvt>
+#include <chrono>
 #include <cmath>
+#include <ctime>
 #include <SFML/Graphics.hpp>
 
-// Window dimensions
-constexpr int WINDOW_WIDTH = 800;
-constexpr int WINDOW_HEIGHT = 800;
-// Grid offsets
-int GRID_OFFSET_X = 100;
-int GRID_OFFSET_Y = 200;
-// Tile size and spacing
-int TILE_SIZE = 30;
-int TILE_MARGIN = 5;
+// 界面设计坐标的尺寸，实际窗口的大小和缩放由 Layout 处理
+constexpr int DESIGN_WIDTH = Layout::DESIGN_WIDTH;
+constexpr int DESIGN_HEIGHT = Layout::DESIGN_HEIGHT;
+
 // Grid line properties
 constexpr int GRID_LINE_THICKNESS = 4;
 const sf::Color GRID_LINE_COLOR = sf::Color(119, 110, 101);
@@ -25,18 +24,68 @@ const sf::Color GRID_LINE_COLOR = sf::Color(119, 110, 101);
 // Animation speed - 修改这里可以调整主菜单GIF移动速度
 constexpr float GIF_MOVE_SPEED = 100.0f; // pixels per second (减慢了速度)
 
+// 存档文件位置
+const std::string SAVE_FILE = "save/current.journal";
+
 // 胜利条件配置 - 修改这里可以改变胜利所需的数值
 constexpr int WIN_VALUE = 16; // 当前设为16，以后可改为2048
 
+// WIN_VALUE 对应的指数，胜率按它求解
+constexpr int winExponent() {
+    int exponent = 0;
+    while ((1 << exponent) < WIN_VALUE) ++exponent;
+    return exponent;
+}
+
+// 胜率求解：后台每个局面最多算这么久，超过就不再算；表约 36MB，满了按局面挤掉旧结果
+constexpr std::chrono::milliseconds CHANCE_TIME_LIMIT(5000);
+constexpr int CHANCE_TABLE_BITS = 21;
+
+// 提示文字里的方向名，按 Direction 下标
+const char* const HINT_DIRECTION_NAMES[] = {
+    "上 (↑)", "下 (↓)", "左 (←)", "右 (→)", "左上 (Q)", "右上 (E)", "左下 (Z)", "右下 (C)"
+};
+
 // UTF-8 字符串转换辅助函数
 sf::String toUTF8String(const std::string& str) {
     return sf::String::fromUtf8(str.begin(), str.end());
 }
 
-Game::Game() : window(sf::VideoMode(WINDOW_WIDTH, WINDOW_HEIGHT), L"合成耄孩子"),
+// 往三角形网格里追加一个纯色矩形
+static void appendQuad(sf::VertexArray& mesh, const sf::FloatRect& rect, const sf::Color& color) {
+    const sf::Vector2f topLeft(rect.left, rect.top);
+    const sf::Vector2f topRight(rect.left + rect.width, rect.top);
+    const sf::Vector2f bottomRight(rect.left + rect.width, rect.top + rect.height);
+    const sf::Vector2f bottomLeft(rect.left, rect.top + rect.height);
+    mesh.append(sf::Vertex(topLeft, color));
+    mesh.append(sf::Vertex(topRight, color));
+    mesh.append(sf::Vertex(bottomRight, color));
+    mesh.append(sf::Vertex(topLeft, color));
+    mesh.append(sf::Vertex(bottomRight, color));
+    mesh.append(sf::Vertex(bottomLeft, color));
+}
+
+Game::Game(bool fullscreen)
+             : window(fullscreen ? sf::VideoMode::getDesktopMode() : sf::VideoMode(DESIGN_WIDTH, DESIGN_HEIGHT),
+                      L"合成耄孩子", fullscreen ? sf::Style::Fullscreen : sf::Style::Default),
                currentState(GameState::MAIN_MENU),
                currentVersion(GameVersion::ORIGINAL),
                gridSize(4),
+               rules(&boardRules(4, GameVersion::ORIGINAL)),
+               hugeSizeIndex(2),
+               boardLayoutGeneration(1),
+               chunkGeneration(0),
+               boardPixelScale(1.0f),
+               panning(false),
+               tileVisualTileSize(0),
+               tileVisualInnerSize(0),
+               tileVisualPixelScale(0.0f),
+               tileLevelScale(0.0f),
+               levelRebuildDelay(0.0f),
+               frameDirty(true),
+               scoreLabelKey(-1, 0, false, false),
+               renderQuit(false),
+               quitRequested(false),
                score(0),
                gameOver(false),
                gameWon(false),
@@ -44,11 +93,43 @@ Game::Game() : window(sf::VideoMode(WINDOW_WIDTH, WINDOW_HEIGHT), L"合成耄孩
                achievedWin(false),
                winAchievementDialogShown(false),
                isPaused(false),
-               gifXPosition(WINDOW_WIDTH),
-               secondGifXPosition(WINDOW_WIDTH + 150) { // 第二个GIF初始位置偏移
+               gameSeed(0),
+               hasFixedSeed(false),
+               fixedSeed(0),
+               replayMode(false),
+               replayPaused(false),
+               replayTimer(0.0f),
+               journaledFlags(0),
+               moveCount(0),
+               hasSavedGame(false),
+               bestScore(0),
+               scoreSubmitted(false),
+               kioskId(0),
+               hintEnabled(false),
+               hintLabelKey(0),
+               monteCarloEnabled(false),
+               chanceEnabled(false),
+               chanceProgress(WinSolver::Progress::SOLVING),
+               evilSpawns(false),
+               musicMuted(false),
+               botMode(false),
+               botCommandsSinceRender(0),
+               gifXPosition(DESIGN_WIDTH),
+               secondGifXPosition(DESIGN_WIDTH + 150) { // 第二个GIF初始位置偏移
     
     // 设置UTF-8语言环境支持中文
     std::setlocale(LC_ALL, "en_US.UTF-8");
+    keysDown.fill(false);
+
+    // 允许用环境变量固定随机种子，方便复现某一局
+    if (const char* seedEnv = std::getenv("MAO_SEED")) {
+        fixedSeed = std::strtoull(seedEnv, nullptr, 10);
+        hasFixedSeed = true;
+        std::cout << "使用固定随机种子: " << fixedSeed << std::endl;
+    }
+    if (const char* kioskEnv = std::getenv("MAO_KIOSK_ID")) {
+        kioskId = static_cast<uint32_t>(std::strtoul(kioskEnv, nullptr, 10));
+    }
     
     // 尝试加载支持中文的字体 - 优先使用确定有效的项目字体
     bool fontLoaded = false;
@@ -102,6 +183,21 @@ Game::Game() : window(sf::VideoMode(WINDOW_WIDTH, WINDOW_HEIGHT), L"合成耄孩
         std::cout << "⚠ 警告：将使用默认字体，中文可能无法正确显示" << std::endl;
     }
     
+    // 检查是否有可以继续的存档
+    SaveState savedState;
+    hasSavedGame = SaveJournal::load(SAVE_FILE, savedState);
+    
+    // 提示用的权重文件，没有时提示功能不可用
+    for (GameVersion version : {GameVersion::ORIGINAL, GameVersion::MODIFIED}) {
+        const std::string path = NTupleWeights::defaultPath(version);
+        NTupleWeights& weights = hintWeights[static_cast<size_t>(version)];
+        if (weights.load(path)) {
+            std::cout << "✓ 已加载提示权重: " << path << "（训练 " << weights.gamesTrained() << " 局）" << std::endl;
+        }
+    }
+    
+    startAudio();
+    
     setupTileColors();
     initializeUI();
     setupExitConfirmUI();
@@ -127,6 +223,10 @@ Game::Game() : window(sf::VideoMode(WINDOW_WIDTH, WINDOW_HEIGHT), L"合成耄孩
     // 图片加载完成后，重新设置sprite的纹理和位置
     setupWinSprites();
 
+    // 按窗口的实际尺寸生成布局和各种渲染缓存
+    registerScaledTexts();
+    onResize(window.getSize().x, window.getSize().y);
+
     // 加载主菜单封面GIF (使用主菜单背景色)
     sf::Color mainMenuBackgroundColor(187, 173, 160); // 主菜单背景色
     GifWrapper coverGif;
@@ -160,7 +260,6 @@ Game::Game() : window(sf::VideoMode(WINDOW_WIDTH, WINDOW_HEIGHT), L"合成耄孩
     // 对应的方块值，用于获取正确的背景色
     std::vector<int> decorativeValues = {4, 8, 16, 32, 64};
     
-    decorativeTextures.resize(decorativeFiles.size());
     decorativeSprites.resize(decorativeFiles.size());
     decorativeGifWrappers.resize(decorativeFiles.size());
     
@@ -168,11 +267,11 @@ Game::Game() : window(sf::VideoMode(WINDOW_WIDTH, WINDOW_HEIGHT), L"合成耄孩
         // 所有装饰GIF都使用主菜单背景色，保持一致的渲染方式
         sf::Color decorativeBackgroundColor = mainMenuBackgroundColor;
         if (decorativeGifWrappers[i].loadFromFile(decorativeFiles[i], decorativeBackgroundColor)) {
-            decorativeTextures[i] = decorativeGifWrappers[i].getCurrentFrame();
-            decorativeSprites[i].setTexture(decorativeTextures[i]);
+            const sf::Texture& firstFrame = decorativeGifWrappers[i].getCurrentFrame();
+            decorativeSprites[i].setTexture(firstFrame);
             
             // 设置装饰图片的大小和位置 (避免与文字重合)
-            float scale = 80.0f / std::max(decorativeTextures[i].getSize().x, decorativeTextures[i].getSize().y);
+            float scale = 80.0f / std::max(firstFrame.getSize().x, firstFrame.getSize().y);
             decorativeSprites[i].setScale(scale, scale);
             
             // 根据索引设置不同位置
@@ -181,16 +280,16 @@ Game::Game() : window(sf::VideoMode(WINDOW_WIDTH, WINDOW_HEIGHT), L"合成耄孩
                     decorativeSprites[i].setPosition(50, 50);
                     break;
                 case 1: // 右上角
-                    decorativeSprites[i].setPosition(WINDOW_WIDTH - 130, 50);
+                    decorativeSprites[i].setPosition(DESIGN_WIDTH - 130, 50);
                     break;
                 case 2: // 左下角 (避开动画GIF区域)
-                    decorativeSprites[i].setPosition(50, WINDOW_HEIGHT / 2);
+                    decorativeSprites[i].setPosition(50, DESIGN_HEIGHT / 2);
                     break;
                 case 3: // 右下角 (避开动画GIF区域)
-                    decorativeSprites[i].setPosition(WINDOW_WIDTH - 130, WINDOW_HEIGHT / 2);
+                    decorativeSprites[i].setPosition(DESIGN_WIDTH - 130, DESIGN_HEIGHT / 2);
                     break;
                 case 4: // 左中
-                    decorativeSprites[i].setPosition(50, WINDOW_HEIGHT / 2 - 150);
+                    decorativeSprites[i].setPosition(50, DESIGN_HEIGHT / 2 - 150);
                     break;
             }
             
@@ -205,9 +304,15 @@ Game::Game() : window(sf::VideoMode(WINDOW_WIDTH, WINDOW_HEIGHT), L"合成耄孩
         std::cerr << "✗ Failed to load 32768.jpg" << std::endl;
     } else {
         std::cout << "✓ Successfully loaded 32768.jpg" << std::endl;
-        tileGifTexturesMap[32768] = texture32768;
+        texture32768.setSmooth(true);
+        texture32768.generateMipmap();
+        tileGifTexturesMap[32768] = &texture32768;
     }
 
+    // 各种网格大小下方块实际显示的像素边长，GIF在加载时就缩小到这些尺寸
+    const std::vector<unsigned> tilePixelSizes = tileLevelSizes(layout);
+    tileLevelScale = layout.scale();
+
     // 加载所有可能的GIF纹理（除了32768）
     std::vector<int> values = {2, 4, 8, 16, 32, 64, 128, 256, 512, 1024, 2048, 4096, 8192, 16384};
     for (int value : values) {
@@ -219,61 +324,165 @@ Game::Game() : window(sf::VideoMode(WINDOW_WIDTH, WINDOW_HEIGHT), L"合成耄孩
         
         if (wrapper.loadFromFile(filename, tileBackgroundColor)) {
             std::cout << "Loaded GIF with background: " << filename << std::endl;
-            tileGifTexturesMap[value] = wrapper.getCurrentFrame();
+            wrapper.setLevelSizes(tilePixelSizes, true);
             gifWrappers[value] = std::move(wrapper);
+            tileGifTexturesMap[value] = &gifWrappers[value].getCurrentFrame();
         } else {
             std::cerr << "Failed to load GIF: " << filename << std::endl;
             // 如果加载失败，使用32768.jpg作为后备
             if (texture32768.getSize().x > 0) {
-                tileGifTexturesMap[value] = texture32768;
+                tileGifTexturesMap[value] = &texture32768;
             } else {
                 // 创建后备纹理
-                sf::Texture fallback;
+                sf::Texture& fallback = fallbackTileTextures[value];
                 fallback.create(100, 100);
                 sf::Image img;
                 img.create(100, 100, tileBackgroundColor);
                 fallback.loadFromImage(img);
-                tileGifTexturesMap[value] = fallback;
+                tileGifTexturesMap[value] = &fallback;
             }
         }
     }
 }
 
 void Game::run() {
+    // 绘制交给渲染线程：窗口的OpenGL上下文要先在主线程上释放，渲染线程才能激活它。
+    // 主线程只轮询事件、推进逻辑、发布帧快照，显卡忙的时候按键照样在一毫秒内处理
+    window.setActive(false);
+    renderQuit.store(false);
+    std::thread renderer(&Game::renderLoop, this);
+    
     sf::Clock clock;
-    while (window.isOpen()) {
+    while (!quitRequested) {
         sf::Time deltaTime = clock.restart();
         processEvents();
         update(deltaTime);
-        render();
+        // 音效在发布这一帧之前发出，输入到出声之间不隔着绘制
+        sfx.flush();
+        frameInputTime = SoundEffects::Clock::time_point();
+        const bool publish = botMode ? shouldRender()
+                                     : frameDirty || publishClock.getElapsedTime().asMilliseconds() >= FRAME_INTERVAL_MS;
+        if (publish) {
+            publishFrame();
+        }
+        // 外部程序驱动时尽快执行命令，平时每轮之间让出一点CPU
+        if (!botMode) {
+            sf::sleep(sf::milliseconds(LOGIC_TICK_MS));
+        }
+    }
+    
+    renderQuit.store(true);
+    renderer.join();
+    window.close();
+    if (std::getenv("MAO_SFX_STATS")) {
+        printSoundStats();
+    }
+    if (std::getenv("MAO_INPUT_STATS")) {
+        printInputStats();
     }
 }
 
+void Game::renderLoop() {
+    window.setActive(true);
+    sf::Clock clock;
+    while (!renderQuit.load()) {
+        // 逻辑线程有输入时立即发布，否则按显示节奏发布；没有新快照时不重画
+        if (!frames.update()) {
+            sf::sleep(sf::milliseconds(LOGIC_TICK_MS));
+            continue;
+        }
+        const FrameSnapshot& frame = frames.readBuffer();
+        if (frame.valid) {
+            render(frame, clock.restart().asSeconds());
+        }
+    }
+    window.setActive(false);
+}
+
+void Game::publishFrame() {
+    // 写端拿到的格子里是更早的一帧，所有字段都要重写；各个数组的容量会保留下来，稳定后不再分配内存
+    frameDirty = false;
+    publishClock.restart();
+    FrameSnapshot& frame = frames.writeBuffer();
+    frame.valid = true;
+    frame.state = currentState;
+    frame.hasSavedGame = hasSavedGame;
+    
+    frame.board = board;
+    frame.gridSize = gridSize;
+    frame.version = currentVersion;
+    frame.layout = layout;
+    frame.boardLayoutGeneration = boardLayoutGeneration;
+    frame.boardView = boardView;
+    frame.visibleWorld = camera.visibleWorld();
+    frame.boardPixelScale = boardPixelScale;
+    
+    frame.gameOver = gameOver;
+    frame.gameWon = gameWon;
+    frame.winDialogShown = winDialogShown;
+    frame.achievedWin = achievedWin;
+    frame.winAchievementDialogShown = winAchievementDialogShown;
+    frame.isPaused = isPaused;
+    frame.winFade = dialogFade(SAVE_FLAG_WIN_DIALOG);
+    frame.achievementFade = dialogFade(SAVE_FLAG_ACHIEVEMENT_DIALOG);
+    frame.gameOverFade = dialogFade(SAVE_FLAG_GAME_OVER);
+    frame.pauseFade = dialogFade(SAVE_FLAG_PAUSED);
+    
+    const uint32_t best = std::max<uint32_t>(bestScore, static_cast<uint32_t>(score));
+    const auto labelKey = std::make_tuple(score, best, replayMode, evilSpawns);
+    if (labelKey != scoreLabelKey) {
+        scoreLabelKey = labelKey;
+        std::stringstream ss;
+        ss << "分数: " << score;
+        if (!replayMode) {
+            ss << "   最高: " << best;
+            if (evilSpawns) {
+                ss << "   恶意生成";
+            }
+        }
+        scoreLabel = ss.str();
+    }
+    frame.scoreLabel = scoreLabel;
+    frame.replayLabel.clear();
+    frame.hintLabel.clear();
+    frame.chanceLabel.clear();
+    if (replayMode) {
+        frame.replayLabel = replayLabel;
+    } else if ((hintEnabled && hintAvailable()) || (monteCarloEnabled && monteCarloAvailable())) {
+        frame.hintLabel = hintLabel;
+    }
+    if (chanceEnabled && chanceAvailable()) {
+        frame.chanceLabel = chanceLabel;
+    }
+    
+    // 一次遍历补间池，得到每格的缩放、被滑动精灵占用的格子和滑动精灵的当前位置
+    frame.cellScale.assign(board.cellCount(), 1.0f);
+    frame.slidingCells = CellMask(board.cellCount());
+    frame.slides.clear();
+    for (size_t i = 0; i < tweens.size(); ++i) {
+        const uint32_t cell = tweens.target(i);
+        if (tweens.kind(i) == TWEEN_SLIDE) {
+            frame.slidingCells.set(cell);
+            frame.slides.push_back({tweens.x(i), tweens.y(i), static_cast<int>(tweens.payload(i))});
+        } else if (tweens.kind(i) == TWEEN_SPAWN || tweens.kind(i) == TWEEN_MERGE) {
+            frame.cellScale[cell] *= tweens.scale(i);
+        }
+    }
+    frames.publish();
+}
+
 void Game::setupTileColors() {
-    tileColors = {
-        sf::Color(238, 228, 218), // 2
-        sf::Color(237, 224, 200), // 4
-        sf::Color(242, 177, 121), // 8
-        sf::Color(245, 149, 99),  // 16
-        sf::Color(246, 124, 95),  // 32
-        sf::Color(246, 94, 59),   // 64
-        sf::Color(237, 207, 114), // 128
-        sf::Color(237, 204, 97),  // 256
-        sf::Color(237, 200, 80),  // 512
-        sf::Color(237, 197, 63),  // 1024
-        sf::Color(237, 194, 46),  // 2048
-        sf::Color(60, 58, 50)     // >2048
-    };
+    tileColors = tileColorTable();
 }
 
 void Game::setupExitConfirmUI() {
     // Semi-transparent background
-    exitConfirmBackground.setSize(sf::Vector2f(WINDOW_WIDTH, WINDOW_HEIGHT));
+    exitConfirmBackground.setSize(sf::Vector2f(DESIGN_WIDTH, DESIGN_HEIGHT));
     exitConfirmBackground.setFillColor(sf::Color(0, 0, 0, 150));
     
     // Confirmation box
     exitConfirmBox.setSize(sf::Vector2f(500, 200));
-    exitConfirmBox.setPosition(WINDOW_WIDTH/2 - 250, WINDOW_HEIGHT/2 - 100);
+    exitConfirmBox.setPosition(DESIGN_WIDTH/2 - 250, DESIGN_HEIGHT/2 - 100);
     exitConfirmBox.setFillColor(sf::Color(143, 122, 102));
     
     // Confirmation text - 横向居中
@@ -285,15 +494,15 @@ void Game::setupExitConfirmUI() {
     sf::FloatRect confirmTextRect = exitConfirmText.getLocalBounds();
     exitConfirmText.setOrigin(confirmTextRect.left + confirmTextRect.width/2.0f,
                              confirmTextRect.top + confirmTextRect.height/2.0f);
-    exitConfirmText.setPosition(WINDOW_WIDTH/2, WINDOW_HEIGHT/2 - 50);
+    exitConfirmText.setPosition(DESIGN_WIDTH/2, DESIGN_HEIGHT/2 - 50);
     
     // Yes/No buttons
     exitConfirmYesButton.setSize(sf::Vector2f(120, 50));
-    exitConfirmYesButton.setPosition(WINDOW_WIDTH/2 - 140, WINDOW_HEIGHT/2 + 20);
+    exitConfirmYesButton.setPosition(DESIGN_WIDTH/2 - 140, DESIGN_HEIGHT/2 + 20);
     exitConfirmYesButton.setFillColor(sf::Color(100, 255, 100));
     
     exitConfirmNoButton.setSize(sf::Vector2f(120, 50));
-    exitConfirmNoButton.setPosition(WINDOW_WIDTH/2 + 20, WINDOW_HEIGHT/2 + 20);
+    exitConfirmNoButton.setPosition(DESIGN_WIDTH/2 + 20, DESIGN_HEIGHT/2 + 20);
     exitConfirmNoButton.setFillColor(sf::Color(255, 100, 100));
     
     // Button texts - 横向居中
@@ -305,7 +514,7 @@ void Game::setupExitConfirmUI() {
     sf::FloatRect yesTextRect = exitConfirmYesText.getLocalBounds();
     exitConfirmYesText.setOrigin(yesTextRect.left + yesTextRect.width/2.0f,
                                 yesTextRect.top + yesTextRect.height/2.0f);
-    exitConfirmYesText.setPosition(WINDOW_WIDTH/2 - 80, WINDOW_HEIGHT/2 + 45); // 按钮中心位置
+    exitConfirmYesText.setPosition(DESIGN_WIDTH/2 - 80, DESIGN_HEIGHT/2 + 45); // 按钮中心位置
     
     exitConfirmNoText.setFont(font);
     exitConfirmNoText.setString(toUTF8String("否(N)"));
@@ -315,38 +524,38 @@ void Game::setupExitConfirmUI() {
     sf::FloatRect noTextRect = exitConfirmNoText.getLocalBounds();
     exitConfirmNoText.setOrigin(noTextRect.left + noTextRect.width/2.0f,
                                noTextRect.top + noTextRect.height/2.0f);
-    exitConfirmNoText.setPosition(WINDOW_WIDTH/2 + 80, WINDOW_HEIGHT/2 + 45); // 按钮中心位置
+    exitConfirmNoText.setPosition(DESIGN_WIDTH/2 + 80, DESIGN_HEIGHT/2 + 45); // 按钮中心位置
 }
 
 void Game::setupWinUI() {
     // Semi-transparent background
-    winBackground.setSize(sf::Vector2f(WINDOW_WIDTH, WINDOW_HEIGHT));
+    winBackground.setSize(sf::Vector2f(DESIGN_WIDTH, DESIGN_HEIGHT));
     winBackground.setFillColor(sf::Color(0, 0, 0, 150));
     
     // Win dialog box
     winBox.setSize(sf::Vector2f(600, 400));
-    winBox.setPosition(WINDOW_WIDTH/2 - 300, WINDOW_HEIGHT/2 - 200);
+    winBox.setPosition(DESIGN_WIDTH/2 - 300, DESIGN_HEIGHT/2 - 200);
     winBox.setFillColor(sf::Color(250, 248, 239));
     
     // Win sprite (will be set in setupWinSprites)
     // 这里只设置默认位置，实际纹理和位置会在图片加载后设置
-    winSprite.setPosition(WINDOW_WIDTH/2 - 100, WINDOW_HEIGHT/2 - 150);
+    winSprite.setPosition(DESIGN_WIDTH/2 - 100, DESIGN_HEIGHT/2 - 150);
     
     // "You win!!" text
     winText.setFont(font);
     winText.setString(toUTF8String("你赢了!!"));
     winText.setCharacterSize(48);
     winText.setFillColor(sf::Color::Red);
-    winText.setPosition(WINDOW_WIDTH/2 - 120, WINDOW_HEIGHT/2 - 20);
+    winText.setPosition(DESIGN_WIDTH/2 - 120, DESIGN_HEIGHT/2 - 20);
     
     // Continue button
     winContinueButton.setSize(sf::Vector2f(150, 60));
-    winContinueButton.setPosition(WINDOW_WIDTH/2 - 180, WINDOW_HEIGHT/2 + 80);
+    winContinueButton.setPosition(DESIGN_WIDTH/2 - 180, DESIGN_HEIGHT/2 + 80);
     winContinueButton.setFillColor(sf::Color(143, 122, 102));
     
     // Quit button
     winQuitButton.setSize(sf::Vector2f(150, 60));
-    winQuitButton.setPosition(WINDOW_WIDTH/2 + 30, WINDOW_HEIGHT/2 + 80);
+    winQuitButton.setPosition(DESIGN_WIDTH/2 + 30, DESIGN_HEIGHT/2 + 80);
     winQuitButton.setFillColor(sf::Color(143, 122, 102));
     
     // Button texts
@@ -354,13 +563,13 @@ void Game::setupWinUI() {
     winContinueText.setString(toUTF8String("继续(Y)"));
     winContinueText.setCharacterSize(20);
     winContinueText.setFillColor(sf::Color::White);
-    winContinueText.setPosition(WINDOW_WIDTH/2 - 165, WINDOW_HEIGHT/2 + 95);
+    winContinueText.setPosition(DESIGN_WIDTH/2 - 165, DESIGN_HEIGHT/2 + 95);
     
     winQuitText.setFont(font);
     winQuitText.setString(toUTF8String("退出(Esc)"));
     winQuitText.setCharacterSize(20);
     winQuitText.setFillColor(sf::Color::White);
-    winQuitText.setPosition(WINDOW_WIDTH/2 + 55, WINDOW_HEIGHT/2 + 95);
+    winQuitText.setPosition(DESIGN_WIDTH/2 + 55, DESIGN_HEIGHT/2 + 95);
 }
 
 void Game::initializeUI() {
@@ -378,14 +587,32 @@ void Game::initializeUI() {
     gameOverText.setString(toUTF8String("游戏结束!"));
     gameOverText.setCharacterSize(48);
     gameOverText.setFillColor(sf::Color::Red);
-    gameOverText.setPosition(WINDOW_WIDTH/2 - 120, WINDOW_HEIGHT/2 - 50);
+    gameOverText.setPosition(DESIGN_WIDTH/2 - 120, DESIGN_HEIGHT/2 - 50);
     
     // Restart prompt text
     restartText.setFont(font);
     restartText.setString(toUTF8String("按 R 键重新开始"));
     restartText.setCharacterSize(24);
     restartText.setFillColor(sf::Color::White);
-    restartText.setPosition(WINDOW_WIDTH/2 - 100, WINDOW_HEIGHT/2 + 20);
+    restartText.setPosition(DESIGN_WIDTH/2 - 100, DESIGN_HEIGHT/2 + 20);
+    
+    // Replay status text
+    replayText.setFont(font);
+    replayText.setCharacterSize(20);
+    replayText.setFillColor(sf::Color::White);
+    replayText.setPosition(20, 65);
+    
+    // Hint text
+    hintText.setFont(font);
+    hintText.setCharacterSize(24);
+    hintText.setFillColor(sf::Color::White);
+    hintText.setPosition(20, 65);
+
+    // Win chance text
+    chanceText.setFont(font);
+    chanceText.setCharacterSize(24);
+    chanceText.setFillColor(sf::Color::White);
+    chanceText.setPosition(20, 95);
 }
 
 void Game::setupMainMenu() {
@@ -396,29 +623,56 @@ void Game::setupMainMenu() {
     titleText.setFillColor(sf::Color::White);
     titleText.setPosition(250, 100);
     
-    const std::array<std::string, 3> sizeLabels = {"4 x 4", "5 x 5", "6 x 6"};
-    const std::array<sf::Color, 3> buttonColors = {
+    // 最后一个按钮是超大棋盘，尺寸由 updateHugeSizeLabel 填写
+    const std::array<std::string, 4> sizeLabels = {"4 x 4", "5 x 5", "6 x 6", ""};
+    const std::array<sf::Color, 4> buttonColors = {
         sf::Color(143, 122, 102),
         sf::Color(143, 122, 102),
-        sf::Color(143, 122, 102)
+        sf::Color(143, 122, 102),
+        sf::Color(119, 110, 101)
     };
+    const std::array<unsigned, 4> labelSizes = {32, 32, 32, 26};
     
     for (size_t i = 0; i < sizeButtons.size(); ++i) {
         // Grid size selection buttons
-        sizeButtons[i].setSize(sf::Vector2f(200, 80));
-        sizeButtons[i].setPosition(300, 250 + i * 120);
+        sizeButtons[i].setSize(sf::Vector2f(240, 80));
+        sizeButtons[i].setPosition(280, 210 + i * 100);
         sizeButtons[i].setFillColor(buttonColors[i]);
         
         // Button text
         sizeButtonTexts[i].setFont(font);
         sizeButtonTexts[i].setString(sizeLabels[i]);
-        sizeButtonTexts[i].setCharacterSize(32);
+        sizeButtonTexts[i].setCharacterSize(labelSizes[i]);
         sizeButtonTexts[i].setFillColor(sf::Color::White);
         sf::FloatRect textRect = sizeButtonTexts[i].getLocalBounds();
         sizeButtonTexts[i].setOrigin(textRect.left + textRect.width/2.0f,
                                     textRect.top + textRect.height/2.0f);
-        sizeButtonTexts[i].setPosition(300 + 100, 250 + i * 120 + 40);
-    }
+        sizeButtonTexts[i].setPosition(280 + 120, 210 + i * 100 + 40);
+    }
+    updateHugeSizeLabel();
+    
+    // 继续上次游戏（有存档时才显示）
+    resumeButton.setSize(sf::Vector2f(200, 60));
+    resumeButton.setPosition(300, 620);
+    resumeButton.setFillColor(sf::Color(50, 180, 50));
+    
+    resumeButtonText.setFont(font);
+    resumeButtonText.setString(toUTF8String("继续上次游戏"));
+    resumeButtonText.setCharacterSize(24);
+    resumeButtonText.setFillColor(sf::Color::White);
+    sf::FloatRect resumeTextRect = resumeButtonText.getLocalBounds();
+    resumeButtonText.setOrigin(resumeTextRect.left + resumeTextRect.width/2.0f,
+                               resumeTextRect.top + resumeTextRect.height/2.0f);
+    resumeButtonText.setPosition(300 + 100, 620 + 30);
+}
+
+void Game::updateHugeSizeLabel() {
+    std::lock_guard<std::mutex> lock(sceneMutex);
+    const int size = HUGE_GRID_SIZES[hugeSizeIndex];
+    sf::Text& label = sizeButtonTexts.back();
+    label.setString(toUTF8String("超大 " + std::to_string(size) + " x " + std::to_string(size) + "  ←/→"));
+    sf::FloatRect textRect = label.getLocalBounds();
+    label.setOrigin(textRect.left + textRect.width/2.0f, textRect.top + textRect.height/2.0f);
 }
 
 void Game::setupVersionMenu() {
@@ -450,55 +704,102 @@ void Game::setupVersionMenu() {
                                        textRect.top + textRect.height/2.0f);
         versionButtonTexts[i].setPosition(200 + 200, 250 + i * 120 + 40);
     }
+    
+    evilModeText.setFont(font);
+    evilModeText.setCharacterSize(24);
+    evilModeText.setFillColor(sf::Color::White);
+    evilModeText.setPosition(400, 540);
+    updateEvilModeLabel();
+}
+
+void Game::updateEvilModeLabel() {
+    std::lock_guard<std::mutex> lock(sceneMutex);
+    evilModeText.setString(toUTF8String(evilSpawns ? "恶意生成: 开  (V 切换)" : "恶意生成: 关  (V 切换)"));
+    sf::FloatRect textRect = evilModeText.getLocalBounds();
+    evilModeText.setOrigin(textRect.left + textRect.width/2.0f, textRect.top + textRect.height/2.0f);
+}
+
+void Game::handleVersionMenuKey(sf::Keyboard::Key key) {
+    if (key == sf::Keyboard::V) {
+        evilSpawns = !evilSpawns;
+        updateEvilModeLabel();
+    }
 }
 
 void Game::processEvents() {
     sf::Event event;
     while (window.pollEvent(event)) {
+        // 有事件的这一轮立即发布，按键到画面之间不多等一个显示帧
+        frameDirty = true;
+        // 排在队列里的按键先于后面的其他事件生效，与逐个处理时的顺序相同
+        if (event.type != sf::Event::KeyPressed) {
+            processInputQueue();
+        }
+
         // Window close event
         if (event.type == sf::Event::Closed) {
             currentState = GameState::EXIT_CONFIRM;
         }
 
+        // 窗口尺寸变化：布局和渲染缓存在这里统一重建一次
+        if (event.type == sf::Event::Resized) {
+            onResize(event.size.width, event.size.height);
+        }
+
+        // 这一帧的输入时间：事件在帧开始时才取出，实际按下的时刻可能还要早不到一帧
+        if ((event.type == sf::Event::KeyPressed || event.type == sf::Event::MouseButtonPressed) &&
+            frameInputTime == SoundEffects::Clock::time_point()) {
+            frameInputTime = SoundEffects::Clock::now();
+        }
+
         // Keyboard input
         if (event.type == sf::Event::KeyPressed) {
-            if (event.key.code == sf::Keyboard::Escape) {
-                currentState = GameState::EXIT_CONFIRM;
-            }
+            queueKey(event.key.code, SoundEffects::Clock::now());
+        }
+        if (event.type == sf::Event::KeyReleased && event.key.code >= 0 && event.key.code < sf::Keyboard::KeyCount) {
+            keysDown[event.key.code] = false;
+        }
+        // 失去焦点时收不到松开的事件
+        if (event.type == sf::Event::LostFocus) {
+            keysDown.fill(false);
+        }
 
-            // Exit confirmation handling
-            if (currentState == GameState::EXIT_CONFIRM) {
-                if (event.key.code == sf::Keyboard::Y) {
-                    window.close();
-                } else if (event.key.code == sf::Keyboard::N) {
-                    if (grid.empty()) {
-                        currentState = GameState::MAIN_MENU;
-                    } else {
-                        currentState = GameState::GAME;
-                    }
-                }
-            }
+        // 超大棋盘：滚轮以鼠标所指的位置为中心缩放
+        if (event.type == sf::Event::MouseWheelScrolled && currentState == GameState::GAME && layout.isHugeBoard()) {
+            const sf::Vector2f anchor = window.mapPixelToCoords(
+                sf::Vector2i(event.mouseWheelScroll.x, event.mouseWheelScroll.y), boardView);
+            camera.zoomAt(std::pow(CAMERA_ZOOM_STEP, event.mouseWheelScroll.delta), anchor);
+            updateBoardView();
+        }
 
-            // Direction keys and R key logic: only in game state
-            if (currentState == GameState::GAME) {
-                if (event.key.code == sf::Keyboard::R) {
-                    resetGame();
-                } else {
-                    // 总是调用handleGameInput，让它内部处理各种对话框状态
-                    handleGameInput(event.key.code);
-                }
-            }
+        // 超大棋盘：按住右键或中键拖动平移
+        if (event.type == sf::Event::MouseMoved && panning) {
+            const sf::Vector2i current(event.mouseMove.x, event.mouseMove.y);
+            camera.pan(window.mapPixelToCoords(panLast, boardView) - window.mapPixelToCoords(current, boardView));
+            panLast = current;
+            updateBoardView();
+        }
+        if (event.type == sf::Event::MouseButtonReleased && event.mouseButton.button != sf::Mouse::Left) {
+            panning = false;
         }
 
         // Mouse click events
         if (event.type == sf::Event::MouseButtonPressed) {
-            sf::Vector2f mousePos(event.mouseButton.x, event.mouseButton.y);
+            if (event.mouseButton.button != sf::Mouse::Left && currentState == GameState::GAME && layout.isHugeBoard()) {
+                panning = true;
+                panLast = sf::Vector2i(event.mouseButton.x, event.mouseButton.y);
+                continue;
+            }
+
+            // 窗口像素换算成设计坐标，按钮的判定区域不随窗口大小变化
+            sf::Vector2f mousePos = window.mapPixelToCoords(
+                sf::Vector2i(event.mouseButton.x, event.mouseButton.y), layout.view());
 
             if (currentState == GameState::EXIT_CONFIRM) {
                 if (exitConfirmYesButton.getGlobalBounds().contains(mousePos)) {
-                    window.close();
+                    quitRequested = true;
                 } else if (exitConfirmNoButton.getGlobalBounds().contains(mousePos)) {
-                    if (grid.empty()) {
+                    if (board.size() == 0) {
                         currentState = GameState::MAIN_MENU;
                     } else {
                         currentState = GameState::GAME;
@@ -533,8 +834,7 @@ void Game::processEvents() {
 
             // 暂停按钮点击处理
             if (currentState == GameState::GAME && !gameOver && !isPaused && !winAchievementDialogShown && !winDialogShown) {
-                sf::FloatRect pauseButtonBounds(WINDOW_WIDTH - 100, 20, 80, 40);
-                if (pauseButtonBounds.contains(mousePos)) {
+                if (pauseButton.getGlobalBounds().contains(mousePos)) {
                     isPaused = true;
                     continue;
                 }
@@ -548,18 +848,144 @@ void Game::processEvents() {
             }
         }
     }
+    processInputQueue();
+}
+
+void Game::queueKey(sf::Keyboard::Key key, SoundEffects::Clock::time_point time) {
+    ++inputStats.keys;
+    const bool known = key >= 0 && key < sf::Keyboard::KeyCount;
+    const bool repeat = known && keysDown[key];
+    if (known) {
+        keysDown[key] = true;
+    }
+    // 自动重复只是“还按着”，堆在一起的几个（例如主线程被窗口缩放卡住之后）只算一次；真正的按下从不丢弃
+    if (repeat) {
+        for (const QueuedKey& queued : inputQueue) {
+            if (queued.repeat && queued.key == key) {
+                ++inputStats.coalescedRepeats;
+                return;
+            }
+        }
+    }
+    inputQueue.push_back({key, repeat, time});
+}
+
+void Game::processInputQueue() {
+    for (const QueuedKey& queued : inputQueue) {
+        handleKeyPressed(queued.key);
+        // 从取出按键到处理完（棋盘已经更新）的时间，同一批里排在后面的按键也算上前面按键的处理时间
+        const int64_t micros = std::chrono::duration_cast<std::chrono::microseconds>(
+            SoundEffects::Clock::now() - queued.time).count();
+        ++inputStats.latencySamples;
+        inputStats.latencyTotalMicros += micros;
+        inputStats.latencyMaxMicros = std::max(inputStats.latencyMaxMicros, micros);
+    }
+    inputQueue.clear();
+}
+
+void Game::handleKeyPressed(sf::Keyboard::Key key) {
+    if (key == sf::Keyboard::Escape) {
+        currentState = GameState::EXIT_CONFIRM;
+    }
+
+    // Exit confirmation handling
+    if (currentState == GameState::EXIT_CONFIRM) {
+        if (key == sf::Keyboard::Y) {
+            quitRequested = true;
+        } else if (key == sf::Keyboard::N) {
+            if (board.size() == 0) {
+                currentState = GameState::MAIN_MENU;
+            } else {
+                currentState = GameState::GAME;
+            }
+        }
+    }
+
+    if (currentState == GameState::MAIN_MENU) {
+        handleMainMenuKey(key);
+    } else if (currentState == GameState::VERSION_MENU) {
+        handleVersionMenuKey(key);
+    }
+
+    // Direction keys and R key logic: only in game state
+    if (currentState == GameState::GAME) {
+        if (handleCameraKey(key)) {
+            // 摄像机按键不影响棋局
+        } else if (replayMode) {
+            handleReplayInput(key);
+        } else if (key == sf::Keyboard::R) {
+            resetGame();
+        } else {
+            // 总是调用handleGameInput，让它内部处理各种对话框状态
+            handleGameInput(key);
+        }
+    }
+}
+
+void Game::printInputStats() const {
+    std::cout << "按键: " << inputStats.keys << " 次，合并自动重复 " << inputStats.coalescedRepeats
+              << " 次，走不动的方向 " << inputStats.noOpMoves << " 次" << std::endl;
+    if (inputStats.latencySamples > 0) {
+        std::cout << "按键到棋盘更新延迟: 平均 "
+                  << inputStats.latencyTotalMicros / 1000.0 / inputStats.latencySamples << " 毫秒，最长 "
+                  << inputStats.latencyMaxMicros / 1000.0 << " 毫秒（" << inputStats.latencySamples << " 次）"
+                  << std::endl;
+    }
 }
 
 void Game::handleMainMenuClick(const sf::Vector2f& pos) {
+    if (hasSavedGame && resumeButton.getGlobalBounds().contains(pos)) {
+        resumeSavedGame();
+        return;
+    }
+    
     for (size_t i = 0; i < sizeButtons.size(); ++i) {
         if (sizeButtons[i].getGlobalBounds().contains(pos)) {
-            gridSize = 4 + i;
+            gridSize = i + 1 < sizeButtons.size() ? 4 + static_cast<int>(i) : HUGE_GRID_SIZES[hugeSizeIndex];
+            // 读档可能改变了恶意生成的开关
+            updateEvilModeLabel();
             currentState = GameState::VERSION_MENU;
             return;
         }
     }
 }
 
+void Game::handleMainMenuKey(sf::Keyboard::Key key) {
+    // ←/→ 切换超大棋盘的尺寸
+    if (key == sf::Keyboard::Left && hugeSizeIndex > 0) {
+        --hugeSizeIndex;
+        updateHugeSizeLabel();
+    } else if (key == sf::Keyboard::Right && hugeSizeIndex + 1 < HUGE_GRID_SIZES.size()) {
+        ++hugeSizeIndex;
+        updateHugeSizeLabel();
+    }
+}
+
+bool Game::handleCameraKey(sf::Keyboard::Key key) {
+    if (!layout.isHugeBoard()) return false;
+    
+    // +/- 以视野中心缩放，Home 回到全貌
+    const sf::FloatRect visibleWorld = camera.visibleWorld();
+    const sf::Vector2f center(visibleWorld.left + visibleWorld.width / 2.0f, visibleWorld.top + visibleWorld.height / 2.0f);
+    switch (key) {
+        case sf::Keyboard::Add:
+        case sf::Keyboard::Equal:
+            camera.zoomAt(CAMERA_ZOOM_STEP, center);
+            break;
+        case sf::Keyboard::Subtract:
+        case sf::Keyboard::Hyphen:
+            camera.zoomAt(1.0f / CAMERA_ZOOM_STEP, center);
+            break;
+        case sf::Keyboard::Home:
+            camera.reset(layout.boardWorld(), layout.boardWorld().width / layout.boardArea().width);
+            break;
+        default:
+            return false;
+    }
+    updateBoardView();
+    return true;
+}
+
 void Game::handleVersionMenuClick(const sf::Vector2f& pos) {
     for (size_t i = 0; i < versionButtons.size(); ++i) {
         if (versionButtons[i].getGlobalBounds().contains(pos)) {
@@ -596,56 +1022,159 @@ void Game::handleGameInput(sf::Keyboard::Key key) {
         return;
     }
     
+    if (key == sf::Keyboard::H) {
+        toggleHint();
+        return;
+    }
+
+    if (key == sf::Keyboard::A) {
+        toggleMonteCarlo();
+        return;
+    }
+
+    if (key == sf::Keyboard::W) {
+        toggleChance();
+        return;
+    }
+    
+    if (key == sf::Keyboard::B) {
+        toggleMusic();
+        return;
+    }
+    
+    if (key == sf::Keyboard::N) {
+        music.nextTrack();
+        return;
+    }
+    
+    if (key == sf::Keyboard::S) {
+        sfx.setMuted(!sfx.isMuted());
+        return;
+    }
+    
     // 检查暂停键
     if (key == sf::Keyboard::P) {
         isPaused = true;
         return;
     }
     
-    bool moved = false;
+    if (key == sf::Keyboard::U) {
+        undoMove();
+        return;
+    }
+    
+    if (key == sf::Keyboard::I) {
+        redoMove();
+        return;
+    }
+    
+    bool hasDirection = true;
+    Direction dir = Direction::UP;
     
     if (currentVersion == GameVersion::ORIGINAL) {
         // Original version: only arrow keys
         switch (key) {
             case sf::Keyboard::Up:
-                moved = moveTiles(0, -1);
+                dir = Direction::UP;
                 break;
             case sf::Keyboard::Down:
-                moved = moveTiles(0, 1);
+                dir = Direction::DOWN;
                 break;
             case sf::Keyboard::Left:
-                moved = moveTiles(-1, 0);
+                dir = Direction::LEFT;
                 break;
             case sf::Keyboard::Right:
-                moved = moveTiles(1, 0);
+                dir = Direction::RIGHT;
                 break;
             default:
+                hasDirection = false;
                 break;
         }
     } else if (currentVersion == GameVersion::MODIFIED) {
         // Diagonal version: only diagonal moves
         switch (key) {
             case sf::Keyboard::Q: // Top-left
-                moved = moveTiles(-1, -1);
+                dir = Direction::UP_LEFT;
                 break;
             case sf::Keyboard::E: // Top-right
-                moved = moveTiles(1, -1);
+                dir = Direction::UP_RIGHT;
                 break;
             case sf::Keyboard::Z: // Bottom-left
-                moved = moveTiles(-1, 1);
+                dir = Direction::DOWN_LEFT;
                 break;
             case sf::Keyboard::C: // Bottom-right
-                moved = moveTiles(1, 1);
+                dir = Direction::DOWN_RIGHT;
                 break;
             default:
+                hasDirection = false;
                 break;
         }
     }
     
-    if (moved) {
-        addRandomTile();
-        gameOver = isGameOver();
+    // 走不动的方向什么都不做：不进撤销历史，也不打断正在播放的动画
+    if (hasDirection && !playMove(dir)) {
+        ++inputStats.noOpMoves;
+    }
+}
+
+bool Game::playMove(Direction dir, const RedoStep* redo) {
+    // 移动前的状态进入撤销历史；随机数状态和新方块一起保存，重做时会生成同一个方块
+    UndoEntry before;
+    before.board = board;
+    before.rngState = rng.getState();
+    before.flags = packSaveFlags();
+    before.direction = dir;
+    int scoreBefore = score;
+    
+    if (!moveTiles(dir)) {
+        return false;
+    }
+    
+    int spawnCell = evilSpawns ? addEvilTile(redo) : addRandomTile();
+    ++moveCount;
+    gameOver = isGameOver();
+    if (gameOver) {
+        submitScore();
+    }
+    
+    before.scoreGained = score - scoreBefore;
+    before.spawnCell = spawnCell;
+    before.spawnExponent = spawnCell >= 0 ? board.exponent(spawnCell) : 0;
+    undoHistory.push(before);
+    recordMove(dir, spawnCell);
+    return true;
+}
+
+bool Game::undoMove() {
+    UndoEntry entry;
+    if (!undoHistory.undo(entry)) {
+        return false;
+    }
+    
+    board = entry.board;
+    rng.setState(entry.rngState);
+    score -= entry.scoreGained;
+    applySaveFlags(entry.flags);
+    if (moveCount > 0) --moveCount;
+    tweens.clear();
+    
+    // 回放里记一条撤销指令；存档日志直接写快照，恢复时不需要撤销历史
+    ReplayMove move;
+    move.op = ReplayOp::UNDO;
+    replayWriter.appendMove(move);
+    journaledFlags = packSaveFlags();
+    saveJournal.appendSnapshot(captureSaveState());
+    return true;
+}
+
+bool Game::redoMove() {
+    if (!undoHistory.canRedo()) {
+        return false;
     }
+    // 从撤销恢复的状态重新走同一方向，随机生成靠恢复的随机数状态、恶意生成靠记下的方块还原同一步；
+    // push 时会弹出重做栈顶。先复制一份，栈顶在 push 里会被弹掉
+    const RedoStep step = undoHistory.nextRedo();
+    return playMove(step.direction, &step);
 }
 
 void Game::handleWinDialogClick(const sf::Vector2f& mousePos) {
@@ -695,15 +1224,15 @@ bool Game::loadGif(const std::string& filename, sf::Texture& texture) {
     return false;
 }
 
-void Game::animateGifOnCover(sf::RenderWindow& window, sf::Texture& gifTexture) {
+void Game::animateGifOnCover(sf::RenderWindow& window, sf::Texture& gifTexture, const FrameSnapshot& frame) {
     // 第一个GIF (稍微加大一点)
     sf::Sprite gifSprite(gifTexture);
     float gifScale = 1.5f; // 增大GIF尺寸
     gifSprite.setScale(gifScale, gifScale);
     
     // 进一步调整Y位置，避免与左下角和右下角的装饰GIF冲突
-    // 装饰GIF位置是WINDOW_HEIGHT - 200，为了避免冲突，移动GIF需要更靠上
-    float gifYPosition = WINDOW_HEIGHT - (gifTexture.getSize().y * gifScale) - 100; // 从-120改为-250，再往上移动130像素
+    // 装饰GIF位置是DESIGN_HEIGHT - 200，为了避免冲突，移动GIF需要更靠上
+    float gifYPosition = DESIGN_HEIGHT - (gifTexture.getSize().y * gifScale) - 100; // 从-120改为-250，再往上移动130像素
     
     gifSprite.setPosition(gifXPosition, gifYPosition);
     window.draw(gifSprite);
@@ -719,21 +1248,22 @@ void Game::animateGifOnCover(sf::RenderWindow& window, sf::Texture& gifTexture)
     window.draw(secondGifSprite);
 
     // 仅当在主菜单时才更新位置
-    if (currentState == GameState::MAIN_MENU) {
+    if (frame.state == GameState::MAIN_MENU) {
         float deltaTime = gifMoveClock.restart().asSeconds();
         
         // 两个GIF以相同速度移动
         gifXPosition -= GIF_MOVE_SPEED * deltaTime;
         secondGifXPosition -= GIF_MOVE_SPEED * deltaTime;
         
-        // 当第一个GIF移出左边界时重置位置
-        if (gifXPosition < -static_cast<float>(gifTexture.getSize().x * gifScale)) {
-            gifXPosition = WINDOW_WIDTH;
+        // 当第一个GIF移出左边界时重置位置（宽屏窗口的可见区域比设计区域宽）
+        const sf::FloatRect& area = frame.layout.visibleArea();
+        if (gifXPosition < area.left - gifTexture.getSize().x * gifScale) {
+            gifXPosition = area.left + area.width;
         }
         
         // 当第二个GIF移出左边界时重置位置
-        if (secondGifXPosition < -static_cast<float>(secondGifTexture.getSize().x * gifScale)) {
-            secondGifXPosition = WINDOW_WIDTH + 150; // 保持150像素的间距
+        if (secondGifXPosition < area.left - secondGifTexture.getSize().x * gifScale) {
+            secondGifXPosition = area.left + area.width + 150; // 保持150像素的间距
         }
     }
 }
@@ -741,7 +1271,7 @@ void Game::animateGifOnCover(sf::RenderWindow& window, sf::Texture& gifTexture)
 void Game::drawGifsOnGrid(sf::RenderWindow& window) {
     for (int y = 0; y < gridSize; ++y) {
         for (int x = 0; x < gridSize; ++x) {
-            int tileValue = grid[y][x];
+            int tileValue = board.value(x, y);
             if (tileValue > 0) {
                 // 使用映射表获取纹理
                 auto it = tileGifTexturesMap.find(tileValue);
@@ -753,12 +1283,12 @@ void Game::drawGifsOnGrid(sf::RenderWindow& window) {
                     }
                 }
                 
-                sf::Sprite tileSprite(it->second);
+                sf::Sprite tileSprite(*it->second);
                 sf::Vector2f tilePos = getTilePosition(x, y);
                 
                 // 缩放GIF以适合方块
-                float scaleX = static_cast<float>(TILE_SIZE + TILE_MARGIN) / it->second.getSize().x;
-                float scaleY = static_cast<float>(TILE_SIZE + TILE_MARGIN) / it->second.getSize().y;
+                float scaleX = static_cast<float>(layout.tileSize() + layout.tileMargin()) / it->second->getSize().x;
+                float scaleY = static_cast<float>(layout.tileSize() + layout.tileMargin()) / it->second->getSize().y;
                 tileSprite.setScale(scaleX, scaleY);
                 
                 tileSprite.setPosition(tilePos);
@@ -769,51 +1299,108 @@ void Game::drawGifsOnGrid(sf::RenderWindow& window) {
 }
 
 void Game::update(sf::Time deltaTime) {
-    // 更新动画
-    for (auto it = newTileAnimations.begin(); it != newTileAnimations.end();) {
-        it->progress += (1.0f / (60.0f * spawnAnimationDuration));
-        if (it->progress >= 1.0f) {
-            it = newTileAnimations.erase(it);
-        } else {
-            ++it;
+    if (replayMode && currentState == GameState::GAME) {
+        updateReplay(deltaTime.asSeconds());
+    }
+    
+    // 对话框的打开/关闭不经过移动，单独记一条标志记录
+    if (saveJournal.isOpen() && !replayMode) {
+        uint8_t flags = packSaveFlags();
+        if (flags != journaledFlags) {
+            saveJournal.appendFlags(flags);
+            journaledFlags = flags;
+        }
+    }
+
+    if (botMode) {
+        updateBot();
+    }
+
+    // 局面变化时交给后台搜索，每帧从置换表里取最新的结果
+    if (hintEnabled && hintAvailable()) {
+        updateHint();
+    }
+    if (monteCarloEnabled && monteCarloAvailable()) {
+        updateMonteCarlo();
+    }
+
+    // 胜率没算完时每帧接着算一点
+    if (chanceEnabled && chanceAvailable()) {
+        updateChance();
+    }
+
+    // 按真实经过的时间推进所有补间，与帧率无关
+    tweens.update(deltaTime.asSeconds());
+
+    // 对话框刚出现时让背景遮罩淡入
+    const uint8_t dialogs = packSaveFlags() & (SAVE_FLAG_GAME_OVER | SAVE_FLAG_WIN_DIALOG |
+                                               SAVE_FLAG_ACHIEVEMENT_DIALOG | SAVE_FLAG_PAUSED);
+    const uint8_t opened = dialogs & ~fadedDialogs;
+    if (opened) {
+        sfx.trigger(SoundEffect::DIALOG, 0, frameInputTime);
+    }
+    for (uint8_t flag = 1; flag != 0 && flag <= opened; flag <<= 1) {
+        if (opened & flag) {
+            Tween fade;
+            fade.kind = TWEEN_DIALOG;
+            fade.target = flag;
+            fade.fromAlpha = 0.0f;
+            fade.toAlpha = 1.0f;
+            fade.duration = dialogFadeDuration;
+            fade.easing = Easing::OUT_QUAD;
+            tweens.add(fade);
+        }
+    }
+    fadedDialogs = dialogs;
+    // GIF动画和方块纹理的重建都由渲染线程处理（updateGifs）
+}
+
+void Game::updateGifs(const FrameSnapshot& frame, float deltaTime) {
+    // 窗口尺寸停止变化一段时间后，再按新的像素尺寸重新生成方块GIF的各级纹理
+    if (levelRebuildDelay > 0.0f) {
+        levelRebuildDelay -= deltaTime;
+        if (levelRebuildDelay <= 0.0f && frame.layout.scale() != tileLevelScale) {
+            rebuildTileLevels(frame.layout);
         }
     }
 
-    // 更新所有GIF动画
+    // 更新所有GIF动画：同一时刻查一次时间线，各GIF按自己的帧延迟前缀和二分出当前帧
+    const uint32_t nowMs = static_cast<uint32_t>(animationClock.getElapsedTime().asMilliseconds());
+    // 按棋盘视图下的实际像素大小取最接近的一级，超大棋盘缩放时也是如此
+    const unsigned tilePixelSize = static_cast<unsigned>(
+        std::max(1.0f, std::round(frame.layout.innerTileSize() * frame.boardPixelScale)));
     for (auto& [value, wrapper] : gifWrappers) {
-        wrapper.updateFrame();
-        // 总是更新纹理，不管是否是动画
-        tileGifTexturesMap[value] = wrapper.getCurrentFrame();
+        wrapper.updateFrame(nowMs);
+        tileGifTexturesMap[value] = &wrapper.getCurrentFrame(tilePixelSize);
     }
     
     // 更新装饰GIF动画
     for (size_t i = 0; i < decorativeGifWrappers.size(); ++i) {
-        decorativeGifWrappers[i].updateFrame();
-        decorativeTextures[i] = decorativeGifWrappers[i].getCurrentFrame();
-        decorativeSprites[i].setTexture(decorativeTextures[i]);
-    }
-
-    // 更新主菜单GIF动画 (这里也会被animateGifOnCover函数处理，但保留备用)
-    if (currentState == GameState::MAIN_MENU) {
-        // GIF动画位置更新在animateGifOnCover函数中处理
-        // 这里可以添加其他主菜单相关的更新逻辑
+        decorativeGifWrappers[i].updateFrame(nowMs);
+        decorativeSprites[i].setTexture(decorativeGifWrappers[i].getCurrentFrame());
     }
 }
 
-void Game::render() {
+void Game::render(const FrameSnapshot& frame, float deltaTime) {
+    // 绘制期间拿着 sceneMutex，逻辑线程改文字和网格时会等这一帧的绘制命令提交完；
+    // 等待显卡（display）时已经放开，不会挡住逻辑线程
+    std::unique_lock<std::mutex> lock(sceneMutex);
+    updateGifs(frame, deltaTime);
+    window.setView(frame.layout.view());
     window.clear();
 
-    if (currentState == GameState::MAIN_MENU) {
-        renderMainMenu();
-        animateGifOnCover(window, gifTexture);
-    } else if (currentState == GameState::VERSION_MENU) {
+    if (frame.state == GameState::MAIN_MENU) {
+        renderMainMenu(frame);
+        animateGifOnCover(window, gifTexture, frame);
+    } else if (frame.state == GameState::VERSION_MENU) {
         renderVersionMenu();
-    } else if (currentState == GameState::GAME) {
-        renderGame(); // 这里会绘制网格和数字
+    } else if (frame.state == GameState::GAME) {
+        renderGame(frame); // 这里会绘制网格和数字
         // 不再调用drawGifsOnGrid，因为我们在renderGame中已经处理了渲染
         
         // 如果胜利且显示对话框，绘制胜利界面
-        if (gameWon && winDialogShown) {
+        if (frame.gameWon && frame.winDialogShown) {
+            winBackground.setFillColor(sf::Color(0, 0, 0, static_cast<sf::Uint8>(150 * frame.winFade)));
             window.draw(winBackground);
             window.draw(winBox);
             window.draw(winSprite);
@@ -825,83 +1412,54 @@ void Game::render() {
         }
         
         // 如果达成胜利且显示对话框，绘制胜利达成界面
-        if (achievedWin && winAchievementDialogShown) {
+        if (frame.achievedWin && frame.winAchievementDialogShown) {
+            winAchievementBackground.setFillColor(sf::Color(0, 0, 0, static_cast<sf::Uint8>(150 * frame.achievementFade)));
             window.draw(winAchievementBackground);
             window.draw(winAchievementBox);
             window.draw(winAchievementSprite);
             window.draw(winAchievementText);
             
             // 绘制圆角按钮
-            drawRoundedRectangle(window, 
-                sf::Vector2f(WINDOW_WIDTH/2 - 180, WINDOW_HEIGHT/2 + 80), 
-                sf::Vector2f(150, 60), 
-                sf::Color(220, 50, 50), // 红色继续游戏按钮
-                12.0f);
-            
-            drawRoundedRectangle(window, 
-                sf::Vector2f(WINDOW_WIDTH/2 + 30, WINDOW_HEIGHT/2 + 80), 
-                sf::Vector2f(150, 60), 
-                sf::Color(50, 180, 50), // 绿色返回主菜单按钮
-                12.0f);
+            window.draw(winAchievementButtonMesh);
             
             window.draw(winAchievementContinueText);
             window.draw(winAchievementMenuText);
         }
         
         // 如果游戏结束且显示对话框，绘制游戏结束界面
-        if (gameOver && !gameWon) {
+        if (frame.gameOver && !frame.gameWon) {
+            gameOverBackground.setFillColor(sf::Color(0, 0, 0, static_cast<sf::Uint8>(150 * frame.gameOverFade)));
             window.draw(gameOverBackground);
             window.draw(gameOverBox);
             window.draw(gameOverSprite);
             window.draw(gameOverDialogText);
             
             // 绘制圆角按钮
-            drawRoundedRectangle(window, 
-                sf::Vector2f(WINDOW_WIDTH/2 - 180, WINDOW_HEIGHT/2 + 80), 
-                sf::Vector2f(150, 60), 
-                sf::Color(220, 50, 50), // 红色重新开始按钮
-                12.0f);
-            
-            drawRoundedRectangle(window, 
-                sf::Vector2f(WINDOW_WIDTH/2 + 30, WINDOW_HEIGHT/2 + 80), 
-                sf::Vector2f(150, 60), 
-                sf::Color(50, 180, 50), // 绿色返回主菜单按钮
-                12.0f);
+            window.draw(gameOverButtonMesh);
             
             window.draw(gameOverRestartText);
             window.draw(gameOverMenuText);
         }
         
         // 如果游戏暂停，绘制暂停界面
-        if (isPaused) {
+        if (frame.isPaused) {
+            pauseBackground.setFillColor(sf::Color(0, 0, 0, static_cast<sf::Uint8>(150 * frame.pauseFade)));
             window.draw(pauseBackground);
             window.draw(pauseBox);
             window.draw(pauseText);
             
             // 绘制圆角按钮
-            drawRoundedRectangle(window, 
-                sf::Vector2f(WINDOW_WIDTH/2 - 100, WINDOW_HEIGHT/2 - 40), 
-                sf::Vector2f(200, 60), 
-                sf::Color(50, 180, 50), // 绿色继续游戏按钮
-                12.0f);
-            
-            drawRoundedRectangle(window, 
-                sf::Vector2f(WINDOW_WIDTH/2 - 100, WINDOW_HEIGHT/2 + 60), 
-                sf::Vector2f(200, 60), 
-                sf::Color(220, 50, 50), // 红色返回主菜单按钮
-                12.0f);
+            window.draw(pauseDialogButtonMesh);
             
             window.draw(pauseContinueText);
             window.draw(pauseMenuText);
         }
-    } else if (currentState == GameState::EXIT_CONFIRM) {
+    } else if (frame.state == GameState::EXIT_CONFIRM) {
         // 根据当前状态绘制背景
-        if (!grid.empty()) {
-            renderGame();
-        } else if (currentState == GameState::VERSION_MENU) {
-            renderVersionMenu();
+        if (frame.board.size() != 0) {
+            renderGame(frame);
         } else {
-            renderMainMenu();
+            renderMainMenu(frame);
         }
         // 绘制确认对话框
         window.draw(exitConfirmBackground);
@@ -909,106 +1467,191 @@ void Game::render() {
         window.draw(exitConfirmText);
         
         // 绘制圆角按钮
-        drawRoundedRectangle(window, 
-            sf::Vector2f(WINDOW_WIDTH/2 - 140, WINDOW_HEIGHT/2 + 20), 
-            sf::Vector2f(120, 50), 
-            sf::Color(100, 255, 100), // 绿色是按钮
-            12.0f);
-        
-        drawRoundedRectangle(window, 
-            sf::Vector2f(WINDOW_WIDTH/2 + 20, WINDOW_HEIGHT/2 + 20), 
-            sf::Vector2f(120, 50), 
-            sf::Color(255, 100, 100), // 红色否按钮
-            12.0f);
+        window.draw(exitConfirmButtonMesh);
         
         window.draw(exitConfirmYesText);
         window.draw(exitConfirmNoText);
     }
 
+    lock.unlock();
     window.display();
 }
 
-void Game::renderGame() {
-    window.clear(sf::Color(187, 173, 160));
+void Game::renderGame(const FrameSnapshot& frame) {
+    const Layout& frameLayout = frame.layout;
+    window.clear(BOARD_BACKGROUND_COLOR);
     
-    // 更新分数显示
-    std::stringstream ss;
-    ss << "分数: " << score;
-    scoreText.setString(toUTF8String(ss.str()));
+    // 分数和提示文字由逻辑线程写进快照，这里只在变化时重新排版
+    auto updateLabel = [](sf::Text& text, std::string& shown, const std::string& label) {
+        if (label != shown) {
+            shown = label;
+            text.setString(toUTF8String(label));
+        }
+    };
+    updateLabel(scoreText, shownScoreLabel, frame.scoreLabel);
     window.draw(scoreText);
     
-    // 绘制网格
-    drawGrid();
+    if (!frame.replayLabel.empty()) {
+        updateLabel(replayText, shownReplayLabel, frame.replayLabel);
+        window.draw(replayText);
+    } else if (!frame.hintLabel.empty()) {
+        updateLabel(hintText, shownHintLabel, frame.hintLabel);
+        window.draw(hintText);
+    }
+    if (!frame.chanceLabel.empty()) {
+        updateLabel(chanceText, shownChanceLabel, frame.chanceLabel);
+        window.draw(chanceText);
+    }
     
-    // 绘制数字和GIF
-    for (int y = 0; y < gridSize; ++y) {
-        for (int x = 0; x < gridSize; ++x) {
-            if (grid[y][x] != 0) {
-                sf::Vector2f pos = getTilePosition(x, y);
-                
-                // 计算内嵌方块的尺寸和位置（留出一些边距）
-                const int innerPadding = TILE_MARGIN / 2; // 内边距
-                const int innerTileSize = TILE_SIZE - innerPadding * 2;
-                sf::Vector2f innerPos(pos.x + innerPadding, pos.y + innerPadding);
-                
-                // 绘制方块背景（内嵌在格子中）
-                sf::RectangleShape tile(sf::Vector2f(innerTileSize, innerTileSize));
-                tile.setPosition(innerPos);
-                tile.setFillColor(getTileColor(grid[y][x]));
-                window.draw(tile);
-
-                // 尝试绘制GIF（内嵌在格子中）
-                auto it = tileGifTexturesMap.find(grid[y][x]);
-                if (it != tileGifTexturesMap.end()) {
-                    // 检查纹理尺寸
-                    sf::Vector2u texSize = it->second.getSize();
-                    if (texSize.x > 0 && texSize.y > 0) {
-                        sf::Sprite sprite(it->second);
-                        sprite.setPosition(innerPos);
-                        
-                        // 缩放GIF以适应内嵌方块大小
-                        float scaleX = static_cast<float>(innerTileSize) / texSize.x;
-                        float scaleY = static_cast<float>(innerTileSize) / texSize.y;
-                        sprite.setScale(scaleX, scaleY);
-                        
-                        window.draw(sprite);
-                    } else {
-                        std::cout << "Warning: Empty texture for value " << grid[y][x] << std::endl;
-                    }
+    // 棋盘内容通过摄像机视图绘制：普通棋盘的视图与界面视图完全重合，超大棋盘只画视野内的部分
+    if (chunkGeneration != frame.boardLayoutGeneration) {
+        rebuildBoardChunks(frame);
+    }
+    window.setView(frame.boardView);
+    const sf::FloatRect& visibleWorld = frame.visibleWorld;
+    for (const BoardChunk& chunk : boardChunks) {
+        if (chunk.bounds.intersects(visibleWorld)) {
+            window.draw(chunk.mesh);
+        }
+    }
+    
+    // 视野内的格子范围
+    const int boardSize = frame.gridSize;
+    const float step = static_cast<float>(frameLayout.tileSize() + frameLayout.tileMargin());
+    const int firstX = std::max(0, static_cast<int>(std::floor((visibleWorld.left - frameLayout.gridOffsetX()) / step)));
+    const int firstY = std::max(0, static_cast<int>(std::floor((visibleWorld.top - frameLayout.gridOffsetY()) / step)));
+    const int lastX = std::min(boardSize - 1, static_cast<int>((visibleWorld.left + visibleWorld.width - frameLayout.gridOffsetX()) / step));
+    const int lastY = std::min(boardSize - 1, static_cast<int>((visibleWorld.top + visibleWorld.height - frameLayout.gridOffsetY()) / step));
+    
+    // 方块在屏幕上太小时（超大棋盘缩小查看）只画纯色方块，合成一个网格一次提交；否则逐个画GIF和数字
+    const bool detailed = frameLayout.innerTileSize() * frame.boardPixelScale >= DETAIL_TILE_SIZE * frameLayout.scale();
+    tileBatch.clear();
+    tileBatch.setPrimitiveType(sf::Triangles);
+    
+    // 绘制数字和GIF（正在滑动的终点格由下面的滑动精灵代替）
+    for (int y = firstY; y <= lastY; ++y) {
+        for (int x = firstX; x <= lastX; ++x) {
+            const int cell = y * boardSize + x;
+            const int tileValue = frame.board.value(x, y);
+            if (tileValue != 0 && !frame.slidingCells.test(cell)) {
+                if (detailed) {
+                    drawTile(frame, frameLayout.tilePosition(x, y), tileValue, frame.cellScale[cell]);
                 } else {
-                    std::cout << "Warning: No texture found for value " << grid[y][x] << std::endl;
+                    appendTileQuad(frame, frameLayout.tilePosition(x, y), tileValue, frame.cellScale[cell]);
                 }
-                
-                // 绘制数字（始终在左上角）
-                sf::Text text;
-                text.setFont(font);
-                text.setString(std::to_string(grid[y][x]));
-                text.setCharacterSize(innerTileSize / 4); // 根据内嵌大小调整字体
-                text.setFillColor(grid[y][x] <= 4 ? sf::Color(119, 110, 101) : sf::Color::White);
-                text.setPosition(innerPos.x + 3, innerPos.y + 3);
-                window.draw(text);
             }
         }
     }
     
+    // 滑动中的方块
+    for (const SlideSprite& slide : frame.slides) {
+        const sf::Vector2f pos(slide.x, slide.y);
+        if (!visibleWorld.intersects(sf::FloatRect(pos.x, pos.y, step, step))) continue;
+        if (detailed) {
+            drawTile(frame, pos, slide.value);
+        } else {
+            appendTileQuad(frame, pos, slide.value);
+        }
+    }
+    if (tileBatch.getVertexCount() > 0) {
+        window.draw(tileBatch);
+    }
+    window.setView(frameLayout.view());
+    
     // 如果游戏结束，显示消息
-    if (gameOver) {
+    if (frame.gameOver) {
         window.draw(gameOverText);
         window.draw(restartText);
     }
     
     // 绘制右上角暂停按钮（只在游戏进行中且未暂停时显示，不受胜利对话框影响）
-    if (!gameOver && !isPaused && !winAchievementDialogShown && !winDialogShown) {
-        drawRoundedRectangle(window, 
-            sf::Vector2f(WINDOW_WIDTH - 100, 20), 
-            sf::Vector2f(80, 40), 
-            sf::Color(100, 100, 100, 200), // 半透明灰色
-            8.0f);
+    if (!frame.gameOver && !frame.isPaused && !frame.winAchievementDialogShown && !frame.winDialogShown) {
+        window.draw(pauseButtonMesh);
         window.draw(pauseButtonText);
     }
 }
 
-void Game::renderMainMenu() {
+Game::TileVisual& Game::tileVisual(const FrameSnapshot& frame, int tileValue) {
+    // 格子尺寸或像素缩放变了（窗口缩放、超大棋盘缩放查看）就全部重摆
+    const int tileSize = frame.layout.tileSize();
+    const int innerTileSize = static_cast<int>(frame.layout.innerTileSize());
+    if (tileSize != tileVisualTileSize || innerTileSize != tileVisualInnerSize ||
+        frame.boardPixelScale != tileVisualPixelScale) {
+        tileVisuals.clear();
+        tileVisualTileSize = tileSize;
+        tileVisualInnerSize = innerTileSize;
+        tileVisualPixelScale = frame.boardPixelScale;
+    }
+    
+    // 内嵌方块留出一些边距，居中在格子里
+    const float centerOffset = tileSize / 2.0f - innerTileSize / 2.0f;
+    auto found = tileVisuals.find(tileValue);
+    if (found == tileVisuals.end()) {
+        found = tileVisuals.emplace(tileValue, TileVisual()).first;
+        TileVisual& visual = found->second;
+        visual.background.setSize(sf::Vector2f(innerTileSize, innerTileSize));
+        visual.background.setPosition(centerOffset, centerOffset);
+        visual.background.setFillColor(getTileColor(tileValue));
+        visual.picture.setPosition(centerOffset, centerOffset);
+        
+        // 数字始终在左上角；按实际像素大小生成字形，再缩回世界坐标，高分辨率或放大查看时不会发虚
+        visual.number.setFont(font);
+        visual.number.setString(std::to_string(tileValue));
+        visual.number.setCharacterSize(static_cast<unsigned>(std::max(1.0f, std::round(innerTileSize / 4.0f * frame.boardPixelScale))));
+        visual.number.setScale(1.0f / frame.boardPixelScale, 1.0f / frame.boardPixelScale);
+        visual.number.setFillColor(tileTextColor(tileValue));
+        visual.number.setPosition(centerOffset + 3, centerOffset + 3);
+    }
+    
+    // GIF换帧或重新生成纹理之后精灵换成新纹理，缩放到内嵌方块大小
+    TileVisual& visual = found->second;
+    auto it = tileGifTexturesMap.find(tileValue);
+    const sf::Texture* texture = it != tileGifTexturesMap.end() ? it->second : nullptr;
+    const sf::Vector2u textureSize = texture ? texture->getSize() : sf::Vector2u();
+    if (texture != visual.texture || textureSize != visual.textureSize) {
+        visual.texture = texture;
+        visual.textureSize = textureSize;
+        if (!texture) {
+            std::cout << "Warning: No texture found for value " << tileValue << std::endl;
+        } else if (textureSize.x == 0 || textureSize.y == 0) {
+            std::cout << "Warning: Empty texture for value " << tileValue << std::endl;
+        } else {
+            visual.picture.setTexture(*texture, true);
+            visual.picture.setScale(static_cast<float>(innerTileSize) / textureSize.x,
+                                    static_cast<float>(innerTileSize) / textureSize.y);
+        }
+    }
+    return visual;
+}
+
+void Game::drawTile(const FrameSnapshot& frame, const sf::Vector2f& pos, int tileValue, float scale) {
+    if (scale <= 0.01f) return;
+    
+    // 缓存的图形都按不缩放的尺寸摆在格子里，这里只移到格子位置，弹出/合并时围绕格子中心缩放
+    const TileVisual& visual = tileVisual(frame, tileValue);
+    sf::RenderStates states;
+    states.transform.translate(pos);
+    if (scale != 1.0f) {
+        const float center = frame.layout.tileSize() / 2.0f;
+        states.transform.scale(scale, scale, center, center);
+    }
+    window.draw(visual.background, states);
+    if (visual.textureSize.x > 0 && visual.textureSize.y > 0) {
+        window.draw(visual.picture, states);
+    }
+    window.draw(visual.number, states);
+}
+
+void Game::appendTileQuad(const FrameSnapshot& frame, const sf::Vector2f& pos, int tileValue, float scale) {
+    if (scale <= 0.01f) return;
+    
+    const float innerTileSize = frame.layout.innerTileSize() * scale;
+    const float centerOffset = frame.layout.tileSize() / 2.0f - innerTileSize / 2.0f;
+    appendQuad(tileBatch, sf::FloatRect(pos.x + centerOffset, pos.y + centerOffset, innerTileSize, innerTileSize),
+               getTileColor(tileValue));
+}
+
+void Game::renderMainMenu(const FrameSnapshot& frame) {
     window.clear(sf::Color(187, 173, 160));
     
     // 绘制装饰图片
@@ -1026,6 +1669,11 @@ void Game::renderMainMenu() {
     for (const auto& text : sizeButtonTexts) {
         window.draw(text);
     }
+    
+    if (frame.hasSavedGame) {
+        window.draw(resumeButton);
+        window.draw(resumeButtonText);
+    }
 }
 
 void Game::renderVersionMenu() {
@@ -1039,43 +1687,33 @@ void Game::renderVersionMenu() {
     for (const auto& text : versionButtonTexts) {
         window.draw(text);
     }
+    window.draw(evilModeText);
 }
 
 sf::Vector2f Game::getTilePosition(int x, int y) const {
-    return sf::Vector2f(GRID_OFFSET_X + x * (TILE_SIZE + TILE_MARGIN),
-                       GRID_OFFSET_Y + y * (TILE_SIZE + TILE_MARGIN));
+    return layout.tilePosition(x, y);
 }
 
 void Game::calculateGridLayout() {
-    // 根据网格大小计算方块尺寸和间距
-    const float maxGridWidth = WINDOW_WIDTH * 0.8f;  // 网格最大宽度为窗口宽度的80%
-    const float maxGridHeight = WINDOW_HEIGHT * 0.6f; // 网格最大高度为窗口高度的60%
-    
-    // 计算适合的方块大小
-    float tileSizeWithMargin = std::min(
-        maxGridWidth / (gridSize + 0.5f),  // 加0.5f为边距留空间
-        maxGridHeight / (gridSize + 0.5f)
-    );
-    
-    // 设置方块大小和间距（间距为大小的1/5）
-    TILE_SIZE = static_cast<int>(tileSizeWithMargin * 0.83f); // 方块占83%
-    TILE_MARGIN = static_cast<int>(tileSizeWithMargin * 0.17f); // 间距占17%
-    
-    // 计算网格起始位置（居中）
-    GRID_OFFSET_X = (WINDOW_WIDTH - (gridSize * (TILE_SIZE + TILE_MARGIN) + TILE_MARGIN)) / 2;
-    GRID_OFFSET_Y = WINDOW_HEIGHT * 0.3f; // 将网格放在窗口上方1/3处
+    // 根据网格大小计算方块尺寸、间距和网格位置
+    layout.setGridSize(gridSize);
+    // 最多放大到与能完整显示的最大棋盘相同的方块大小
+    camera.reset(layout.boardWorld(), layout.boardWorld().width / layout.boardArea().width);
+    panning = false;
+    updateBoardView();
+    ++boardLayoutGeneration;
 }
 
 void Game::initializeGame(int size, GameVersion version) {
     gridSize = size;
     currentVersion = version;
+    rules = &boardRules(gridSize, currentVersion);
     
     // 必须在添加方块前计算布局
     calculateGridLayout();
     
     // 初始化网格
-    grid.clear();
-    grid.resize(gridSize, std::vector<int>(gridSize, 0));
+    board = Board(gridSize);
     
     // 重置游戏状态
     score = 0;
@@ -1085,185 +1723,755 @@ void Game::initializeGame(int size, GameVersion version) {
     achievedWin = false;
     winAchievementDialogShown = false;
     isPaused = false;
+    replayMode = false;
+    moveCount = 0;
+    undoHistory.clear(gridSize);
+    scoreSubmitted = false;
+    if (!botMode) {
+        openLeaderboard();
+    }
+
+    // 每局只播种一次
+    gameSeed = hasFixedSeed ? fixedSeed : Rng::randomSeed();
+    rng.seed(gameSeed);
     
     // 添加初始方块
     addRandomTile();
     addRandomTile();
+
+    // 外部程序驱动的对局不录回放，也不覆盖玩家的存档
+    if (botMode) return;
+    startRecording();
+    
+    // 新的一局覆盖旧存档
+    std::error_code ec;
+    std::filesystem::create_directories("save", ec);
+    journaledFlags = packSaveFlags();
+    hasSavedGame = saveJournal.begin(SAVE_FILE, captureSaveState());
 }
 
 void Game::resetGame() {
     initializeGame(gridSize, currentVersion);
 }
 
-void Game::addRandomTile() {
-    // 找到所有空单元格
-    std::vector<std::pair<int, int>> emptyCells;
-    for (int y = 0; y < gridSize; ++y) {
-        for (int x = 0; x < gridSize; ++x) {
-            if (grid[y][x] == 0) {
-                emptyCells.emplace_back(x, y);
-            }
+int Game::addEvilTile(const RedoStep* redo) {
+    SpawnChoice choice;
+    if (redo) {
+        choice.cell = redo->spawnCell;
+        choice.exponent = redo->spawnExponent;
+    } else {
+        choice = evilSpawner.choose(board, currentVersion);
+    }
+    if (choice.cell < 0) return -1;
+    board.setExponent(choice.cell, choice.exponent);
+    startSpawnAnimation(choice.cell, tweens.hasKind(TWEEN_SLIDE) ? slideAnimationDuration : 0.0f);
+    return choice.cell;
+}
+
+int Game::addRandomTile() {
+    // 空单元格掩码与抽取逻辑都在棋盘核心里，保证回放和模拟使用同一套规则
+    int cell = board.spawnRandom(rng);
+    if (cell < 0) return -1;
+    // 紧跟在移动之后生成的方块等滑动结束再弹出
+    startSpawnAnimation(cell, tweens.hasKind(TWEEN_SLIDE) ? slideAnimationDuration : 0.0f);
+    return cell;
+}
+
+bool Game::moveTiles(Direction dir) {
+    MoveResult result;
+    if (!rules->move(board, dir, result, &movePlan)) {
+        return false;
+    }
+    startSlideAnimation(movePlan);
+    
+    score += result.scoreGained;
+    
+    // mergedExponents 的第e位对应数值2^e，因此可以直接和数值按位与
+    // 检测是否首次达到胜利条件
+    if ((result.mergedExponents & WIN_VALUE) && !achievedWin) {
+        achievedWin = true;
+        winAchievementDialogShown = true;
+    }
+    
+    // 检测是否达到2048胜利条件
+    if ((result.mergedExponents & 2048) && !gameWon && !winDialogShown) {
+        gameWon = true;
+        winDialogShown = true;
+    }
+    
+    return true;
+}
+
+void Game::startRecording() {
+    std::error_code ec;
+    std::filesystem::create_directories("replays", ec);
+    
+    ReplayHeader header;
+    header.gridSize = static_cast<uint8_t>(gridSize);
+    header.version = currentVersion;
+    header.seed = gameSeed;
+    header.flags = evilSpawns ? REPLAY_FLAG_EVIL_SPAWNS : 0;
+    
+    replayPath = uniqueReplayPath();
+    if (replayWriter.open(replayPath, header)) {
+        std::cout << "✓ 正在录制回放: " << replayPath << std::endl;
+    } else {
+        replayPath.clear();
+    }
+}
+
+std::string Game::uniqueReplayPath() const {
+    // 种子 + 模式 + 开局时间，例如 replays/replay_123456_4x4_classic_20260101-120000.mrp；
+    // 固定种子在同一秒里连开几局时再加序号
+    char stamp[32] = "";
+    const std::time_t now = std::time(nullptr);
+    if (const std::tm* local = std::localtime(&now)) {
+        std::strftime(stamp, sizeof(stamp), "%Y%m%d-%H%M%S", local);
+    }
+    const std::string base = "replays/replay_" + std::to_string(gameSeed) + "_" + std::to_string(gridSize) + "x" +
+                             std::to_string(gridSize) + (currentVersion == GameVersion::ORIGINAL ? "_classic" : "_diagonal") +
+                             (evilSpawns ? "_evil" : "") + "_" + stamp;
+    std::string path = base + ".mrp";
+    std::error_code ec;
+    for (int index = 2; std::filesystem::exists(path, ec); ++index) {
+        path = base + "_" + std::to_string(index) + ".mrp";
+    }
+    return path;
+}
+
+void Game::recordMove(Direction dir, int spawnCell) {
+    if (spawnCell < 0) return;
+    
+    ReplayMove move = makeReplayMove(dir, board, spawnCell);
+    replayWriter.appendMove(move);
+    
+    // 存档日志同时记下移动后的标志，恢复时不必重新推导胜负状态
+    journaledFlags = packSaveFlags();
+    saveJournal.appendMove(move, journaledFlags);
+    if (saveJournal.movesSinceSnapshot() >= SaveJournal::SNAPSHOT_INTERVAL) {
+        saveJournal.appendSnapshot(captureSaveState());
+    }
+}
+
+uint8_t Game::packSaveFlags() const {
+    uint8_t flags = 0;
+    if (gameOver) flags |= SAVE_FLAG_GAME_OVER;
+    if (gameWon) flags |= SAVE_FLAG_GAME_WON;
+    if (winDialogShown) flags |= SAVE_FLAG_WIN_DIALOG;
+    if (achievedWin) flags |= SAVE_FLAG_ACHIEVED_WIN;
+    if (winAchievementDialogShown) flags |= SAVE_FLAG_ACHIEVEMENT_DIALOG;
+    if (isPaused) flags |= SAVE_FLAG_PAUSED;
+    if (evilSpawns) flags |= SAVE_FLAG_EVIL_SPAWNS;
+    return flags;
+}
+
+void Game::applySaveFlags(uint8_t flags) {
+    gameOver = (flags & SAVE_FLAG_GAME_OVER) != 0;
+    gameWon = (flags & SAVE_FLAG_GAME_WON) != 0;
+    winDialogShown = (flags & SAVE_FLAG_WIN_DIALOG) != 0;
+    achievedWin = (flags & SAVE_FLAG_ACHIEVED_WIN) != 0;
+    winAchievementDialogShown = (flags & SAVE_FLAG_ACHIEVEMENT_DIALOG) != 0;
+    isPaused = (flags & SAVE_FLAG_PAUSED) != 0;
+    evilSpawns = (flags & SAVE_FLAG_EVIL_SPAWNS) != 0;
+}
+
+SaveState Game::captureSaveState() const {
+    SaveState state;
+    state.board = board;
+    state.version = currentVersion;
+    state.flags = packSaveFlags();
+    state.moveCount = moveCount;
+    state.score = score;
+    state.seed = gameSeed;
+    state.rngState = rng.getState();
+    state.replayPath = replayPath;
+    return state;
+}
+
+bool Game::resumeSavedGame() {
+    SaveState state;
+    if (!SaveJournal::load(SAVE_FILE, state)) {
+        std::cerr << "✗ 读取存档失败" << std::endl;
+        hasSavedGame = false;
+        return false;
+    }
+    
+    gridSize = state.board.size();
+    currentVersion = state.version;
+    rules = &boardRules(gridSize, currentVersion);
+    calculateGridLayout();
+    
+    board = state.board;
+    score = state.score;
+    moveCount = state.moveCount;
+    gameSeed = state.seed;
+    rng.setState(state.rngState);
+    applySaveFlags(state.flags);
+    tweens.clear();
+    replayMode = false;
+    // 撤销历史不进存档，读档后从当前局面重新开始记录
+    undoHistory.clear(gridSize);
+    // 已经结束的局在结束时就上过榜了
+    scoreSubmitted = gameOver;
+    openLeaderboard();
+    
+    // 回放文件与存档一致时接着录制（回放里可能有撤销指令，所以比较最终局面而不是步数）。
+    // 旧版本的存档没有记回放路径，按当时只含种子的文件名去找
+    replayPath = state.replayPath.empty() ? "replays/replay_" + std::to_string(gameSeed) + ".mrp" : state.replayPath;
+    ReplayPlayer existing;
+    if (existing.load(replayPath) && existing.header().seed == gameSeed &&
+        existing.seek(existing.moveCount()) == existing.moveCount() &&
+        existing.board() == board && existing.score() == score && replayWriter.openForAppend(replayPath)) {
+        state.replayPath = replayPath;
+    } else {
+        replayWriter.close();
+        replayPath.clear();
+        state.replayPath.clear();
+        std::cerr << "⚠ 回放文件与存档不一致，本局后续步数不再录制" << std::endl;
+    }
+    
+    // 用恢复出的状态重写一份紧凑的日志
+    journaledFlags = state.flags;
+    saveJournal.begin(SAVE_FILE, state);
+    
+    currentState = GameState::GAME;
+    std::cout << "✓ 已恢复存档: " << gridSize << "x" << gridSize << "，第 " << moveCount
+              << " 步，分数 " << score << std::endl;
+    return true;
+}
+
+void Game::startAudio() {
+    const char* sinkEnv = std::getenv("MAO_AUDIO_SINK");
+    const bool nullSink = sinkEnv && std::string(sinkEnv) == "null";
+    sfx.load(!nullSink);
+    
+    std::vector<std::string> tracks;
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator("assets/music", ec)) {
+        if (entry.path().extension() == ".mp3") {
+            tracks.push_back(entry.path().string());
         }
     }
+    std::sort(tracks.begin(), tracks.end());
+    if (tracks.empty()) return;
     
-    if (emptyCells.empty()) return;
+    if (music.start(tracks, nullSink ? MusicPlayer::Sink::NONE : MusicPlayer::Sink::DEVICE)) {
+        std::cout << "✓ 背景音乐: " << tracks.size() << " 首" << (nullSink ? "（空输出）" : "") << std::endl;
+    }
+}
+
+void Game::toggleMusic() {
+    musicMuted = !musicMuted;
+    music.setVolume(musicMuted ? 0.0f : 1.0f);
+}
+
+void Game::printSoundStats() const {
+    const SoundEffects::Stats& stats = sfx.stats();
+    std::cout << "音效: 触发 " << stats.triggered << " 次，播放 " << stats.played << " 次，抢占声部 "
+              << stats.stolen << " 次" << std::endl;
+    if (stats.latencySamples > 0) {
+        std::cout << "输入到出声延迟: 平均 " << stats.latencyMeanMicros / 1000.0 << " 毫秒，最长 "
+                  << stats.latencyMaxMicros / 1000.0 << " 毫秒（" << stats.latencySamples << " 次）" << std::endl;
+    }
+}
+
+void Game::openLeaderboard() {
+    std::error_code ec;
+    std::filesystem::create_directories("leaderboard", ec);
     
-    // 随机选择一个空单元格
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_int_distribution<> dist(0, emptyCells.size() - 1);
+    bestScore = 0;
+    if (leaderboard.open(Leaderboard::defaultPath(gridSize, currentVersion, evilSpawns), gridSize, currentVersion)) {
+        std::vector<LeaderboardEntry> best = leaderboard.top(1);
+        if (!best.empty()) {
+            bestScore = best[0].score;
+        }
+    }
+}
+
+void Game::submitScore() {
+    if (scoreSubmitted || replayMode || botMode || !leaderboard.isOpen()) return;
+    scoreSubmitted = true;
     
-    auto [x, y] = emptyCells[dist(gen)];
-    grid[y][x] = (dist(gen) % 10 < 8) ? 2 : 4;
+    LeaderboardEntry entry;
+    entry.score = static_cast<uint32_t>(score);
+    entry.moves = moveCount;
+    entry.maxExponent = static_cast<uint8_t>(board.maxExponent());
+    entry.timestamp = static_cast<int64_t>(std::time(nullptr));
+    entry.kioskId = kioskId;
     
-    // 添加新方块动画
-    newTileAnimations.push_back({
-        getTilePosition(x, y),
-        0.0f // 初始进度为0
-    });
+    if (leaderboard.insert(entry)) {
+        std::cout << "✓ 本局得分 " << score << "，排名第 " << leaderboard.rankOf(entry.score) + 1
+                  << " / " << leaderboard.size() << std::endl;
+        bestScore = std::max(bestScore, entry.score);
+    }
 }
 
-bool Game::moveTiles(int dx, int dy) {
-    bool moved = false;
-    std::vector<std::vector<bool>> merged(gridSize, std::vector<bool>(gridSize, false));
+bool Game::hintAvailable() const {
+    return !replayMode && HintEngine::supports(gridSize);
+}
 
-    // 根据移动方向确定遍历顺序
-    const bool horizontal = (dx != 0);
-    const int start = (dx > 0 || dy > 0) ? gridSize - 1 : 0;
-    const int step = (dx > 0 || dy > 0) ? -1 : 1;
+void Game::toggleHint() {
+    if (!HintEngine::supports(gridSize)) {
+        std::cout << "提示只支持不超过 " << HintEngine::MAX_GRID_SIZE << "x" << HintEngine::MAX_GRID_SIZE
+                  << " 的棋盘" << std::endl;
+        return;
+    }
+    hintEnabled = !hintEnabled;
+    hintBoard = Board();
+    hintLabel.clear();
+    hintLabelKey = 0;
+    if (!hintEnabled) {
+        hintEngine->stop();
+        return;
+    }
+    // 两种提示共用一行文字，只能开一种
+    if (monteCarloEnabled) {
+        toggleMonteCarlo();
+    }
+    if (!hintEngine) {
+        hintEngine.reset(new HintEngine());
+    }
+    if (gridSize == NTupleNetwork::GRID_SIZE && !hintWeights[static_cast<size_t>(currentVersion)].isLoaded()) {
+        std::cout << "没有找到提示权重 " << NTupleWeights::defaultPath(currentVersion)
+                  << "，使用启发式估值（运行 train2048 可以生成）" << std::endl;
+    }
+    hintEngine->start();
+}
 
-    for (int i = 0; i < gridSize; ++i) {
-        for (int j = start; j >= 0 && j < gridSize; j += step) {
-            int x = horizontal ? j : i;
-            int y = horizontal ? i : j;
-            
-            if (grid[y][x] == 0) continue;
-
-            int newX = x;
-            int newY = y;
-            int prevX = x;
-            int prevY = y;
-            bool hasMerged = false;
-
-            while (true) {
-                int nextX = newX + dx;
-                int nextY = newY + dy;
-
-                // 边界检查
-                if (nextX < 0 || nextX >= gridSize || nextY < 0 || nextY >= gridSize) break;
-
-                // 如果目标位置为空，继续移动
-                if (grid[nextY][nextX] == 0) {
-                    prevX = newX;
-                    prevY = newY;
-                    newX = nextX;
-                    newY = nextY;
-                    moved = true;
-                } 
-                // 如果目标位置有相同值且未合并过
-                else if (grid[nextY][nextX] == grid[y][x] && !merged[nextY][nextX]) {
-                    merged[nextY][nextX] = true;
-                    grid[nextY][nextX] *= 2;
-                    score += grid[nextY][nextX];
-                    
-                    // 检测是否首次达到胜利条件
-                    if (grid[nextY][nextX] == WIN_VALUE && !achievedWin) {
-                        achievedWin = true;
-                        winAchievementDialogShown = true;
-                    }
-                    
-                    // 检测是否达到2048胜利条件
-                    if (grid[nextY][nextX] == 2048 && !gameWon && !winDialogShown) {
-                        gameWon = true;
-                        winDialogShown = true;
-                    }
-                    
-                    grid[y][x] = 0;
-                    moved = true;
-                    hasMerged = true;
-                    break;
-                } 
-                // 其他情况停止移动
-                else {
-                    break;
-                }
-            }
+void Game::updateHint() {
+    if (board != hintBoard) {
+        hintBoard = board;
+        const NTupleWeights& weights = hintWeights[static_cast<size_t>(currentVersion)];
+        const bool useWeights = gridSize == NTupleNetwork::GRID_SIZE && weights.isLoaded();
+        hintEngine->setPosition(board, currentVersion, useWeights ? weights.data() : nullptr);
+    }
+
+    // 投机搜索已经算过的局面在走完这一步的同一帧就能查到；结果没变时不重新拼文字
+    HintResult result;
+    const bool found = hintEngine->lookup(board, currentVersion, result);
+    const uint64_t key = !found ? 1 : !result.hasMove ? 2
+                       : 3 + static_cast<uint64_t>(result.depth) * 16 + static_cast<int>(result.move);
+    if (key == hintLabelKey) return;
+    hintLabelKey = key;
+    if (!found) {
+        hintLabel = "提示: 思考中…";
+    } else if (!result.hasMove) {
+        hintLabel = "提示: 无路可走";
+    } else {
+        hintLabel = std::string("提示: ") + HINT_DIRECTION_NAMES[static_cast<int>(result.move)] + "  深度 " +
+                    std::to_string(result.depth);
+    }
+}
+
+bool Game::monteCarloAvailable() const {
+    return !replayMode;
+}
+
+void Game::toggleMonteCarlo() {
+    monteCarloEnabled = !monteCarloEnabled;
+    monteCarloBoard = Board();
+    hintLabel.clear();
+    hintLabelKey = 0;
+    if (!monteCarloEnabled) {
+        monteCarlo->stop();
+        return;
+    }
+    if (hintEnabled) {
+        toggleHint();
+    }
+    if (!monteCarlo) {
+        monteCarlo.reset(new MonteCarloAdvisor());
+    }
+    monteCarlo->start();
+}
+
+void Game::updateMonteCarlo() {
+    if (board != monteCarloBoard) {
+        monteCarloBoard = board;
+        MonteCarloOptions options;
+        options.seed = gameSeed + moveCount;
+        // 大棋盘每步都要扫很多格，模拟只看前面一段，否则第一轮结果要等很久
+        if (gridSize > Board::INLINE_SIZE) options.maxPlayoutMoves = 200;
+        monteCarlo->setPosition(board, currentVersion, options);
+    }
+
+    // 每轮模拟结束时结果更新一次，分析完之前数字会逐渐收敛；没有新的一轮时不重新拼文字
+    MonteCarloResult result;
+    const bool found = monteCarlo->latest(board, currentVersion, result);
+    const uint64_t key = !found ? 1 : !result.hasMove ? 2
+                       : 3 + (result.playouts * 16 + static_cast<int>(result.move)) * 2 + result.finished;
+    if (key == hintLabelKey) return;
+    hintLabelKey = key;
+    std::string label;
+    if (!found) {
+        label = "蒙特卡洛: 模拟中…";
+    } else if (!result.hasMove) {
+        label = "蒙特卡洛: 无路可走";
+    } else {
+        const MoveEstimate& estimate = result.moves[directionIndex(result.move)];
+        std::ostringstream ss;
+        ss << "蒙特卡洛: " << HINT_DIRECTION_NAMES[static_cast<int>(result.move)];
+        if (estimate.playouts > 0) {
+            ss << "  平均 " << static_cast<int64_t>(estimate.mean) << " ± " << static_cast<int64_t>(estimate.halfWidth)
+               << "  " << result.playouts << " 局";
+        }
+        if (!result.finished) ss << "…";
+        label = ss.str();
+    }
+    hintLabel = label;
+}
+
+bool Game::chanceAvailable() const {
+    // 已经合成过目标之后胜率没有意义
+    // 胜率按随机生成计算，恶意生成下没有意义
+    return !replayMode && !achievedWin && !evilSpawns && WinSolver::supports(gridSize, winExponent());
+}
+
+void Game::toggleChance() {
+    if (!WinSolver::supports(gridSize, winExponent())) {
+        std::cout << "胜率只支持不超过 5x5 的棋盘" << std::endl;
+        return;
+    }
+    chanceEnabled = !chanceEnabled;
+    chanceBoard = Board();
+    if (!chanceEnabled && winSolver) {
+        winSolver->stop();
+    }
+}
+
+void Game::updateChance() {
+    // 换了尺寸或版本就重建求解器，表里的结果只对同一种规则有效
+    if (!winSolver || winSolver->gridSize() != gridSize || winSolver->version() != currentVersion) {
+        winSolver.reset(new WinSolver(gridSize, currentVersion, winExponent(), CHANCE_TABLE_BITS));
+        chanceBoard = Board();
+    }
+    winSolver->start();
+    if (board != chanceBoard) {
+        chanceBoard = board;
+        chanceProgress = WinSolver::Progress::SOLVING;
+        chanceLabel = "胜率: 计算中…";
+        winSolver->setPosition(board, CHANCE_TIME_LIMIT);
+    }
+    if (chanceProgress != WinSolver::Progress::SOLVING) return;
+
+    // 后台算完或者超时之前每帧只查一下进度；超时时已经算完的子局面都留在表里，后面的局面还能用上
+    WinChance chance;
+    chanceProgress = winSolver->latest(board, chance);
+    if (chanceProgress == WinSolver::Progress::SOLVED) {
+        std::ostringstream ss;
+        ss << "合成 " << WIN_VALUE << " 的概率: " << std::fixed << std::setprecision(2) << chance.probability * 100.0
+           << "%";
+        chanceLabel = ss.str();
+    } else if (chanceProgress == WinSolver::Progress::TIMED_OUT) {
+        chanceLabel = "胜率: 局面太复杂，无法精确计算";
+    }
+}
+
+bool Game::startReplay(const std::string& filename, size_t startMove) {
+    if (!replayPlayer.load(filename)) {
+        return false;
+    }
+    
+    replayWriter.close();
+    gridSize = replayPlayer.header().gridSize;
+    currentVersion = replayPlayer.header().version;
+    rules = &boardRules(gridSize, currentVersion);
+    calculateGridLayout();
+    
+    gameWon = false;
+    winDialogShown = false;
+    achievedWin = false;
+    winAchievementDialogShown = false;
+    isPaused = false;
+    tweens.clear();
+    
+    // 快进直接在棋盘核心上进行，不经过渲染
+    size_t reached = replayPlayer.seek(startMove);
+    std::cout << "✓ 回放已载入: " << filename << " (共 " << replayPlayer.moveCount()
+              << " 步，从第 " << reached << " 步开始)" << std::endl;
+    if (reached < std::min(startMove, replayPlayer.moveCount())) {
+        std::cerr << "⚠ 回放在第 " << reached << " 步与种子或棋盘不一致，只能播放到这里" << std::endl;
+    }
+    
+    replayMode = true;
+    replayPaused = false;
+    replayTimer = 0.0f;
+    currentState = GameState::GAME;
+    syncFromReplay();
+    return true;
+}
+
+bool Game::startBot(const std::string& name) {
+    if (!botLink.create(name)) {
+        return false;
+    }
+    botMode = true;
+    replayWriter.close();
+    saveJournal.close();
+    leaderboard.close();
+    
+    // 代理可以随时用 RESET 换棋盘；先开一局经典 4x4，连上就能走
+    initializeGame(4, GameVersion::ORIGINAL);
+    currentState = GameState::GAME;
+    publishBotState(0, false);
+    std::cout << "✓ 外部程序接口: " << name << std::endl;
+    return true;
+}
 
-            // 如果没有合并但移动了位置
-            if (!hasMerged && (newX != x || newY != y)) {
-                grid[newY][newX] = grid[y][x];
-                grid[y][x] = 0;
-                moved = true;
+void Game::updateBot() {
+    BotCommand command;
+    for (int i = 0; i < BOT_COMMANDS_PER_FRAME && botLink.popCommand(command); ++i) {
+        bool changed = false;
+        switch (command.op) {
+            case BotOp::MOVE:
+                changed = !gameOver && playMove(directionFromIndex(currentVersion, command.arg & 3));
+                break;
+            case BotOp::RESET: {
+                const int size = static_cast<int>(command.arg & 0xFF);
+                if (size >= 2 && size <= Board::MAX_SIZE) {
+                    initializeGame(size, (command.arg >> 8) & 1 ? GameVersion::MODIFIED : GameVersion::ORIGINAL);
+                } else {
+                    resetGame();
+                }
+                changed = true;
+                break;
             }
+            case BotOp::UNDO:
+                changed = undoMove();
+                break;
+            default:
+                break;
         }
+        // 不是每步都画时，补间动画只会越积越多，直接丢掉
+        if (botLink.renderEvery() > 0) {
+            tweens.clear();
+        }
+        ++botCommandsSinceRender;
+        publishBotState(command.id, changed);
     }
+}
 
-    return moved;
+void Game::publishBotState(uint64_t commandId, bool changed) {
+    BotState state;
+    state.lastCommand = commandId;
+    state.score = static_cast<uint32_t>(score);
+    state.moveCount = moveCount;
+    state.gridSize = static_cast<uint8_t>(gridSize);
+    state.version = static_cast<uint8_t>(currentVersion);
+    state.gameOver = gameOver ? 1 : 0;
+    state.lastMoveChanged = changed ? 1 : 0;
+    for (int i = 0; i < 4; ++i) {
+        Board probe = board;
+        MoveResult result;
+        if (probe.move(directionFromIndex(currentVersion, i), result)) {
+            state.legalMoves |= static_cast<uint8_t>(1 << i);
+        }
+    }
+    for (int cell = 0; cell < board.cellCount(); ++cell) {
+        state.cells[cell] = board.exponent(cell);
+    }
+    botLink.publish(state);
 }
 
-// Placeholder for moveTilesContinuous (not implemented in original code)
-bool Game::moveTilesContinuous(int dx, int dy) {
-    return moveTiles(dx, dy); // Fallback to regular moveTiles
+bool Game::shouldRender() {
+    if (!botMode) return true;
+    const uint32_t every = botLink.renderEvery();
+    if (every == 0 || botCommandsSinceRender >= every ||
+        botRenderClock.getElapsedTime().asSeconds() >= BOT_MIN_RENDER_INTERVAL) {
+        botCommandsSinceRender = 0;
+        botRenderClock.restart();
+        return true;
+    }
+    return false;
 }
 
-bool Game::isGameOver() const {
-    // Check for empty tiles
-    for (int y = 0; y < gridSize; ++y) {
-        for (int x = 0; x < gridSize; ++x) {
-            if (grid[y][x] == 0) {
-                return false;
+void Game::handleReplayInput(sf::Keyboard::Key key) {
+    switch (key) {
+        case sf::Keyboard::Space:
+            replayPaused = !replayPaused;
+            break;
+        case sf::Keyboard::Right:
+            replayPaused = true;
+            replayPlayer.step();
+            break;
+        case sf::Keyboard::Left:
+            replayPaused = true;
+            if (replayPlayer.position() > 0) {
+                replayPlayer.seek(replayPlayer.position() - 1);
             }
+            break;
+        case sf::Keyboard::R:
+            replayPlayer.restart();
+            replayTimer = 0.0f;
+            break;
+        case sf::Keyboard::M:
+            replayMode = false;
+            currentState = GameState::MAIN_MENU;
+            return;
+        default:
+            return;
+    }
+    syncFromReplay();
+}
+
+void Game::updateReplay(float deltaTime) {
+    if (replayPaused || replayPlayer.finished()) return;
+    
+    replayTimer += deltaTime;
+    if (replayTimer < REPLAY_STEP_INTERVAL) return;
+    replayTimer -= REPLAY_STEP_INTERVAL;
+    
+    if (replayPlayer.step(&movePlan)) {
+        startSlideAnimation(movePlan);
+        int cell = replayPlayer.lastSpawnCell();
+        if (cell >= 0) {
+            startSpawnAnimation(cell, slideAnimationDuration);
         }
+    } else {
+        // 文件在这一步出错，停下来而不是每隔一步重试一次
+        replayPaused = true;
     }
+    syncFromReplay();
+}
+
+void Game::syncFromReplay() {
+    board = replayPlayer.board();
+    score = replayPlayer.score();
+    // 回放中不弹出任何对话框
+    gameOver = false;
     
-    // Check for possible moves
-    if (currentVersion == GameVersion::ORIGINAL) {
-        // Check adjacent tiles for possible merges
-        for (int y = 0; y < gridSize; ++y) {
-            for (int x = 0; x < gridSize; ++x) {
-                int value = grid[y][x];
-                
-                // Check right
-                if (x < gridSize - 1 && grid[y][x + 1] == value) {
-                    return false;
-                }
-                
-                // Check down
-                if (y < gridSize - 1 && grid[y + 1][x] == value) {
-                    return false;
-                }
-            }
+    std::stringstream ss;
+    ss << "回放 " << replayPlayer.position() << "/" << replayPlayer.moveCount();
+    if (replayPlayer.finished()) {
+        ss << " (结束)";
+    } else if (replayPaused) {
+        ss << " (暂停)";
+    }
+    ss << "  空格:播放/暂停  ←/→:单步  R:从头  M:菜单";
+    replayLabel = ss.str();
+}
+
+void Game::startSlideAnimation(const MovePlan& plan) {
+    // 精灵的 toCell 始终是它代表的方块当前所在的格子；
+    // 一个方块被合并后又继续滑动时，停在它起点的精灵都跟着走，合并标记也跟着走。
+    // 每格挂一条精灵链表，超大棋盘上一次移动上千个方块也不用逐个查找
+    // 上一次移动还没播完的滑动、弹出和合并动画直接跳到终点（棋盘上已经是最终结果），
+    // 连续快速按键时只播放最新一步的动画
+    tweens.removeKind(TWEEN_SLIDE);
+    tweens.removeKind(TWEEN_SPAWN);
+    tweens.removeKind(TWEEN_MERGE);
+    std::vector<SlideAnimation>& slides = slideBuffer;
+    slides.clear();
+    slides.reserve(plan.count + 1);
+    if (slideHeads.size() < static_cast<size_t>(board.cellCount())) {
+        slideHeads.resize(board.cellCount(), -1);
+    }
+    pulseCells.clear();
+    auto attach = [&](int index, int cell) {
+        slides[index].toCell = cell;
+        slides[index].next = slideHeads[cell];
+        slideHeads[cell] = index;
+    };
+    for (int i = 0; i < plan.count; ++i) {
+        const TileMove& move = plan.moves[i];
+        
+        if (move.merged && slideHeads[move.to] < 0) {
+            // 原地不动的合并目标，动画期间仍显示合并前的数值
+            slides.push_back({move.to, move.to, 1 << (move.exponent - 1), -1});
+            attach(static_cast<int>(slides.size()) - 1, move.to);
         }
-    } else if (currentVersion == GameVersion::MODIFIED) {
-        // Check diagonal moves for possible merges
-        for (int y = 0; y < gridSize; ++y) {
-            for (int x = 0; x < gridSize; ++x) {
-                int value = grid[y][x];
-                
-                // Check top-right
-                if (x < gridSize - 1 && y > 0 && grid[y - 1][x + 1] == value) {
-                    return false;
-                }
-                
-                // Check bottom-right
-                if (x < gridSize - 1 && y < gridSize - 1 && grid[y + 1][x + 1] == value) {
-                    return false;
-                }
-                
-                // Check bottom-left
-                if (x > 0 && y < gridSize - 1 && grid[y + 1][x - 1] == value) {
-                    return false;
-                }
-                
-                // Check top-left
-                if (x > 0 && y > 0 && grid[y - 1][x - 1] == value) {
-                    return false;
-                }
+        
+        if (slideHeads[move.from] >= 0) {
+            int index = slideHeads[move.from];
+            slideHeads[move.from] = -1;
+            while (index >= 0) {
+                const int next = slides[index].next;
+                attach(index, move.to);
+                index = next;
             }
+        } else {
+            int movingExponent = move.merged ? move.exponent - 1 : move.exponent;
+            slides.push_back({move.from, move.to, 1 << movingExponent, -1});
+            attach(static_cast<int>(slides.size()) - 1, move.to);
+        }
+        
+        // 合并标记跟着方块走，合并出的格子边走边记下来，不用事后扫描整个棋盘
+        if (pulseMask.test(move.from)) {
+            pulseMask.reset(move.from);
+            pulseMask.set(move.to);
+            pulseCells.push_back(move.to);
+        }
+        if (move.merged) {
+            pulseMask.set(move.to);
+            pulseCells.push_back(move.to);
+            // 每次合并都触发一次音效，帧末合并成一次播放，音高取最大的数值
+            sfx.trigger(SoundEffect::MERGE, move.exponent, frameInputTime);
         }
     }
     
-    return true;
+    for (const SlideAnimation& slide : slides) {
+        // 精灵最后都停在 toCell，复位这些表头就让整张表回到全 -1
+        slideHeads[slide.toCell] = -1;
+        sf::Vector2f from = getTilePosition(slide.fromCell % gridSize, slide.fromCell / gridSize);
+        sf::Vector2f to = getTilePosition(slide.toCell % gridSize, slide.toCell / gridSize);
+        Tween tween;
+        tween.kind = TWEEN_SLIDE;
+        tween.target = static_cast<uint32_t>(slide.toCell);
+        tween.payload = static_cast<uint32_t>(slide.value);
+        tween.fromX = from.x;
+        tween.fromY = from.y;
+        tween.toX = to.x;
+        tween.toY = to.y;
+        tween.duration = slideAnimationDuration;
+        tween.easing = Easing::OUT_QUAD;
+        tweens.add(tween);
+    }
+    
+    // 滑动结束后合并出的方块放大一下；标记在哪一格就在哪一格放大，清掉标记顺便去重
+    for (int cell : pulseCells) {
+        if (!pulseMask.test(cell)) continue;
+        pulseMask.reset(cell);
+        Tween pulse;
+        pulse.kind = TWEEN_MERGE;
+        pulse.target = static_cast<uint32_t>(cell);
+        pulse.fromScale = 1.0f;
+        pulse.toScale = 1.15f;
+        pulse.duration = mergeAnimationDuration;
+        pulse.delay = slideAnimationDuration;
+        pulse.easing = Easing::PULSE;
+        tweens.add(pulse);
+    }
+}
+
+void Game::startSpawnAnimation(int cell, float delay) {
+    sfx.trigger(SoundEffect::SPAWN, 0, frameInputTime);
+    Tween pop;
+    pop.kind = TWEEN_SPAWN;
+    pop.target = static_cast<uint32_t>(cell);
+    pop.fromScale = 0.0f;
+    pop.toScale = 1.0f;
+    pop.duration = spawnAnimationDuration;
+    pop.delay = delay;
+    pop.easing = Easing::OUT_BACK;
+    tweens.add(pop);
+}
+
+float Game::dialogFade(uint8_t dialogFlag) const {
+    for (size_t i = 0; i < tweens.size(); ++i) {
+        if (tweens.kind(i) == TWEEN_DIALOG && tweens.target(i) == dialogFlag) {
+            return tweens.alpha(i);
+        }
+    }
+    return 1.0f;
+}
+
+// Placeholder for moveTilesContinuous (not implemented in original code)
+bool Game::moveTilesContinuous(int dx, int dy) {
+    return moveTiles(directionFromDelta(dx, dy)); // Fallback to regular moveTiles
+}
+
+bool Game::isGameOver() const {
+    return rules->isGameOver(board);
 }
 
 // Placeholder for isGameOver_grid (not implemented in original code)
@@ -1293,87 +2501,96 @@ sf::Color Game::getTileColor(int value) const {
 
 sf::Color Game::getCellBackgroundColor(int x, int y) const {
     // Return checkerboard pattern for modified version
-    if ((x + y) % 2 == 0) {
-        return sf::Color(205, 193, 171);
-    } else {
-        return sf::Color(205, 193, 180);
-    }
+    return checkerCellColor(x, y);
 }
 
-void Game::drawGrid() {
-    // 计算网格的实际尺寸（不包含多余的边距）
-    int gridWidth = gridSize * (TILE_SIZE + TILE_MARGIN) - TILE_MARGIN;
-    int gridHeight = gridSize * (TILE_SIZE + TILE_MARGIN) - TILE_MARGIN;
-    
-    // 绘制整体背景
-    sf::RectangleShape background(sf::Vector2f(gridWidth + TILE_MARGIN * 2, gridHeight + TILE_MARGIN * 2));
-    background.setPosition(GRID_OFFSET_X - TILE_MARGIN, GRID_OFFSET_Y - TILE_MARGIN);
-    background.setFillColor(sf::Color(187, 173, 160));
-    window.draw(background);
-    
-    // 绘制每个格子的背景
-    for (int y = 0; y < gridSize; ++y) {
-        for (int x = 0; x < gridSize; ++x) {
-            sf::RectangleShape cell(sf::Vector2f(TILE_SIZE, TILE_SIZE));
-            cell.setPosition(
-                GRID_OFFSET_X + x * (TILE_SIZE + TILE_MARGIN),
-                GRID_OFFSET_Y + y * (TILE_SIZE + TILE_MARGIN)
-            );
+void Game::rebuildBoardChunks(const FrameSnapshot& frame) {
+    chunkGeneration = frame.boardLayoutGeneration;
+    boardChunks.clear();
+    
+    const int boardSize = frame.gridSize;
+    const int tile = frame.layout.tileSize();
+    const int margin = frame.layout.tileMargin();
+    const int step = tile + margin;
+    const int offsetX = frame.layout.gridOffsetX();
+    const int offsetY = frame.layout.gridOffsetY();
+    // 网格的实际尺寸（不包含多余的边距）
+    const int gridExtent = boardSize * step - margin;
+    
+    // 每块从第一列左侧的间距开始，最后一块再带上外圈边距；网格线归它左边（上边）那一格所在的块
+    for (int y0 = 0; y0 < boardSize; y0 += BOARD_CHUNK_SIZE) {
+        for (int x0 = 0; x0 < boardSize; x0 += BOARD_CHUNK_SIZE) {
+            const int x1 = std::min(boardSize, x0 + BOARD_CHUNK_SIZE);
+            const int y1 = std::min(boardSize, y0 + BOARD_CHUNK_SIZE);
+            const float left = static_cast<float>(offsetX + x0 * step - margin);
+            const float top = static_cast<float>(offsetY + y0 * step - margin);
+            const float right = static_cast<float>(offsetX + x1 * step - (x1 == boardSize ? 0 : margin));
+            const float bottom = static_cast<float>(offsetY + y1 * step - (y1 == boardSize ? 0 : margin));
             
-            // 根据游戏版本设置背景颜色
-            if (currentVersion == GameVersion::MODIFIED) {
-                cell.setFillColor(getCellBackgroundColor(x, y));
-            } else {
-                cell.setFillColor(sf::Color(205, 193, 180));
+            BoardChunk chunk;
+            chunk.bounds = sf::FloatRect(left, top, right - left, bottom - top);
+            chunk.mesh.setPrimitiveType(sf::Triangles);
+            
+            // 整体背景
+            appendQuad(chunk.mesh, chunk.bounds, BOARD_BACKGROUND_COLOR);
+            
+            // 每个格子的背景，根据游戏版本设置颜色
+            for (int y = y0; y < y1; ++y) {
+                for (int x = x0; x < x1; ++x) {
+                    const sf::Color color = frame.version == GameVersion::MODIFIED
+                        ? getCellBackgroundColor(x, y) : CELL_BACKGROUND_COLOR;
+                    appendQuad(chunk.mesh, sf::FloatRect(offsetX + x * step, offsetY + y * step, tile, tile), color);
+                }
+            }
+            
+            // 网格线，只画到网格的实际范围
+            const float lineTop = std::max(top, static_cast<float>(offsetY));
+            const float lineBottom = std::min(bottom, static_cast<float>(offsetY + gridExtent));
+            const float lineLeft = std::max(left, static_cast<float>(offsetX));
+            const float lineRight = std::min(right, static_cast<float>(offsetX + gridExtent));
+            const int lastX = x1 == boardSize ? boardSize : x1 - 1;
+            const int lastY = y1 == boardSize ? boardSize : y1 - 1;
+            for (int i = x0; i <= lastX; ++i) {
+                const float x = offsetX + i * step - margin / 2 - GRID_LINE_THICKNESS / 2;
+                appendQuad(chunk.mesh, sf::FloatRect(x, lineTop, GRID_LINE_THICKNESS, lineBottom - lineTop), GRID_LINE_COLOR);
+            }
+            for (int i = y0; i <= lastY; ++i) {
+                const float y = offsetY + i * step - margin / 2 - GRID_LINE_THICKNESS / 2;
+                appendQuad(chunk.mesh, sf::FloatRect(lineLeft, y, lineRight - lineLeft, GRID_LINE_THICKNESS), GRID_LINE_COLOR);
             }
             
-            window.draw(cell);
+            boardChunks.push_back(std::move(chunk));
         }
     }
-    
-    // 绘制网格线 - 修正长度，确保对齐
-    for (int i = 0; i <= gridSize; ++i) {
-        // 垂直线 - 只绘制到网格的实际高度
-        sf::RectangleShape vLine(sf::Vector2f(GRID_LINE_THICKNESS, gridHeight));
-        vLine.setPosition(
-            GRID_OFFSET_X + i * (TILE_SIZE + TILE_MARGIN) - TILE_MARGIN/2 - GRID_LINE_THICKNESS/2,
-            GRID_OFFSET_Y
-        );
-        vLine.setFillColor(GRID_LINE_COLOR);
-        window.draw(vLine);
-        
-        // 水平线 - 只绘制到网格的实际宽度
-        sf::RectangleShape hLine(sf::Vector2f(gridWidth, GRID_LINE_THICKNESS));
-        hLine.setPosition(
-            GRID_OFFSET_X,
-            GRID_OFFSET_Y + i * (TILE_SIZE + TILE_MARGIN) - TILE_MARGIN/2 - GRID_LINE_THICKNESS/2
-        );
-        hLine.setFillColor(GRID_LINE_COLOR);
-        window.draw(hLine);
-    }
+}
+
+void Game::updateBoardView() {
+    const sf::FloatRect visibleWorld = camera.visibleWorld();
+    boardView = layout.boardView(visibleWorld);
+    boardPixelScale = layout.scale() * layout.boardArea().width / visibleWorld.width;
 }
 
 void Game::updateGifFrame(sf::Texture& texture, int value) {
     auto it = gifWrappers.find(value);
     if (it != gifWrappers.end()) {
-        it->second.updateFrame();
+        it->second.updateFrame(static_cast<uint32_t>(animationClock.getElapsedTime().asMilliseconds()));
         texture = it->second.getCurrentFrame();
     }
 }
 
 void Game::setupWinAchievementUI() {
     // Semi-transparent background
-    winAchievementBackground.setSize(sf::Vector2f(WINDOW_WIDTH, WINDOW_HEIGHT));
+    winAchievementBackground.setSize(sf::Vector2f(DESIGN_WIDTH, DESIGN_HEIGHT));
     winAchievementBackground.setFillColor(sf::Color(0, 0, 0, 150));
     
     // Achievement dialog box with rounded corners effect
     winAchievementBox.setSize(sf::Vector2f(600, 400));
-    winAchievementBox.setPosition(WINDOW_WIDTH/2 - 300, WINDOW_HEIGHT/2 - 200);
+    winAchievementBox.setPosition(DESIGN_WIDTH/2 - 300, DESIGN_HEIGHT/2 - 200);
     winAchievementBox.setFillColor(sf::Color(250, 248, 239));
     
     // Achievement sprite (win image) - 将在setupWinSprites中设置
     // 这里只设置默认位置，实际纹理和位置会在图片加载后设置
-    winAchievementSprite.setPosition(WINDOW_WIDTH/2 - 75, WINDOW_HEIGHT/2 - 130);
+    winAchievementSprite.setPosition(DESIGN_WIDTH/2 - 75, DESIGN_HEIGHT/2 - 130);
     
     // "You Win!!" text
     winAchievementText.setFont(font);
@@ -1383,16 +2600,16 @@ void Game::setupWinAchievementUI() {
     // 只左右居中，不上下居中
     sf::FloatRect winTextRect = winAchievementText.getLocalBounds();
     winAchievementText.setOrigin(winTextRect.left + winTextRect.width/2.0f, 0);
-    winAchievementText.setPosition(WINDOW_WIDTH/2, WINDOW_HEIGHT/2 + 20);
+    winAchievementText.setPosition(DESIGN_WIDTH/2, DESIGN_HEIGHT/2 + 20);
     
     // Continue button (红色圆角按钮)
     winAchievementContinueButton.setSize(sf::Vector2f(150, 60));
-    winAchievementContinueButton.setPosition(WINDOW_WIDTH/2 - 180, WINDOW_HEIGHT/2 + 80);
+    winAchievementContinueButton.setPosition(DESIGN_WIDTH/2 - 180, DESIGN_HEIGHT/2 + 80);
     winAchievementContinueButton.setFillColor(sf::Color(220, 50, 50)); // 红色
     
     // Menu button (绿色圆角按钮)
     winAchievementMenuButton.setSize(sf::Vector2f(150, 60));
-    winAchievementMenuButton.setPosition(WINDOW_WIDTH/2 + 30, WINDOW_HEIGHT/2 + 80);
+    winAchievementMenuButton.setPosition(DESIGN_WIDTH/2 + 30, DESIGN_HEIGHT/2 + 80);
     winAchievementMenuButton.setFillColor(sf::Color(50, 180, 50)); // 绿色
     
     // Button texts
@@ -1404,7 +2621,7 @@ void Game::setupWinAchievementUI() {
     sf::FloatRect continueTextRect = winAchievementContinueText.getLocalBounds();
     winAchievementContinueText.setOrigin(continueTextRect.left + continueTextRect.width/2.0f,
                                         continueTextRect.top + continueTextRect.height/2.0f);
-    winAchievementContinueText.setPosition(WINDOW_WIDTH/2 - 105, WINDOW_HEIGHT/2 + 110);
+    winAchievementContinueText.setPosition(DESIGN_WIDTH/2 - 105, DESIGN_HEIGHT/2 + 110);
     
     winAchievementMenuText.setFont(font);
     winAchievementMenuText.setString(toUTF8String("返回主菜单(M)"));
@@ -1414,22 +2631,22 @@ void Game::setupWinAchievementUI() {
     sf::FloatRect menuTextRect = winAchievementMenuText.getLocalBounds();
     winAchievementMenuText.setOrigin(menuTextRect.left + menuTextRect.width/2.0f,
                                     menuTextRect.top + menuTextRect.height/2.0f);
-    winAchievementMenuText.setPosition(WINDOW_WIDTH/2 + 105, WINDOW_HEIGHT/2 + 110);
+    winAchievementMenuText.setPosition(DESIGN_WIDTH/2 + 105, DESIGN_HEIGHT/2 + 110);
 }
 
 void Game::setupGameOverUI() {
     // Semi-transparent background
-    gameOverBackground.setSize(sf::Vector2f(WINDOW_WIDTH, WINDOW_HEIGHT));
+    gameOverBackground.setSize(sf::Vector2f(DESIGN_WIDTH, DESIGN_HEIGHT));
     gameOverBackground.setFillColor(sf::Color(0, 0, 0, 150));
     
     // Game over dialog box with rounded corners effect
     gameOverBox.setSize(sf::Vector2f(600, 400));
-    gameOverBox.setPosition(WINDOW_WIDTH/2 - 300, WINDOW_HEIGHT/2 - 200);
+    gameOverBox.setPosition(DESIGN_WIDTH/2 - 300, DESIGN_HEIGHT/2 - 200);
     gameOverBox.setFillColor(sf::Color(250, 248, 239));
     
     // Game over sprite (lose image) - 将在setupWinSprites中设置
     // 这里只设置默认位置，实际纹理和位置会在图片加载后设置
-    gameOverSprite.setPosition(WINDOW_WIDTH/2 - 75, WINDOW_HEIGHT/2 - 130);
+    gameOverSprite.setPosition(DESIGN_WIDTH/2 - 75, DESIGN_HEIGHT/2 - 130);
     
     // "You Lose!!" text
     gameOverDialogText.setFont(font);
@@ -1439,16 +2656,16 @@ void Game::setupGameOverUI() {
     // 只左右居中，不上下居中
     sf::FloatRect loseTextRect = gameOverDialogText.getLocalBounds();
     gameOverDialogText.setOrigin(loseTextRect.left + loseTextRect.width/2.0f, 0);
-    gameOverDialogText.setPosition(WINDOW_WIDTH/2, WINDOW_HEIGHT/2 + 20);
+    gameOverDialogText.setPosition(DESIGN_WIDTH/2, DESIGN_HEIGHT/2 + 20);
     
     // Restart button (红色圆角按钮)
     gameOverRestartButton.setSize(sf::Vector2f(150, 60));
-    gameOverRestartButton.setPosition(WINDOW_WIDTH/2 - 180, WINDOW_HEIGHT/2 + 80);
+    gameOverRestartButton.setPosition(DESIGN_WIDTH/2 - 180, DESIGN_HEIGHT/2 + 80);
     gameOverRestartButton.setFillColor(sf::Color(220, 50, 50)); // 红色
     
     // Menu button (绿色圆角按钮)
     gameOverMenuButton.setSize(sf::Vector2f(150, 60));
-    gameOverMenuButton.setPosition(WINDOW_WIDTH/2 + 30, WINDOW_HEIGHT/2 + 80);
+    gameOverMenuButton.setPosition(DESIGN_WIDTH/2 + 30, DESIGN_HEIGHT/2 + 80);
     gameOverMenuButton.setFillColor(sf::Color(50, 180, 50)); // 绿色
     
     // Button texts
@@ -1460,7 +2677,7 @@ void Game::setupGameOverUI() {
     sf::FloatRect restartTextRect = gameOverRestartText.getLocalBounds();
     gameOverRestartText.setOrigin(restartTextRect.left + restartTextRect.width/2.0f,
                                  restartTextRect.top + restartTextRect.height/2.0f);
-    gameOverRestartText.setPosition(WINDOW_WIDTH/2 - 105, WINDOW_HEIGHT/2 + 110);
+    gameOverRestartText.setPosition(DESIGN_WIDTH/2 - 105, DESIGN_HEIGHT/2 + 110);
     
     gameOverMenuText.setFont(font);
     gameOverMenuText.setString(toUTF8String("返回主菜单(M)"));
@@ -1470,7 +2687,7 @@ void Game::setupGameOverUI() {
     sf::FloatRect gameOverMenuTextRect = gameOverMenuText.getLocalBounds();
     gameOverMenuText.setOrigin(gameOverMenuTextRect.left + gameOverMenuTextRect.width/2.0f,
                               gameOverMenuTextRect.top + gameOverMenuTextRect.height/2.0f);
-    gameOverMenuText.setPosition(WINDOW_WIDTH/2 + 105, WINDOW_HEIGHT/2 + 110);
+    gameOverMenuText.setPosition(DESIGN_WIDTH/2 + 105, DESIGN_HEIGHT/2 + 110);
 }
 
 void Game::handleWinAchievementDialogClick(const sf::Vector2f& mousePos) {
@@ -1520,6 +2737,12 @@ void Game::handleGameOverDialogClick(const sf::Vector2f& mousePos) {
 }
 
 void Game::handleGameOverDialogKeyInput(sf::Keyboard::Key key) {
+    if (key == sf::Keyboard::U) {
+        // 撤销最后一步，回到游戏
+        undoMove();
+        return;
+    }
+    
     if (key == sf::Keyboard::R) {
         // Restart game
         resetGame();
@@ -1542,16 +2765,16 @@ void Game::setupWinSprites() {
         winSprite.setScale(spriteScale, spriteScale);
         float spriteWidth = winTexture.getSize().x * spriteScale;
         float spriteHeight = winTexture.getSize().y * spriteScale;
-        winSprite.setPosition(WINDOW_WIDTH/2 - spriteWidth/2, WINDOW_HEIGHT/2 - 160);
+        winSprite.setPosition(DESIGN_WIDTH/2 - spriteWidth/2, DESIGN_HEIGHT/2 - 160);
         
         // 设置胜利达成界面图片
         winAchievementSprite.setTexture(winTexture);
         winAchievementSprite.setScale(spriteScale, spriteScale);
-        winAchievementSprite.setPosition(WINDOW_WIDTH/2 - spriteWidth/2, WINDOW_HEIGHT/2 - 160);
+        winAchievementSprite.setPosition(DESIGN_WIDTH/2 - spriteWidth/2, DESIGN_HEIGHT/2 - 160);
         
         // 暂停界面不需要图片
         
-        std::cout << "✓ 胜利图片设置完成: 位置(" << (WINDOW_WIDTH/2 - spriteWidth/2) << ", " << (WINDOW_HEIGHT/2 - 180) << "), 大小(" << spriteWidth << "x" << spriteHeight << ")" << std::endl;
+        std::cout << "✓ 胜利图片设置完成: 位置(" << (DESIGN_WIDTH/2 - spriteWidth/2) << ", " << (DESIGN_HEIGHT/2 - 180) << "), 大小(" << spriteWidth << "x" << spriteHeight << ")" << std::endl;
     }
     
     // 重新设置游戏结束界面的图片
@@ -1561,63 +2784,180 @@ void Game::setupWinSprites() {
         gameOverSprite.setScale(spriteScale, spriteScale);
         float spriteWidth = loseTexture.getSize().x * spriteScale;
         float spriteHeight = loseTexture.getSize().y * spriteScale;
-        gameOverSprite.setPosition(WINDOW_WIDTH/2 - spriteWidth/2, WINDOW_HEIGHT/2 - 160);
+        gameOverSprite.setPosition(DESIGN_WIDTH/2 - spriteWidth/2, DESIGN_HEIGHT/2 - 160);
         
-        std::cout << "✓ 失败图片设置完成: 位置(" << (WINDOW_WIDTH/2 - spriteWidth/2) << ", " << (WINDOW_HEIGHT/2 - 180) << "), 大小(" << spriteWidth << "x" << spriteHeight << ")" << std::endl;
+        std::cout << "✓ 失败图片设置完成: 位置(" << (DESIGN_WIDTH/2 - spriteWidth/2) << ", " << (DESIGN_HEIGHT/2 - 180) << "), 大小(" << spriteWidth << "x" << spriteHeight << ")" << std::endl;
     }
 }
 
-void Game::drawRoundedRectangle(sf::RenderWindow& window, const sf::Vector2f& position, const sf::Vector2f& size, const sf::Color& color, float cornerRadius) {
-    // 用SFML的CircleShape做真正的圆角 - 简单有效
+void Game::onResize(unsigned width, unsigned height) {
+    // 界面视图随帧快照交给渲染线程设置；文字和按钮网格是渲染线程正在画的对象，改之前先拿锁
+    layout.resize(width, height);
+    std::lock_guard<std::mutex> lock(sceneMutex);
     
-    float radius = std::min(cornerRadius, std::min(size.x, size.y) / 2.0f);
+    // 全屏遮罩铺满整个可见区域
+    const sf::FloatRect& area = layout.visibleArea();
+    for (sf::RectangleShape* backdrop : {&exitConfirmBackground, &winBackground, &winAchievementBackground,
+                                        &gameOverBackground, &pauseBackground}) {
+        backdrop->setPosition(area.left, area.top);
+        backdrop->setSize(sf::Vector2f(area.width, area.height));
+    }
     
-    // 主体矩形（中间部分）
-    sf::RectangleShape mainRect(sf::Vector2f(size.x, size.y - 2 * radius));
-    mainRect.setPosition(position.x, position.y + radius);
-    mainRect.setFillColor(color);
-    window.draw(mainRect);
+    // 文字、按钮网格和棋盘视图都与实际像素大小有关，在这里统一重建一次
+    for (const ScaledText& entry : scaledTexts) {
+        rescaleText(entry);
+    }
+    rebuildButtonMeshes();
+    updateBoardView();
     
-    // 上下横条
-    sf::RectangleShape topRect(sf::Vector2f(size.x - 2 * radius, radius));
-    topRect.setPosition(position.x + radius, position.y);
-    topRect.setFillColor(color);
-    window.draw(topRect);
+    // 拖动窗口边框时会连续收到很多次尺寸变化，GIF纹理重新生成比较慢，等停下来再做
+    if (layout.scale() != tileLevelScale) {
+        levelRebuildDelay = LEVEL_REBUILD_DELAY;
+    }
+}
+
+void Game::registerScaledTexts() {
+    // 原点与各 setup 函数中设置的一致：水平居中、垂直居中或者都不居中
+    scaledTexts = {
+        {&titleText, 0, false, false},
+        {&resumeButtonText, 0, true, true},
+        {&versionTitleText, 0, false, false},
+        {&scoreText, 0, false, false},
+        {&gameOverText, 0, false, false},
+        {&restartText, 0, false, false},
+        {&replayText, 0, false, false},
+        {&hintText, 0, false, false},
+        {&chanceText, 0, false, false},
+        {&evilModeText, 0, true, true},
+        {&pauseButtonText, 0, true, true},
+        {&exitConfirmText, 0, true, true},
+        {&exitConfirmYesText, 0, true, true},
+        {&exitConfirmNoText, 0, true, true},
+        {&winText, 0, false, false},
+        {&winContinueText, 0, false, false},
+        {&winQuitText, 0, false, false},
+        {&winAchievementText, 0, true, false},
+        {&winAchievementContinueText, 0, true, true},
+        {&winAchievementMenuText, 0, true, true},
+        {&gameOverDialogText, 0, true, false},
+        {&gameOverRestartText, 0, true, true},
+        {&gameOverMenuText, 0, true, true},
+        {&pauseText, 0, true, false},
+        {&pauseContinueText, 0, true, true},
+        {&pauseMenuText, 0, true, true}
+    };
+    for (sf::Text& text : sizeButtonTexts) {
+        scaledTexts.push_back({&text, 0, true, true});
+    }
+    for (sf::Text& text : versionButtonTexts) {
+        scaledTexts.push_back({&text, 0, true, true});
+    }
     
-    sf::RectangleShape bottomRect(sf::Vector2f(size.x - 2 * radius, radius));
-    bottomRect.setPosition(position.x + radius, position.y + size.y - radius);
-    bottomRect.setFillColor(color);
-    window.draw(bottomRect);
+    // setup 函数里设置的字号就是设计坐标下的字号
+    for (ScaledText& entry : scaledTexts) {
+        entry.baseSize = entry.text->getCharacterSize();
+    }
+}
+
+void Game::rescaleText(const ScaledText& entry) {
+    // 按实际像素大小生成字形，再整体缩回设计坐标：位置不变，笔画在任何分辨率下都是清晰的
+    sf::Text& text = *entry.text;
+    text.setCharacterSize(layout.toPixels(static_cast<float>(entry.baseSize)));
+    text.setScale(1.0f / layout.scale(), 1.0f / layout.scale());
     
-    // 四个真正的圆角
-    sf::CircleShape corner(radius);
-    corner.setFillColor(color);
+    sf::FloatRect bounds = text.getLocalBounds();
+    text.setOrigin(entry.centerX ? bounds.left + bounds.width / 2.0f : 0.0f,
+                   entry.centerY ? bounds.top + bounds.height / 2.0f : 0.0f);
+}
+
+void Game::appendRoundedRectangle(sf::VertexArray& mesh, const sf::RectangleShape& shape, float cornerRadius) {
+    const sf::Vector2f position = shape.getPosition();
+    const sf::Vector2f size = shape.getSize();
+    const sf::Color color = shape.getFillColor();
+    float radius = std::min(cornerRadius, std::min(size.x, size.y) / 2.0f);
     
-    // 左上角
-    corner.setPosition(position.x, position.y);
-    window.draw(corner);
+    // 每段圆角的分段数随实际像素半径增加，放大到4K也看不出折线
+    const int segments = std::min(32, std::max(3, static_cast<int>(radius * layout.scale() / 2.0f)));
     
-    // 右上角
-    corner.setPosition(position.x + size.x - 2 * radius, position.y);
-    window.draw(corner);
+    // 四个圆角的圆心，依次为左上、右上、右下、左下
+    const sf::Vector2f corners[4] = {
+        sf::Vector2f(position.x + radius, position.y + radius),
+        sf::Vector2f(position.x + size.x - radius, position.y + radius),
+        sf::Vector2f(position.x + size.x - radius, position.y + size.y - radius),
+        sf::Vector2f(position.x + radius, position.y + size.y - radius)
+    };
     
-    // 左下角
-    corner.setPosition(position.x, position.y + size.y - 2 * radius);
-    window.draw(corner);
+    // 沿轮廓顺时针取点，圆角矩形是凸多边形，以中心为公共顶点拆成三角形（半透明颜色也不会重叠变深）
+    std::vector<sf::Vector2f> outline;
+    outline.reserve(4 * (segments + 1));
+    for (int corner = 0; corner < 4; ++corner) {
+        for (int i = 0; i <= segments; ++i) {
+            const float angle = (180.0f + 90.0f * (corner + static_cast<float>(i) / segments)) * 3.14159265f / 180.0f;
+            outline.push_back(sf::Vector2f(corners[corner].x + radius * std::cos(angle),
+                                           corners[corner].y + radius * std::sin(angle)));
+        }
+    }
     
-    // 右下角
-    corner.setPosition(position.x + size.x - 2 * radius, position.y + size.y - 2 * radius);
-    window.draw(corner);
+    const sf::Vector2f center(position.x + size.x / 2.0f, position.y + size.y / 2.0f);
+    for (size_t i = 0; i < outline.size(); ++i) {
+        mesh.append(sf::Vertex(center, color));
+        mesh.append(sf::Vertex(outline[i], color));
+        mesh.append(sf::Vertex(outline[(i + 1) % outline.size()], color));
+    }
+}
+
+void Game::rebuildButtonMeshes() {
+    // 每个对话框的圆角按钮合成一个三角形网格，绘制时一次提交
+    struct ButtonGroup {
+        sf::VertexArray* mesh;
+        std::vector<const sf::RectangleShape*> buttons;
+        float cornerRadius;
+    };
+    const std::array<ButtonGroup, 5> groups = {{
+        {&exitConfirmButtonMesh, {&exitConfirmYesButton, &exitConfirmNoButton}, 12.0f},
+        {&winAchievementButtonMesh, {&winAchievementContinueButton, &winAchievementMenuButton}, 12.0f},
+        {&gameOverButtonMesh, {&gameOverRestartButton, &gameOverMenuButton}, 12.0f},
+        {&pauseDialogButtonMesh, {&pauseContinueButton, &pauseMenuButton}, 12.0f},
+        {&pauseButtonMesh, {&pauseButton}, 8.0f}
+    }};
+    
+    for (const ButtonGroup& group : groups) {
+        group.mesh->clear();
+        group.mesh->setPrimitiveType(sf::Triangles);
+        for (const sf::RectangleShape* button : group.buttons) {
+            appendRoundedRectangle(*group.mesh, *button, group.cornerRadius);
+        }
+    }
+}
+
+std::vector<unsigned> Game::tileLevelSizes(const Layout& tileLayout) const {
+    std::vector<unsigned> sizes;
+    for (int size = 2; size <= MAX_GRID_SIZE; ++size) {
+        int tileSize = 0;
+        int tileMargin = 0;
+        Layout::computeTileLayout(size, tileSize, tileMargin);
+        sizes.push_back(tileLayout.toPixels(static_cast<float>(Layout::innerTileSize(tileSize, tileMargin))));
+    }
+    return sizes;
+}
+
+void Game::rebuildTileLevels(const Layout& tileLayout) {
+    // 重建后旧纹理失效，调用方随后会在同一次 updateGifs 中重新取各GIF的当前帧
+    const std::vector<unsigned> sizes = tileLevelSizes(tileLayout);
+    for (auto& [value, wrapper] : gifWrappers) {
+        wrapper.setLevelSizes(sizes, true);
+    }
+    tileLevelScale = tileLayout.scale();
 }
 
 void Game::setupPauseUI() {
     // Semi-transparent background
-    pauseBackground.setSize(sf::Vector2f(WINDOW_WIDTH, WINDOW_HEIGHT));
+    pauseBackground.setSize(sf::Vector2f(DESIGN_WIDTH, DESIGN_HEIGHT));
     pauseBackground.setFillColor(sf::Color(0, 0, 0, 150));
     
     // Pause dialog box with rounded corners effect
     pauseBox.setSize(sf::Vector2f(600, 400));
-    pauseBox.setPosition(WINDOW_WIDTH/2 - 300, WINDOW_HEIGHT/2 - 200);
+    pauseBox.setPosition(DESIGN_WIDTH/2 - 300, DESIGN_HEIGHT/2 - 200);
     pauseBox.setFillColor(sf::Color(250, 248, 239));
     
     // 暂停界面不需要图片
@@ -1630,16 +2970,16 @@ void Game::setupPauseUI() {
     // 只左右居中，不上下居中
     sf::FloatRect pauseTextRect = pauseText.getLocalBounds();
     pauseText.setOrigin(pauseTextRect.left + pauseTextRect.width/2.0f, 0);
-    pauseText.setPosition(WINDOW_WIDTH/2, WINDOW_HEIGHT/2 - 120); // 从-60改为-120，再往上移动60像素
+    pauseText.setPosition(DESIGN_WIDTH/2, DESIGN_HEIGHT/2 - 120); // 从-60改为-120，再往上移动60像素
     
     // Continue button (绿色圆角按钮) - 上方，继续往上移动
     pauseContinueButton.setSize(sf::Vector2f(200, 60));
-    pauseContinueButton.setPosition(WINDOW_WIDTH/2 - 100, WINDOW_HEIGHT/2 - 40); // 从+20改为-40，往上移动60像素
+    pauseContinueButton.setPosition(DESIGN_WIDTH/2 - 100, DESIGN_HEIGHT/2 - 40); // 从+20改为-40，往上移动60像素
     pauseContinueButton.setFillColor(sf::Color(50, 180, 50)); // 绿色
     
     // Menu button (红色圆角按钮) - 下方，继续往上移动
     pauseMenuButton.setSize(sf::Vector2f(200, 60));
-    pauseMenuButton.setPosition(WINDOW_WIDTH/2 - 100, WINDOW_HEIGHT/2 + 60); // 从+120改为+60，往上移动60像素
+    pauseMenuButton.setPosition(DESIGN_WIDTH/2 - 100, DESIGN_HEIGHT/2 + 60); // 从+120改为+60，往上移动60像素
     pauseMenuButton.setFillColor(sf::Color(220, 50, 50)); // 红色
     
     // Button texts
@@ -1651,7 +2991,7 @@ void Game::setupPauseUI() {
     sf::FloatRect continueTextRect = pauseContinueText.getLocalBounds();
     pauseContinueText.setOrigin(continueTextRect.left + continueTextRect.width/2.0f,
                                continueTextRect.top + continueTextRect.height/2.0f);
-    pauseContinueText.setPosition(WINDOW_WIDTH/2, WINDOW_HEIGHT/2 - 10); // 从+50改为-10，往上移动60像素
+    pauseContinueText.setPosition(DESIGN_WIDTH/2, DESIGN_HEIGHT/2 - 10); // 从+50改为-10，往上移动60像素
     
     pauseMenuText.setFont(font);
     pauseMenuText.setString(toUTF8String("返回主菜单(M)"));
@@ -1661,11 +3001,11 @@ void Game::setupPauseUI() {
     sf::FloatRect pauseMenuTextRect = pauseMenuText.getLocalBounds();
     pauseMenuText.setOrigin(pauseMenuTextRect.left + pauseMenuTextRect.width/2.0f,
                            pauseMenuTextRect.top + pauseMenuTextRect.height/2.0f);
-    pauseMenuText.setPosition(WINDOW_WIDTH/2, WINDOW_HEIGHT/2 + 90); // 从+150改为+90，往上移动60像素
+    pauseMenuText.setPosition(DESIGN_WIDTH/2, DESIGN_HEIGHT/2 + 90); // 从+150改为+90，往上移动60像素
     
     // 右上角暂停按钮
     pauseButton.setSize(sf::Vector2f(80, 40));
-    pauseButton.setPosition(WINDOW_WIDTH - 100, 20); // 右上角位置
+    pauseButton.setPosition(DESIGN_WIDTH - 100, 20); // 右上角位置
     pauseButton.setFillColor(sf::Color(100, 100, 100, 200)); // 半透明灰色
     
     pauseButtonText.setFont(font);
@@ -1676,7 +3016,7 @@ void Game::setupPauseUI() {
     sf::FloatRect pauseButtonTextRect = pauseButtonText.getLocalBounds();
     pauseButtonText.setOrigin(pauseButtonTextRect.left + pauseButtonTextRect.width/2.0f,
                              pauseButtonTextRect.top + pauseButtonTextRect.height/2.0f);
-    pauseButtonText.setPosition(WINDOW_WIDTH - 60, 40); // 按钮中心位置
+    pauseButtonText.setPosition(DESIGN_WIDTH - 60, 40); // 按钮中心位置
 }
 
 void Game::handlePauseDialogClick(const sf::Vector2f& mousePos) {
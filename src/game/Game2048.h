@@ -5,7 +5,30 @@
 #include <vector>
 #include <array>
 #include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <tuple>
 #include "../gif/gif_wrapper.h"
+#include "../core/Board.h"
+#include "../core/BoardEngine.h"
+#include "../core/Replay.h"
+#include "../core/SaveJournal.h"
+#include "../core/UndoHistory.h"
+#include "../core/Leaderboard.h"
+#include "../core/BotLink.h"
+#include "../ai/EvilSpawner.h"
+#include "../ai/HintEngine.h"
+#include "../ai/MonteCarloAdvisor.h"
+#include "../ai/NTupleNetwork.h"
+#include "../ai/WinSolver.h"
+#include "../audio/MusicPlayer.h"
+#include "../audio/SoundEffects.h"
+#include "TweenPool.h"
+#include "TripleBuffer.h"
+#include "TileStyle.h"
+#include "Layout.h"
 #include <iostream>
 #include <unordered_map>
 
@@ -16,35 +39,174 @@ enum class GameState {
     EXIT_CONFIRM,
 };
 
-enum class GameVersion {
-    ORIGINAL,
-    MODIFIED
-};
-
 class Game {
 public:
-    Game();
+    // fullscreen 为真时以桌面分辨率全屏运行
+    explicit Game(bool fullscreen = false);
     void run();
 
+    // 载入回放文件并直接跳到第 startMove 步开始播放
+    bool startReplay(const std::string& filename, size_t startMove);
+    // 打开共享内存接口，由外部程序通过命令驱动游戏（见 BotLink.h）
+    bool startBot(const std::string& name);
+
 private:
     // Window and state
     sf::RenderWindow window;
     GameState currentState;
     GameVersion currentVersion;
     int gridSize;
+    const BoardRules* rules;    // 开局时按 gridSize 和 currentVersion 选定的特化规则
 
     constexpr static int MAX_GRID_SIZE = 6;
+    // 超大棋盘（活动展示用）可选的尺寸，主菜单里用 ←/→ 切换
+    constexpr static std::array<int, 7> HUGE_GRID_SIZES = {8, 12, 16, 24, 32, 48, 64};
+    size_t hugeSizeIndex;
+
+    // 界面布局与渲染缓存：只在窗口尺寸（或棋盘尺寸）变化时重建，每帧只负责绘制。
+    // 文字、按钮网格等 SFML 对象由渲染线程绘制，逻辑线程只在窗口尺寸变化、菜单文字变化时改动它们，
+    // 两边都要先拿 sceneMutex；每帧变化的内容（棋盘、分数、提示文字……）都通过帧快照传递
+    Layout layout;
+    std::mutex sceneMutex;
+    struct ScaledText {
+        sf::Text* text;
+        unsigned baseSize;  // 设计坐标下的字号
+        bool centerX;
+        bool centerY;
+    };
+    std::vector<ScaledText> scaledTexts;
+    // 棋盘背景、格子和网格线按 BOARD_CHUNK_SIZE x BOARD_CHUNK_SIZE 格分块生成三角形网格，
+    // 只在棋盘尺寸或版本变化时（boardLayoutGeneration 加一）由渲染线程重建，绘制时跳过不在视野内的块
+    struct BoardChunk {
+        sf::VertexArray mesh;
+        sf::FloatRect bounds;   // 世界坐标
+    };
+    constexpr static int BOARD_CHUNK_SIZE = 16;
+    std::vector<BoardChunk> boardChunks;
+    uint32_t boardLayoutGeneration;     // 逻辑线程
+    uint32_t chunkGeneration;           // 渲染线程：boardChunks 是按哪一代布局生成的
+    // 棋盘摄像机：普通棋盘始终显示全貌，超大棋盘可以缩放和平移
+    BoardCamera camera;
+    sf::View boardView;
+    float boardPixelScale;      // 棋盘视图下每个世界单位对应的物理像素数
+    bool panning;
+    sf::Vector2i panLast;
+    constexpr static float CAMERA_ZOOM_STEP = 1.25f;
+    // 方块在屏幕上小于这个尺寸（设计坐标）时只画纯色方块，不画GIF和数字
+    constexpr static float DETAIL_TILE_SIZE = 24.0f;
+    sf::VertexArray tileBatch;  // 纯色方块每帧合成一个网格
+    // 每种数值一套方块背景、GIF精灵和数字，以格子左上角为原点、按不缩放的尺寸摆好；
+    // 只在布局、像素缩放变化或GIF换帧时更新，绘制时只换变换（位置和弹出/合并的缩放）
+    struct TileVisual {
+        sf::RectangleShape background;
+        sf::Sprite picture;
+        sf::Text number;
+        const sf::Texture* texture = nullptr;
+        sf::Vector2u textureSize;
+    };
+    std::unordered_map<int, TileVisual> tileVisuals;
+    int tileVisualTileSize;         // tileVisuals 是按哪个格子尺寸、内嵌尺寸和像素缩放摆的
+    int tileVisualInnerSize;
+    float tileVisualPixelScale;
+    std::vector<float> cellScale;
+    sf::VertexArray exitConfirmButtonMesh;
+    sf::VertexArray winAchievementButtonMesh;
+    sf::VertexArray gameOverButtonMesh;
+    sf::VertexArray pauseDialogButtonMesh;
+    sf::VertexArray pauseButtonMesh;
+    float tileLevelScale;       // 方块GIF各级纹理是按哪个缩放比例生成的
+    float levelRebuildDelay;    // 大于0时表示正在等待窗口尺寸稳定（受 sceneMutex 保护）
+    constexpr static float LEVEL_REBUILD_DELAY = 0.25f;
 
     // Animation related members
-    struct NewTileAnimation {
-        sf::Vector2f position;
-        float progress;
+    // 所有补间（滑动、新方块弹出、合并放大、对话框淡入）都放在同一个对象池里按时间推进
+    enum TweenKind : uint8_t {
+        TWEEN_SLIDE,    // target 为终点格，payload 为方块数值
+        TWEEN_SPAWN,    // target 为格子，缩放 0 -> 1
+        TWEEN_MERGE,    // target 为格子，缩放脉冲
+        TWEEN_DIALOG    // target 为对话框对应的 SAVE_FLAG_*，透明度 0 -> 1
     };
-    std::vector<NewTileAnimation> newTileAnimations;
-    float spawnAnimationDuration = 0.3f; // New tile spawn animation duration
+    TweenPool tweens;
+    float slideAnimationDuration = 0.12f;
+    float spawnAnimationDuration = 0.2f;
+    float mergeAnimationDuration = 0.15f;
+    float dialogFadeDuration = 0.2f;
+    uint8_t fadedDialogs = 0;   // 已经开始淡入的对话框
+
+    // 滑动精灵：由移动计划直接生成，每个精灵从起点格滑到终点格，动画期间终点格不按棋盘绘制
+    struct SlideAnimation {
+        int fromCell;
+        int toCell;
+        int value;
+        int next;       // 同一格上的下一个精灵，-1 表示没有
+    };
+    MovePlan movePlan;
+    // startSlideAnimation 每步复用的缓冲区：用完只把碰过的格子复位，开销只和移动的方块数有关
+    std::vector<SlideAnimation> slideBuffer;
+    std::vector<int> slideHeads;        // 每格精灵链表的表头，不用时全为 -1
+    CellMask pulseMask;                 // 带合并标记的格子，不用时全为 0
+    std::vector<int> pulseCells;        // 设置过合并标记的格子，可能有重复
+
+    // 一帧要画的全部内容，逻辑线程每次更新之后整帧写好再发布，渲染线程只读快照，
+    // 不会看到走到一半的棋盘或者与棋盘不一致的分数和动画
+    struct SlideSprite {
+        float x;
+        float y;
+        int value;
+    };
+    struct FrameSnapshot {
+        bool valid = false;     // 逻辑线程还没有发布过时为 false
+        GameState state = GameState::MAIN_MENU;
+        bool hasSavedGame = false;
+
+        Board board;
+        int gridSize = 4;
+        GameVersion version = GameVersion::ORIGINAL;
+        Layout layout;
+        uint32_t boardLayoutGeneration = 0;
+        sf::View boardView;
+        sf::FloatRect visibleWorld;
+        float boardPixelScale = 1.0f;
+
+        bool gameOver = false;
+        bool gameWon = false;
+        bool winDialogShown = false;
+        bool achievedWin = false;
+        bool winAchievementDialogShown = false;
+        bool isPaused = false;
+        // 对话框遮罩的淡入进度，按 SAVE_FLAG_* 分开
+        float winFade = 1.0f;
+        float achievementFade = 1.0f;
+        float gameOverFade = 1.0f;
+        float pauseFade = 1.0f;
+
+        // 为空表示不显示
+        std::string scoreLabel;
+        std::string replayLabel;
+        std::string hintLabel;
+        std::string chanceLabel;
+
+        // 补间的当前值：每格的缩放（新方块弹出、合并放大）、被滑动精灵占用的格子和滑动精灵的位置
+        std::vector<float> cellScale;
+        CellMask slidingCells;
+        std::vector<SlideSprite> slides;
+    };
+    // 逻辑线程发布、渲染线程读取，双方都不加锁
+    TripleBuffer<FrameSnapshot> frames;
+    // 有输入的这一轮立即发布，其余时候每 FRAME_INTERVAL_MS 发布一次：
+    // 补间、提示文字和GIF动画按显示节奏采样就够了，不必每轮都拷一份快照、让渲染线程重画
+    bool frameDirty;
+    sf::Clock publishClock;
+    constexpr static int FRAME_INTERVAL_MS = 8;
+    // 分数文字只在分数、最高分或模式变化时重新拼接
+    std::string scoreLabel;
+    std::tuple<int, uint32_t, bool, bool> scoreLabelKey;
+    std::atomic<bool> renderQuit;
+    bool quitRequested;     // 退出确认后由主循环停下渲染线程再关窗口
+    constexpr static int LOGIC_TICK_MS = 1;    // 逻辑线程每轮之间休息的时间，事件轮询的间隔不超过它
 
     // Game data
-    std::vector<std::vector<int>> grid;
+    Board board;
     int score;
     bool gameOver;
     bool gameWon;
@@ -52,6 +214,110 @@ private:
     bool achievedWin;
     bool winAchievementDialogShown;
     bool isPaused; // 新增：暂停状态
+
+    // 每局游戏独立的随机数发生器，种子决定整局的方块生成序列
+    Rng rng;
+    uint64_t gameSeed;
+    bool hasFixedSeed;    // 通过环境变量 MAO_SEED 指定了固定种子
+    uint64_t fixedSeed;
+
+    // 回放录制与播放
+    ReplayWriter replayWriter;
+    std::string replayPath;   // 本局正在录制的回放文件，随存档保存，读档后接着录
+    ReplayPlayer replayPlayer;
+    bool replayMode;
+    bool replayPaused;
+    float replayTimer;
+    constexpr static float REPLAY_STEP_INTERVAL = 0.35f; // 实时播放时每步间隔（秒）
+    std::string replayLabel;
+    sf::Text replayText;
+
+    // 存档：只追加的日志 + 定期快照
+    SaveJournal saveJournal;
+    uint8_t journaledFlags; // 已写入日志的对话框标志，变化时追加一条记录
+    uint32_t moveCount;
+    bool hasSavedGame;
+
+    // 撤销/重做（U 撤销，I 重做），不限步数
+    UndoHistory undoHistory;
+
+    // 本地排行榜：每种 (尺寸, 版本) 一个文件，游戏结束时写入
+    Leaderboard leaderboard;
+    uint32_t bestScore;
+    bool scoreSubmitted;
+    uint32_t kioskId;     // 通过环境变量 MAO_KIOSK_ID 指定，合并多台机器的排行榜时区分来源
+
+    // 提示（H 键开关）：后台线程做期望最大化搜索，界面每帧查它的置换表。
+    // 4x4 棋盘用 n元组网络估值，权重文件由 train2048 生成，启动时映射进内存；其他尺寸用启发式估值
+    std::array<NTupleWeights, 2> hintWeights;   // 按 GameVersion 下标
+    std::unique_ptr<HintEngine> hintEngine;     // 第一次打开提示时创建
+    bool hintEnabled;
+    Board hintBoard;      // 最近一次交给后台搜索的局面
+    std::string hintLabel;
+    uint64_t hintLabelKey;    // hintLabel 是按哪个结果拼的（两种提示共用），0 表示还没有
+    sf::Text hintText;
+
+    // 蒙特卡洛提示（A 键开关，和 H 键的提示二选一，共用左上角的文字）：不限棋盘尺寸，
+    // 每个方向走一步后随机模拟几千局，在全部CPU核心上后台进行，显示领先方向、平均得分和置信区间
+    std::unique_ptr<MonteCarloAdvisor> monteCarlo;  // 第一次打开时创建
+    bool monteCarloEnabled;
+    Board monteCarloBoard;    // 最近一次交给后台模拟的局面
+
+    // 胜率（W 键开关）：最优走法下合成出 WIN_VALUE 的精确概率。局面交给求解器的后台线程多线程求解，
+    // 每个局面限时，界面每帧只查进度；求解器的表在整局里保留，走一步之后新局面大多已经算过
+    std::unique_ptr<WinSolver> winSolver;
+    bool chanceEnabled;
+    Board chanceBoard;        // 当前胜率是针对哪个局面算的
+    WinSolver::Progress chanceProgress;
+    std::string chanceLabel;
+    sf::Text chanceText;
+
+    // 恶意生成（版本菜单里按 V 切换）：开局两个方块照常随机，之后每步的新方块由搜索挑最难受的位置和数值。
+    // 随机数不再参与，回放和存档里记下实际生成的方块；排行榜单独成榜
+    bool evilSpawns;
+    EvilSpawner evilSpawner;
+    sf::Text evilModeText;
+
+    // 背景音乐（B 键开关，N 键下一首）：assets/music 下的MP3按文件名顺序循环播放。
+    // 设置 MAO_AUDIO_SINK=null 时不打开声卡（没有声卡的机器、测试环境）
+    MusicPlayer music;
+    bool musicMuted;
+
+    // 音效（S 键开关）：新方块、合并和对话框，一帧里的同种音效合并成一次，帧末统一播放。
+    // frameInputTime 是这一帧第一个按键/点击的时间，用来统计从输入到出声的延迟；
+    // 设置 MAO_SFX_STATS 时退出前打印统计
+    SoundEffects sfx;
+    SoundEffects::Clock::time_point frameInputTime;
+
+    // 按键队列：processEvents 把按键连同取出的时刻排进队列，遇到其他事件之前或者这一批事件取完时按顺序处理，
+    // 顺序与逐个处理完全相同。移动立即作用在棋盘上，还没播完的动画直接跳到终点，不会越积越多；
+    // 按住不放时系统自动重复的按键，同一批里同一个键只留最早的一个；走不动的方向不进撤销历史，也不打断动画。
+    // 设置 MAO_INPUT_STATS 时退出前打印从取出按键到棋盘更新的延迟
+    struct QueuedKey {
+        sf::Keyboard::Key key;
+        bool repeat;
+        SoundEffects::Clock::time_point time;
+    };
+    struct InputStats {
+        uint64_t keys = 0;
+        uint64_t coalescedRepeats = 0;
+        uint64_t noOpMoves = 0;
+        uint64_t latencySamples = 0;
+        int64_t latencyTotalMicros = 0;
+        int64_t latencyMaxMicros = 0;
+    };
+    std::vector<QueuedKey> inputQueue;
+    std::array<bool, sf::Keyboard::KeyCount> keysDown;   // 区分新按下和自动重复
+    InputStats inputStats;
+
+    // 外部程序驱动（--bot 名字）：每帧执行命令环里的命令，每条命令之后发布一次局面。
+    // 这些对局不录回放、不写存档和排行榜。代理要求少画时，主循环只在执行了足够多的命令后才绘制
+    BotLink botLink;
+    bool botMode;
+    uint32_t botCommandsSinceRender;
+    sf::Clock botRenderClock;
+    constexpr static int BOT_COMMANDS_PER_FRAME = 4096;   // 每帧最多执行的命令数，保证窗口仍能响应
+    constexpr static float BOT_MIN_RENDER_INTERVAL = 0.25f;  // 少画模式下至少隔这么久也画一帧
     
     // Resources
     sf::Font font;
@@ -63,8 +329,10 @@ private:
     
     // UI Elements - Main Menu
     sf::Text titleText;
-    std::array<sf::RectangleShape, 3> sizeButtons;
-    std::array<sf::Text, 3> sizeButtonTexts;
+    std::array<sf::RectangleShape, 4> sizeButtons;    // 最后一个是超大棋盘
+    std::array<sf::Text, 4> sizeButtonTexts;
+    sf::RectangleShape resumeButton;
+    sf::Text resumeButtonText;
     
     // UI Elements - Version Menu
     sf::Text versionTitleText;
@@ -73,6 +341,11 @@ private:
     
     // Game UI
     sf::Text scoreText;
+    // 渲染线程：上一帧放进各文字对象的字符串，没变时不重新排版
+    std::string shownScoreLabel;
+    std::string shownReplayLabel;
+    std::string shownHintLabel;
+    std::string shownChanceLabel;
     sf::Text gameOverText;
     sf::Text restartText;
     
@@ -135,7 +408,20 @@ private:
     void setupGameOverUI();
     void setupPauseUI(); // 新增
     void setupWinSprites();
-    void drawRoundedRectangle(sf::RenderWindow& window, const sf::Vector2f& position, const sf::Vector2f& size, const sf::Color& color, float cornerRadius = 10.0f);
+    void appendRoundedRectangle(sf::VertexArray& mesh, const sf::RectangleShape& shape, float cornerRadius);
+
+    // Layout
+    void onResize(unsigned width, unsigned height);
+    void registerScaledTexts();
+    void rescaleText(const ScaledText& entry);
+    void rebuildButtonMeshes();
+    void rebuildBoardChunks(const FrameSnapshot& frame);
+    void updateBoardView();
+    void updateHugeSizeLabel();
+    void handleVersionMenuKey(sf::Keyboard::Key key);
+    void updateEvilModeLabel();
+    std::vector<unsigned> tileLevelSizes(const Layout& tileLayout) const;
+    void rebuildTileLevels(const Layout& tileLayout);
 
     // Draw black and white grids in the modified version
     sf::Color getCellBackgroundColor(int x, int y) const;
@@ -143,19 +429,31 @@ private:
     // Core functions
     void processEvents();
     void update(sf::Time deltaTime);
-    void render();
+    void publishFrame();
     
-    // State rendering
-    void renderMainMenu();
+    // State rendering（受 sceneMutex 保护）
+    void renderLoop();
+    void render(const FrameSnapshot& frame, float deltaTime);
+    void updateGifs(const FrameSnapshot& frame, float deltaTime);
+    void renderMainMenu(const FrameSnapshot& frame);
     void renderVersionMenu();
-    void renderGame();
+    void renderGame(const FrameSnapshot& frame);
+    void drawTile(const FrameSnapshot& frame, const sf::Vector2f& pos, int tileValue, float scale = 1.0f);
+    TileVisual& tileVisual(const FrameSnapshot& frame, int tileValue);
+    void appendTileQuad(const FrameSnapshot& frame, const sf::Vector2f& pos, int tileValue, float scale = 1.0f);
 
     void calculateGridLayout();
     sf::Vector2f getTilePosition(int x, int y) const;
     
     // Input handling
+    void queueKey(sf::Keyboard::Key key, SoundEffects::Clock::time_point time);
+    void processInputQueue();
+    void handleKeyPressed(sf::Keyboard::Key key);
+    void printInputStats() const;
     void handleMainMenuClick(const sf::Vector2f& mousePos);
     void handleVersionMenuClick(const sf::Vector2f& mousePos);
+    void handleMainMenuKey(sf::Keyboard::Key key);
+    bool handleCameraKey(sf::Keyboard::Key key);
     void handleGameInput(sf::Keyboard::Key key);
     void handleWinDialogClick(const sf::Vector2f& mousePos);
     void handleWinDialogKeyInput(sf::Keyboard::Key key);
@@ -169,12 +467,62 @@ private:
     // Game logic
     void initializeGame(int size, GameVersion version);
     void resetGame();
-    void addRandomTile();
-    bool moveTiles(int dx, int dy);
+    int addRandomTile();
+    // redo 不为空时放回重做记录里的方块，不再搜索
+    int addEvilTile(const RedoStep* redo = nullptr);
+    bool moveTiles(Direction dir);
+    bool playMove(Direction dir, const RedoStep* redo = nullptr);
+    void startSlideAnimation(const MovePlan& plan);
+    void startSpawnAnimation(int cell, float delay);
+    float dialogFade(uint8_t dialogFlag) const;
+    bool undoMove();
+    bool redoMove();
     bool moveTilesContinuous(int dx, int dy);
     bool isGameOver() const;
     bool isGameOver_grid() const;
     bool isGameOVer_diagonal() const;
+
+    // Replay
+    void startRecording();
+    // 本局回放的文件名，不会覆盖已有的回放
+    std::string uniqueReplayPath() const;
+    void recordMove(Direction dir, int spawnCell);
+    void handleReplayInput(sf::Keyboard::Key key);
+    void updateReplay(float deltaTime);
+    void syncFromReplay();
+
+    // Save / resume
+    uint8_t packSaveFlags() const;
+    void applySaveFlags(uint8_t flags);
+    SaveState captureSaveState() const;
+    bool resumeSavedGame();
+
+    // Audio
+    void startAudio();
+    void toggleMusic();
+    void printSoundStats() const;
+
+    // Bot
+    void updateBot();
+    void publishBotState(uint64_t commandId, bool changed);
+    bool shouldRender();
+
+    // Leaderboard
+    void openLeaderboard();
+    void submitScore();
+
+    // Hint
+    bool hintAvailable() const;
+    void toggleHint();
+    void updateHint();
+    // Monte-Carlo advice
+    bool monteCarloAvailable() const;
+    void toggleMonteCarlo();
+    void updateMonteCarlo();
+    // Win chance
+    bool chanceAvailable() const;
+    void toggleChance();
+    void updateChance();
     
     // Helper functions
     void initializeUI();
@@ -182,11 +530,10 @@ private:
     void setupVersionMenu();
     void setupTileColors();
     sf::Color getTileColor(int value) const;
-    void drawGrid();
 
     // GIF handling functions
     bool loadGif(const std::string& filename, sf::Texture& texture);
-    void animateGifOnCover(sf::RenderWindow& window, sf::Texture& gifTexture);
+    void animateGifOnCover(sf::RenderWindow& window, sf::Texture& gifTexture, const FrameSnapshot& frame);
     void drawGifsOnGrid(sf::RenderWindow& window);
     void updateGifFrame(sf::Texture& texture, int value);
 
@@ -195,14 +542,15 @@ private:
     float gifXPosition;
     float secondGifXPosition;
     std::vector<sf::Texture> tileGifTextures;
-    sf::Clock animationClock;
+    sf::Clock animationClock;   // 所有GIF共用的时间线
     sf::Clock gifMoveClock;
     
-    std::unordered_map<int, sf::Texture> tileGifTexturesMap;
+    // 每个数值当前应显示的纹理（指向GIF的当前帧或后备纹理），每帧只更新指针，不复制纹理
+    std::unordered_map<int, const sf::Texture*> tileGifTexturesMap;
     std::unordered_map<int, GifWrapper> gifWrappers;
+    std::unordered_map<int, sf::Texture> fallbackTileTextures;
     
     // 主菜单装饰元素 - 新增
-    std::vector<sf::Texture> decorativeTextures;
     std::vector<sf::Sprite> decorativeSprites;
     std::vector<GifWrapper> decorativeGifWrappers; // 新增：装饰GIF包装器用于动画
 };
@@ -0,0 +1,124 @@
+#include "Layout.h"
+#include <algorithm>
+#include <cmath>
+
+Layout::Layout()
+    : width(DESIGN_WIDTH), height(DESIGN_HEIGHT), pixelScale(1.0f),
+      visible(0.0f, 0.0f, DESIGN_WIDTH, DESIGN_HEIGHT), uiView(visible),
+      gridSize(4), area(), world(), tile(30), margin(5), offsetX(100), offsetY(200) {
+    setGridSize(gridSize);
+}
+
+void Layout::resize(unsigned newWidth, unsigned newHeight) {
+    // 最小化时部分平台会报告 0 尺寸，保留原来的布局
+    if (newWidth == 0 || newHeight == 0) return;
+
+    width = newWidth;
+    height = newHeight;
+    pixelScale = std::min(static_cast<float>(width) / DESIGN_WIDTH,
+                          static_cast<float>(height) / DESIGN_HEIGHT);
+
+    // 设计区域居中，视图向多出来的方向延伸
+    const float visibleWidth = width / pixelScale;
+    const float visibleHeight = height / pixelScale;
+    visible = sf::FloatRect((DESIGN_WIDTH - visibleWidth) / 2.0f, (DESIGN_HEIGHT - visibleHeight) / 2.0f,
+                            visibleWidth, visibleHeight);
+    uiView.reset(visible);
+}
+
+void Layout::setGridSize(int size) {
+    gridSize = size;
+    computeTileLayout(std::min(gridSize, MAX_FITTED_SIZE), tile, margin);
+
+    // 计算网格起始位置（居中），超大棋盘按能放下的最大棋盘占用同一块区域
+    const int fittedSize = std::min(gridSize, MAX_FITTED_SIZE);
+    const int fittedSpan = fittedSize * (tile + margin) + margin;
+    const int fittedX = (DESIGN_WIDTH - fittedSpan) / 2 + margin;
+    const int fittedY = static_cast<int>(DESIGN_HEIGHT * 0.3f); // 将网格放在窗口上方1/3处
+    area = sf::FloatRect(fittedX - margin, fittedY - margin, fittedSpan, fittedSpan);
+
+    if (isHugeBoard()) {
+        offsetX = margin;
+        offsetY = margin;
+    } else {
+        offsetX = fittedX;
+        offsetY = fittedY;
+    }
+    const int span = gridSize * (tile + margin) + margin;
+    world = sf::FloatRect(offsetX - margin, offsetY - margin, span, span);
+}
+
+sf::View Layout::boardView(const sf::FloatRect& visibleWorld) const {
+    sf::View view(visibleWorld);
+    view.setViewport(sf::FloatRect((area.left - visible.left) / visible.width,
+                                   (area.top - visible.top) / visible.height,
+                                   area.width / visible.width,
+                                   area.height / visible.height));
+    return view;
+}
+
+sf::Vector2f Layout::tilePosition(int x, int y) const {
+    return sf::Vector2f(offsetX + x * (tile + margin), offsetY + y * (tile + margin));
+}
+
+unsigned Layout::toPixels(float designLength) const {
+    return static_cast<unsigned>(std::max(1.0f, std::round(designLength * pixelScale)));
+}
+
+void Layout::computeTileLayout(int size, int& tileSize, int& tileMargin) {
+    const float maxGridWidth = DESIGN_WIDTH * 0.8f;  // 网格最大宽度为窗口宽度的80%
+    const float maxGridHeight = DESIGN_HEIGHT * 0.6f; // 网格最大高度为窗口高度的60%
+
+    // 计算适合的方块大小
+    float tileSizeWithMargin = std::min(
+        maxGridWidth / (size + 0.5f),  // 加0.5f为边距留空间
+        maxGridHeight / (size + 0.5f)
+    );
+
+    // 设置方块大小和间距（间距为大小的1/5）
+    tileSize = static_cast<int>(tileSizeWithMargin * 0.83f); // 方块占83%
+    tileMargin = static_cast<int>(tileSizeWithMargin * 0.17f); // 间距占17%
+}
+
+int Layout::innerTileSize(int tileSize, int tileMargin) {
+    return tileSize - (tileMargin / 2) * 2;
+}
+
+BoardCamera::BoardCamera() : world(), center(), zoomLevel(1.0f), maxZoomLevel(1.0f) {
+}
+
+void BoardCamera::reset(const sf::FloatRect& boardWorld, float maxZoom) {
+    world = boardWorld;
+    center = sf::Vector2f(world.left + world.width / 2.0f, world.top + world.height / 2.0f);
+    zoomLevel = 1.0f;
+    maxZoomLevel = std::max(1.0f, maxZoom);
+}
+
+void BoardCamera::zoomAt(float factor, const sf::Vector2f& anchor) {
+    const float newZoom = std::min(std::max(zoomLevel * factor, 1.0f), maxZoomLevel);
+    // 缩放前后 anchor 在屏幕上的位置不变
+    const float ratio = zoomLevel / newZoom;
+    center.x = anchor.x + (center.x - anchor.x) * ratio;
+    center.y = anchor.y + (center.y - anchor.y) * ratio;
+    zoomLevel = newZoom;
+    clampCenter();
+}
+
+void BoardCamera::pan(const sf::Vector2f& worldDelta) {
+    center += worldDelta;
+    clampCenter();
+}
+
+sf::FloatRect BoardCamera::visibleWorld() const {
+    const float width = world.width / zoomLevel;
+    const float height = world.height / zoomLevel;
+    return sf::FloatRect(center.x - width / 2.0f, center.y - height / 2.0f, width, height);
+}
+
+void BoardCamera::clampCenter() {
+    // 视野不超出棋盘
+    const float halfWidth = world.width / zoomLevel / 2.0f;
+    const float halfHeight = world.height / zoomLevel / 2.0f;
+    center.x = std::min(std::max(center.x, world.left + halfWidth), world.left + world.width - halfWidth);
+    center.y = std::min(std::max(center.y, world.top + halfHeight), world.top + world.height - halfHeight);
+}
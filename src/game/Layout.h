@@ -0,0 +1,91 @@
+#ifndef LAYOUT_H
+#define LAYOUT_H
+
+#include <SFML/Graphics.hpp>
+
+// 界面布局。所有控件都按 800x800 的设计坐标摆放，由视图映射到实际窗口：
+// 窗口按较短边等比缩放，多出来的宽度或高度两侧对称露出背景，不拉伸也不加黑边。
+// 只在窗口尺寸（sf::Event::Resized）或棋盘尺寸变化时重新计算，绘制时只读取结果。
+class Layout {
+public:
+    static constexpr int DESIGN_WIDTH = 800;
+    static constexpr int DESIGN_HEIGHT = 800;
+    // 不超过这个尺寸的棋盘整个摆在棋盘区域里；更大的棋盘按这个尺寸的方块大小铺开，由摄像机缩放和平移
+    static constexpr int MAX_FITTED_SIZE = 6;
+
+    Layout();
+
+    void resize(unsigned width, unsigned height);
+    void setGridSize(int size);
+
+    const sf::View& view() const { return uiView; }
+    // 每个设计单位对应的物理像素数
+    float scale() const { return pixelScale; }
+    // 窗口内可见的设计坐标范围，全屏遮罩按它铺满
+    const sf::FloatRect& visibleArea() const { return visible; }
+    unsigned windowWidth() const { return width; }
+    unsigned windowHeight() const { return height; }
+
+    // 棋盘布局。方块位置使用棋盘的世界坐标：能放下的棋盘与设计坐标相同，超大棋盘从原点开始铺开
+    bool isHugeBoard() const { return gridSize > MAX_FITTED_SIZE; }
+    // 屏幕上显示棋盘的区域（设计坐标）
+    const sf::FloatRect& boardArea() const { return area; }
+    // 整个棋盘背景（含外圈边距）在世界坐标中的范围
+    const sf::FloatRect& boardWorld() const { return world; }
+    // 摄像机看到的世界范围映射到屏幕上的棋盘区域
+    sf::View boardView(const sf::FloatRect& visibleWorld) const;
+    int tileSize() const { return tile; }
+    int tileMargin() const { return margin; }
+    int gridOffsetX() const { return offsetX; }
+    int gridOffsetY() const { return offsetY; }
+    sf::Vector2f tilePosition(int x, int y) const;
+    // 方块内嵌图片的边长：设计坐标和实际像素
+    int innerTileSize() const { return innerTileSize(tile, margin); }
+    unsigned innerTilePixels() const { return toPixels(static_cast<float>(innerTileSize())); }
+
+    unsigned toPixels(float designLength) const;
+
+    // 某个网格大小下的方块尺寸和间距
+    static void computeTileLayout(int size, int& tileSize, int& tileMargin);
+    static int innerTileSize(int tileSize, int tileMargin);
+
+private:
+    unsigned width;
+    unsigned height;
+    float pixelScale;
+    sf::FloatRect visible;
+    sf::View uiView;
+
+    int gridSize;
+    sf::FloatRect area;
+    sf::FloatRect world;
+    int tile;
+    int margin;
+    int offsetX;
+    int offsetY;
+};
+
+// 棋盘摄像机：zoom 为1时整个棋盘正好放满棋盘区域，放大后只显示其中一块，可以平移
+class BoardCamera {
+public:
+    BoardCamera();
+
+    void reset(const sf::FloatRect& boardWorld, float maxZoom);
+    // 以 anchor（世界坐标）为不动点缩放
+    void zoomAt(float factor, const sf::Vector2f& anchor);
+    void pan(const sf::Vector2f& worldDelta);
+
+    float zoom() const { return zoomLevel; }
+    // 当前看到的世界范围
+    sf::FloatRect visibleWorld() const;
+
+private:
+    void clampCenter();
+
+    sf::FloatRect world;
+    sf::Vector2f center;
+    float zoomLevel;
+    float maxZoomLevel;
+};
+
+#endif // LAYOUT_H
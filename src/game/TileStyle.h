@@ -0,0 +1,41 @@
+#ifndef TILE_STYLE_H
+#define TILE_STYLE_H
+
+#include <SFML/Graphics.hpp>
+#include <array>
+
+// 棋盘配色：游戏界面和导出回放动画（replay2gif）共用，保证导出的画面和游戏里一样
+
+// 方块底色：2, 4, 8 …… 2048，更大的数值都用最后一种
+inline const std::array<sf::Color, 12>& tileColorTable() {
+    static const std::array<sf::Color, 12> colors = {
+        sf::Color(238, 228, 218), // 2
+        sf::Color(237, 224, 200), // 4
+        sf::Color(242, 177, 121), // 8
+        sf::Color(245, 149, 99),  // 16
+        sf::Color(246, 124, 95),  // 32
+        sf::Color(246, 94, 59),   // 64
+        sf::Color(237, 207, 114), // 128
+        sf::Color(237, 204, 97),  // 256
+        sf::Color(237, 200, 80),  // 512
+        sf::Color(237, 197, 63),  // 1024
+        sf::Color(237, 194, 46),  // 2048
+        sf::Color(60, 58, 50)     // >2048
+    };
+    return colors;
+}
+
+const sf::Color BOARD_BACKGROUND_COLOR(187, 173, 160);
+const sf::Color CELL_BACKGROUND_COLOR(205, 193, 180);
+
+// 对角线版本的棋盘格：相邻格子深浅交替
+inline sf::Color checkerCellColor(int x, int y) {
+    return (x + y) % 2 == 0 ? sf::Color(205, 193, 171) : sf::Color(205, 193, 180);
+}
+
+// 方块上数字的颜色：浅色方块用深色字
+inline sf::Color tileTextColor(int value) {
+    return value <= 4 ? sf::Color(119, 110, 101) : sf::Color::White;
+}
+
+#endif // TILE_STYLE_H
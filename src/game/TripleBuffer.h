@@ -0,0 +1,48 @@
+#ifndef TRIPLE_BUFFER_H
+#define TRIPLE_BUFFER_H
+
+#include <atomic>
+#include <cstdint>
+
+// 单写单读的无锁三缓冲：写端总有一格可写，读端总有一格完整的可读，第三格在两者之间交接。
+// 写端写完一帧后 publish 把它换到中间格，读端 update 时如果中间格是新的就换过来；
+// 两边都只做一次原子交换，谁也不会等谁。读端来不及取的旧帧直接被新帧覆盖，读到的永远是完整写好的最新一帧。
+template <class T>
+class TripleBuffer {
+public:
+    TripleBuffer() : middle(1), writeIndex(0), readIndex(2) {
+    }
+
+    TripleBuffer(const TripleBuffer&) = delete;
+    TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+    // 只能由写端调用。换回来的格子里是更早的某一帧，写端需要整帧重写
+    T& writeBuffer() { return slots[writeIndex]; }
+
+    void publish() {
+        const uint8_t previous = middle.exchange(static_cast<uint8_t>(writeIndex | FRESH), std::memory_order_acq_rel);
+        writeIndex = previous & INDEX_MASK;
+    }
+
+    // 只能由读端调用，有新的一帧时换到读端并返回 true
+    bool update() {
+        if (!(middle.load(std::memory_order_relaxed) & FRESH)) return false;
+        const uint8_t previous = middle.exchange(readIndex, std::memory_order_acq_rel);
+        readIndex = previous & INDEX_MASK;
+        return true;
+    }
+
+    const T& readBuffer() const { return slots[readIndex]; }
+
+private:
+    static constexpr uint8_t INDEX_MASK = 3;
+    static constexpr uint8_t FRESH = 4;     // 中间格是写端发布后还没被读端取走的一帧
+
+    T slots[3];
+    // 中间格的下标和 FRESH 标志放在同一个字节里一起交换；两端各自的下标只有自己访问，分放在不同的缓存行
+    alignas(64) std::atomic<uint8_t> middle;
+    alignas(64) uint8_t writeIndex;
+    alignas(64) uint8_t readIndex;
+};
+
+#endif // TRIPLE_BUFFER_H
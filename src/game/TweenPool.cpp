@@ -0,0 +1,126 @@
+#include "TweenPool.h"
+#include <algorithm>
+#include <cmath>
+
+float applyEasing(Easing easing, float t) {
+    switch (easing) {
+        case Easing::OUT_QUAD:
+            return 1.0f - (1.0f - t) * (1.0f - t);
+        case Easing::OUT_BACK: {
+            const float c1 = 1.70158f;
+            const float c3 = c1 + 1.0f;
+            const float u = t - 1.0f;
+            return 1.0f + c3 * u * u * u + c1 * u * u;
+        }
+        case Easing::PULSE:
+            return std::sin(t * 3.14159265f);
+        case Easing::LINEAR:
+        default:
+            return t;
+    }
+}
+
+TweenPool::TweenPool(size_t initialCapacity) : count(0) {
+    reserve(initialCapacity);
+}
+
+void TweenPool::reserve(size_t capacity) {
+    kinds.resize(capacity);
+    easings.resize(capacity);
+    targets.resize(capacity);
+    payloads.resize(capacity);
+    for (std::vector<float>* field : {&fromX, &fromY, &toX, &toY, &fromScale, &toScale, &fromAlpha, &toAlpha,
+                                      &elapsed, &durations, &delays,
+                                      &currentX, &currentY, &currentScale, &currentAlpha}) {
+        field->resize(capacity);
+    }
+}
+
+void TweenPool::add(const Tween& tween) {
+    if (count == kinds.size()) {
+        reserve(std::max<size_t>(16, kinds.size() * 2));
+    }
+
+    const size_t i = count++;
+    kinds[i] = tween.kind;
+    easings[i] = tween.easing;
+    targets[i] = tween.target;
+    payloads[i] = tween.payload;
+    fromX[i] = tween.fromX;
+    fromY[i] = tween.fromY;
+    toX[i] = tween.toX;
+    toY[i] = tween.toY;
+    fromScale[i] = tween.fromScale;
+    toScale[i] = tween.toScale;
+    fromAlpha[i] = tween.fromAlpha;
+    toAlpha[i] = tween.toAlpha;
+    elapsed[i] = 0.0f;
+    durations[i] = std::max(tween.duration, 0.001f);
+    delays[i] = tween.delay;
+    sample(i);
+}
+
+void TweenPool::sample(size_t i) {
+    float t = (elapsed[i] - delays[i]) / durations[i];
+    t = std::min(std::max(t, 0.0f), 1.0f);
+    const float e = applyEasing(easings[i], t);
+    currentX[i] = fromX[i] + (toX[i] - fromX[i]) * e;
+    currentY[i] = fromY[i] + (toY[i] - fromY[i]) * e;
+    currentScale[i] = fromScale[i] + (toScale[i] - fromScale[i]) * e;
+    currentAlpha[i] = fromAlpha[i] + (toAlpha[i] - fromAlpha[i]) * e;
+}
+
+void TweenPool::removeAt(size_t i) {
+    const size_t last = --count;
+    if (i == last) return;
+    kinds[i] = kinds[last];
+    easings[i] = easings[last];
+    targets[i] = targets[last];
+    payloads[i] = payloads[last];
+    fromX[i] = fromX[last];
+    fromY[i] = fromY[last];
+    toX[i] = toX[last];
+    toY[i] = toY[last];
+    fromScale[i] = fromScale[last];
+    toScale[i] = toScale[last];
+    fromAlpha[i] = fromAlpha[last];
+    toAlpha[i] = toAlpha[last];
+    elapsed[i] = elapsed[last];
+    durations[i] = durations[last];
+    delays[i] = delays[last];
+    currentX[i] = currentX[last];
+    currentY[i] = currentY[last];
+    currentScale[i] = currentScale[last];
+    currentAlpha[i] = currentAlpha[last];
+}
+
+void TweenPool::update(float deltaTime) {
+    size_t i = 0;
+    while (i < count) {
+        elapsed[i] += deltaTime;
+        if (elapsed[i] >= delays[i] + durations[i]) {
+            removeAt(i); // 换进来的末尾元素留在 i 处继续处理
+        } else {
+            sample(i);
+            ++i;
+        }
+    }
+}
+
+void TweenPool::removeKind(uint8_t kind) {
+    size_t i = 0;
+    while (i < count) {
+        if (kinds[i] == kind) {
+            removeAt(i);
+        } else {
+            ++i;
+        }
+    }
+}
+
+bool TweenPool::hasKind(uint8_t kind) const {
+    for (size_t i = 0; i < count; ++i) {
+        if (kinds[i] == kind) return true;
+    }
+    return false;
+}
@@ -0,0 +1,72 @@
+#ifndef TWEEN_POOL_H
+#define TWEEN_POOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+enum class Easing : uint8_t {
+    LINEAR,
+    OUT_QUAD,
+    OUT_BACK,   // 略微冲过终点再回弹，用于新方块弹出
+    PULSE       // 0 -> 1 -> 0，用于合并时的放大再恢复
+};
+
+float applyEasing(Easing easing, float t);
+
+// 添加补间时的参数
+struct Tween {
+    uint8_t kind = 0;       // 由使用者定义的类别
+    uint32_t target = 0;    // 作用对象，例如格子下标
+    uint32_t payload = 0;   // 附加数据，例如方块数值
+    float fromX = 0.0f, fromY = 0.0f, toX = 0.0f, toY = 0.0f;
+    float fromScale = 1.0f, toScale = 1.0f;
+    float fromAlpha = 1.0f, toAlpha = 1.0f;
+    float duration = 0.1f;  // 秒
+    float delay = 0.0f;     // 延迟开始，期间保持起始值
+    Easing easing = Easing::LINEAR;
+};
+
+// 活动补间的对象池：按字段分开存放的数组（结构数组），按真实经过的时间推进，
+// 结束的补间与末尾交换后删除，不移动其余元素；数组容量只增不减，稳定后不再分配内存。
+// 上百个补间同时进行时每帧的开销也只是几次顺序遍历。
+class TweenPool {
+public:
+    explicit TweenPool(size_t initialCapacity = 64);
+
+    void add(const Tween& tween);
+    void update(float deltaTime);
+    void clear() { count = 0; }
+    void removeKind(uint8_t kind);
+    bool hasKind(uint8_t kind) const;
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    // 第 i 个活动补间的当前值（顺序会因删除而变化，只在一次遍历内使用下标）
+    uint8_t kind(size_t i) const { return kinds[i]; }
+    uint32_t target(size_t i) const { return targets[i]; }
+    uint32_t payload(size_t i) const { return payloads[i]; }
+    float x(size_t i) const { return currentX[i]; }
+    float y(size_t i) const { return currentY[i]; }
+    float scale(size_t i) const { return currentScale[i]; }
+    float alpha(size_t i) const { return currentAlpha[i]; }
+
+private:
+    void reserve(size_t capacity);
+    void sample(size_t i);
+    void removeAt(size_t i);
+
+    size_t count;
+
+    std::vector<uint8_t> kinds;
+    std::vector<Easing> easings;
+    std::vector<uint32_t> targets;
+    std::vector<uint32_t> payloads;
+    std::vector<float> fromX, fromY, toX, toY;
+    std::vector<float> fromScale, toScale, fromAlpha, toAlpha;
+    std::vector<float> elapsed, durations, delays;
+    std::vector<float> currentX, currentY, currentScale, currentAlpha;
+};
+
+#endif // TWEEN_POOL_H
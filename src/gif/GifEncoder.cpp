@@ -0,0 +1,441 @@
+#include "GifEncoder.h"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <iostream>
+
+namespace {
+
+constexpr int BIN_COUNT = 1 << 15;      // 每通道5位
+constexpr int MAX_COLORS = 256;
+constexpr int MAX_CODE = 4095;          // GIF 的 LZW 码最长12位
+constexpr int HASH_BITS = 13;           // 字典最多4096项，哈希表保持一半以下的装载率
+
+inline int binOf(const uint8_t* pixel) {
+    return ((pixel[0] >> 3) << 10) | ((pixel[1] >> 3) << 5) | (pixel[2] >> 3);
+}
+
+inline int binChannel(int bin, int axis) {
+    return (bin >> (10 - axis * 5)) & 31;
+}
+
+// 中位切分的一个盒子：usedBins[begin, end) 里的桶
+struct ColorBox {
+    int begin;
+    int end;
+    uint64_t population;
+};
+
+// 按位写出变长的码，攒满255字节就输出一个数据子块
+class CodeWriter {
+public:
+    explicit CodeWriter(std::vector<uint8_t>& output) : out(output), bitBuffer(0), bitCount(0), blockSize(0) {
+    }
+
+    void write(int code, int codeSize) {
+        bitBuffer |= static_cast<uint32_t>(code) << bitCount;
+        bitCount += codeSize;
+        while (bitCount >= 8) {
+            putByte(static_cast<uint8_t>(bitBuffer & 0xFF));
+            bitBuffer >>= 8;
+            bitCount -= 8;
+        }
+    }
+
+    void finish() {
+        if (bitCount > 0) {
+            putByte(static_cast<uint8_t>(bitBuffer & 0xFF));
+            bitBuffer = 0;
+            bitCount = 0;
+        }
+        flushBlock();
+        out.push_back(0);
+    }
+
+private:
+    void putByte(uint8_t byte) {
+        block[blockSize++] = byte;
+        if (blockSize == 255) flushBlock();
+    }
+
+    void flushBlock() {
+        if (blockSize == 0) return;
+        out.push_back(static_cast<uint8_t>(blockSize));
+        out.insert(out.end(), block.begin(), block.begin() + blockSize);
+        blockSize = 0;
+    }
+
+    std::vector<uint8_t>& out;
+    uint32_t bitBuffer;
+    int bitCount;
+    std::array<uint8_t, 255> block;
+    int blockSize;
+};
+
+void putShort(std::vector<uint8_t>& out, int value) {
+    out.push_back(static_cast<uint8_t>(value & 0xFF));
+    out.push_back(static_cast<uint8_t>((value >> 8) & 0xFF));
+}
+
+} // namespace
+
+void quantizeImage(const uint8_t* rgba, int stride, int x, int y, int width, int height, QuantizedImage& out) {
+    std::vector<uint32_t> counts(BIN_COUNT, 0);
+    std::vector<uint16_t> bins(static_cast<size_t>(width) * height);
+    for (int row = 0; row < height; ++row) {
+        const uint8_t* pixel = rgba + (static_cast<size_t>(y + row) * stride + x) * 4;
+        uint16_t* binRow = bins.data() + static_cast<size_t>(row) * width;
+        for (int col = 0; col < width; ++col, pixel += 4) {
+            const int bin = binOf(pixel);
+            binRow[col] = static_cast<uint16_t>(bin);
+            ++counts[bin];
+        }
+    }
+
+    std::vector<int> usedBins;
+    for (int bin = 0; bin < BIN_COUNT; ++bin) {
+        if (counts[bin] > 0) usedBins.push_back(bin);
+    }
+
+    // 用到的桶不超过256个时每个桶单独成一个盒子，否则每次切开像素最多、还能再分的盒子
+    std::vector<ColorBox> boxes;
+    if (usedBins.size() <= static_cast<size_t>(MAX_COLORS)) {
+        for (size_t i = 0; i < usedBins.size(); ++i) {
+            boxes.push_back({static_cast<int>(i), static_cast<int>(i) + 1, counts[usedBins[i]]});
+        }
+    } else {
+        boxes.push_back({0, static_cast<int>(usedBins.size()), static_cast<uint64_t>(width) * height});
+        std::vector<int> sorted(usedBins.size());
+        while (boxes.size() < static_cast<size_t>(MAX_COLORS)) {
+            int target = -1;
+            for (size_t i = 0; i < boxes.size(); ++i) {
+                if (boxes[i].end - boxes[i].begin < 2) continue;
+                if (target < 0 || boxes[i].population > boxes[target].population) target = static_cast<int>(i);
+            }
+            if (target < 0) break;
+            ColorBox& box = boxes[target];
+
+            // 沿跨度最大的通道排序，在像素数的中位处切开
+            int axis = 0;
+            int bestRange = -1;
+            for (int a = 0; a < 3; ++a) {
+                int low = 31, high = 0;
+                for (int i = box.begin; i < box.end; ++i) {
+                    const int value = binChannel(usedBins[i], a);
+                    low = std::min(low, value);
+                    high = std::max(high, value);
+                }
+                if (high - low > bestRange) {
+                    bestRange = high - low;
+                    axis = a;
+                }
+            }
+            // 通道值只有32种，用计数排序把盒子里的桶按这个通道排好
+            std::array<int, 33> offsets = {};
+            for (int i = box.begin; i < box.end; ++i) {
+                ++offsets[binChannel(usedBins[i], axis) + 1];
+            }
+            for (int v = 0; v < 32; ++v) {
+                offsets[v + 1] += offsets[v];
+            }
+            for (int i = box.begin; i < box.end; ++i) {
+                sorted[box.begin + offsets[binChannel(usedBins[i], axis)]++] = usedBins[i];
+            }
+            std::copy(sorted.begin() + box.begin, sorted.begin() + box.end, usedBins.begin() + box.begin);
+            uint64_t half = 0;
+            int split = box.begin + 1;
+            for (int i = box.begin; i < box.end - 1; ++i) {
+                half += counts[usedBins[i]];
+                split = i + 1;
+                if (half * 2 >= box.population) break;
+            }
+            const ColorBox upper = {split, box.end, box.population - half};
+            box.end = split;
+            box.population = half;
+            boxes.push_back(upper);
+        }
+    }
+
+    std::vector<uint8_t> binToIndex(BIN_COUNT, 0);
+    for (size_t b = 0; b < boxes.size(); ++b) {
+        for (int i = boxes[b].begin; i < boxes[b].end; ++i) {
+            binToIndex[usedBins[i]] = static_cast<uint8_t>(b);
+        }
+    }
+
+    // 每种颜色取落在其中的像素的平均值：只用到少量颜色时（棋盘的纯色块）与原色完全一致
+    std::array<uint64_t, MAX_COLORS * 3> sums = {};
+    out.colorCount = static_cast<int>(boxes.size());
+    out.indices.resize(bins.size());
+    for (int row = 0; row < height; ++row) {
+        const uint8_t* pixel = rgba + (static_cast<size_t>(y + row) * stride + x) * 4;
+        const size_t base = static_cast<size_t>(row) * width;
+        for (int col = 0; col < width; ++col, pixel += 4) {
+            const uint8_t index = binToIndex[bins[base + col]];
+            out.indices[base + col] = index;
+            sums[index * 3] += pixel[0];
+            sums[index * 3 + 1] += pixel[1];
+            sums[index * 3 + 2] += pixel[2];
+        }
+    }
+    out.palette.assign(static_cast<size_t>(out.colorCount) * 3, 0);
+    for (size_t b = 0; b < boxes.size(); ++b) {
+        const uint64_t total = std::max<uint64_t>(1, boxes[b].population);
+        for (int a = 0; a < 3; ++a) {
+            out.palette[b * 3 + a] = static_cast<uint8_t>((sums[b * 3 + a] + total / 2) / total);
+        }
+    }
+}
+
+void lzwEncode(const std::vector<uint8_t>& indices, int minCodeSize, std::vector<uint8_t>& out) {
+    out.push_back(static_cast<uint8_t>(minCodeSize));
+    CodeWriter writer(out);
+
+    const int clearCode = 1 << minCodeSize;
+    // 字典用开放寻址的哈希表：键是 (前缀码 << 8 | 下一个下标) + 1，0 表示空位
+    std::vector<int32_t> keys(1 << HASH_BITS, 0);
+    std::vector<uint16_t> codes(1 << HASH_BITS, 0);
+    const uint32_t mask = (1u << HASH_BITS) - 1;
+
+    int codeSize = minCodeSize + 1;
+    int maxCode = clearCode + 1;
+    int current = -1;
+    writer.write(clearCode, codeSize);
+    for (const uint8_t value : indices) {
+        if (current < 0) {
+            current = value;
+            continue;
+        }
+        const int32_t key = ((current << 8) | value) + 1;
+        uint32_t slot = (static_cast<uint32_t>(key) * 2654435761u) >> (32 - HASH_BITS);
+        while (keys[slot] != 0 && keys[slot] != key) {
+            slot = (slot + 1) & mask;
+        }
+        if (keys[slot] == key) {
+            current = codes[slot];
+            continue;
+        }
+
+        writer.write(current, codeSize);
+        keys[slot] = key;
+        codes[slot] = static_cast<uint16_t>(++maxCode);
+        if (maxCode >= (1 << codeSize)) ++codeSize;
+        if (maxCode == MAX_CODE) {
+            // 字典满了：发清除码从头开始
+            writer.write(clearCode, codeSize);
+            std::fill(keys.begin(), keys.end(), 0);
+            codeSize = minCodeSize + 1;
+            maxCode = clearCode + 1;
+        }
+        current = value;
+    }
+    if (current >= 0) writer.write(current, codeSize);
+    writer.write(clearCode + 1, codeSize);
+    writer.finish();
+}
+
+GifEncoder::GifEncoder(unsigned threads)
+    : width(0),
+      height(0),
+      file(nullptr),
+      failed(false),
+      maxInFlight(std::max(1u, threads) * 2 + 2),
+      quit(false) {
+    for (unsigned i = 0; i < std::max(1u, threads); ++i) {
+        workers.emplace_back(&GifEncoder::workerLoop, this);
+    }
+}
+
+GifEncoder::~GifEncoder() {
+    close();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        quit = true;
+    }
+    jobReady.notify_all();
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+bool GifEncoder::open(const std::string& filename, int frameWidth, int frameHeight) {
+    close();
+    file = std::fopen(filename.c_str(), "wb");
+    if (!file) {
+        std::cerr << "Failed to create " << filename << std::endl;
+        return false;
+    }
+    width = frameWidth;
+    height = frameHeight;
+    failed = false;
+    lastPixels.reset();
+    counters = Stats();
+
+    // 文件头、逻辑屏幕（不用全局调色板，每帧自带）和无限循环的 NETSCAPE2.0 扩展
+    std::vector<uint8_t> header = {'G', 'I', 'F', '8', '9', 'a'};
+    putShort(header, width);
+    putShort(header, height);
+    header.insert(header.end(), {0x00, 0x00, 0x00});
+    header.insert(header.end(), {0x21, 0xFF, 0x0B, 'N', 'E', 'T', 'S', 'C', 'A', 'P', 'E', '2', '.', '0',
+                                 0x03, 0x01, 0x00, 0x00, 0x00});
+    if (std::fwrite(header.data(), 1, header.size(), file) != header.size()) failed = true;
+    counters.bytes += header.size();
+    return !failed;
+}
+
+bool GifEncoder::addFrame(Pixels pixels, uint16_t delay) {
+    if (!file || failed) return false;
+    std::shared_ptr<Job> job(new Job());
+    job->pixels = pixels;
+    job->previous = lastPixels;
+    job->delay = delay;
+    lastPixels = pixels;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending.push_back(job);
+        inFlight.push_back(job);
+    }
+    jobReady.notify_one();
+
+    // 已经编完的帧顺手写出；排队的帧太多时等最早的一帧
+    while (true) {
+        size_t count;
+        bool frontDone;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            count = inFlight.size();
+            frontDone = count > 0 && inFlight.front()->done;
+        }
+        if (count == 0 || (!frontDone && count <= maxInFlight)) break;
+        if (!writeOldest()) return false;
+    }
+    return true;
+}
+
+bool GifEncoder::close() {
+    if (!file) return false;
+    while (true) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (inFlight.empty()) break;
+        }
+        if (!writeOldest()) break;
+    }
+    const uint8_t trailer = 0x3B;
+    if (std::fwrite(&trailer, 1, 1, file) != 1) failed = true;
+    counters.bytes += 1;
+    if (std::fclose(file) != 0) failed = true;
+    file = nullptr;
+    lastPixels.reset();
+
+    // 写入失败时还有没写出的帧：没开始编码的直接丢掉，正在编码的等它结束
+    std::unique_lock<std::mutex> lock(mutex);
+    for (const std::shared_ptr<Job>& job : pending) {
+        job->done = true;
+    }
+    pending.clear();
+    jobDone.wait(lock, [this] {
+        return std::all_of(inFlight.begin(), inFlight.end(), [](const std::shared_ptr<Job>& job) { return job->done; });
+    });
+    inFlight.clear();
+    return !failed;
+}
+
+bool GifEncoder::writeOldest() {
+    std::shared_ptr<Job> job;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        jobDone.wait(lock, [this] { return inFlight.front()->done; });
+        job = inFlight.front();
+        inFlight.pop_front();
+    }
+
+    // 图形控制扩展：保留上一帧（只覆盖变化的矩形），显示 delay 个百分之一秒
+    const uint8_t control[] = {0x21, 0xF9, 0x04, 0x04, static_cast<uint8_t>(job->delay & 0xFF),
+                               static_cast<uint8_t>(job->delay >> 8), 0x00, 0x00};
+    if (std::fwrite(control, 1, sizeof(control), file) != sizeof(control) ||
+        std::fwrite(job->encoded.data(), 1, job->encoded.size(), file) != job->encoded.size()) {
+        std::cerr << "Failed to write GIF frame" << std::endl;
+        failed = true;
+        return false;
+    }
+    ++counters.frames;
+    counters.bytes += sizeof(control) + job->encoded.size();
+    counters.encodedPixels += job->encodedPixels;
+    return true;
+}
+
+void GifEncoder::workerLoop() {
+    while (true) {
+        std::shared_ptr<Job> job;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            jobReady.wait(lock, [this] { return quit || !pending.empty(); });
+            if (quit && pending.empty()) return;
+            job = pending.front();
+            pending.pop_front();
+        }
+        encodeJob(*job);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            job->done = true;
+            // 编码结果已经在 encoded 里，画面不再需要
+            job->pixels.reset();
+            job->previous.reset();
+        }
+        jobDone.notify_all();
+    }
+}
+
+void GifEncoder::encodeJob(Job& job) const {
+    const uint32_t* current = reinterpret_cast<const uint32_t*>(job.pixels->data());
+    int left = 0, top = 0, right = width - 1, bottom = height - 1;
+
+    // 与上一帧比较，只编码包住所有变化像素的矩形
+    if (job.previous) {
+        const uint32_t* previous = reinterpret_cast<const uint32_t*>(job.previous->data());
+        auto rowDiffers = [&](int row) {
+            return std::memcmp(current + static_cast<size_t>(row) * width, previous + static_cast<size_t>(row) * width,
+                               static_cast<size_t>(width) * 4) != 0;
+        };
+        while (top < height && !rowDiffers(top)) ++top;
+        if (top == height) {
+            // 完全相同的画面，编一个像素占位
+            top = bottom = left = right = 0;
+        } else {
+            while (!rowDiffers(bottom)) --bottom;
+            left = width;
+            right = -1;
+            for (int row = top; row <= bottom; ++row) {
+                const uint32_t* a = current + static_cast<size_t>(row) * width;
+                const uint32_t* b = previous + static_cast<size_t>(row) * width;
+                int x = 0;
+                while (x < left && a[x] == b[x]) ++x;
+                left = std::min(left, x);
+                x = width - 1;
+                while (x > right && a[x] == b[x]) --x;
+                right = std::max(right, x);
+            }
+        }
+    }
+    const int regionWidth = right - left + 1;
+    const int regionHeight = bottom - top + 1;
+
+    QuantizedImage image;
+    quantizeImage(job.pixels->data(), width, left, top, regionWidth, regionHeight, image);
+    int tableBits = 1;
+    while ((1 << tableBits) < image.colorCount) ++tableBits;
+
+    std::vector<uint8_t>& out = job.encoded;
+    out.reserve(static_cast<size_t>(regionWidth) * regionHeight / 2 + 1024);
+    out.push_back(0x2C);
+    putShort(out, left);
+    putShort(out, top);
+    putShort(out, regionWidth);
+    putShort(out, regionHeight);
+    out.push_back(static_cast<uint8_t>(0x80 | (tableBits - 1)));   // 局部调色板
+    out.insert(out.end(), image.palette.begin(), image.palette.end());
+    out.insert(out.end(), static_cast<size_t>((1 << tableBits) - image.colorCount) * 3, 0);
+    lzwEncode(image.indices, std::max(2, tableBits), out);
+    job.encodedPixels = static_cast<uint64_t>(regionWidth) * regionHeight;
+}
@@ -0,0 +1,90 @@
+#ifndef GIF_ENCODER_H
+#define GIF_ENCODER_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// 量化后的一块画面：最多256色的调色板和每个像素的下标
+struct QuantizedImage {
+    std::vector<uint8_t> palette;   // RGB，每色3字节
+    std::vector<uint8_t> indices;
+    int colorCount = 0;
+};
+
+// 把 RGBA 画面中 (x, y, width, height) 这一块量化到最多 256 色。
+// 颜色先按每通道5位归到 32768 个桶里：用到的桶不超过256个时每个桶就是一种颜色，
+// 否则对桶做中位切分。每个像素直接查它所在桶的下标，不需要逐像素找最近的颜色。
+void quantizeImage(const uint8_t* rgba, int stride, int x, int y, int width, int height, QuantizedImage& out);
+
+// GIF 的变长 LZW 压缩，输出已经切成不超过255字节的数据子块（含结尾的0长度块）
+void lzwEncode(const std::vector<uint8_t>& indices, int minCodeSize, std::vector<uint8_t>& out);
+
+// 动画GIF编码器：调用线程按顺序提交整帧 RGBA 画面，工作线程并行做差异裁剪、量化和 LZW 压缩，
+// 编好的帧再按提交顺序写进文件。同时在编码的帧数有上限，超过时 addFrame 先写出最早的一帧，
+// 内存占用与动画长度无关。每帧只编码与上一帧不同的矩形区域（上一帧保留不清除），
+// 相同的连续画面由调用方合并成一帧（延长显示时间）。
+class GifEncoder {
+public:
+    using Pixels = std::shared_ptr<const std::vector<uint8_t>>;
+
+    struct Stats {
+        uint64_t frames = 0;
+        uint64_t bytes = 0;
+        uint64_t encodedPixels = 0;   // 裁剪后实际编码的像素数
+    };
+
+    explicit GifEncoder(unsigned threads);
+    ~GifEncoder();
+
+    GifEncoder(const GifEncoder&) = delete;
+    GifEncoder& operator=(const GifEncoder&) = delete;
+
+    bool open(const std::string& filename, int width, int height);
+    // pixels 是 width x height 的 RGBA，提交后不能再修改；delay 单位为百分之一秒
+    bool addFrame(Pixels pixels, uint16_t delay);
+    // 等所有帧编完写出，关闭文件
+    bool close();
+    bool isOpen() const { return file != nullptr; }
+
+    const Stats& stats() const { return counters; }
+
+private:
+    struct Job {
+        Pixels pixels;
+        Pixels previous;    // 上一帧，为空表示第一帧
+        uint16_t delay = 0;
+        std::vector<uint8_t> encoded;   // 图像描述符、局部调色板和压缩数据
+        uint64_t encodedPixels = 0;
+        bool done = false;
+    };
+
+    void workerLoop();
+    void encodeJob(Job& job) const;
+    // 等最早提交的一帧编完并写出
+    bool writeOldest();
+
+    int width;
+    int height;
+    FILE* file;
+    bool failed;
+    Pixels lastPixels;
+    Stats counters;
+
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable jobReady;
+    std::condition_variable jobDone;
+    std::deque<std::shared_ptr<Job>> pending;     // 还没被工作线程取走的
+    std::deque<std::shared_ptr<Job>> inFlight;    // 按提交顺序，等待写出
+    size_t maxInFlight;
+    bool quit;
+};
+
+#endif // GIF_ENCODER_H
@@ -2,6 +2,7 @@
 #include <iostream>
 #include <cstring>
 #include <algorithm>
+#include <functional>
 #include <vector>
 #include <unordered_map>
 
@@ -12,6 +13,10 @@ const uint8_t EXTENSION_INTRODUCER = 0x21;
 const uint8_t GRAPHIC_CONTROL_LABEL = 0xF9;
 const uint8_t TRAILER = 0x3B;
 
+// 过短的帧延迟按常见浏览器的做法当作100毫秒
+const uint32_t MIN_FRAME_DELAY_MS = 20;
+const uint32_t SHORT_FRAME_DELAY_MS = 100;
+
 struct GifWrapper::GifData {
     std::vector<uint8_t> buffer;
     size_t position = 0;
@@ -21,7 +26,7 @@ struct GifWrapper::GifData {
     float defaultDelay = 0.1f; // 默认帧延迟（秒）
 };
 
-GifWrapper::GifWrapper() : currentFrame(0), looping(true), animated(false), 
+GifWrapper::GifWrapper() : useMipmaps(false), levelsDirty(false), currentFrame(0), looping(true), totalDuration(0), startTime(0), animated(false), 
                          backgroundColorOverride(sf::Color::Transparent), useBackgroundOverride(false) {
     gifData = std::make_unique<GifData>();
 }
@@ -32,9 +37,14 @@ GifWrapper::~GifWrapper() {
 
 GifWrapper::GifWrapper(GifWrapper&& other) noexcept
     : frames(std::move(other.frames)),
+      levelSizes(std::move(other.levelSizes)),
+      useMipmaps(other.useMipmaps),
+      levelsDirty(other.levelsDirty),
       currentFrame(other.currentFrame),
       looping(other.looping),
-      frameClock(other.frameClock),
+      frameEnds(std::move(other.frameEnds)),
+      totalDuration(other.totalDuration),
+      startTime(other.startTime),
       animated(other.animated),
       backgroundColorOverride(other.backgroundColorOverride),
       useBackgroundOverride(other.useBackgroundOverride),
@@ -44,9 +54,14 @@ GifWrapper::GifWrapper(GifWrapper&& other) noexcept
 GifWrapper& GifWrapper::operator=(GifWrapper&& other) noexcept {
     if (this != &other) {
         frames = std::move(other.frames);
+        levelSizes = std::move(other.levelSizes);
+        useMipmaps = other.useMipmaps;
+        levelsDirty = other.levelsDirty;
         currentFrame = other.currentFrame;
         looping = other.looping;
-        frameClock = other.frameClock;
+        frameEnds = std::move(other.frameEnds);
+        totalDuration = other.totalDuration;
+        startTime = other.startTime;
         animated = other.animated;
         backgroundColorOverride = other.backgroundColorOverride;
         useBackgroundOverride = other.useBackgroundOverride;
@@ -192,9 +207,11 @@ bool GifWrapper::loadFromFile(const std::string& filename, const sf::Color& back
     
     // 清除现有数据
     frames.clear();
+    levelSizes.clear();
+    frameEnds.clear();
+    totalDuration = 0;
     currentFrame = 0;
     animated = false;
-    frameClock.restart();
 
     // 打开文件
     FILE* file = fopen(filename.c_str(), "rb");
@@ -354,8 +371,7 @@ bool GifWrapper::loadFromFile(const std::string& filename, const sf::Color& back
 
             // 创建帧
             GifFrame frame;
-            frame.texture.create(width, height);
-            frame.texture.update(frameImage);
+            frame.image = frameImage;
             frame.delay = frameDelay;
             frames.push_back(frame);
 
@@ -406,38 +422,126 @@ bool GifWrapper::loadFromFile(const std::string& filename, const sf::Color& back
     // 如果没有帧，创建一个默认帧
     if (frames.empty()) {
         GifFrame frame;
-        frame.texture.create(width, height);
-        frame.texture.update(baseImage);
+        frame.image = baseImage;
         frame.delay = gifData->defaultDelay;
         frames.push_back(frame);
     }
 
+    // 纹理等第一次取帧时再生成，加载后紧接着 setLevelSizes 也只上传一次
+    levelsDirty = true;
+    buildTimeline();
     return true;
 }
 
-void GifWrapper::updateFrame() {
-    if (frames.empty() || !animated) return;
+void GifWrapper::setLevelSizes(std::vector<unsigned> sizes, bool mipmaps) {
+    if (frames.empty()) return;
+
+    // 比原图还大的尺寸都由原尺寸一级代替
+    const sf::Vector2u native = frames[0].image.getSize();
+    const unsigned nativeSize = std::max(native.x, native.y);
+    for (unsigned& size : sizes) {
+        size = std::min(size, nativeSize);
+    }
+    std::sort(sizes.begin(), sizes.end(), std::greater<unsigned>());
+    sizes.erase(std::unique(sizes.begin(), sizes.end()), sizes.end());
+    sizes.erase(std::remove(sizes.begin(), sizes.end(), 0u), sizes.end());
 
-    float elapsed = frameClock.getElapsedTime().asSeconds();
-    if (elapsed >= frames[currentFrame].delay) {
-        frameClock.restart();
-        if (looping || currentFrame + 1 < frames.size()) {
-            currentFrame = (currentFrame + 1) % frames.size();
+    levelSizes = sizes;
+    useMipmaps = mipmaps;
+    levelsDirty = true;
+}
+
+void GifWrapper::buildLevels() {
+    levelsDirty = false;
+    if (frames.empty()) return;
+
+    const sf::Vector2u native = frames[0].image.getSize();
+    if (levelSizes.empty()) {
+        levelSizes.push_back(std::max(native.x, native.y));
+    }
+
+    for (GifFrame& frame : frames) {
+        frame.levels.clear();
+        frame.levels.resize(levelSizes.size());
+        for (size_t level = 0; level < levelSizes.size(); ++level) {
+            const unsigned width = std::min(levelSizes[level], native.x);
+            const unsigned height = std::min(levelSizes[level], native.y);
+            sf::Texture& texture = frame.levels[level];
+            if (width == native.x && height == native.y) {
+                texture.loadFromImage(frame.image);
+            } else {
+                texture.loadFromImage(resampleImage(frame.image, width, height));
+            }
+            texture.setSmooth(true);
+            if (useMipmaps) {
+                texture.generateMipmap();
+            }
         }
     }
 }
 
+void GifWrapper::buildTimeline() {
+    frameEnds.resize(frames.size());
+    uint32_t end = 0;
+    for (size_t i = 0; i < frames.size(); ++i) {
+        uint32_t delayMs = static_cast<uint32_t>(frames[i].delay * 1000.0f + 0.5f);
+        if (delayMs < MIN_FRAME_DELAY_MS) {
+            delayMs = SHORT_FRAME_DELAY_MS;
+        }
+        end += delayMs;
+        frameEnds[i] = end;
+    }
+    totalDuration = end;
+}
+
+size_t GifWrapper::frameAt(uint32_t nowMs) const {
+    if (!animated || totalDuration == 0) return 0;
+
+    uint32_t t = nowMs - startTime;
+    if (looping) {
+        t %= totalDuration;
+    } else if (t >= totalDuration) {
+        return frames.size() - 1;
+    }
+    // 第一个结束时刻大于 t 的帧
+    return std::upper_bound(frameEnds.begin(), frameEnds.end(), t) - frameEnds.begin();
+}
+
+void GifWrapper::updateFrame(uint32_t nowMs) {
+    currentFrame = frameAt(nowMs);
+}
+
+static sf::Texture& emptyFrameTexture() {
+    static sf::Texture emptyTexture;
+    if (emptyTexture.getSize().x == 0) {
+        sf::Image img;
+        img.create(64, 64, sf::Color(128, 128, 128, 255));
+        emptyTexture.loadFromImage(img);
+    }
+    return emptyTexture;
+}
+
 sf::Texture& GifWrapper::getCurrentFrame() {
     if (frames.empty()) {
-        static sf::Texture emptyTexture;
-        if (emptyTexture.getSize().x == 0) {
-            sf::Image img;
-            img.create(64, 64, sf::Color(128, 128, 128, 255));
-            emptyTexture.loadFromImage(img);
+        return emptyFrameTexture();
+    }
+    if (levelsDirty) buildLevels();
+    return frames[currentFrame].levels[0];
+}
+
+const sf::Texture& GifWrapper::getCurrentFrame(unsigned pixelSize) {
+    if (frames.empty()) {
+        return emptyFrameTexture();
+    }
+    if (levelsDirty) buildLevels();
+    // levelSizes 从大到小，从最小一级往上找第一个够大的
+    const std::vector<sf::Texture>& levels = frames[currentFrame].levels;
+    for (size_t level = levelSizes.size(); level-- > 0;) {
+        if (levelSizes[level] >= pixelSize) {
+            return levels[level];
         }
-        return emptyTexture;
     }
-    return frames[currentFrame].texture;
+    return levels[0];
 }
 
 void GifWrapper::setLooping(bool loop) {
@@ -448,9 +552,9 @@ bool GifWrapper::isLooping() const {
     return looping;
 }
 
-void GifWrapper::reset() {
+void GifWrapper::reset(uint32_t nowMs) {
     currentFrame = 0;
-    frameClock.restart();
+    startTime = nowMs;
 }
 
 bool GifWrapper::isAnimated() const {
@@ -462,6 +566,84 @@ float GifWrapper::getFrameDelay() const {
     return frames[currentFrame].delay;
 }
 
+namespace {
+
+// 一维面积加权：每个输出像素覆盖 [o*scale, (o+1)*scale) 的源像素区间，按重叠长度取权重
+struct ResampleTap {
+    unsigned index;
+    float weight;
+};
+
+std::vector<std::vector<ResampleTap>> buildResampleTaps(unsigned sourceSize, unsigned targetSize) {
+    std::vector<std::vector<ResampleTap>> taps(targetSize);
+    const float scale = static_cast<float>(sourceSize) / targetSize;
+    for (unsigned o = 0; o < targetSize; ++o) {
+        const float begin = o * scale;
+        const float end = std::min((o + 1) * scale, static_cast<float>(sourceSize));
+        for (unsigned i = static_cast<unsigned>(begin); i < sourceSize && i < end; ++i) {
+            const float overlap = std::min(end, i + 1.0f) - std::max(begin, static_cast<float>(i));
+            if (overlap > 0.0f) {
+                taps[o].push_back({i, overlap / scale});
+            }
+        }
+    }
+    return taps;
+}
+
+} // namespace
+
+sf::Image resampleImage(const sf::Image& source, unsigned width, unsigned height) {
+    const sf::Vector2u sourceSize = source.getSize();
+    sf::Image result;
+    if (width == 0 || height == 0 || sourceSize.x == 0 || sourceSize.y == 0) {
+        return result;
+    }
+    width = std::min(width, sourceSize.x);
+    height = std::min(height, sourceSize.y);
+
+    const auto tapsX = buildResampleTaps(sourceSize.x, width);
+    const auto tapsY = buildResampleTaps(sourceSize.y, height);
+    const sf::Uint8* pixels = source.getPixelsPtr();
+
+    // 先横向缩小到 width x 源高度，颜色按透明度预乘，避免透明像素的颜色渗到边缘
+    std::vector<float> rows(static_cast<size_t>(width) * sourceSize.y * 4, 0.0f);
+    for (unsigned y = 0; y < sourceSize.y; ++y) {
+        for (unsigned x = 0; x < width; ++x) {
+            float* out = &rows[(static_cast<size_t>(y) * width + x) * 4];
+            for (const ResampleTap& tap : tapsX[x]) {
+                const sf::Uint8* in = &pixels[(static_cast<size_t>(y) * sourceSize.x + tap.index) * 4];
+                const float alpha = in[3] / 255.0f;
+                out[0] += in[0] * alpha * tap.weight;
+                out[1] += in[1] * alpha * tap.weight;
+                out[2] += in[2] * alpha * tap.weight;
+                out[3] += in[3] * tap.weight;
+            }
+        }
+    }
+
+    // 再纵向缩小并还原为非预乘颜色
+    std::vector<sf::Uint8> output(static_cast<size_t>(width) * height * 4);
+    for (unsigned y = 0; y < height; ++y) {
+        for (unsigned x = 0; x < width; ++x) {
+            float sum[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+            for (const ResampleTap& tap : tapsY[y]) {
+                const float* in = &rows[(static_cast<size_t>(tap.index) * width + x) * 4];
+                for (int c = 0; c < 4; ++c) sum[c] += in[c] * tap.weight;
+            }
+            sf::Uint8* out = &output[(static_cast<size_t>(y) * width + x) * 4];
+            const float alpha = sum[3] / 255.0f;
+            for (int c = 0; c < 3; ++c) {
+                float value = alpha > 0.0f ? sum[c] / alpha : 0.0f;
+                out[c] = static_cast<sf::Uint8>(std::min(255.0f, value + 0.5f));
+            }
+            out[3] = static_cast<sf::Uint8>(std::min(255.0f, sum[3] + 0.5f));
+        }
+    }
+
+    result.create(width, height, output.data());
+    return result;
+}
+
 bool loadGif(const std::string& filename, sf::Texture& texture) {
     GifWrapper wrapper;
     if (wrapper.loadFromFile(filename)) {
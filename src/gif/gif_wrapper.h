@@ -2,15 +2,20 @@
 #define GIF_WRAPPER_H
 
 #include <SFML/Graphics.hpp>
+#include <cstdint>
 #include <string>
 #include <vector>
 #include <memory>
 
 struct GifFrame {
-    sf::Texture texture;
+    sf::Image image;                  // 解码后的原始帧，保留在内存里以便按新尺寸重新生成纹理
+    std::vector<sf::Texture> levels;  // 各级纹理，与 GifWrapper 的 levelSizes 一一对应
     float delay;  // 帧延迟（秒）
 };
 
+// 高质量缩小（按面积加权平均，预乘透明度），只用于缩小，放大交给显卡的平滑过滤
+sf::Image resampleImage(const sf::Image& source, unsigned width, unsigned height);
+
 class GifWrapper {
 public:
     GifWrapper();
@@ -26,19 +31,36 @@ public:
 
     bool loadFromFile(const std::string& filename);
     bool loadFromFile(const std::string& filename, const sf::Color& backgroundColor);
-    void updateFrame();
+    // 所有GIF由同一条时间线驱动：传入时间线上的当前时刻（毫秒），
+    // 当前帧由帧延迟的前缀和二分查找得到，与调用频率无关，卡顿后也不会累积误差
+    void updateFrame(uint32_t nowMs);
+    // 某一时刻应显示的帧，不修改状态（录制画面时可以直接指定时刻）
+    size_t frameAt(uint32_t nowMs) const;
+    // 各级纹理在加载或改尺寸后第一次取帧时才生成（之前取到的纹理引用随之失效）
     sf::Texture& getCurrentFrame();
+    // 最接近显示尺寸的一级：不小于 pixelSize 的最小一级，都比它小时取最大一级
+    const sf::Texture& getCurrentFrame(unsigned pixelSize);
+    // 按实际需要的显示边长缩小各级纹理（原图更小的方向保持原尺寸），可选再生成 mipmap；
+    // 不调用时只有原尺寸一级。只记下尺寸，纹理留到下次取帧时生成
+    void setLevelSizes(std::vector<unsigned> sizes, bool mipmaps);
     void setLooping(bool loop);
     bool isLooping() const;
-    void reset();
+    // 从时刻 nowMs 开始重新播放
+    void reset(uint32_t nowMs);
     bool isAnimated() const;
     float getFrameDelay() const;
+    uint32_t getTotalDuration() const { return totalDuration; }
 
 private:
     std::vector<GifFrame> frames;
+    std::vector<unsigned> levelSizes;   // 各级边长，从大到小
+    bool useMipmaps;
+    bool levelsDirty;                   // 帧或尺寸变了，纹理还没重新生成
     size_t currentFrame;
     bool looping;
-    sf::Clock frameClock;
+    std::vector<uint32_t> frameEnds;   // 每帧结束时刻（毫秒，帧延迟的前缀和）
+    uint32_t totalDuration;
+    uint32_t startTime;
     bool animated;
     sf::Color backgroundColorOverride;
     bool useBackgroundOverride;
@@ -51,6 +73,8 @@ private:
     bool readColorTable(FILE* file, int size, std::vector<sf::Color>& colorTable);
     bool readImageData(FILE* file, sf::Image& image, const std::vector<sf::Color>& colorTable);
     void clearGifData();
+    void buildTimeline();
+    void buildLevels();
 };
 
 bool loadGif(const std::string& filename, sf::Texture& texture);
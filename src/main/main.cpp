@@ -1,7 +1,38 @@
 #include "../game/Game2048.h"
+#include <cstdlib>
+#include <string>
 
-int main() {
-    Game game;
+int main(int argc, char* argv[]) {
+    std::string replayFile;
+    size_t startMove = 0;
+    bool fullscreen = false;
+    std::string botName;
+    
+    // 用法: startGame [--fullscreen] [--replay 文件] [--goto 步数] [--bot 共享内存名]
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--replay" && i + 1 < argc) {
+            replayFile = argv[++i];
+        } else if (arg == "--goto" && i + 1 < argc) {
+            startMove = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--fullscreen") {
+            fullscreen = true;
+        } else if (arg == "--bot" && i + 1 < argc) {
+            botName = argv[++i];
+        } else {
+            std::cerr << "未知参数: " << arg << std::endl;
+            std::cerr << "用法: " << argv[0] << " [--fullscreen] [--replay 文件] [--goto 步数] [--bot 共享内存名]" << std::endl;
+            return 1;
+        }
+    }
+    
+    Game game(fullscreen);
+    if (!replayFile.empty() && !game.startReplay(replayFile, startMove)) {
+        return 1;
+    }
+    if (!botName.empty() && !game.startBot(botName)) {
+        return 1;
+    }
     game.run();
     return 0;
 }
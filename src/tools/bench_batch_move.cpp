@@ -0,0 +1,155 @@
+#include "../core/BoardBatch.h"
+#include "../core/BoardEngine.h"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// 批量移动的正确性检查和基准测试：随机生成一批局面，
+// 先确认每种实现的结果（棋盘、得分、是否变化）与逐个调用 Board::move 完全相同，
+// 再比较每秒能移动多少个棋盘。按尺寸和版本特化的 BoardRules 也一起比较（包括结束判断）。
+
+namespace {
+
+// 随机局面：大约六成的格子有方块，指数偏小，相邻相等的情况足够多
+Board randomBoard(int n, Rng& rng) {
+    Board board(n);
+    for (int cell = 0; cell < n * n; ++cell) {
+        if (rng.bounded(10) < 6) {
+            board.setExponent(cell, static_cast<uint8_t>(1 + rng.bounded(4) + rng.bounded(4)));
+        }
+    }
+    return board;
+}
+
+template <class Fn>
+double boardsPerSecond(int boardCount, int rounds, Fn&& moveOnce) {
+    double seconds = 0.0;
+    for (int round = 0; round < rounds; ++round) {
+        seconds += moveOnce();
+    }
+    return seconds > 0.0 ? static_cast<double>(boardCount) * rounds / seconds : 0.0;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    int boardCount = 4096;
+    int rounds = 200;
+
+    // 用法: bench_batch_move [--boards N] [--rounds N]
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--boards" && i + 1 < argc) {
+            boardCount = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--rounds" && i + 1 < argc) {
+            rounds = std::max(1, std::atoi(argv[++i]));
+        } else {
+            std::cerr << "用法: bench_batch_move [--boards N] [--rounds N]" << std::endl;
+            return 1;
+        }
+    }
+
+    const BatchKernel kernels[] = {BatchKernel::SCALAR, BatchKernel::SSE41, BatchKernel::AVX2};
+    std::cout << "本机最快的实现: " << batchKernelName(bestBatchKernel()) << "，每轮 " << boardCount << " 个棋盘" << std::endl;
+
+    bool allMatch = true;
+    Rng rng(2048);
+    for (int n = 4; n <= 6; ++n) {
+        for (GameVersion version : {GameVersion::ORIGINAL, GameVersion::MODIFIED}) {
+            std::vector<Board> boards;
+            for (int i = 0; i < boardCount; ++i) {
+                boards.push_back(randomBoard(n, rng));
+            }
+            BoardBatch pristine(n, boardCount);
+            for (int i = 0; i < boardCount; ++i) {
+                pristine.setBoard(i, boards[i]);
+            }
+
+            std::cout << n << "x" << n << (version == GameVersion::ORIGINAL ? " 经典  " : " 对角线");
+            // 逐个调用 Board::move（棋盘按对象存放）
+            std::vector<Board> work = boards;
+            int directionIndex = 0;
+            const double reference = boardsPerSecond(boardCount, rounds, [&]() {
+                const Direction dir = directionFromIndex(version, directionIndex++);
+                std::copy(boards.begin(), boards.end(), work.begin());
+                const auto start = std::chrono::steady_clock::now();
+                for (Board& board : work) {
+                    MoveResult result;
+                    board.move(dir, result);
+                }
+                return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            });
+            std::cout << std::fixed << std::setprecision(1) << "  Board::move " << reference / 1e6 << " M/s";
+
+            // 特化模板：逐个棋盘调用，和上面只差在 Board::move 换成 rules.move
+            const BoardRules& rules = boardRules(n, version);
+            bool rulesMatch = true;
+            for (int d = 0; d < 4 && rulesMatch; ++d) {
+                const Direction dir = directionFromIndex(version, d);
+                for (int i = 0; i < boardCount && rulesMatch; ++i) {
+                    Board expected = boards[i];
+                    Board actual = boards[i];
+                    MoveResult expectedResult;
+                    MoveResult actualResult;
+                    rulesMatch = expected.move(dir, expectedResult) == rules.move(actual, dir, actualResult, nullptr) &&
+                                 actual == expected && actualResult.scoreGained == expectedResult.scoreGained &&
+                                 rules.isGameOver(actual) == expected.isGameOver(version);
+                }
+            }
+            allMatch = allMatch && rulesMatch;
+            directionIndex = 0;
+            const double specialized = boardsPerSecond(boardCount, rounds, [&]() {
+                const Direction dir = directionFromIndex(version, directionIndex++);
+                std::copy(boards.begin(), boards.end(), work.begin());
+                const auto start = std::chrono::steady_clock::now();
+                for (Board& board : work) {
+                    MoveResult result;
+                    rules.move(board, dir, result, nullptr);
+                }
+                return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            });
+            std::cout << "  特化 " << specialized / 1e6 << " M/s (x" << std::setprecision(2) << specialized / reference
+                      << std::setprecision(1) << ")";
+            if (!rulesMatch) std::cout << " 结果不一致!";
+
+            for (BatchKernel kernel : kernels) {
+                if (!batchKernelAvailable(kernel)) continue;
+
+                // 四个方向都与 Board::move 逐个比对
+                bool match = true;
+                for (int d = 0; d < 4 && match; ++d) {
+                    const Direction dir = directionFromIndex(version, d);
+                    BoardBatch batch = pristine;
+                    batch.move(dir, kernel);
+                    for (int i = 0; i < boardCount && match; ++i) {
+                        Board expected = boards[i];
+                        MoveResult result;
+                        const bool changed = expected.move(dir, result);
+                        match = batch.board(i) == expected && batch.changed(i) == changed &&
+                                batch.scoreGained(i) == static_cast<uint32_t>(result.scoreGained);
+                    }
+                }
+                allMatch = allMatch && match;
+
+                BoardBatch batch = pristine;
+                directionIndex = 0;
+                const double speed = boardsPerSecond(boardCount, rounds, [&]() {
+                    const Direction dir = directionFromIndex(version, directionIndex++);
+                    std::memcpy(batch.lanes(0), pristine.lanes(0), static_cast<size_t>(n) * n * batch.stride());
+                    const auto start = std::chrono::steady_clock::now();
+                    batch.move(dir, kernel);
+                    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                });
+                std::cout << "  " << batchKernelName(kernel) << " " << speed / 1e6 << " M/s (x"
+                          << std::setprecision(2) << speed / reference << std::setprecision(1) << ")";
+                if (!match) std::cout << " 结果不一致!";
+            }
+            std::cout << std::endl;
+        }
+    }
+    return allMatch ? 0 : 1;
+}
@@ -0,0 +1,98 @@
+#include "../core/BotLink.h"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+
+// 通过共享内存接口驱动游戏的示例代理：连接 startGame --bot 打开的接口，每步在合法方向里随机选一个，
+// 一局结束就重开。打印每秒走了多少步，用来检查接口的吞吐量。
+
+int main(int argc, char* argv[]) {
+    std::string name = "/mao_bot";
+    int gridSize = 4;
+    int version = 0;
+    uint32_t renderEvery = 100;
+    int seconds = 10;
+
+    // 用法: bot_random [--name 共享内存名] [--size N] [--version classic|diagonal] [--render-every N] [--seconds N]
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--name" && i + 1 < argc) {
+            name = argv[++i];
+        } else if (arg == "--size" && i + 1 < argc) {
+            gridSize = std::atoi(argv[++i]);
+        } else if (arg == "--version" && i + 1 < argc) {
+            version = std::string(argv[++i]) == "diagonal" ? 1 : 0;
+        } else if (arg == "--render-every" && i + 1 < argc) {
+            renderEvery = static_cast<uint32_t>(std::atoi(argv[++i]));
+        } else if (arg == "--seconds" && i + 1 < argc) {
+            seconds = std::atoi(argv[++i]);
+        } else {
+            std::cerr << "用法: bot_random [--name 共享内存名] [--size N] [--version classic|diagonal]"
+                         " [--render-every N] [--seconds N]" << std::endl;
+            return 1;
+        }
+    }
+
+    BotLink link;
+    if (!link.attach(name)) return 1;
+    link.setRenderEvery(renderEvery);
+
+    uint64_t nextId = 1;
+    // 发出一条命令并等游戏执行完，返回执行后的局面
+    auto execute = [&](BotOp op, uint32_t arg, BotState& state) {
+        BotCommand command;
+        command.op = op;
+        command.arg = arg;
+        command.id = nextId++;
+        while (!link.pushCommand(command)) {
+            std::this_thread::yield();
+        }
+        while (link.readState(state) && state.lastCommand != command.id) {
+            std::this_thread::yield();
+        }
+    };
+
+    BotState state;
+    execute(BotOp::RESET, static_cast<uint32_t>(gridSize | (version << 8)), state);
+
+    uint32_t rng = 0x9E3779B9u;
+    uint64_t moves = 0;
+    uint64_t games = 0;
+    uint64_t totalScore = 0;
+    const auto started = std::chrono::steady_clock::now();
+    auto nextReport = started + std::chrono::seconds(1);
+    const auto deadline = started + std::chrono::seconds(seconds);
+    while (std::chrono::steady_clock::now() < deadline) {
+        if (state.gameOver || state.legalMoves == 0) {
+            ++games;
+            totalScore += state.score;
+            execute(BotOp::RESET, 0, state);
+            continue;
+        }
+        // 在合法方向里均匀地挑一个
+        int choices[4];
+        int count = 0;
+        for (int i = 0; i < 4; ++i) {
+            if (state.legalMoves & (1 << i)) choices[count++] = i;
+        }
+        rng ^= rng << 13;
+        rng ^= rng >> 17;
+        rng ^= rng << 5;
+        execute(BotOp::MOVE, static_cast<uint32_t>(choices[rng % count]), state);
+        ++moves;
+
+        const auto now = std::chrono::steady_clock::now();
+        if (now >= nextReport) {
+            const double elapsed = std::chrono::duration<double>(now - started).count();
+            std::cout << static_cast<int>(elapsed) << "s  " << moves << " 步（" << static_cast<uint64_t>(moves / elapsed)
+                      << " 步/秒）  " << games << " 局";
+            if (games > 0) std::cout << "  平均分 " << totalScore / games;
+            std::cout << std::endl;
+            nextReport += std::chrono::seconds(1);
+        }
+    }
+    link.setRenderEvery(0);
+    return 0;
+}
@@ -0,0 +1,64 @@
+#include "../core/Leaderboard.h"
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+// 把多台机器导出的排行榜文件合并成一个。
+// 每个输入文件本身由若干有序段组成，所有输入的所有段一起做一次k路归并、顺序写出，
+// 内存占用只和段数有关，与记录总数无关。
+int main(int argc, char* argv[]) {
+    std::string output;
+    std::vector<std::string> inputs;
+    bool keepDuplicates = false;
+
+    // 用法: leaderboard_merge -o 输出文件 [--keep-duplicates] 输入文件...
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "-o" && i + 1 < argc) {
+            output = argv[++i];
+        } else if (arg == "--keep-duplicates") {
+            keepDuplicates = true;
+        } else if (!arg.empty() && arg[0] == '-') {
+            std::cerr << "未知参数: " << arg << std::endl;
+            return 1;
+        } else {
+            inputs.push_back(arg);
+        }
+    }
+    if (output.empty() || inputs.empty()) {
+        std::cerr << "用法: " << argv[0] << " -o 输出文件 [--keep-duplicates] 输入文件..." << std::endl;
+        return 1;
+    }
+
+    std::vector<std::unique_ptr<Leaderboard>> boards;
+    LeaderboardStream stream;
+    uint64_t total = 0;
+    for (const std::string& input : inputs) {
+        std::unique_ptr<Leaderboard> board(new Leaderboard());
+        if (!board->openExisting(input)) {
+            return 1;
+        }
+        if (!boards.empty() &&
+            (board->gridSize() != boards[0]->gridSize() || board->version() != boards[0]->version())) {
+            std::cerr << "模式不一致，不能合并: " << input << std::endl;
+            return 1;
+        }
+        for (const LeaderboardRun& run : board->runs()) {
+            stream.addRun(run);
+        }
+        total += board->size();
+        boards.push_back(std::move(board));
+    }
+
+    // 同一条记录可能出现在多份导出里（同一台机器、同一时间、同样的分数），默认只保留一条
+    uint64_t written = 0;
+    if (!Leaderboard::writeSorted(output, boards[0]->gridSize(), boards[0]->version(), stream,
+                                  !keepDuplicates, written)) {
+        return 1;
+    }
+
+    std::cout << "合并了 " << inputs.size() << " 个文件，共 " << total << " 条记录，写出 " << written
+              << " 条到 " << output << std::endl;
+    return 0;
+}
@@ -0,0 +1,79 @@
+#include "../audio/MusicPlayer.h"
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// 不打开声卡检查背景音乐：用空输出按实时速度播放，每秒打印播放进度、欠载次数和缓冲区内存，
+// 可以在没有声卡的机器上确认解码跟得上、切歌的交叉淡化不会造成欠载。
+
+namespace {
+
+// Linux 上进程的峰值常驻内存（KB），其他平台返回0
+long peakResidentKb() {
+#ifdef __linux__
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.compare(0, 6, "VmHWM:") == 0) {
+            return std::atol(line.c_str() + 6);
+        }
+    }
+#endif
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    int seconds = 10;
+    int skipEvery = 0;
+    std::vector<std::string> tracks;
+
+    // 用法: music_check [--seconds N] [--skip-every N] 文件.mp3...
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--seconds" && i + 1 < argc) {
+            seconds = std::atoi(argv[++i]);
+        } else if (arg == "--skip-every" && i + 1 < argc) {
+            skipEvery = std::atoi(argv[++i]);
+        } else if (!arg.empty() && arg[0] == '-') {
+            std::cerr << "未知参数: " << arg << std::endl;
+            return 1;
+        } else {
+            tracks.push_back(arg);
+        }
+    }
+    if (tracks.empty()) {
+        std::cerr << "用法: music_check [--seconds N] [--skip-every N] 文件.mp3..." << std::endl;
+        return 1;
+    }
+
+    const long residentBefore = peakResidentKb();
+    MusicPlayer player;
+    if (!player.start(tracks, MusicPlayer::Sink::NONE)) {
+        return 1;
+    }
+
+    for (int second = 1; second <= seconds; ++second) {
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+        if (skipEvery > 0 && second % skipEvery == 0) {
+            player.nextTrack();
+        }
+        const MusicPlayer::Stats stats = player.stats();
+        std::cout << second << "s  曲目 " << stats.track << "  已播放 " << stats.framesPlayed
+                  << " 帧  欠载 " << stats.underruns << "  缓冲 " << stats.bufferedFrames
+                  << " 帧  缓冲区内存 " << stats.memoryBytes / 1024 << " KB" << std::endl;
+    }
+
+    const MusicPlayer::Stats stats = player.stats();
+    player.stop();
+    const long residentAfter = peakResidentKb();
+    if (residentAfter > 0) {
+        std::cout << "峰值常驻内存增加 " << residentAfter - residentBefore << " KB" << std::endl;
+    }
+    return stats.underruns == 0 ? 0 : 2;
+}
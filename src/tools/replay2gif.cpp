@@ -0,0 +1,394 @@
+#include "../core/Replay.h"
+#include "../game/TileStyle.h"
+#include "../game/TweenPool.h"
+#include "../gif/GifEncoder.h"
+#include "../gif/gif_wrapper.h"
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// 把回放导出成动画GIF，不打开窗口：每一帧画到离屏的 sf::RenderTexture 上，读回内存后交给
+// GifEncoder 的工作线程量化和压缩，主线程接着画下一帧（绘制/读回与量化/压缩流水线并行）。
+// 动画节奏与游戏内回放相同（每步0.35秒，含滑动、弹出和合并动画），可以用 --speed 加快。
+// 一次可以导出很多个回放，字体、方块图片和离屏画布只准备一次。
+
+namespace {
+
+// 与游戏内回放和动画的时长一致（秒）
+constexpr float REPLAY_STEP_INTERVAL = 0.35f;
+constexpr float SLIDE_DURATION = 0.12f;
+constexpr float SPAWN_DURATION = 0.2f;
+constexpr float MERGE_DURATION = 0.15f;
+constexpr float START_HOLD = 0.5f;      // 开局画面停留
+constexpr float END_HOLD = 2.0f;        // 最后一步之后停留
+constexpr int HEADER_HEIGHT = 48;       // 顶部分数栏
+
+struct Options {
+    int boardPixels = 400;
+    int fps = 20;
+    float speed = 1.0f;
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    bool pictures = true;
+    std::string outDir;
+};
+
+// 一次移动里的一个滑动方块
+struct Slide {
+    int fromCell;
+    int toCell;
+    int value;
+    int next;   // 同一格上的下一个方块，-1 表示没有
+};
+
+// 与游戏里的做法相同：按移动计划把每个方块从起点格挂到终点格，
+// 合并后又继续滑动（对角线向下移动）的方块跟着一起走
+void buildSlides(const MovePlan& plan, int cellCount, std::vector<Slide>& slides, std::vector<bool>& merged) {
+    slides.clear();
+    merged.assign(cellCount, false);
+    std::vector<int> cellSlides(cellCount, -1);
+    auto attach = [&](int index, int cell) {
+        slides[index].toCell = cell;
+        slides[index].next = cellSlides[cell];
+        cellSlides[cell] = index;
+    };
+    for (int i = 0; i < plan.count; ++i) {
+        const TileMove& move = plan.moves[i];
+        if (move.merged && cellSlides[move.to] < 0) {
+            slides.push_back({move.to, move.to, 1 << (move.exponent - 1), -1});
+            attach(static_cast<int>(slides.size()) - 1, move.to);
+        }
+        if (cellSlides[move.from] >= 0) {
+            int index = cellSlides[move.from];
+            cellSlides[move.from] = -1;
+            while (index >= 0) {
+                const int next = slides[index].next;
+                attach(index, move.to);
+                index = next;
+            }
+        } else {
+            const int exponent = move.merged ? move.exponent - 1 : move.exponent;
+            slides.push_back({move.from, move.to, 1 << exponent, -1});
+            attach(static_cast<int>(slides.size()) - 1, move.to);
+        }
+        if (merged[move.from]) {
+            merged[move.from] = false;
+            merged[move.to] = true;
+        }
+        if (move.merged) merged[move.to] = true;
+    }
+}
+
+class ReplayRenderer {
+public:
+    explicit ReplayRenderer(const Options& opts) : options(opts), encoder(opts.threads) {
+    }
+
+    bool init() {
+        width = options.boardPixels;
+        height = options.boardPixels + HEADER_HEIGHT;
+        if (!canvas.create(width, height)) {
+            std::cerr << "无法创建离屏画布" << std::endl;
+            return false;
+        }
+        if (!font.loadFromFile("assets/fonts/arial.ttf")) {
+            std::cerr << "无法加载字体 assets/fonts/arial.ttf" << std::endl;
+            return false;
+        }
+        if (options.pictures) {
+            for (int exponent = 1; exponent <= 14; ++exponent) {
+                const int value = 1 << exponent;
+                GifWrapper wrapper;
+                if (wrapper.loadFromFile("assets/picture/" + std::to_string(value) + ".gif", tileColor(value))) {
+                    pictures[value] = std::move(wrapper);
+                }
+            }
+        }
+        return true;
+    }
+
+    bool exportReplay(const std::string& replayFile, const std::string& gifFile) {
+        ReplayPlayer player;
+        if (!player.load(replayFile)) {
+            std::cerr << "无法读取回放: " << replayFile << std::endl;
+            return false;
+        }
+        gridSize = player.header().gridSize;
+        version = player.header().version;
+        step = static_cast<float>(options.boardPixels) / gridSize;
+        margin = std::max(1.0f, step * 0.06f);
+        // 方块图片按这个尺寸的棋盘预先缩小，连续导出同样尺寸的回放时不重复生成
+        const unsigned tilePixels = static_cast<unsigned>(step - 2 * margin);
+        if (tilePixels != pictureSize) {
+            for (auto& entry : pictures) {
+                entry.second.setLevelSizes({tilePixels}, false);
+            }
+            pictureSize = tilePixels;
+        }
+        if (!encoder.open(gifFile, width, height)) return false;
+
+        const auto started = std::chrono::steady_clock::now();
+        delay = static_cast<uint16_t>(std::max(2, (100 + options.fps / 2) / options.fps));
+        frameSeconds = delay / 100.0f;
+        timeline = 0.0f;
+        renderedFrames = 0;
+        held.reset();
+        heldDelay = 0;
+
+        // 开局画面
+        Board board = player.board();
+        slides.clear();
+        merged.assign(board.cellCount(), false);
+        spawnCell = -1;
+        holdFrames(board, player.score(), 0, player.moveCount(), START_HOLD);
+
+        MovePlan plan;
+        const float interval = REPLAY_STEP_INTERVAL / options.speed;
+        while (!player.finished()) {
+            plan.count = 0;
+            if (!player.step(&plan)) break;
+            buildSlides(plan, player.board().cellCount(), slides, merged);
+            spawnCell = player.lastSpawnCell();
+            for (float t = 0.0f; t < interval; t += frameSeconds) {
+                renderFrame(player.board(), player.score(), player.position(), player.moveCount(), t * options.speed);
+            }
+        }
+        slides.clear();
+        merged.assign(player.board().cellCount(), false);
+        spawnCell = -1;
+        holdFrames(player.board(), player.score(), player.position(), player.moveCount(), END_HOLD);
+
+        if (held) encoder.addFrame(held, heldDelay);
+        held.reset();
+        const bool ok = encoder.close();
+
+        const double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+        const double played = renderedFrames * frameSeconds;
+        std::cout << gifFile << ": " << player.moveCount() << " 步, " << renderedFrames << " 帧 -> "
+                  << encoder.stats().frames << " 帧, " << encoder.stats().bytes / 1024 << " KB, " << std::fixed
+                  << std::setprecision(2) << wall << " 秒 (" << std::setprecision(1) << played / std::max(wall, 1e-6)
+                  << " 倍实时)" << std::endl;
+        totalFrames += renderedFrames;
+        totalPlayed += played;
+        return ok;
+    }
+
+    uint64_t frames() const { return totalFrames; }
+    double playedSeconds() const { return totalPlayed; }
+
+private:
+    static sf::Color tileColor(int value) {
+        int index = 0;
+        while ((2 << index) < value) ++index;
+        return tileColorTable()[std::min<size_t>(index, tileColorTable().size() - 1)];
+    }
+
+    sf::Vector2f cellPosition(int cell) const {
+        return sf::Vector2f((cell % gridSize) * step + margin, HEADER_HEIGHT + (cell / gridSize) * step + margin);
+    }
+
+    void holdFrames(const Board& board, int score, size_t move, size_t moves, float seconds) {
+        for (float t = 0.0f; t < seconds; t += frameSeconds) {
+            // 没有动画，时间停在动画结束之后
+            renderFrame(board, score, move, moves, SLIDE_DURATION + SPAWN_DURATION);
+        }
+    }
+
+    void drawTile(const sf::Vector2f& pos, int value, float scale) {
+        if (scale <= 0.01f) return;
+        const float size = (step - 2 * margin) * scale;
+        const sf::Vector2f corner(pos.x + (step - 2 * margin - size) / 2, pos.y + (step - 2 * margin - size) / 2);
+        sf::RectangleShape tile(sf::Vector2f(size, size));
+        tile.setPosition(corner);
+        tile.setFillColor(tileColor(value));
+        canvas.draw(tile);
+
+        auto picture = pictures.find(value);
+        if (picture != pictures.end()) {
+            const sf::Texture& texture = picture->second.getCurrentFrame(static_cast<unsigned>(size));
+            const sf::Vector2u textureSize = texture.getSize();
+            if (textureSize.x > 0 && textureSize.y > 0) {
+                sf::Sprite sprite(texture);
+                sprite.setPosition(corner);
+                sprite.setScale(size / textureSize.x, size / textureSize.y);
+                canvas.draw(sprite);
+            }
+        }
+
+        sf::Text text(std::to_string(value), font, static_cast<unsigned>(std::max(8.0f, size / 4.0f)));
+        text.setFillColor(tileTextColor(value));
+        text.setPosition(corner.x + 3, corner.y + 3);
+        canvas.draw(text);
+    }
+
+    // t 是这一步开始后经过的动画时间（秒，已经按 --speed 换算）
+    void renderFrame(const Board& board, int score, size_t move, size_t moves, float t) {
+        const uint32_t nowMs = static_cast<uint32_t>(timeline * 1000.0f);
+        for (auto& entry : pictures) {
+            entry.second.updateFrame(nowMs);
+        }
+
+        canvas.clear(BOARD_BACKGROUND_COLOR);
+        sf::Text header("Score " + std::to_string(score), font, 22);
+        header.setFillColor(sf::Color::White);
+        header.setPosition(margin + 4, 10);
+        canvas.draw(header);
+        header.setString("Move " + std::to_string(move) + "/" + std::to_string(moves));
+        header.setPosition(width - header.getLocalBounds().width - margin - 4, 10);
+        canvas.draw(header);
+
+        const int cells = board.cellCount();
+        for (int cell = 0; cell < cells; ++cell) {
+            sf::RectangleShape background(sf::Vector2f(step - 2 * margin, step - 2 * margin));
+            background.setPosition(cellPosition(cell));
+            background.setFillColor(version == GameVersion::MODIFIED ? checkerCellColor(cell % gridSize, cell / gridSize)
+                                                                     : CELL_BACKGROUND_COLOR);
+            canvas.draw(background);
+        }
+
+        const bool sliding = t < SLIDE_DURATION && !slides.empty();
+        std::vector<bool>& covered = coveredCells;
+        covered.assign(cells, false);
+        if (sliding) {
+            for (const Slide& slide : slides) covered[slide.toCell] = true;
+        }
+        for (int cell = 0; cell < cells; ++cell) {
+            const uint8_t exponent = board.exponent(cell);
+            if (exponent == 0 || covered[cell]) continue;
+            float scale = 1.0f;
+            if (cell == spawnCell) {
+                const float progress = std::min(1.0f, std::max(0.0f, (t - SLIDE_DURATION) / SPAWN_DURATION));
+                scale = applyEasing(Easing::OUT_BACK, progress);
+            } else if (merged[cell] && t >= SLIDE_DURATION && t < SLIDE_DURATION + MERGE_DURATION) {
+                scale = 1.0f + 0.15f * applyEasing(Easing::PULSE, (t - SLIDE_DURATION) / MERGE_DURATION);
+            }
+            drawTile(cellPosition(cell), 1 << exponent, scale);
+        }
+        if (sliding) {
+            const float progress = applyEasing(Easing::OUT_QUAD, t / SLIDE_DURATION);
+            for (const Slide& slide : slides) {
+                const sf::Vector2f from = cellPosition(slide.fromCell);
+                const sf::Vector2f to = cellPosition(slide.toCell);
+                drawTile(from + (to - from) * progress, slide.value, 1.0f);
+            }
+        }
+
+        canvas.display();
+        emitFrame(canvas.getTexture().copyToImage());
+        timeline += frameSeconds;
+        ++renderedFrames;
+    }
+
+    // 与上一帧完全相同的画面不单独成帧，只延长上一帧的显示时间
+    void emitFrame(const sf::Image& image) {
+        const uint8_t* pixels = image.getPixelsPtr();
+        const size_t size = static_cast<size_t>(width) * height * 4;
+        if (held && std::memcmp(held->data(), pixels, size) == 0) {
+            heldDelay = static_cast<uint16_t>(std::min(65535, heldDelay + delay));
+            return;
+        }
+        if (held) encoder.addFrame(held, heldDelay);
+        held = std::make_shared<const std::vector<uint8_t>>(pixels, pixels + size);
+        heldDelay = delay;
+    }
+
+    const Options& options;
+    GifEncoder encoder;
+    sf::RenderTexture canvas;
+    sf::Font font;
+    std::map<int, GifWrapper> pictures;
+    unsigned pictureSize = 0;
+    int width = 0;
+    int height = 0;
+
+    int gridSize = 4;
+    GameVersion version = GameVersion::ORIGINAL;
+    float step = 0.0f;
+    float margin = 0.0f;
+    std::vector<Slide> slides;
+    std::vector<bool> merged;
+    std::vector<bool> coveredCells;
+    int spawnCell = -1;
+
+    uint16_t delay = 5;
+    float frameSeconds = 0.05f;
+    float timeline = 0.0f;
+    uint64_t renderedFrames = 0;
+    GifEncoder::Pixels held;
+    int heldDelay = 0;
+
+    uint64_t totalFrames = 0;
+    double totalPlayed = 0.0;
+};
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+    std::vector<std::string> replays;
+
+    // 用法: replay2gif [--px 边长] [--fps N] [--speed X] [--threads N] [--plain] [--out 目录] 回放文件...
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--px" && i + 1 < argc) {
+            options.boardPixels = std::max(64, std::atoi(argv[++i]));
+        } else if (arg == "--fps" && i + 1 < argc) {
+            options.fps = std::min(50, std::max(1, std::atoi(argv[++i])));
+        } else if (arg == "--speed" && i + 1 < argc) {
+            options.speed = std::max(0.1f, static_cast<float>(std::atof(argv[++i])));
+        } else if (arg == "--threads" && i + 1 < argc) {
+            options.threads = static_cast<unsigned>(std::max(1, std::atoi(argv[++i])));
+        } else if (arg == "--plain") {
+            options.pictures = false;
+        } else if (arg == "--out" && i + 1 < argc) {
+            options.outDir = argv[++i];
+        } else if (!arg.empty() && arg[0] == '-') {
+            std::cerr << "未知参数: " << arg << std::endl;
+            return 1;
+        } else {
+            replays.push_back(arg);
+        }
+    }
+    if (replays.empty()) {
+        std::cerr << "用法: replay2gif [--px 边长] [--fps N] [--speed X] [--threads N] [--plain] [--out 目录] 回放文件..."
+                  << std::endl;
+        return 1;
+    }
+    if (!options.outDir.empty()) {
+        std::error_code ec;
+        std::filesystem::create_directories(options.outDir, ec);
+    }
+
+    ReplayRenderer renderer(options);
+    if (!renderer.init()) return 1;
+
+    const auto started = std::chrono::steady_clock::now();
+    int failures = 0;
+    for (const std::string& replay : replays) {
+        std::filesystem::path output = std::filesystem::path(replay).replace_extension(".gif");
+        if (!options.outDir.empty()) {
+            output = std::filesystem::path(options.outDir) / output.filename();
+        }
+        if (!renderer.exportReplay(replay, output.string())) ++failures;
+    }
+
+    const double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    if (replays.size() > 1) {
+        std::cout << "共 " << replays.size() << " 个回放, " << renderer.frames() << " 帧, " << std::fixed
+                  << std::setprecision(1) << wall << " 秒 (" << renderer.playedSeconds() / std::max(wall, 1e-6)
+                  << " 倍实时)" << std::endl;
+    }
+    if (failures > 0) {
+        std::cerr << failures << " 个回放导出失败" << std::endl;
+    }
+    return failures == 0 ? 0 : 1;
+}
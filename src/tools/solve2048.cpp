@@ -0,0 +1,180 @@
+#include "../ai/WinSolver.h"
+#include "../core/Replay.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// 批量计算局面的精确胜率（最优走法下合成出目标数值的概率）。
+// 输入每行一个局面：按行优先写出所有格子的数值，0 表示空格，用空格或逗号分隔；# 开头的行忽略。
+// 也可以用 --replay 逐步分析一局回放。所有局面共用同一张表，后面的局面会复用前面算过的结果。
+// --seconds 限制每个局面的计算时间，超时的局面只报告超时，已经算完的子局面留在表里。
+
+namespace {
+
+const char* directionName(Direction dir) {
+    static const char* const NAMES[] = {"上", "下", "左", "右", "左上", "右上", "左下", "右下"};
+    return NAMES[static_cast<int>(dir)];
+}
+
+int exponentOf(int value) {
+    int exponent = 0;
+    while ((1 << exponent) < value) ++exponent;
+    return (1 << exponent) == value ? exponent : -1;
+}
+
+bool parseBoard(const std::string& line, int gridSize, Board& board) {
+    std::string text = line;
+    for (char& c : text) {
+        if (c == ',') c = ' ';
+    }
+    std::istringstream in(text);
+    std::vector<int> values;
+    int value;
+    while (in >> value) {
+        values.push_back(value);
+    }
+    if (static_cast<int>(values.size()) != gridSize * gridSize) return false;
+
+    board = Board(gridSize);
+    for (int cell = 0; cell < gridSize * gridSize; ++cell) {
+        if (values[cell] == 0) continue;
+        const int exponent = exponentOf(values[cell]);
+        if (exponent < 1) return false;
+        board.setExponent(cell, static_cast<uint8_t>(exponent));
+    }
+    return true;
+}
+
+void report(const std::string& label, bool solved, const WinChance& chance, double milliseconds) {
+    if (!solved) {
+        std::cout << label << "超时" << std::fixed << std::setprecision(2) << "  (" << milliseconds << " ms)"
+                  << std::endl;
+        return;
+    }
+    std::cout << label << std::fixed << std::setprecision(6) << chance.probability;
+    if (chance.hasMove) {
+        std::cout << "  最佳: " << directionName(chance.bestMove);
+    }
+    std::cout << std::setprecision(2) << "  (" << milliseconds << " ms)" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    int gridSize = 4;
+    GameVersion version = GameVersion::ORIGINAL;
+    int targetValue = 16;
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    int tableBits = 24;
+    double seconds = 0.0;
+    std::string replayFile;
+    std::string inputFile;
+
+    // 用法: solve2048 [--size N] [--version classic|diagonal] [--target 数值] [--threads N] [--table-bits N]
+    //                 [--seconds 每个局面的秒数] [--replay 回放文件 | 局面文件]
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--size" && i + 1 < argc) {
+            gridSize = std::atoi(argv[++i]);
+        } else if (arg == "--version" && i + 1 < argc) {
+            std::string value = argv[++i];
+            version = value == "diagonal" ? GameVersion::MODIFIED : GameVersion::ORIGINAL;
+        } else if (arg == "--target" && i + 1 < argc) {
+            targetValue = std::atoi(argv[++i]);
+        } else if (arg == "--threads" && i + 1 < argc) {
+            threads = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--table-bits" && i + 1 < argc) {
+            tableBits = std::atoi(argv[++i]);
+        } else if (arg == "--seconds" && i + 1 < argc) {
+            seconds = std::atof(argv[++i]);
+        } else if (arg == "--replay" && i + 1 < argc) {
+            replayFile = argv[++i];
+        } else if (!arg.empty() && arg[0] == '-') {
+            std::cerr << "未知参数: " << arg << std::endl;
+            return 1;
+        } else {
+            inputFile = arg;
+        }
+    }
+
+    ReplayPlayer player;
+    if (!replayFile.empty()) {
+        if (!player.load(replayFile)) {
+            return 1;
+        }
+        gridSize = player.header().gridSize;
+        version = player.header().version;
+    }
+
+    const int targetExponent = exponentOf(targetValue);
+    if (targetExponent < 0 || !WinSolver::supports(gridSize, targetExponent) || tableBits < 10 || tableBits > 30) {
+        std::cerr << "不支持的参数: " << gridSize << "x" << gridSize << "，目标 " << targetValue << std::endl;
+        return 1;
+    }
+    WinSolver solver(gridSize, version, targetExponent, tableBits, threads);
+    const std::chrono::milliseconds timeLimit(static_cast<int64_t>(std::max(0.0, seconds) * 1000.0));
+
+    auto timed = [&](const Board& board, WinChance& chance, bool& done) {
+        const auto start = std::chrono::steady_clock::now();
+        done = solver.solve(board, chance, timeLimit);
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    size_t solved = 0;
+    size_t timedOut = 0;
+    double totalMilliseconds = 0.0;
+    if (!replayFile.empty()) {
+        // 每一步走完、新方块出现之后的局面
+        while (true) {
+            WinChance chance;
+            bool done = false;
+            const double milliseconds = timed(player.board(), chance, done);
+            report("第 " + std::to_string(player.position()) + " 步: ", done, chance, milliseconds);
+            totalMilliseconds += milliseconds;
+            ++(done ? solved : timedOut);
+            if (player.board().maxExponent() >= targetExponent || !player.step()) break;
+        }
+    } else {
+        std::ifstream file;
+        if (!inputFile.empty()) {
+            file.open(inputFile);
+            if (!file) {
+                std::cerr << "无法打开 " << inputFile << std::endl;
+                return 1;
+            }
+        }
+        std::istream& in = inputFile.empty() ? std::cin : file;
+        std::string line;
+        size_t lineNumber = 0;
+        while (std::getline(in, line)) {
+            ++lineNumber;
+            if (line.empty() || line[0] == '#') continue;
+            Board board;
+            if (!parseBoard(line, gridSize, board)) {
+                std::cerr << "第 " << lineNumber << " 行不是 " << gridSize << "x" << gridSize << " 的局面" << std::endl;
+                continue;
+            }
+            WinChance chance;
+            bool done = false;
+            const double milliseconds = timed(board, chance, done);
+            report("第 " + std::to_string(lineNumber) + " 行: ", done, chance, milliseconds);
+            totalMilliseconds += milliseconds;
+            ++(done ? solved : timedOut);
+        }
+    }
+
+    std::cout << "共 " << solved << " 个局面";
+    if (timedOut > 0) {
+        std::cout << "，另有 " << timedOut << " 个超时";
+    }
+    std::cout << "，总计 " << std::fixed << std::setprecision(1) << totalMilliseconds
+              << " ms，表中 " << solver.tableSize() << " 个局面" << std::endl;
+    return 0;
+}
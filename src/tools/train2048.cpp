@@ -0,0 +1,264 @@
+#include "../ai/NTupleNetwork.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// 用时间差分学习 TD(0) 训练 4x4 棋盘的 n元组网络。
+// 所有线程同时自我对弈，直接读写同一份权重，不加锁（Hogwild）：
+// 权重表有三十多万项，两个线程同时改到同一项的概率很小，偶尔丢掉一次更新不影响收敛。
+// 第 i 局的随机序列只由种子和 i 决定，与线程数无关；单线程训练时结果逐位可复现，
+// 多线程时各线程更新权重的先后顺序不固定，结果只在统计意义上相同。
+
+namespace {
+
+struct TrainerOptions {
+    GameVersion version = GameVersion::ORIGINAL;
+    int epochs = 10;
+    uint64_t gamesPerEpoch = 10000;
+    unsigned threads = 0;
+    uint64_t seed = 1;
+    float alpha = 0.1f;
+    std::string output;
+    std::string init;
+};
+
+struct EpochStats {
+    uint64_t games = 0;
+    uint64_t totalScore = 0;
+    uint64_t maxScore = 0;
+    uint64_t reached2048 = 0;
+};
+
+// 权重更新只用 relaxed 的读和写（不是原子加），与直接读写 float 生成的指令相同
+class SharedWeights {
+public:
+    SharedWeights() : weights(new std::atomic<float>[NTupleNetwork::WEIGHT_COUNT]) {
+        for (uint32_t i = 0; i < NTupleNetwork::WEIGHT_COUNT; ++i) {
+            weights[i].store(0.0f, std::memory_order_relaxed);
+        }
+    }
+
+    float evaluate(const uint32_t* indices, int count) const {
+        float value = 0.0f;
+        for (int i = 0; i < count; ++i) {
+            value += weights[indices[i]].load(std::memory_order_relaxed);
+        }
+        return value;
+    }
+
+    void update(const uint32_t* indices, int count, float delta) {
+        for (int i = 0; i < count; ++i) {
+            std::atomic<float>& weight = weights[indices[i]];
+            weight.store(weight.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+        }
+    }
+
+    void load(const float* source) {
+        for (uint32_t i = 0; i < NTupleNetwork::WEIGHT_COUNT; ++i) {
+            weights[i].store(source[i], std::memory_order_relaxed);
+        }
+    }
+
+    std::vector<float> snapshot() const {
+        std::vector<float> copy(NTupleNetwork::WEIGHT_COUNT);
+        for (uint32_t i = 0; i < NTupleNetwork::WEIGHT_COUNT; ++i) {
+            copy[i] = weights[i].load(std::memory_order_relaxed);
+        }
+        return copy;
+    }
+
+private:
+    std::unique_ptr<std::atomic<float>[]> weights;
+};
+
+// splitmix64：把种子和局号混合成每局独立的种子
+uint64_t gameSeed(uint64_t seed, uint64_t gameIndex) {
+    uint64_t z = seed + (gameIndex + 1) * 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+// 一局自我对弈：每步贪心选择 得分 + 移动后局面估值 最大的方向，
+// 再用下一步的 得分 + 估值 更新上一个移动后局面的估值（游戏结束时目标为0）
+void playTrainingGame(SharedWeights& weights, GameVersion version, uint64_t seed, float learningRate,
+                      EpochStats& stats) {
+    Rng rng(seed);
+    Board board(NTupleNetwork::GRID_SIZE);
+    board.spawnRandom(rng);
+    board.spawnRandom(rng);
+
+    const int featureCount = NTupleNetwork::featureCount(version);
+    uint32_t previous[NTupleNetwork::FEATURE_COUNT];
+    bool hasPrevious = false;
+    uint64_t score = 0;
+    while (true) {
+        bool found = false;
+        float bestValue = 0.0f;
+        int bestReward = 0;
+        Board bestAfter;
+        uint32_t bestFeatures[NTupleNetwork::FEATURE_COUNT];
+        for (int i = 0; i < 4; ++i) {
+            Board after = board;
+            MoveResult result;
+            if (!after.move(directionFromIndex(version, i), result)) continue;
+            uint32_t features[NTupleNetwork::FEATURE_COUNT];
+            NTupleNetwork::features(packBoard(after), version, features);
+            const float value = result.scoreGained + weights.evaluate(features, featureCount);
+            if (!found || value > bestValue) {
+                found = true;
+                bestValue = value;
+                bestReward = result.scoreGained;
+                bestAfter = after;
+                std::copy(features, features + featureCount, bestFeatures);
+            }
+        }
+
+        if (hasPrevious) {
+            const float target = found ? bestValue : 0.0f;
+            const float error = target - weights.evaluate(previous, featureCount);
+            weights.update(previous, featureCount, learningRate * error);
+        }
+        if (!found) break;
+
+        std::copy(bestFeatures, bestFeatures + featureCount, previous);
+        hasPrevious = true;
+        score += static_cast<uint64_t>(bestReward);
+        board = bestAfter;
+        board.spawnRandom(rng);
+    }
+
+    ++stats.games;
+    stats.totalScore += score;
+    stats.maxScore = std::max(stats.maxScore, score);
+    if (board.maxExponent() >= 11) {
+        ++stats.reached2048;
+    }
+}
+
+bool parseOptions(int argc, char* argv[], TrainerOptions& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--version" && i + 1 < argc) {
+            std::string value = argv[++i];
+            if (value == "classic") {
+                options.version = GameVersion::ORIGINAL;
+            } else if (value == "diagonal") {
+                options.version = GameVersion::MODIFIED;
+            } else {
+                std::cerr << "未知版本: " << value << "（classic 或 diagonal）" << std::endl;
+                return false;
+            }
+        } else if (arg == "--epochs" && i + 1 < argc) {
+            options.epochs = std::atoi(argv[++i]);
+        } else if (arg == "--games" && i + 1 < argc) {
+            options.gamesPerEpoch = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--threads" && i + 1 < argc) {
+            options.threads = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--seed" && i + 1 < argc) {
+            options.seed = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--alpha" && i + 1 < argc) {
+            options.alpha = std::strtof(argv[++i], nullptr);
+        } else if (arg == "--init" && i + 1 < argc) {
+            options.init = argv[++i];
+        } else if (arg == "-o" && i + 1 < argc) {
+            options.output = argv[++i];
+        } else {
+            std::cerr << "未知参数: " << arg << std::endl;
+            return false;
+        }
+    }
+    return options.epochs > 0 && options.gamesPerEpoch > 0 && options.alpha > 0.0f;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    // 用法: train2048 [--version classic|diagonal] [--epochs N] [--games 每轮局数] [--threads N]
+    //                 [--seed N] [--alpha 学习率] [--init 已有权重] [-o 输出文件]
+    TrainerOptions options;
+    if (!parseOptions(argc, argv, options)) {
+        std::cerr << "用法: " << argv[0] << " [--version classic|diagonal] [--epochs N] [--games N] [--threads N]"
+                  << " [--seed N] [--alpha X] [--init 权重文件] [-o 输出文件]" << std::endl;
+        return 1;
+    }
+    if (options.threads == 0) {
+        options.threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    if (options.output.empty()) {
+        options.output = NTupleWeights::defaultPath(options.version);
+        std::error_code ec;
+        std::filesystem::create_directories("weights", ec);
+    }
+
+    SharedWeights weights;
+    uint64_t gamesTrained = 0;
+    if (!options.init.empty()) {
+        NTupleWeights initial;
+        if (!initial.load(options.init) || initial.version() != options.version) {
+            std::cerr << "无法从 " << options.init << " 继续训练" << std::endl;
+            return 1;
+        }
+        weights.load(initial.data());
+        gamesTrained = initial.gamesTrained();
+    }
+
+    // 学习率平摊到每个特征上（对角线版本的特征比经典版本少）
+    const float learningRate = options.alpha / NTupleNetwork::featureCount(options.version);
+    std::cout << "训练 4x4 " << (options.version == GameVersion::ORIGINAL ? "经典" : "对角线") << "版本: "
+              << options.epochs << " 轮 x " << options.gamesPerEpoch << " 局，" << options.threads
+              << " 个线程，种子 " << options.seed << std::endl;
+
+    for (int epoch = 0; epoch < options.epochs; ++epoch) {
+        const uint64_t firstGame = gamesTrained;
+        std::atomic<uint64_t> nextGame(0);
+        std::vector<EpochStats> threadStats(options.threads);
+        const auto start = std::chrono::steady_clock::now();
+
+        std::vector<std::thread> workers;
+        for (unsigned t = 0; t < options.threads; ++t) {
+            workers.emplace_back([&, t]() {
+                uint64_t game;
+                while ((game = nextGame.fetch_add(1, std::memory_order_relaxed)) < options.gamesPerEpoch) {
+                    playTrainingGame(weights, options.version, gameSeed(options.seed, firstGame + game),
+                                     learningRate, threadStats[t]);
+                }
+            });
+        }
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        EpochStats total;
+        for (const EpochStats& stats : threadStats) {
+            total.games += stats.games;
+            total.totalScore += stats.totalScore;
+            total.maxScore = std::max(total.maxScore, stats.maxScore);
+            total.reached2048 += stats.reached2048;
+        }
+        gamesTrained += total.games;
+
+        std::cout << "第 " << std::setw(3) << epoch + 1 << " 轮: " << std::fixed << std::setprecision(0)
+                  << total.games / std::max(seconds, 1e-9) << " 局/秒，平均分 "
+                  << static_cast<double>(total.totalScore) / total.games << "，最高分 " << total.maxScore
+                  << "，达到2048 " << std::setprecision(1) << 100.0 * total.reached2048 / total.games << "%"
+                  << std::endl;
+
+        // 每轮结束都写一次，训练随时可以中断
+        if (!NTupleWeights::save(options.output, options.version, gamesTrained, weights.snapshot())) {
+            return 1;
+        }
+    }
+
+    std::cout << "权重已写入 " << options.output << "（累计 " << gamesTrained << " 局）" << std::endl;
+    return 0;
+}